@@ -0,0 +1,618 @@
+#include "Game/AnimAssetArchive.hpp"
+#include "Game/AnimStateMachineTable.hpp"
+
+#include "Engine/Animation/AnimClip.hpp"
+#include "Engine/Core/ErrorWarningAssert.hpp"
+#include "Engine/Core/StringUtils.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+
+//----------------------------------------------------------------------------------------------------------
+constexpr int	   COMPRESSION_HASH_BITS	= 14;
+constexpr size_t   COMPRESSION_MIN_MATCH	= 4;
+constexpr size_t   COMPRESSION_MAX_MATCH	= 0x7F + COMPRESSION_MIN_MATCH;
+constexpr size_t   COMPRESSION_MAX_LITERALS = 0x80;
+constexpr size_t   COMPRESSION_MAX_OFFSET	= 0xFFFF;
+constexpr uint8_t  COMPRESSION_MATCH_FLAG	= 0x80;
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimAssetWriteBuffer::WriteBytes( void const* data, size_t numBytes )
+{
+	uint8_t const* bytes = ( uint8_t const* ) data;
+	m_bytes.insert( m_bytes.end(), bytes, bytes + numBytes );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimAssetWriteBuffer::WriteString( std::string const& text )
+{
+	Write( ( uint32_t ) text.size() );
+	WriteBytes( text.data(), text.size() );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+AnimAssetReadBuffer::AnimAssetReadBuffer( std::vector<uint8_t> const& bytes )
+	: m_data( bytes.data() ), m_size( bytes.size() )
+{
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool AnimAssetReadBuffer::ReadBytes( void* out_data, size_t numBytes )
+{
+	if ( !m_isValid || numBytes > m_size - m_cursor )
+	{
+		m_isValid = false;
+		return false;
+	}
+
+	memcpy( out_data, m_data + m_cursor, numBytes );
+	m_cursor += numBytes;
+
+	return true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+std::string AnimAssetReadBuffer::ReadString()
+{
+	uint32_t length = Read<uint32_t>();
+	if ( !m_isValid || length > m_size - m_cursor )
+	{
+		m_isValid = false;
+		return "";
+	}
+
+	std::string text( ( char const* ) ( m_data + m_cursor ), length );
+	m_cursor += length;
+
+	return text;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+template <typename CurveType>
+static void WriteCurve( AnimAssetWriteBuffer& buffer, CurveType const& curve )
+{
+	uint32_t numKeyframes = ( uint32_t ) curve.m_keyframes.size();
+	buffer.Write( numKeyframes );
+	buffer.WriteBytes( curve.m_keyframes.data(), numKeyframes * sizeof( curve.m_keyframes[ 0 ] ) );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+template <typename CurveType>
+static bool ReadCurve( AnimAssetReadBuffer& buffer, CurveType& out_curve )
+{
+	uint32_t numKeyframes = buffer.Read<uint32_t>();
+	size_t	 numBytes	  = numKeyframes * sizeof( out_curve.m_keyframes[ 0 ] );
+	if ( !buffer.m_isValid || numBytes > buffer.m_size - buffer.m_cursor )
+	{
+		buffer.m_isValid = false;
+		return false;
+	}
+
+	out_curve.m_keyframes.resize( numKeyframes );
+	return buffer.ReadBytes( out_curve.m_keyframes.data(), numBytes );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+AnimAssetArchive::~AnimAssetArchive()
+{
+	Close();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimAssetArchive::AddEntry( std::string const& name, AnimAssetType type, std::vector<uint8_t> const& rawBytes )
+{
+	PendingEntry entry;
+	entry.m_tocEntry.m_name	   = name;
+	entry.m_tocEntry.m_type	   = type;
+	entry.m_tocEntry.m_rawSize = ( uint32_t ) rawBytes.size();
+	CompressBytes( rawBytes, entry.m_compressedBytes );
+	entry.m_tocEntry.m_compressedSize = ( uint32_t ) entry.m_compressedBytes.size();
+
+	m_pendingEntries.push_back( entry );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool AnimAssetArchive::WriteToFile( std::string const& filePath ) const
+{
+	// layout: header | compressed entries | table of contents
+	AnimAssetWriteBuffer header;
+	header.Write( ANIM_ASSET_ARCHIVE_MAGIC );
+	header.Write( ANIM_ASSET_ARCHIVE_VERSION );
+	header.Write( ( uint32_t ) m_pendingEntries.size() );
+	size_t tocOffsetPosition = header.m_bytes.size();
+	header.Write( ( uint64_t ) 0 );
+
+	AnimAssetWriteBuffer tableOfContents;
+	uint64_t			 offset = header.m_bytes.size();
+	for ( PendingEntry const& entry : m_pendingEntries )
+	{
+		tableOfContents.WriteString( entry.m_tocEntry.m_name );
+		tableOfContents.Write( ( uint32_t ) entry.m_tocEntry.m_type );
+		tableOfContents.Write( offset );
+		tableOfContents.Write( entry.m_tocEntry.m_compressedSize );
+		tableOfContents.Write( entry.m_tocEntry.m_rawSize );
+
+		offset += entry.m_compressedBytes.size();
+	}
+	memcpy( header.m_bytes.data() + tocOffsetPosition, &offset, sizeof( offset ) );
+
+	FILE* file = nullptr;
+	if ( fopen_s( &file, filePath.c_str(), "wb" ) != 0 || !file )
+	{
+		DebuggerPrintf( "Error: Unable to open cooked archive for writing: %s\n", filePath.c_str() );
+		return false;
+	}
+
+	fwrite( header.m_bytes.data(), 1, header.m_bytes.size(), file );
+	for ( PendingEntry const& entry : m_pendingEntries )
+	{
+		fwrite( entry.m_compressedBytes.data(), 1, entry.m_compressedBytes.size(), file );
+	}
+	fwrite( tableOfContents.m_bytes.data(), 1, tableOfContents.m_bytes.size(), file );
+	fclose( file );
+
+	return true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool AnimAssetArchive::OpenForRead( std::string const& filePath )
+{
+	Close();
+
+	if ( fopen_s( &m_file, filePath.c_str(), "rb" ) != 0 || !m_file )
+	{
+		m_file = nullptr;
+		return false;
+	}
+
+	// header
+	uint8_t headerBytes[ 20 ] = {};
+	if ( fread( headerBytes, 1, sizeof( headerBytes ), m_file ) != sizeof( headerBytes ) )
+	{
+		DebuggerPrintf( "Error: Cooked archive is truncated: %s\n", filePath.c_str() );
+		Close();
+		return false;
+	}
+
+	uint32_t magic		= 0;
+	uint32_t version	= 0;
+	uint32_t numEntries = 0;
+	uint64_t tocOffset	= 0;
+	memcpy( &magic, headerBytes, 4 );
+	memcpy( &version, headerBytes + 4, 4 );
+	memcpy( &numEntries, headerBytes + 8, 4 );
+	memcpy( &tocOffset, headerBytes + 12, 8 );
+	if ( magic != ANIM_ASSET_ARCHIVE_MAGIC || version != ANIM_ASSET_ARCHIVE_VERSION )
+	{
+		DebuggerPrintf( "Error: %s is not a cooked archive of version %u\n", filePath.c_str(), ANIM_ASSET_ARCHIVE_VERSION );
+		Close();
+		return false;
+	}
+
+	// table of contents runs to the end of the file
+	_fseeki64( m_file, 0, SEEK_END );
+	int64_t fileSize = _ftelli64( m_file );
+	if ( ( int64_t ) tocOffset > fileSize )
+	{
+		Close();
+		return false;
+	}
+
+	std::vector<uint8_t> tocBytes( ( size_t ) ( fileSize - tocOffset ) );
+	_fseeki64( m_file, ( int64_t ) tocOffset, SEEK_SET );
+	fread( tocBytes.data(), 1, tocBytes.size(), m_file );
+
+	AnimAssetReadBuffer tocBuffer( tocBytes );
+	m_tableOfContents.reserve( numEntries );
+	for ( uint32_t entryIndex = 0; entryIndex < numEntries; entryIndex++ )
+	{
+		AnimAssetTocEntry entry;
+		entry.m_name		   = tocBuffer.ReadString();
+		entry.m_type		   = ( AnimAssetType ) tocBuffer.Read<uint32_t>();
+		entry.m_offset		   = tocBuffer.Read<uint64_t>();
+		entry.m_compressedSize = tocBuffer.Read<uint32_t>();
+		entry.m_rawSize		   = tocBuffer.Read<uint32_t>();
+		if ( !tocBuffer.m_isValid )
+		{
+			DebuggerPrintf( "Error: Cooked archive table of contents is corrupt: %s\n", filePath.c_str() );
+			Close();
+			return false;
+		}
+
+		m_tableOfContents.push_back( entry );
+	}
+
+	return true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimAssetArchive::Close()
+{
+	if ( m_file )
+	{
+		fclose( m_file );
+		m_file = nullptr;
+	}
+
+	m_tableOfContents.clear();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool AnimAssetArchive::IsOpen() const
+{
+	return m_file != nullptr;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+AnimAssetTocEntry const* AnimAssetArchive::FindEntry( std::string const& name ) const
+{
+	for ( AnimAssetTocEntry const& entry : m_tableOfContents )
+	{
+		if ( entry.m_name == name )
+		{
+			return &entry;
+		}
+	}
+
+	return nullptr;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool AnimAssetArchive::ReadEntry( std::string const& name, std::vector<uint8_t>& out_rawBytes )
+{
+	AnimAssetTocEntry const* entry = FindEntry( name );
+	if ( !entry )
+	{
+		return false;
+	}
+
+	std::vector<uint8_t> compressedBytes( entry->m_compressedSize );
+	{
+		// entries are read from loading jobs, so the shared file handle is guarded
+		std::lock_guard<std::mutex> lock( m_fileMutex );
+		if ( !m_file )
+		{
+			return false;
+		}
+
+		_fseeki64( m_file, ( int64_t ) entry->m_offset, SEEK_SET );
+		if ( fread( compressedBytes.data(), 1, compressedBytes.size(), m_file ) != compressedBytes.size() )
+		{
+			DebuggerPrintf( "Error: Unable to read cooked asset: %s\n", name.c_str() );
+			return false;
+		}
+	}
+
+	return DecompressBytes( compressedBytes.data(), compressedBytes.size(), entry->m_rawSize, out_rawBytes );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+size_t AnimAssetArchive::GetNumEntries() const
+{
+	return m_tableOfContents.size();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimAssetArchive::SerializeAnimClip( AnimAssetWriteBuffer& buffer, AnimClip const& clip )
+{
+	buffer.WriteString( clip.m_name );
+	buffer.Write( ( uint8_t ) ( clip.m_removeRootMotion ? 1 : 0 ) );
+	buffer.Write( ( uint32_t ) clip.m_animChannels.size() );
+
+	for ( AnimChannel const& channel : clip.m_animChannels )
+	{
+		buffer.Write( ( int32_t ) channel.m_jointId );
+		buffer.WriteString( channel.m_jointName );
+		WriteCurve( buffer, channel.m_positionCurve );
+		WriteCurve( buffer, channel.m_rotationCurve );
+		WriteCurve( buffer, channel.m_scaleCurve );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool AnimAssetArchive::DeserializeAnimClip( AnimAssetReadBuffer& buffer, AnimClip& out_clip )
+{
+	out_clip.m_name				= buffer.ReadString();
+	out_clip.m_removeRootMotion = buffer.Read<uint8_t>() != 0;
+	uint32_t numChannels		= buffer.Read<uint32_t>();
+	if ( !buffer.m_isValid )
+	{
+		return false;
+	}
+
+	out_clip.m_animChannels.clear();
+	out_clip.m_animChannels.resize( numChannels );
+	for ( AnimChannel& channel : out_clip.m_animChannels )
+	{
+		channel.m_jointId	= buffer.Read<int32_t>();
+		channel.m_jointName = buffer.ReadString();
+		ReadCurve( buffer, channel.m_positionCurve );
+		ReadCurve( buffer, channel.m_rotationCurve );
+		ReadCurve( buffer, channel.m_scaleCurve );
+
+		if ( !buffer.m_isValid )
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimAssetArchive::SerializeSkinnedMesh( AnimAssetWriteBuffer& buffer, std::vector<Vertex_PCUTBN> const& verts, std::vector<std::vector<std::pair<int, float>>> const& jointWeights )
+{
+	buffer.Write( ( uint32_t ) verts.size() );
+	buffer.WriteBytes( verts.data(), verts.size() * sizeof( Vertex_PCUTBN ) );
+
+	buffer.Write( ( uint32_t ) jointWeights.size() );
+	for ( std::vector<std::pair<int, float>> const& vertexWeights : jointWeights )
+	{
+		buffer.Write( ( uint32_t ) vertexWeights.size() );
+		for ( std::pair<int, float> const& jointWeight : vertexWeights )
+		{
+			buffer.Write( ( int32_t ) jointWeight.first );
+			buffer.Write( jointWeight.second );
+		}
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool AnimAssetArchive::DeserializeSkinnedMesh( AnimAssetReadBuffer& buffer, std::vector<Vertex_PCUTBN>& out_verts, std::vector<std::vector<std::pair<int, float>>>& out_jointWeights )
+{
+	uint32_t numVerts = buffer.Read<uint32_t>();
+	if ( !buffer.m_isValid || numVerts * sizeof( Vertex_PCUTBN ) > buffer.m_size - buffer.m_cursor )
+	{
+		return false;
+	}
+
+	out_verts.resize( numVerts );
+	buffer.ReadBytes( out_verts.data(), numVerts * sizeof( Vertex_PCUTBN ) );
+
+	uint32_t numWeightedVerts = buffer.Read<uint32_t>();
+	if ( !buffer.m_isValid || numWeightedVerts > buffer.m_size - buffer.m_cursor )
+	{
+		return false;
+	}
+
+	out_jointWeights.resize( numWeightedVerts );
+	for ( std::vector<std::pair<int, float>>& vertexWeights : out_jointWeights )
+	{
+		uint32_t numWeights = buffer.Read<uint32_t>();
+		if ( !buffer.m_isValid || numWeights * ( sizeof( int32_t ) + sizeof( float ) ) > buffer.m_size - buffer.m_cursor )
+		{
+			return false;
+		}
+
+		vertexWeights.resize( numWeights );
+		for ( std::pair<int, float>& jointWeight : vertexWeights )
+		{
+			jointWeight.first  = buffer.Read<int32_t>();
+			jointWeight.second = buffer.Read<float>();
+		}
+	}
+
+	return buffer.m_isValid;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool AnimAssetArchive::LoadAnimClip( std::string const& clipFilePath, AnimClip& out_clip )
+{
+	std::vector<uint8_t> rawBytes;
+	if ( !ReadEntry( clipFilePath, rawBytes ) )
+	{
+		return false;
+	}
+
+	AnimAssetReadBuffer buffer( rawBytes );
+	return DeserializeAnimClip( buffer, out_clip );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool AnimAssetArchive::LoadSkinnedMesh( std::string const& meshFilePath, std::vector<Vertex_PCUTBN>& out_verts, std::vector<std::vector<std::pair<int, float>>>& out_jointWeights )
+{
+	std::vector<uint8_t> rawBytes;
+	if ( !ReadEntry( meshFilePath, rawBytes ) )
+	{
+		return false;
+	}
+
+	AnimAssetReadBuffer buffer( rawBytes );
+	return DeserializeSkinnedMesh( buffer, out_verts, out_jointWeights );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool AnimAssetArchive::LoadStateMachineTable( std::string const& animConfigPath, AnimStateMachineTable& out_table )
+{
+	std::vector<uint8_t> rawBytes;
+	if ( !ReadEntry( animConfigPath + COOKED_STATE_MACHINE_ENTRY_SUFFIX, rawBytes ) )
+	{
+		return false;
+	}
+
+	// the table is stored behind the hash of the config it was compiled from
+	AnimAssetReadBuffer buffer( rawBytes );
+	uint64_t			cookedConfigHash = buffer.Read<uint64_t>();
+	uint64_t			configHash		 = 0;
+	if ( !buffer.m_isValid || !HashSourceFile( animConfigPath, configHash ) || cookedConfigHash != configHash )
+	{
+		DebuggerPrintf( "Cooked state machine is out of date with %s\n", animConfigPath.c_str() );
+		return false;
+	}
+
+	return out_table.Deserialize( buffer );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// 64 bit fnv-1a
+uint64_t AnimAssetArchive::HashBytes( std::vector<uint8_t> const& bytes )
+{
+	uint64_t hash = 14695981039346656037ull;
+	for ( uint8_t byte : bytes )
+	{
+		hash ^= byte;
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool AnimAssetArchive::HashSourceFile( std::string const& filePath, uint64_t& out_hash )
+{
+	std::ifstream sourceFile( filePath, std::ios::binary );
+	if ( !sourceFile )
+	{
+		return false;
+	}
+
+	std::vector<uint8_t> sourceBytes( ( std::istreambuf_iterator<char>( sourceFile ) ), std::istreambuf_iterator<char>() );
+	out_hash = HashBytes( sourceBytes );
+
+	return true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+static void AppendLiteralRuns( std::vector<uint8_t> const& rawBytes, size_t start, size_t end, std::vector<uint8_t>& out_compressedBytes )
+{
+	while ( start < end )
+	{
+		size_t runLength = end - start;
+		if ( runLength > COMPRESSION_MAX_LITERALS )
+		{
+			runLength = COMPRESSION_MAX_LITERALS;
+		}
+
+		out_compressedBytes.push_back( ( uint8_t ) ( runLength - 1 ) );
+		out_compressedBytes.insert( out_compressedBytes.end(), rawBytes.begin() + start, rawBytes.begin() + start + runLength );
+		start += runLength;
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimAssetArchive::CompressBytes( std::vector<uint8_t> const& rawBytes, std::vector<uint8_t>& out_compressedBytes )
+{
+	out_compressedBytes.clear();
+	out_compressedBytes.reserve( rawBytes.size() / 2 + 16 );
+
+	// most recent position of every hashed 4 byte sequence
+	std::vector<int64_t> lastSeenAt( ( size_t ) 1 << COMPRESSION_HASH_BITS, -1 );
+
+	size_t const numBytes	  = rawBytes.size();
+	size_t		 literalStart = 0;
+	size_t		 cursor		  = 0;
+	while ( cursor + COMPRESSION_MIN_MATCH <= numBytes )
+	{
+		uint32_t sequence = 0;
+		memcpy( &sequence, &rawBytes[ cursor ], sizeof( sequence ) );
+		uint32_t hash	   = ( sequence * 2654435761u ) >> ( 32 - COMPRESSION_HASH_BITS );
+		int64_t	 candidate = lastSeenAt[ hash ];
+		lastSeenAt[ hash ] = ( int64_t ) cursor;
+
+		bool isMatch = candidate >= 0 && cursor - ( size_t ) candidate <= COMPRESSION_MAX_OFFSET &&
+					   memcmp( &rawBytes[ ( size_t ) candidate ], &rawBytes[ cursor ], COMPRESSION_MIN_MATCH ) == 0;
+		if ( !isMatch )
+		{
+			cursor++;
+			continue;
+		}
+
+		size_t matchStart  = ( size_t ) candidate;
+		size_t matchLength = COMPRESSION_MIN_MATCH;
+		while ( matchLength < COMPRESSION_MAX_MATCH && cursor + matchLength < numBytes && rawBytes[ matchStart + matchLength ] == rawBytes[ cursor + matchLength ] )
+		{
+			matchLength++;
+		}
+
+		AppendLiteralRuns( rawBytes, literalStart, cursor, out_compressedBytes );
+
+		size_t matchOffset = cursor - matchStart;
+		out_compressedBytes.push_back( COMPRESSION_MATCH_FLAG | ( uint8_t ) ( matchLength - COMPRESSION_MIN_MATCH ) );
+		out_compressedBytes.push_back( ( uint8_t ) ( matchOffset & 0xFF ) );
+		out_compressedBytes.push_back( ( uint8_t ) ( matchOffset >> 8 ) );
+
+		cursor += matchLength;
+		literalStart = cursor;
+	}
+
+	AppendLiteralRuns( rawBytes, literalStart, numBytes, out_compressedBytes );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool AnimAssetArchive::DecompressBytes( uint8_t const* compressedBytes, size_t compressedSize, size_t rawSize, std::vector<uint8_t>& out_rawBytes )
+{
+	out_rawBytes.clear();
+	out_rawBytes.reserve( rawSize );
+
+	uint8_t const* cursor = compressedBytes;
+	uint8_t const* end	  = compressedBytes + compressedSize;
+	while ( cursor < end )
+	{
+		uint8_t control = *cursor++;
+		if ( control & COMPRESSION_MATCH_FLAG )
+		{
+			if ( end - cursor < 2 )
+			{
+				return false;
+			}
+
+			size_t matchLength = ( size_t ) ( control & ~COMPRESSION_MATCH_FLAG ) + COMPRESSION_MIN_MATCH;
+			size_t matchOffset = ( size_t ) cursor[ 0 ] | ( ( size_t ) cursor[ 1 ] << 8 );
+			cursor += 2;
+			if ( matchOffset == 0 || matchOffset > out_rawBytes.size() || out_rawBytes.size() + matchLength > rawSize )
+			{
+				return false;
+			}
+
+			// byte by byte so overlapping references repeat the pattern
+			size_t matchStart = out_rawBytes.size() - matchOffset;
+			for ( size_t index = 0; index < matchLength; index++ )
+			{
+				out_rawBytes.push_back( out_rawBytes[ matchStart + index ] );
+			}
+		}
+		else
+		{
+			size_t runLength = ( size_t ) control + 1;
+			if ( ( size_t ) ( end - cursor ) < runLength || out_rawBytes.size() + runLength > rawSize )
+			{
+				return false;
+			}
+
+			out_rawBytes.insert( out_rawBytes.end(), cursor, cursor + runLength );
+			cursor += runLength;
+		}
+	}
+
+	return out_rawBytes.size() == rawSize;
+}
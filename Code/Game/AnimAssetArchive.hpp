@@ -0,0 +1,132 @@
+#pragma once
+
+#include "Engine/Core/Vertex_PCUTBN.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class AnimClip;
+class AnimStateMachineTable;
+
+
+//----------------------------------------------------------------------------------------------------------
+constexpr uint32_t ANIM_ASSET_ARCHIVE_MAGIC	  = 0x4B415053; // "SPAK"
+constexpr uint32_t ANIM_ASSET_ARCHIVE_VERSION = 5;
+
+char const* const COOKED_ANIM_ARCHIVE_PATH		   = "Data/Cooked/Animations.spak";
+char const* const COOKED_STATE_MACHINE_ENTRY_SUFFIX = ".stateMachine";
+
+
+//----------------------------------------------------------------------------------------------------------
+enum class AnimAssetType : uint32_t
+{
+	UNKNOWN = 0,
+	ANIM_CLIP,
+	SKINNED_MESH,
+	ANIM_CONFIG,
+	ANIM_STATE_MACHINE,
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+struct AnimAssetTocEntry
+{
+	std::string	  m_name		   = "";
+	AnimAssetType m_type		   = AnimAssetType::UNKNOWN;
+	uint64_t	  m_offset		   = 0;
+	uint32_t	  m_compressedSize = 0;
+	uint32_t	  m_rawSize		   = 0;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+struct AnimAssetWriteBuffer
+{
+	std::vector<uint8_t> m_bytes;
+
+	void WriteBytes( void const* data, size_t numBytes );
+	void WriteString( std::string const& text );
+
+	template <typename T>
+	void Write( T const& value )
+	{
+		WriteBytes( &value, sizeof( T ) );
+	}
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+struct AnimAssetReadBuffer
+{
+	uint8_t const* m_data	 = nullptr;
+	size_t		   m_size	 = 0;
+	size_t		   m_cursor	 = 0;
+	bool		   m_isValid = true;
+
+	AnimAssetReadBuffer( std::vector<uint8_t> const& bytes );
+
+	bool		ReadBytes( void* out_data, size_t numBytes );
+	std::string ReadString();
+
+	template <typename T>
+	T Read()
+	{
+		T value = T();
+		ReadBytes( &value, sizeof( T ) );
+		return value;
+	}
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// one file holding every cooked animation asset, located through a table of contents
+class AnimAssetArchive
+{
+public:
+	AnimAssetArchive() {}
+	~AnimAssetArchive();
+
+	// writing (cooker)
+	void					 AddEntry( std::string const& name, AnimAssetType type, std::vector<uint8_t> const& rawBytes );
+	bool					 WriteToFile( std::string const& filePath ) const;
+
+	// reading (runtime)
+	bool					 OpenForRead( std::string const& filePath );
+	void					 Close();
+	bool					 IsOpen() const;
+	AnimAssetTocEntry const* FindEntry( std::string const& name ) const;
+	bool					 ReadEntry( std::string const& name, std::vector<uint8_t>& out_rawBytes );
+	size_t					 GetNumEntries() const;
+
+	// asset payloads
+	static void				 SerializeAnimClip( AnimAssetWriteBuffer& buffer, AnimClip const& clip );
+	static bool				 DeserializeAnimClip( AnimAssetReadBuffer& buffer, AnimClip& out_clip );
+	static void				 SerializeSkinnedMesh( AnimAssetWriteBuffer& buffer, std::vector<Vertex_PCUTBN> const& verts, std::vector<std::vector<std::pair<int, float>>> const& jointWeights );
+	static bool				 DeserializeSkinnedMesh( AnimAssetReadBuffer& buffer, std::vector<Vertex_PCUTBN>& out_verts, std::vector<std::vector<std::pair<int, float>>>& out_jointWeights );
+	bool					 LoadAnimClip( std::string const& clipFilePath, AnimClip& out_clip );
+	bool					 LoadSkinnedMesh( std::string const& meshFilePath, std::vector<Vertex_PCUTBN>& out_verts, std::vector<std::vector<std::pair<int, float>>>& out_jointWeights );
+	bool					 LoadStateMachineTable( std::string const& animConfigPath, AnimStateMachineTable& out_table );
+
+	// source hashes, cooked data derived from a source file is stale once the file's bytes change
+	static uint64_t			 HashBytes( std::vector<uint8_t> const& bytes );
+	static bool				 HashSourceFile( std::string const& filePath, uint64_t& out_hash );
+
+	// byte compression (lz77 style, literal runs and back references)
+	static void				 CompressBytes( std::vector<uint8_t> const& rawBytes, std::vector<uint8_t>& out_compressedBytes );
+	static bool				 DecompressBytes( uint8_t const* compressedBytes, size_t compressedSize, size_t rawSize, std::vector<uint8_t>& out_rawBytes );
+
+protected:
+	struct PendingEntry
+	{
+		AnimAssetTocEntry	 m_tocEntry;
+		std::vector<uint8_t> m_compressedBytes;
+	};
+	std::vector<PendingEntry>	   m_pendingEntries;
+
+	std::vector<AnimAssetTocEntry> m_tableOfContents;
+	FILE*						   m_file = nullptr;
+	std::mutex					   m_fileMutex;
+};
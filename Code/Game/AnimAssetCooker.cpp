@@ -0,0 +1,122 @@
+#include "Game/AnimAssetCooker.hpp"
+#include "Game/AnimAssetArchive.hpp"
+#include "Game/AnimStateMachineTable.hpp"
+
+#include "Engine/Animation/AnimClip.hpp"
+#include "Engine/Animation/FbxFileImporter.hpp"
+#include "Engine/Core/XmlUtils.hpp"
+#include "Engine/Core/StringUtils.hpp"
+#include "Engine/Core/ErrorWarningAssert.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <set>
+
+
+//----------------------------------------------------------------------------------------------------------
+bool AnimAssetCooker::IsCookRequested( std::string const& commandLine )
+{
+	return commandLine.find( COOK_COMMAND_LINE_FLAG ) != std::string::npos;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// usage: -cook [outputArchivePath]
+int AnimAssetCooker::RunFromCommandLine( std::string const& commandLine )
+{
+	std::string outputArchivePath = COOKED_ANIM_ARCHIVE_PATH;
+
+	Strings arguments = SplitStringOnDelimiter( commandLine, ' ' );
+	for ( size_t argIndex = 0; argIndex < arguments.size(); argIndex++ )
+	{
+		if ( arguments[ argIndex ] == COOK_COMMAND_LINE_FLAG && argIndex + 1 < arguments.size() && !arguments[ argIndex + 1 ].empty() )
+		{
+			outputArchivePath = arguments[ argIndex + 1 ];
+		}
+	}
+
+	bool succeeded = CookAnimConfig( "Data/Animations/AnimConfig.xml", "Data/Meshes/XBotTPose.fbx", outputArchivePath );
+	return succeeded ? 0 : 1;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool AnimAssetCooker::CookAnimConfig( std::string const& animConfigPath, std::string const& meshFilePath, std::string const& outputArchivePath )
+{
+	XmlDocument animConfigDocument;
+	if ( animConfigDocument.LoadFile( animConfigPath.c_str() ) != tinyxml2::XML_SUCCESS )
+	{
+		DebuggerPrintf( "Error: Cooker unable to load anim config: %s\n", animConfigPath.c_str() );
+		return false;
+	}
+
+	AnimAssetArchive archive;
+
+	// the config itself travels with the archive so the cooked data always matches its state graph
+	std::ifstream		 configFile( animConfigPath, std::ios::binary );
+	std::vector<uint8_t> configBytes( ( std::istreambuf_iterator<char>( configFile ) ), std::istreambuf_iterator<char>() );
+	archive.AddEntry( animConfigPath, AnimAssetType::ANIM_CONFIG, configBytes );
+
+	// and its state graph compiled into the flat table the runtime evaluates
+	AnimStateMachineTable stateMachineTable;
+	stateMachineTable.CompileFromXML( *animConfigDocument.RootElement() );
+
+	AnimAssetWriteBuffer stateMachineBuffer;
+	stateMachineBuffer.Write( AnimAssetArchive::HashBytes( configBytes ) );
+	stateMachineTable.Serialize( stateMachineBuffer );
+	archive.AddEntry( animConfigPath + COOKED_STATE_MACHINE_ENTRY_SUFFIX, AnimAssetType::ANIM_STATE_MACHINE, stateMachineBuffer.m_bytes );
+
+	// every distinct clip referenced by an animation state
+	std::set<std::string> clipFilePaths;
+	XmlElement const*	  animStateElement = animConfigDocument.RootElement()->FirstChildElement( "AnimationState" );
+	while ( animStateElement )
+	{
+		std::string clipFilePath = ParseXmlAttribute( *animStateElement, "clip", "" );
+		if ( !clipFilePath.empty() )
+		{
+			clipFilePaths.insert( clipFilePath );
+		}
+
+		animStateElement = animStateElement->NextSiblingElement( "AnimationState" );
+	}
+
+	for ( std::string const& clipFilePath : clipFilePaths )
+	{
+		AnimClip clip;
+		FbxFileImporter::LoadAnimClipFromFile( clipFilePath.c_str(), clip );
+		if ( clip.m_animChannels.empty() )
+		{
+			DebuggerPrintf( "Error: Cooker found no animation channels in clip: %s\n", clipFilePath.c_str() );
+			return false;
+		}
+
+		AnimAssetWriteBuffer clipBuffer;
+		AnimAssetArchive::SerializeAnimClip( clipBuffer, clip );
+		archive.AddEntry( clipFilePath, AnimAssetType::ANIM_CLIP, clipBuffer.m_bytes );
+	}
+
+	// skinned mesh
+	std::vector<Vertex_PCUTBN>						meshVerts;
+	std::vector<std::vector<std::pair<int, float>>> vertexJointWeights;
+	FbxFileImporter::LoadPreRiggedAndPreSkinnedMeshBindPoseFromFile( meshFilePath.c_str(), meshVerts, vertexJointWeights );
+
+	AnimAssetWriteBuffer meshBuffer;
+	AnimAssetArchive::SerializeSkinnedMesh( meshBuffer, meshVerts, vertexJointWeights );
+	archive.AddEntry( meshFilePath, AnimAssetType::SKINNED_MESH, meshBuffer.m_bytes );
+
+	std::filesystem::path outputDirectory = std::filesystem::path( outputArchivePath ).parent_path();
+	if ( !outputDirectory.empty() )
+	{
+		std::error_code errorCode;
+		std::filesystem::create_directories( outputDirectory, errorCode );
+	}
+
+	if ( !archive.WriteToFile( outputArchivePath ) )
+	{
+		return false;
+	}
+
+	DebuggerPrintf( "Cooked %d clips and 1 mesh into %s\n", ( int ) clipFilePaths.size(), outputArchivePath.c_str() );
+	return true;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <string>
+
+
+//----------------------------------------------------------------------------------------------------------
+char const* const COOK_COMMAND_LINE_FLAG = "-cook";
+
+
+//----------------------------------------------------------------------------------------------------------
+// offline step: resolves every clip referenced by the anim config plus the skinned mesh and packs them into
+// a single compressed archive, so the runtime opens one file instead of one fbx per animation state
+class AnimAssetCooker
+{
+public:
+	static bool IsCookRequested( std::string const& commandLine );
+	static int	RunFromCommandLine( std::string const& commandLine );
+	static bool CookAnimConfig( std::string const& animConfigPath, std::string const& meshFilePath, std::string const& outputArchivePath );
+};
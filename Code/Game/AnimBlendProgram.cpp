@@ -0,0 +1,148 @@
+#include "Game/AnimBlendProgram.hpp"
+
+#include "Engine/Animation/AnimClip.hpp"
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimBlendProgram::Startup( AnimPose const& skeletonPose )
+{
+	m_skeletonPose = skeletonPose;
+	m_registers.clear();
+	Clear();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// keeps the instruction capacity and the registers, only the program is forgotten
+void AnimBlendProgram::Clear()
+{
+	m_instructions.clear();
+	m_numRegistersUsed = 0;
+	m_resultRegister   = -1;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+int AnimBlendProgram::EmitSampleClip( AnimClip* clip, float timeMs )
+{
+	AnimBlendInstruction instruction;
+	instruction.m_op	 = AnimBlendOp::SAMPLE_CLIP;
+	instruction.m_clip	 = clip;
+	instruction.m_timeMs = timeMs;
+
+	return EmitInstruction( instruction );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+int AnimBlendProgram::EmitBlend( int registerA, int registerB, float weight, int maskJoint )
+{
+	AnimBlendInstruction instruction;
+	instruction.m_op		= AnimBlendOp::BLEND;
+	instruction.m_sourceA	= registerA;
+	instruction.m_sourceB	= registerB;
+	instruction.m_weight	= weight;
+	instruction.m_maskJoint = maskJoint;
+
+	return EmitInstruction( instruction );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+int AnimBlendProgram::EmitDifference( int registerA, int referenceRegister )
+{
+	AnimBlendInstruction instruction;
+	instruction.m_op	  = AnimBlendOp::DIFFERENCE;
+	instruction.m_sourceA = registerA;
+	instruction.m_sourceB = referenceRegister;
+
+	return EmitInstruction( instruction );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// a partial additive is the full addition blended back towards the base
+int AnimBlendProgram::EmitAdd( int baseRegister, int differenceRegister, float weight )
+{
+	AnimBlendInstruction instruction;
+	instruction.m_op	  = AnimBlendOp::ADD;
+	instruction.m_sourceA = baseRegister;
+	instruction.m_sourceB = differenceRegister;
+
+	int addedRegister = EmitInstruction( instruction );
+	if ( weight >= 1.f )
+	{
+		return addedRegister;
+	}
+
+	return EmitBlend( baseRegister, addedRegister, weight );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+int AnimBlendProgram::EmitInstruction( AnimBlendInstruction& instruction )
+{
+	instruction.m_target = AllocateRegister();
+	m_instructions.push_back( instruction );
+	m_resultRegister = instruction.m_target;
+
+	return instruction.m_target;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+int AnimBlendProgram::AllocateRegister()
+{
+	if ( m_numRegistersUsed == ( int ) m_registers.size() )
+	{
+		m_registers.push_back( m_skeletonPose );
+	}
+
+	return m_numRegistersUsed++;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimBlendProgram::Execute()
+{
+	for ( AnimBlendInstruction const& instruction : m_instructions )
+	{
+		AnimPose& targetPose = m_registers[ instruction.m_target ];
+		switch ( instruction.m_op )
+		{
+			case AnimBlendOp::SAMPLE_CLIP:
+				instruction.m_clip->Sample( instruction.m_timeMs, targetPose );
+				break;
+			case AnimBlendOp::BLEND:
+				AnimPose::Blend( targetPose, m_registers[ instruction.m_sourceA ], m_registers[ instruction.m_sourceB ], instruction.m_weight, instruction.m_maskJoint );
+				break;
+			case AnimBlendOp::DIFFERENCE:
+				m_registers[ instruction.m_sourceA ].GetDifference( m_registers[ instruction.m_sourceB ], targetPose );
+				break;
+			case AnimBlendOp::ADD:
+				m_registers[ instruction.m_sourceA ].GetAddition( m_registers[ instruction.m_sourceB ], targetPose );
+				break;
+			default:
+				break;
+		}
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+AnimPose const& AnimBlendProgram::GetResultPose() const
+{
+	if ( m_resultRegister < 0 )
+	{
+		return m_skeletonPose;
+	}
+
+	return m_registers[ m_resultRegister ];
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+int AnimBlendProgram::GetNumInstructions() const
+{
+	return ( int ) m_instructions.size();
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Engine/Animation/AnimPose.hpp"
+
+#include <cstdint>
+#include <vector>
+
+class AnimClip;
+
+
+//----------------------------------------------------------------------------------------------------------
+enum class AnimBlendOp : uint32_t
+{
+	SAMPLE_CLIP, // target = clip sampled at m_timeMs
+	BLEND,		 // target = lerp( sourceA, sourceB, m_weight ), masked to a subtree when m_maskJoint is not -1
+	DIFFERENCE,	 // target = sourceA - sourceB
+	ADD,		 // target = sourceA + sourceB
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+struct AnimBlendInstruction
+{
+	AnimBlendOp m_op		= AnimBlendOp::SAMPLE_CLIP;
+	int			m_target	= 0;
+	int			m_sourceA	= 0;
+	int			m_sourceB	= 0;
+	AnimClip*	m_clip		= nullptr;
+	float		m_timeMs	= 0.f;
+	float		m_weight	= 0.f;
+	int			m_maskJoint = -1;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// a blend graph flattened into a list of instructions over a small file of pose registers, executed in order
+// with a switch instead of walking virtual nodes that each own a pose; the controller re-emits it every pose
+// update into the same storage, so once the register file has grown nothing is allocated
+class AnimBlendProgram
+{
+public:
+	void							  Startup( AnimPose const& skeletonPose );
+	void							  Clear();
+	int								  EmitSampleClip( AnimClip* clip, float timeMs );
+	int								  EmitBlend( int registerA, int registerB, float weight, int maskJoint = -1 );
+	int								  EmitDifference( int registerA, int referenceRegister );
+	int								  EmitAdd( int baseRegister, int differenceRegister, float weight = 1.f );
+	void							  Execute();
+	AnimPose const&					  GetResultPose() const;
+	int								  GetNumInstructions() const;
+
+	std::vector<AnimBlendInstruction> m_instructions;
+	int								  m_resultRegister = -1;
+
+	// registers are handed out in emit order and never shared, a frame's program touches a few poses at most
+	std::vector<AnimPose>			  m_registers;
+	int								  m_numRegistersUsed = 0;
+	AnimPose						  m_skeletonPose;
+	int								  AllocateRegister();
+	int								  EmitInstruction( AnimBlendInstruction& instruction );
+};
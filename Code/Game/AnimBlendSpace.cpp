@@ -0,0 +1,646 @@
+#include "Game/AnimBlendSpace.hpp"
+#include "Game/AnimBlendProgram.hpp"
+#include "Game/AnimationState.hpp"
+
+#include "Engine/Animation/AnimClip.hpp"
+#include "Engine/Core/ErrorWarningAssert.hpp"
+
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+
+
+//----------------------------------------------------------------------------------------------------------
+// weights this small are dropped, so a clip sitting exactly on a sample is sampled once
+constexpr float MIN_BLEND_SPACE_WEIGHT = 0.001f;
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimBlendSpaceTriangle::GetBarycentricWeights( Vec2 const& point, float out_weights[ 3 ] ) const
+{
+	Vec2 toPoint	 = point - m_origin;
+	out_weights[ 1 ] = ( toPoint.x * m_edgeC.y - toPoint.y * m_edgeC.x ) * m_inverseDeterminant;
+	out_weights[ 2 ] = ( m_edgeB.x * toPoint.y - m_edgeB.y * toPoint.x ) * m_inverseDeterminant;
+	out_weights[ 0 ] = 1.f - out_weights[ 1 ] - out_weights[ 2 ];
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+static void AddBlendSpaceWeight( AnimBlendSpaceWeights& weights, int sampleIndex, float weight )
+{
+	if ( weight < MIN_BLEND_SPACE_WEIGHT || weights.m_numSamples >= MAX_BLEND_SPACE_WEIGHTS )
+	{
+		return;
+	}
+
+	weights.m_sampleIndices[ weights.m_numSamples ] = sampleIndex;
+	weights.m_weights[ weights.m_numSamples ]		= weight;
+	weights.m_numSamples++;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+static void NormalizeBlendSpaceWeights( AnimBlendSpaceWeights& weights )
+{
+	float totalWeight = 0.f;
+	for ( int weightIndex = 0; weightIndex < weights.m_numSamples; weightIndex++ )
+	{
+		totalWeight += weights.m_weights[ weightIndex ];
+	}
+
+	if ( totalWeight <= 0.f )
+	{
+		return;
+	}
+
+	for ( int weightIndex = 0; weightIndex < weights.m_numSamples; weightIndex++ )
+	{
+		weights.m_weights[ weightIndex ] /= totalWeight;
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimBlendSpace::Clear()
+{
+	m_samples.clear();
+	m_parameterXName = "speed";
+	m_parameterYName = "";
+	m_syncGroupId	 = INVALID_ANIM_NAME_ID;
+	m_triangles.clear();
+	m_trianglesByCell.clear();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// <BlendSpace parameterX="speed" parameterY="direction" syncGroup="locomotion">
+//     <Sample state="walk" x="2.0" y="0.0"/>
+// </BlendSpace>
+void AnimBlendSpace::LoadFromXML( XmlElement const& animStateElement )
+{
+	Clear();
+
+	XmlElement const* blendSpaceElement = animStateElement.FirstChildElement( "BlendSpace" );
+	if ( !blendSpaceElement )
+	{
+		return;
+	}
+
+	m_parameterXName		  = ParseXmlAttribute( *blendSpaceElement, "parameterX", m_parameterXName );
+	m_parameterYName		  = ParseXmlAttribute( *blendSpaceElement, "parameterY", m_parameterYName );
+	std::string syncGroupName = ParseXmlAttribute( *blendSpaceElement, "syncGroup", "" );
+	if ( !syncGroupName.empty() )
+	{
+		m_syncGroupId = AnimNameTable::Intern( syncGroupName );
+	}
+
+	XmlElement const* sampleElement = blendSpaceElement->FirstChildElement( "Sample" );
+	while ( sampleElement )
+	{
+		std::string stateName = ParseXmlAttribute( *sampleElement, "state", "" );
+		if ( stateName.empty() )
+		{
+			DebuggerPrintf( "Error: Blend space sample without a state\n" );
+		}
+		else
+		{
+			AnimBlendSpaceSample sample;
+			sample.m_stateNameId = AnimNameTable::Intern( stateName );
+			sample.m_position	 = Vec2( ParseXmlAttribute( *sampleElement, "x", 0.f ), ParseXmlAttribute( *sampleElement, "y", 0.f ) );
+			m_samples.push_back( sample );
+		}
+
+		sampleElement = sampleElement->NextSiblingElement( "Sample" );
+	}
+
+	std::sort( m_samples.begin(), m_samples.end(), []( AnimBlendSpaceSample const& sampleA, AnimBlendSpaceSample const& sampleB )
+		{
+			if ( sampleA.m_position.x != sampleB.m_position.x )
+			{
+				return sampleA.m_position.x < sampleB.m_position.x;
+			}
+			return sampleA.m_position.y < sampleB.m_position.y;
+		} );
+
+	if ( !m_parameterYName.empty() && m_samples.size() >= 3 )
+	{
+		Triangulate();
+		if ( m_triangles.empty() )
+		{
+			DebuggerPrintf( "Error: Blend space samples are collinear, blending along %s only\n", m_parameterXName.c_str() );
+			return;
+		}
+
+		BuildLookupGrid();
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool AnimBlendSpace::IsEmpty() const
+{
+	return m_samples.empty();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool AnimBlendSpace::Is2D() const
+{
+	return !m_triangles.empty();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// samples name other states, which may be declared later in the config
+bool AnimBlendSpace::AreSamplesResolved() const
+{
+	std::vector<AnimationState*> const& statesById = AnimationState::s_animationStatesById;
+	for ( AnimBlendSpaceSample const& sample : m_samples )
+	{
+		if ( sample.m_stateNameId < 0 || sample.m_stateNameId >= ( AnimNameId ) statesById.size() || !statesById[ sample.m_stateNameId ] )
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+int AnimBlendSpace::FindSampleIndex( AnimNameId stateNameId ) const
+{
+	for ( int sampleIndex = 0; sampleIndex < ( int ) m_samples.size(); sampleIndex++ )
+	{
+		if ( m_samples[ sampleIndex ].m_stateNameId == stateNameId )
+		{
+			return sampleIndex;
+		}
+	}
+
+	return -1;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimBlendSpace::GetWeights( Vec2 const& parameters, AnimBlendSpaceWeights& out_weights ) const
+{
+	out_weights.m_numSamples = 0;
+
+	if ( Is2D() )
+	{
+		GetWeights2D( parameters, out_weights );
+	}
+	else
+	{
+		GetWeights1D( parameters.x, out_weights );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimBlendSpace::GetWeights1D( float parameter, AnimBlendSpaceWeights& out_weights ) const
+{
+	if ( m_samples.empty() )
+	{
+		return;
+	}
+
+	// clamped to the ends of the line
+	int lastSampleIndex = ( int ) m_samples.size() - 1;
+	if ( parameter <= m_samples[ 0 ].m_position.x )
+	{
+		AddBlendSpaceWeight( out_weights, 0, 1.f );
+		return;
+	}
+	if ( parameter >= m_samples[ lastSampleIndex ].m_position.x )
+	{
+		AddBlendSpaceWeight( out_weights, lastSampleIndex, 1.f );
+		return;
+	}
+
+	auto upperIter = std::upper_bound( m_samples.begin(), m_samples.end(), parameter, []( float value, AnimBlendSpaceSample const& sample )
+		{
+			return value < sample.m_position.x;
+		} );
+	int	  upperIndex   = ( int ) ( upperIter - m_samples.begin() );
+	int	  lowerIndex   = upperIndex - 1;
+	float lowerX	   = m_samples[ lowerIndex ].m_position.x;
+	float upperX	   = m_samples[ upperIndex ].m_position.x;
+	float upperWeight  = ( upperX > lowerX ) ? ( parameter - lowerX ) / ( upperX - lowerX ) : 0.f;
+
+	AddBlendSpaceWeight( out_weights, lowerIndex, 1.f - upperWeight );
+	AddBlendSpaceWeight( out_weights, upperIndex, upperWeight );
+	NormalizeBlendSpaceWeights( out_weights );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimBlendSpace::GetWeights2D( Vec2 const& parameters, AnimBlendSpaceWeights& out_weights ) const
+{
+	float barycentricWeights[ 3 ];
+	float const insideTolerance = -0.0001f;
+
+	AnimBlendSpaceTriangle const* containingTriangle = nullptr;
+	for ( int triangleIndex : m_trianglesByCell[ GetCellIndex( parameters ) ] )
+	{
+		m_triangles[ triangleIndex ].GetBarycentricWeights( parameters, barycentricWeights );
+		if ( barycentricWeights[ 0 ] >= insideTolerance && barycentricWeights[ 1 ] >= insideTolerance && barycentricWeights[ 2 ] >= insideTolerance )
+		{
+			containingTriangle = &m_triangles[ triangleIndex ];
+			break;
+		}
+	}
+
+	// outside the hull, use the triangle the point is least outside of and clamp its weights
+	if ( !containingTriangle )
+	{
+		float bestMinWeight = -FLT_MAX;
+		for ( AnimBlendSpaceTriangle const& triangle : m_triangles )
+		{
+			triangle.GetBarycentricWeights( parameters, barycentricWeights );
+			float minWeight = std::min( barycentricWeights[ 0 ], std::min( barycentricWeights[ 1 ], barycentricWeights[ 2 ] ) );
+			if ( minWeight > bestMinWeight )
+			{
+				bestMinWeight	   = minWeight;
+				containingTriangle = &triangle;
+			}
+		}
+	}
+
+	containingTriangle->GetBarycentricWeights( parameters, barycentricWeights );
+	for ( int cornerIndex = 0; cornerIndex < 3; cornerIndex++ )
+	{
+		AddBlendSpaceWeight( out_weights, containingTriangle->m_sampleIndices[ cornerIndex ], barycentricWeights[ cornerIndex ] );
+	}
+	NormalizeBlendSpaceWeights( out_weights );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+struct DelaunayTriangle
+{
+	int	  m_indices[ 3 ]		  = { 0, 0, 0 };
+	Vec2  m_circumcenter;
+	float m_circumradiusSquared = 0.f;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+static bool MakeDelaunayTriangle( std::vector<Vec2> const& points, int indexA, int indexB, int indexC, DelaunayTriangle& out_triangle )
+{
+	Vec2 const& pointA		= points[ indexA ];
+	Vec2 const& pointB		= points[ indexB ];
+	Vec2 const& pointC		= points[ indexC ];
+	float		determinant = 2.f * ( pointA.x * ( pointB.y - pointC.y ) + pointB.x * ( pointC.y - pointA.y ) + pointC.x * ( pointA.y - pointB.y ) );
+	if ( fabsf( determinant ) < 0.000001f )
+	{
+		return false;
+	}
+
+	float lengthSquaredA = pointA.x * pointA.x + pointA.y * pointA.y;
+	float lengthSquaredB = pointB.x * pointB.x + pointB.y * pointB.y;
+	float lengthSquaredC = pointC.x * pointC.x + pointC.y * pointC.y;
+	float centerX		 = ( lengthSquaredA * ( pointB.y - pointC.y ) + lengthSquaredB * ( pointC.y - pointA.y ) + lengthSquaredC * ( pointA.y - pointB.y ) ) / determinant;
+	float centerY		 = ( lengthSquaredA * ( pointC.x - pointB.x ) + lengthSquaredB * ( pointA.x - pointC.x ) + lengthSquaredC * ( pointB.x - pointA.x ) ) / determinant;
+
+	out_triangle.m_indices[ 0 ]		   = indexA;
+	out_triangle.m_indices[ 1 ]		   = indexB;
+	out_triangle.m_indices[ 2 ]		   = indexC;
+	out_triangle.m_circumcenter		   = Vec2( centerX, centerY );
+	out_triangle.m_circumradiusSquared = ( pointA.x - centerX ) * ( pointA.x - centerX ) + ( pointA.y - centerY ) * ( pointA.y - centerY );
+
+	return true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// bowyer watson, run once at load; the parameters are remapped to a unit square first so that a speed axis and
+// a direction axis in degrees don't skew which triangles come out
+void AnimBlendSpace::Triangulate()
+{
+	m_triangles.clear();
+
+	int numSamples = ( int ) m_samples.size();
+	m_boundsMins   = m_samples[ 0 ].m_position;
+	m_boundsMaxs   = m_samples[ 0 ].m_position;
+	for ( AnimBlendSpaceSample const& sample : m_samples )
+	{
+		m_boundsMins.x = std::min( m_boundsMins.x, sample.m_position.x );
+		m_boundsMins.y = std::min( m_boundsMins.y, sample.m_position.y );
+		m_boundsMaxs.x = std::max( m_boundsMaxs.x, sample.m_position.x );
+		m_boundsMaxs.y = std::max( m_boundsMaxs.y, sample.m_position.y );
+	}
+
+	float extentX = m_boundsMaxs.x - m_boundsMins.x;
+	float extentY = m_boundsMaxs.y - m_boundsMins.y;
+	if ( extentX <= 0.f || extentY <= 0.f )
+	{
+		return;
+	}
+
+	// unit square points followed by a super triangle enclosing all of them
+	std::vector<Vec2> points;
+	points.reserve( numSamples + 3 );
+	for ( AnimBlendSpaceSample const& sample : m_samples )
+	{
+		points.push_back( Vec2( ( sample.m_position.x - m_boundsMins.x ) / extentX, ( sample.m_position.y - m_boundsMins.y ) / extentY ) );
+	}
+	points.push_back( Vec2( -10.f, -10.f ) );
+	points.push_back( Vec2( 30.f, -10.f ) );
+	points.push_back( Vec2( -10.f, 30.f ) );
+
+	std::vector<DelaunayTriangle> triangles;
+	DelaunayTriangle			  superTriangle;
+	MakeDelaunayTriangle( points, numSamples, numSamples + 1, numSamples + 2, superTriangle );
+	triangles.push_back( superTriangle );
+
+	std::vector<std::pair<int, int>> cavityEdges;
+	for ( int pointIndex = 0; pointIndex < numSamples; pointIndex++ )
+	{
+		Vec2 const& point = points[ pointIndex ];
+
+		// remove every triangle whose circumcircle holds the point, keeping the edges of the cavity
+		cavityEdges.clear();
+		for ( int triangleIndex = ( int ) triangles.size() - 1; triangleIndex >= 0; triangleIndex-- )
+		{
+			DelaunayTriangle const& triangle	   = triangles[ triangleIndex ];
+			float					offsetX		   = point.x - triangle.m_circumcenter.x;
+			float					offsetY		   = point.y - triangle.m_circumcenter.y;
+			if ( offsetX * offsetX + offsetY * offsetY < triangle.m_circumradiusSquared )
+			{
+				for ( int edgeIndex = 0; edgeIndex < 3; edgeIndex++ )
+				{
+					cavityEdges.push_back( std::make_pair( triangle.m_indices[ edgeIndex ], triangle.m_indices[ ( edgeIndex + 1 ) % 3 ] ) );
+				}
+				triangles.erase( triangles.begin() + triangleIndex );
+			}
+		}
+
+		// edges shared by two removed triangles are inside the cavity, the rest are fanned to the point
+		for ( size_t edgeIndex = 0; edgeIndex < cavityEdges.size(); edgeIndex++ )
+		{
+			std::pair<int, int> const& edge		  = cavityEdges[ edgeIndex ];
+			bool					   isShared = false;
+			for ( size_t otherIndex = 0; otherIndex < cavityEdges.size(); otherIndex++ )
+			{
+				std::pair<int, int> const& otherEdge = cavityEdges[ otherIndex ];
+				if ( otherIndex != edgeIndex && otherEdge.first == edge.second && otherEdge.second == edge.first )
+				{
+					isShared = true;
+					break;
+				}
+			}
+
+			DelaunayTriangle newTriangle;
+			if ( !isShared && MakeDelaunayTriangle( points, edge.first, edge.second, pointIndex, newTriangle ) )
+			{
+				triangles.push_back( newTriangle );
+			}
+		}
+	}
+
+	// triangles touching the super triangle are outside the hull of the samples
+	for ( DelaunayTriangle const& triangle : triangles )
+	{
+		if ( triangle.m_indices[ 0 ] >= numSamples || triangle.m_indices[ 1 ] >= numSamples || triangle.m_indices[ 2 ] >= numSamples )
+		{
+			continue;
+		}
+
+		AnimBlendSpaceTriangle blendSpaceTriangle;
+		for ( int cornerIndex = 0; cornerIndex < 3; cornerIndex++ )
+		{
+			blendSpaceTriangle.m_sampleIndices[ cornerIndex ] = triangle.m_indices[ cornerIndex ];
+		}
+
+		blendSpaceTriangle.m_origin = m_samples[ triangle.m_indices[ 0 ] ].m_position;
+		blendSpaceTriangle.m_edgeB	= m_samples[ triangle.m_indices[ 1 ] ].m_position - blendSpaceTriangle.m_origin;
+		blendSpaceTriangle.m_edgeC	= m_samples[ triangle.m_indices[ 2 ] ].m_position - blendSpaceTriangle.m_origin;
+
+		float determinant = blendSpaceTriangle.m_edgeB.x * blendSpaceTriangle.m_edgeC.y - blendSpaceTriangle.m_edgeB.y * blendSpaceTriangle.m_edgeC.x;
+		if ( fabsf( determinant ) < 0.000001f )
+		{
+			continue;
+		}
+
+		blendSpaceTriangle.m_inverseDeterminant = 1.f / determinant;
+		m_triangles.push_back( blendSpaceTriangle );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimBlendSpace::BuildLookupGrid()
+{
+	m_trianglesByCell.clear();
+	m_trianglesByCell.resize( LOOKUP_GRID_SIZE * LOOKUP_GRID_SIZE );
+
+	for ( int triangleIndex = 0; triangleIndex < ( int ) m_triangles.size(); triangleIndex++ )
+	{
+		AnimBlendSpaceTriangle const& triangle = m_triangles[ triangleIndex ];
+		Vec2						  cornerB  = triangle.m_origin + triangle.m_edgeB;
+		Vec2						  cornerC  = triangle.m_origin + triangle.m_edgeC;
+		Vec2						  mins( std::min( triangle.m_origin.x, std::min( cornerB.x, cornerC.x ) ), std::min( triangle.m_origin.y, std::min( cornerB.y, cornerC.y ) ) );
+		Vec2						  maxs( std::max( triangle.m_origin.x, std::max( cornerB.x, cornerC.x ) ), std::max( triangle.m_origin.y, std::max( cornerB.y, cornerC.y ) ) );
+
+		// every cell the triangle's bounds overlap lists it as a candidate
+		int minCellIndex = GetCellIndex( mins );
+		int maxCellIndex = GetCellIndex( maxs );
+		for ( int cellY = minCellIndex / LOOKUP_GRID_SIZE; cellY <= maxCellIndex / LOOKUP_GRID_SIZE; cellY++ )
+		{
+			for ( int cellX = minCellIndex % LOOKUP_GRID_SIZE; cellX <= maxCellIndex % LOOKUP_GRID_SIZE; cellX++ )
+			{
+				m_trianglesByCell[ cellY * LOOKUP_GRID_SIZE + cellX ].push_back( triangleIndex );
+			}
+		}
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// points outside the bounds land in the nearest border cell
+int AnimBlendSpace::GetCellIndex( Vec2 const& point ) const
+{
+	float fractionX = ( point.x - m_boundsMins.x ) / ( m_boundsMaxs.x - m_boundsMins.x );
+	float fractionY = ( point.y - m_boundsMins.y ) / ( m_boundsMaxs.y - m_boundsMins.y );
+	int	  cellX		= std::max( 0, std::min( ( int ) floorf( fractionX * ( float ) LOOKUP_GRID_SIZE ), LOOKUP_GRID_SIZE - 1 ) );
+	int	  cellY		= std::max( 0, std::min( ( int ) floorf( fractionY * ( float ) LOOKUP_GRID_SIZE ), LOOKUP_GRID_SIZE - 1 ) );
+
+	return cellY * LOOKUP_GRID_SIZE + cellX;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+AnimBlendSpacePlayer::AnimBlendSpacePlayer( AnimBlendSpace const& blendSpace, AnimPose const& skeletonPose )
+	: m_blendSpace( blendSpace ), m_skeletonPose( skeletonPose )
+{
+	m_sampleNodes.resize( m_blendSpace.m_samples.size(), nullptr );
+	m_sampleClipVersions.resize( m_blendSpace.m_samples.size(), -1 );
+
+	m_pairLerpNode.m_blendedPose	 = skeletonPose;
+	m_triangleLerpNode.m_blendedPose = skeletonPose;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+AnimBlendSpacePlayer::~AnimBlendSpacePlayer()
+{
+	// the lerp nodes are members and only borrow the sample nodes
+	m_pairLerpNode.m_childNodeA		= nullptr;
+	m_pairLerpNode.m_childNodeB		= nullptr;
+	m_triangleLerpNode.m_childNodeA = nullptr;
+	m_triangleLerpNode.m_childNodeB = nullptr;
+
+	for ( AnimClipNode* sampleNode : m_sampleNodes )
+	{
+		delete sampleNode;
+	}
+	m_sampleNodes.clear();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimBlendSpacePlayer::UpdateWeights( Vec2 const& parameters )
+{
+	m_blendSpace.GetWeights( parameters, m_weights );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// the length of one blended cycle, the owning instance scales its playback rate by it to keep the samples in phase
+float AnimBlendSpacePlayer::GetWeightedDurationMs() const
+{
+	float weightedDurationMs = 0.f;
+	for ( int weightIndex = 0; weightIndex < m_weights.m_numSamples; weightIndex++ )
+	{
+		AnimClip* clip		= GetSampleState( m_weights.m_sampleIndices[ weightIndex ] )->GetClip();
+		weightedDurationMs += m_weights.m_weights[ weightIndex ] * ( clip->GetEndTime() - clip->GetStartTime() );
+	}
+
+	return weightedDurationMs;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// all samples share the normalized phase, only the weighted ones are sampled
+void AnimBlendSpacePlayer::Update( float parametricZeroToOne )
+{
+	for ( int weightIndex = 0; weightIndex < m_weights.m_numSamples; weightIndex++ )
+	{
+		GetSampleNode( m_weights.m_sampleIndices[ weightIndex ] )->Update( parametricZeroToOne );
+	}
+
+	if ( m_weights.m_numSamples < 2 )
+	{
+		return;
+	}
+
+	float weightA				= m_weights.m_weights[ 0 ];
+	float weightB				= m_weights.m_weights[ 1 ];
+	m_pairLerpNode.m_childNodeA = GetSampleNode( m_weights.m_sampleIndices[ 0 ] );
+	m_pairLerpNode.m_childNodeB = GetSampleNode( m_weights.m_sampleIndices[ 1 ] );
+	m_pairLerpNode.Update( weightB / ( weightA + weightB ) );
+
+	if ( m_weights.m_numSamples < 3 )
+	{
+		return;
+	}
+
+	m_triangleLerpNode.m_childNodeA = &m_pairLerpNode;
+	m_triangleLerpNode.m_childNodeB = GetSampleNode( m_weights.m_sampleIndices[ 2 ] );
+	m_triangleLerpNode.Update( m_weights.m_weights[ 2 ] );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+AnimBlendNode* AnimBlendSpacePlayer::GetRootNode()
+{
+	if ( m_weights.m_numSamples == 3 )
+	{
+		return &m_triangleLerpNode;
+	}
+
+	if ( m_weights.m_numSamples == 2 )
+	{
+		return &m_pairLerpNode;
+	}
+
+	return GetSampleNode( m_weights.m_sampleIndices[ 0 ] );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+AnimPose const& AnimBlendSpacePlayer::GetBlendedPose()
+{
+	if ( m_weights.m_numSamples == 3 )
+	{
+		return m_triangleLerpNode.m_blendedPose;
+	}
+
+	if ( m_weights.m_numSamples == 2 )
+	{
+		return m_pairLerpNode.m_blendedPose;
+	}
+
+	return GetSampleNode( m_weights.m_sampleIndices[ 0 ] )->m_sampledPose;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// the same ( a lerp b ) lerp c, as instructions sampling the clips straight into registers
+int AnimBlendSpacePlayer::EmitToBlendProgram( AnimBlendProgram& program, float parametricZeroToOne )
+{
+	int numSamples = std::max( m_weights.m_numSamples, 1 );
+	int sampleRegisters[ MAX_BLEND_SPACE_WEIGHTS ];
+	for ( int weightIndex = 0; weightIndex < numSamples; weightIndex++ )
+	{
+		AnimClip* clip					= GetSampleState( m_weights.m_sampleIndices[ weightIndex ] )->GetClip();
+		float	  sampleTimeMs			= clip->GetStartTime() + parametricZeroToOne * ( clip->GetEndTime() - clip->GetStartTime() );
+		sampleRegisters[ weightIndex ] = program.EmitSampleClip( clip, sampleTimeMs );
+	}
+
+	if ( numSamples < 2 )
+	{
+		return sampleRegisters[ 0 ];
+	}
+
+	float weightA	   = m_weights.m_weights[ 0 ];
+	float weightB	   = m_weights.m_weights[ 1 ];
+	int	  pairRegister = program.EmitBlend( sampleRegisters[ 0 ], sampleRegisters[ 1 ], weightB / ( weightA + weightB ) );
+	if ( numSamples < 3 )
+	{
+		return pairRegister;
+	}
+
+	return program.EmitBlend( pairRegister, sampleRegisters[ 2 ], m_weights.m_weights[ 2 ] );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+AnimClipNode* AnimBlendSpacePlayer::GetSampleNode( int sampleIndex )
+{
+	AnimationState* sampleState = GetSampleState( sampleIndex );
+	AnimClip*		clip		= sampleState->GetClip();
+
+	AnimClipNode*& sampleNode = m_sampleNodes[ sampleIndex ];
+	if ( sampleNode && m_sampleClipVersions[ sampleIndex ] == sampleState->m_clipVersion )
+	{
+		return sampleNode;
+	}
+
+	// the lerp nodes take their children again on every update, nothing else keeps the old node
+	delete sampleNode;
+	sampleNode							= new AnimClipNode( *clip );
+	sampleNode->m_sampledPose			= m_skeletonPose;
+	m_sampleClipVersions[ sampleIndex ] = sampleState->m_clipVersion;
+
+	return sampleNode;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+AnimationState* AnimBlendSpacePlayer::GetSampleState( int sampleIndex ) const
+{
+	return AnimationState::GetAnimationStateById( m_blendSpace.m_samples[ sampleIndex ].m_stateNameId );
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "Game/AnimNameTable.hpp"
+
+#include "Engine/Animation/AnimBlendNode.hpp"
+#include "Engine/Core/XmlUtils.hpp"
+#include "Engine/Math/Vec2.hpp"
+
+#include <vector>
+
+class AnimationState;
+class AnimBlendProgram;
+
+
+//----------------------------------------------------------------------------------------------------------
+constexpr int MAX_BLEND_SPACE_WEIGHTS = 3;
+
+
+//----------------------------------------------------------------------------------------------------------
+struct AnimBlendSpaceSample
+{
+	AnimNameId m_stateNameId = INVALID_ANIM_NAME_ID;
+	Vec2	   m_position;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// barycentric coordinates of a point are two cross products against the precomputed edges
+struct AnimBlendSpaceTriangle
+{
+	int	  m_sampleIndices[ 3 ] = { 0, 0, 0 };
+	Vec2  m_origin;
+	Vec2  m_edgeB;
+	Vec2  m_edgeC;
+	float m_inverseDeterminant = 0.f;
+	void  GetBarycentricWeights( Vec2 const& point, float out_weights[ 3 ] ) const;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+struct AnimBlendSpaceWeights
+{
+	int	  m_numSamples								 = 0;
+	int	  m_sampleIndices[ MAX_BLEND_SPACE_WEIGHTS ] = { 0, 0, 0 };
+	float m_weights[ MAX_BLEND_SPACE_WEIGHTS ]		 = { 0.f, 0.f, 0.f };
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// clips of other animation states placed on a 1D line or 2D plane of parameters (speed, direction), the
+// triangulation and a grid of candidate triangles are built once at load, so a lookup touches a handful of
+// triangles and never weights more than three clips
+class AnimBlendSpace
+{
+public:
+	void							   Clear();
+	void							   LoadFromXML( XmlElement const& animStateElement );
+	void							   GetWeights( Vec2 const& parameters, AnimBlendSpaceWeights& out_weights ) const;
+	bool							   IsEmpty() const;
+	bool							   Is2D() const;
+	bool							   AreSamplesResolved() const;
+	int								   FindSampleIndex( AnimNameId stateNameId ) const;
+
+	std::vector<AnimBlendSpaceSample>  m_samples;
+	std::string						   m_parameterXName = "speed";
+	std::string						   m_parameterYName = "";
+
+	// states whose blend spaces share a sync group hand their phase over on transitions between them
+	AnimNameId						   m_syncGroupId	= INVALID_ANIM_NAME_ID;
+
+	// 1D, samples sorted along x
+	void							   GetWeights1D( float parameter, AnimBlendSpaceWeights& out_weights ) const;
+
+	// 2D, delaunay triangulation with a uniform lookup grid over the samples' bounds
+	static constexpr int			   LOOKUP_GRID_SIZE = 8;
+	std::vector<AnimBlendSpaceTriangle> m_triangles;
+	Vec2							   m_boundsMins;
+	Vec2							   m_boundsMaxs;
+	std::vector<std::vector<int>>	   m_trianglesByCell;
+	void							   Triangulate();
+	void							   BuildLookupGrid();
+	int								   GetCellIndex( Vec2 const& point ) const;
+	void							   GetWeights2D( Vec2 const& parameters, AnimBlendSpaceWeights& out_weights ) const;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// per instance evaluation of a blend space, every sample clip is played at the same normalized phase and at most
+// three of them are sampled and lerped each frame
+class AnimBlendSpacePlayer
+{
+public:
+	AnimBlendSpacePlayer( AnimBlendSpace const& blendSpace, AnimPose const& skeletonPose );
+	AnimBlendSpacePlayer( AnimBlendSpacePlayer const& copy ) = delete;
+	~AnimBlendSpacePlayer();
+
+	AnimBlendSpace const&	   m_blendSpace;
+	AnimBlendSpaceWeights	   m_weights;
+	void					   UpdateWeights( Vec2 const& parameters );
+	float					   GetWeightedDurationMs() const;
+	void					   Update( float parametricZeroToOne );
+	AnimBlendNode*			   GetRootNode();
+	AnimPose const&			   GetBlendedPose();
+	int						   EmitToBlendProgram( AnimBlendProgram& program, float parametricZeroToOne );
+
+	// one clip node per sample, rebuilt when that state's clip is reloaded or evicted
+	std::vector<AnimClipNode*> m_sampleNodes;
+	std::vector<int>		   m_sampleClipVersions;
+	AnimPose				   m_skeletonPose;
+	AnimClipNode*			   GetSampleNode( int sampleIndex );
+	AnimationState*			   GetSampleState( int sampleIndex ) const;
+
+	// ( a lerp b ) lerp c
+	BinaryLerpBlendNode		   m_pairLerpNode;
+	BinaryLerpBlendNode		   m_triangleLerpNode;
+};
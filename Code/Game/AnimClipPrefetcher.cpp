@@ -0,0 +1,148 @@
+#include "Game/AnimClipPrefetcher.hpp"
+#include "Game/AnimClipResidencyManager.hpp"
+#include "Game/AnimationState.hpp"
+#include "Game/Character.hpp"
+#include "Game/GameCommon.hpp"
+
+#include "Engine/Math/FloatRange.hpp"
+
+#include <algorithm>
+
+
+//----------------------------------------------------------------------------------------------------------
+static bool IsVaultLikely()
+{
+	return g_theCharacter->IsFootInFrontOfAnObstacle( g_theCharacter->m_footRaycastMaxDistance );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+static bool IsLedgeGrabLikely()
+{
+	return g_theCharacter->IsHeadInRangeOfAnObstacle( FloatRange( 0.f, g_theCharacter->m_headraycastMaxDistance ) );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimClipPrefetcher::Startup( int maxHops )
+{
+	m_maxHops = maxHops;
+	InitHints();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// the movement states take these transitions once the same raycasts report a closer hit
+void AnimClipPrefetcher::InitHints()
+{
+	m_hints.clear();
+	m_hints.push_back( AnimClipPrefetchHint{ ANIM_NAME_VAULT, IsVaultLikely } );
+	m_hints.push_back( AnimClipPrefetchHint{ ANIM_NAME_HANG, IsLedgeGrabLikely } );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimClipPrefetcher::Update( std::vector<AnimationState*> const& playingStates )
+{
+	if ( !g_theAnimClipResidencyManager || !g_theAnimClipResidencyManager->m_isStreamingEnabled )
+	{
+		return;
+	}
+
+	GatherCandidates( playingStates );
+
+	// nearer states load first, requesting resident clips every frame keeps them from being evicted
+	for ( PrefetchCandidate const& candidate : m_candidates )
+	{
+		float priority = ( float ) ( m_maxHops + 1 - candidate.m_hops );
+		g_theAnimClipResidencyManager->RequestLoad( AnimationState::GetAnimationStateByIndex( candidate.m_stateIndex ), priority );
+	}
+
+	if ( !g_theCharacter )
+	{
+		return;
+	}
+
+	for ( PrefetchCandidate const& candidate : m_candidates )
+	{
+		RequestHintedStates( candidate.m_stateIndex );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// breadth first over the compiled state machine, end transitions cost no hop since they are taken without any input
+void AnimClipPrefetcher::GatherCandidates( std::vector<AnimationState*> const& playingStates )
+{
+	AnimStateMachineTable const& stateMachine = AnimationState::s_stateMachineTable;
+
+	m_candidates.clear();
+	for ( AnimationState* playingState : playingStates )
+	{
+		AddCandidate( playingState->GetStateMachineIndex(), 0 );
+	}
+
+	for ( size_t candidateIndex = 0; candidateIndex < m_candidates.size(); candidateIndex++ )
+	{
+		int stateIndex = m_candidates[ candidateIndex ].m_stateIndex;
+		int hops	   = m_candidates[ candidateIndex ].m_hops;
+		if ( hops >= m_maxHops )
+		{
+			continue;
+		}
+
+		AnimStateMachineState const& state = stateMachine.m_states[ stateIndex ];
+		for ( int transitionIndex = state.m_firstTransition; transitionIndex < state.m_firstTransition + state.m_numTransitions; transitionIndex++ )
+		{
+			AddCandidate( stateMachine.m_transitions[ transitionIndex ].m_targetState, hops + 1 );
+		}
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimClipPrefetcher::AddCandidate( int stateIndex, int hops )
+{
+	if ( stateIndex == INVALID_ANIM_STATE_MACHINE_INDEX )
+	{
+		return;
+	}
+
+	auto candidateIter = std::find_if( m_candidates.begin(), m_candidates.end(), [ stateIndex ]( PrefetchCandidate const& candidate ) { return candidate.m_stateIndex == stateIndex; } );
+	if ( candidateIter != m_candidates.end() )
+	{
+		return;
+	}
+
+	m_candidates.push_back( PrefetchCandidate{ stateIndex, hops } );
+
+	// whatever this state ends into is reached at the same hop count
+	AddCandidate( AnimationState::s_stateMachineTable.GetEndTransitionTarget( stateIndex ), hops );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimClipPrefetcher::RequestHintedStates( int stateIndex )
+{
+	AnimStateMachineTable const& stateMachine = AnimationState::s_stateMachineTable;
+	float const					 hintPriority = ( float ) ( m_maxHops + 2 );
+
+	for ( AnimClipPrefetchHint const& hint : m_hints )
+	{
+		int transitionIndex = stateMachine.FindTransition( stateIndex, hint.m_transitionNameId );
+		if ( transitionIndex == INVALID_ANIM_STATE_MACHINE_INDEX || !hint.m_isLikely() )
+		{
+			continue;
+		}
+
+		// the hinted state and whatever it ends into, e.g. idleToLedgeGrab then hang
+		int hintedStateIndex = stateMachine.m_transitions[ transitionIndex ].m_targetState;
+		for ( int chainLength = 0; hintedStateIndex != INVALID_ANIM_STATE_MACHINE_INDEX && chainLength < stateMachine.GetNumStates(); chainLength++ )
+		{
+			g_theAnimClipResidencyManager->RequestLoad( AnimationState::GetAnimationStateByIndex( hintedStateIndex ), hintPriority );
+
+			int endStateIndex = stateMachine.GetEndTransitionTarget( hintedStateIndex );
+			hintedStateIndex  = ( endStateIndex != hintedStateIndex ) ? endStateIndex : INVALID_ANIM_STATE_MACHINE_INDEX;
+		}
+	}
+}
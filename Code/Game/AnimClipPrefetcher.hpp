@@ -0,0 +1,42 @@
+#pragma once
+
+#include "Game/AnimStateMachineTable.hpp"
+
+#include <vector>
+
+class AnimationState;
+
+
+//----------------------------------------------------------------------------------------------------------
+// transitions that gameplay is about to take when a raycast sees an obstacle, loaded ahead of the hop search
+struct AnimClipPrefetchHint
+{
+	AnimNameId m_transitionNameId = INVALID_ANIM_NAME_ID;
+	bool ( *m_isLikely )()		  = nullptr;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// walks the transition graph out from the playing states and requests the clips within a few hops, so that
+// with streaming enabled a transition finds its clip already resident
+class AnimClipPrefetcher
+{
+public:
+	void Startup( int maxHops );
+	void Update( std::vector<AnimationState*> const& playingStates );
+
+	int								  m_maxHops = 2;
+	std::vector<AnimClipPrefetchHint> m_hints;
+	void							  InitHints();
+
+	// graph walk
+	struct PrefetchCandidate
+	{
+		int m_stateIndex = INVALID_ANIM_STATE_MACHINE_INDEX;
+		int m_hops		 = 0;
+	};
+	std::vector<PrefetchCandidate> m_candidates;
+	void						   GatherCandidates( std::vector<AnimationState*> const& playingStates );
+	void						   AddCandidate( int stateIndex, int hops );
+	void						   RequestHintedStates( int stateIndex );
+};
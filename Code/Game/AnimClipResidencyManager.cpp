@@ -0,0 +1,582 @@
+#include "Game/AnimClipResidencyManager.hpp"
+#include "Game/AnimationState.hpp"
+#include "Game/GameCommon.hpp"
+
+#include "Engine/Animation/AnimClip.hpp"
+#include "Engine/Core/JobSystem.hpp"
+#include "Engine/Core/StringUtils.hpp"
+#include "Engine/Core/ErrorWarningAssert.hpp"
+
+#include <algorithm>
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimClipResidencyManager::Startup( bool isStreamingEnabled, size_t budgetBytes )
+{
+	m_isStreamingEnabled = isStreamingEnabled;
+	m_budgetBytes		 = budgetBytes;
+	m_mainThreadId		 = std::this_thread::get_id();
+
+	// without streaming everything is requested up front and never evicted
+	if ( !m_isStreamingEnabled )
+	{
+		for ( auto const& stateEntry : AnimationState::s_animationStatesRegistery )
+		{
+			RequestLoad( stateEntry.second );
+		}
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimClipResidencyManager::Shutdown()
+{
+	m_loadQueue.clear();
+	m_clipRecords.clear();
+	m_cookedClips.clear();
+
+	// a worker may still be writing an in-flight job, whichever side gets to the job second frees its clip; the job
+	// objects stay with the job system, which may still hold them in its queues
+	for ( JobLoadAnimationClip* inFlightJob : m_inFlightJobs )
+	{
+		if ( inFlightJob->m_isFinishedOrOrphaned.exchange( true ) && !inFlightJob->m_isCachedClip )
+		{
+			delete inFlightJob->m_animClip;
+			inFlightJob->m_animClip = nullptr;
+		}
+	}
+	m_inFlightJobs.clear();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// completed jobs are retrieved once per frame by the game and handed to every system, the manager only claims its own
+void AnimClipResidencyManager::Update( std::vector<Job*> const& completedJobs )
+{
+	m_frameNumber++;
+
+	ApplyCompletedJobs( completedJobs );
+
+	// pinned clips are in use this frame
+	for ( auto& recordEntry : m_clipRecords )
+	{
+		if ( recordEntry.second.m_pinCount > 0 )
+		{
+			recordEntry.second.m_lastUsedFrame = m_frameNumber;
+		}
+	}
+
+	IssueQueuedLoads();
+	EvictUntilWithinBudget();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// records, the load queue and the states' clips are only ever written from the thread that started the manager
+bool AnimClipResidencyManager::IsOnMainThread() const
+{
+	return std::this_thread::get_id() == m_mainThreadId;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+AnimClipResidencyManager::ClipRecord& AnimClipResidencyManager::GetRecord( AnimationState* state )
+{
+	return m_clipRecords[ state ];
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool AnimClipResidencyManager::IsResident( AnimationState const* state ) const
+{
+	auto recordIter = m_clipRecords.find( const_cast<AnimationState*>( state ) );
+	if ( recordIter == m_clipRecords.cend() )
+	{
+		return false;
+	}
+
+	return recordIter->second.m_isResident;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// transitions wait for their clips and startup waits for the first state's, so a state is resident before it is
+// pinned; a pin on a clip that is not only asks for it ahead of any prefetch
+void AnimClipResidencyManager::Pin( AnimationState* state )
+{
+	ClipRecord& record = GetRecord( state );
+	record.m_pinCount++;
+	record.m_lastUsedFrame = m_frameNumber;
+
+	if ( !record.m_isResident )
+	{
+		RequestLoad( state, ANIM_CLIP_MISS_PRIORITY );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimClipResidencyManager::Unpin( AnimationState* state )
+{
+	ClipRecord& record = GetRecord( state );
+	if ( record.m_pinCount > 0 )
+	{
+		record.m_pinCount--;
+	}
+	record.m_lastUsedFrame = m_frameNumber;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimClipResidencyManager::RequestLoad( AnimationState* state, float priority )
+{
+	if ( !state )
+	{
+		return;
+	}
+
+	ClipRecord& record = GetRecord( state );
+	if ( record.m_isResident )
+	{
+		record.m_lastUsedFrame = m_frameNumber;
+		return;
+	}
+
+	if ( record.m_isLoadRequested )
+	{
+		// already queued or in flight, only raise its priority
+		record.m_requestPriority = std::max( record.m_requestPriority, priority );
+		for ( QueuedLoad& queuedLoad : m_loadQueue )
+		{
+			if ( queuedLoad.m_state == state )
+			{
+				queuedLoad.m_priority = record.m_requestPriority;
+			}
+		}
+		return;
+	}
+
+	record.m_isLoadRequested = true;
+	record.m_requestPriority = priority;
+	m_loadQueue.push_back( QueuedLoad{ state, priority } );
+	m_stats.m_numLoadRequests++;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// a state and the states its blend space samples, everything a controller needs to enter it
+void AnimClipResidencyManager::RequestStateClips( AnimationState* state, float priority )
+{
+	if ( !state )
+	{
+		return;
+	}
+
+	RequestLoad( state, priority );
+	if ( state->HasBlendSpace() )
+	{
+		for ( AnimBlendSpaceSample const& sample : state->m_blendSpace.m_samples )
+		{
+			RequestLoad( AnimationState::GetAnimationStateById( sample.m_stateNameId ), priority );
+		}
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimClipResidencyManager::RequestReload( AnimationState* state )
+{
+	ClipRecord& record		  = GetRecord( state );
+	record.m_isSourceModified = true;
+
+	if ( record.m_isResident )
+	{
+		JobLoadAnimationClip* reloadJob = state->CreateLoadClipJob( true, true );
+		reloadJob->m_isReload			= true;
+		record.m_numPendingJobs++;
+		m_inFlightJobs.push_back( reloadJob );
+		g_theJobSystem->PostNewJob( reloadJob );
+	}
+	else if ( !m_isStreamingEnabled )
+	{
+		RequestLoad( state );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// blocking load, only for startup builds and tools that need a clip before the first frame; gameplay requests
+// loads and waits for them, counted so any blocking load shows up in the stats
+void AnimClipResidencyManager::MakeResidentNow( AnimationState* state )
+{
+	if ( !IsOnMainThread() )
+	{
+		ERROR_AND_DIE( Stringf( "Error: Clip for %s was loaded off the main thread, it has to be pinned before it is sampled", state->m_name.c_str() ) );
+	}
+
+	ClipRecord& record = GetRecord( state );
+	if ( record.m_isResident )
+	{
+		record.m_lastUsedFrame = m_frameNumber;
+		return;
+	}
+
+	m_loadQueue.erase( std::remove_if( m_loadQueue.begin(), m_loadQueue.end(), [ state ]( QueuedLoad const& queuedLoad ) { return queuedLoad.m_state == state; } ),
+		m_loadQueue.end() );
+
+	if ( ShareCookedClip( state, record ) )
+	{
+		return;
+	}
+
+	JobLoadAnimationClip* blockingJob = state->CreateLoadClipJob( m_isStreamingEnabled || record.m_isSourceModified, record.m_isSourceModified );
+	blockingJob->Execute();
+	record.m_numPendingJobs++;
+	m_stats.m_numBlockingLoads++;
+
+	ApplyLoadedClip( blockingJob );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimClipResidencyManager::MakeStateClipsResidentNow( AnimationState* state )
+{
+	MakeResidentNow( state );
+	if ( state->HasBlendSpace() )
+	{
+		for ( AnimBlendSpaceSample const& sample : state->m_blendSpace.m_samples )
+		{
+			AnimationState* sampleState = AnimationState::GetAnimationStateById( sample.m_stateNameId );
+			if ( sampleState )
+			{
+				MakeResidentNow( sampleState );
+			}
+		}
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// a clip a transition wants that is not resident yet, the load jumps the queue instead of blocking; reported every
+// frame the transition waits, but logged and counted once per load
+void AnimClipResidencyManager::ReportPrefetchMiss( AnimationState* state )
+{
+	ClipRecord& record = GetRecord( state );
+	if ( record.m_isResident || ( record.m_isLoadRequested && record.m_requestPriority >= ANIM_CLIP_MISS_PRIORITY ) )
+	{
+		return;
+	}
+
+	DebuggerPrintf( "Clip prefetch miss: %s, the transition waits for it\n", state->m_name.c_str() );
+	m_stats.m_numPrefetchMisses++;
+	RequestLoad( state, ANIM_CLIP_MISS_PRIORITY );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool AnimClipResidencyManager::HasPendingLoads() const
+{
+	return !m_loadQueue.empty() || !m_inFlightJobs.empty();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimClipResidencyManager::IssueQueuedLoads()
+{
+	if ( m_loadQueue.empty() )
+	{
+		return;
+	}
+
+	std::stable_sort( m_loadQueue.begin(), m_loadQueue.end(), []( QueuedLoad const& a, QueuedLoad const& b ) { return a.m_priority > b.m_priority; } );
+
+	size_t numToIssue = m_loadQueue.size();
+	if ( m_isStreamingEnabled )
+	{
+		int numFreeSlots = m_maxLoadsInFlight - ( int ) m_inFlightJobs.size();
+		numToIssue		 = ( size_t ) std::max( 0, std::min( numFreeSlots, ( int ) m_loadQueue.size() ) );
+	}
+
+	for ( size_t queueIndex = 0; queueIndex < numToIssue; queueIndex++ )
+	{
+		AnimationState*		  state	  = m_loadQueue[ queueIndex ].m_state;
+		ClipRecord&			  record  = GetRecord( state );
+		if ( ShareCookedClip( state, record ) )
+		{
+			continue;
+		}
+
+		JobLoadAnimationClip* loadJob = state->CreateLoadClipJob( m_isStreamingEnabled || record.m_isSourceModified, record.m_isSourceModified );
+		record.m_numPendingJobs++;
+		m_inFlightJobs.push_back( loadJob );
+		g_theJobSystem->PostNewJob( loadJob );
+	}
+
+	m_loadQueue.erase( m_loadQueue.begin(), m_loadQueue.begin() + numToIssue );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimClipResidencyManager::ApplyCompletedJobs( std::vector<Job*> const& completedJobs )
+{
+	for ( Job* completedJob : completedJobs )
+	{
+		JobLoadAnimationClip* clipJob	   = dynamic_cast<JobLoadAnimationClip*>( completedJob );
+		auto				  inFlightIter = std::find( m_inFlightJobs.begin(), m_inFlightJobs.end(), clipJob );
+		if ( !clipJob || inFlightIter == m_inFlightJobs.end() )
+		{
+			continue;
+		}
+
+		m_inFlightJobs.erase( inFlightIter );
+		ApplyLoadedClip( clipJob );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimClipResidencyManager::ApplyLoadedClip( JobLoadAnimationClip* completedJob )
+{
+	AnimationState* state = AnimationState::GetAnimationStateByName( completedJob->m_stateName );
+	if ( !state )
+	{
+		DiscardLoadedClip( completedJob );
+		return;
+	}
+
+	ClipRecord& record = GetRecord( state );
+	record.m_numPendingJobs--;
+
+	if ( record.m_isResident )
+	{
+		if ( !completedJob->m_isReload )
+		{
+			// a blocking load got there first
+			DiscardLoadedClip( completedJob );
+			return;
+		}
+
+		// pinned or not, nothing samples at the frame boundary and the version bump has every instance rebind its
+		// clip node before its next sample
+		ReleaseClip( state, record );
+	}
+
+	// a clip from the engine cache is shared and outlives the state, so only owned clips count against the budget;
+	// a cooked clip is counted once, by the state that first brought it in
+	record.m_bytes = 0;
+	if ( completedJob->m_isCookedClip )
+	{
+		completedJob->m_animClip = AcquireCookedClip( *completedJob, record );
+	}
+	else if ( !completedJob->m_isCachedClip )
+	{
+		record.m_bytes = GetClipMemoryBytes( *completedJob->m_animClip );
+	}
+
+	state->ApplyLoadedClip( *completedJob );
+	record.m_isResident		 = true;
+	record.m_isLoadRequested = false;
+	record.m_requestPriority = 0.f;
+	record.m_ownsClip		 = !completedJob->m_isCachedClip;
+	record.m_lastUsedFrame	 = m_frameNumber;
+
+	m_stats.m_numResidentClips++;
+	m_stats.m_numLoadsCompleted++;
+	m_stats.m_residentBytes += record.m_bytes;
+	m_stats.m_peakResidentBytes = std::max( m_stats.m_peakResidentBytes, m_stats.m_residentBytes );
+
+	delete completedJob;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimClipResidencyManager::DiscardLoadedClip( JobLoadAnimationClip* completedJob )
+{
+	auto cookedClipIter		= m_cookedClips.find( CookedClipKey( completedJob->m_clipFileName, completedJob->m_removeRootMotion ) );
+	bool isSharedCookedClip = cookedClipIter != m_cookedClips.end() && cookedClipIter->second.m_clip == completedJob->m_animClip;
+	if ( !completedJob->m_isCachedClip && !isSharedCookedClip )
+	{
+		delete completedJob->m_animClip;
+	}
+
+	delete completedJob;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// returns the bytes freed, which is nothing while other states still share a cooked clip
+size_t AnimClipResidencyManager::ReleaseClip( AnimationState* state, ClipRecord& record )
+{
+	size_t freedBytes = record.m_bytes;
+	if ( record.m_isCookedClip )
+	{
+		state->UnloadClip( false );
+		freedBytes = ReleaseCookedClip( record.m_cookedClipKey );
+	}
+	else
+	{
+		state->UnloadClip( record.m_ownsClip );
+	}
+
+	m_stats.m_numResidentClips--;
+	m_stats.m_residentBytes -= freedBytes;
+
+	record.m_isResident	  = false;
+	record.m_ownsClip	  = false;
+	record.m_isCookedClip = false;
+	record.m_bytes		  = 0;
+
+	return freedBytes;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// another state already holds the cooked clip of this file, so it is shared instead of read again
+bool AnimClipResidencyManager::ShareCookedClip( AnimationState* state, ClipRecord& record )
+{
+	if ( record.m_isSourceModified )
+	{
+		return false;
+	}
+
+	auto cookedClipIter = m_cookedClips.find( CookedClipKey( state->m_clipFilePath, state->m_removeRootMotion ) );
+	if ( cookedClipIter == m_cookedClips.end() )
+	{
+		return false;
+	}
+
+	JobLoadAnimationClip* sharedJob = state->CreateLoadClipJob( false, false );
+	sharedJob->m_animClip			= cookedClipIter->second.m_clip;
+	sharedJob->m_isCookedClip		= true;
+	sharedJob->m_defaultPose		= AnimationState::LoadOrGetRestPose( ANIM_REST_POSE_FILE_PATH );
+	record.m_numPendingJobs++;
+
+	ApplyLoadedClip( sharedJob );
+	return true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// a second load of a file that is already resident, from two states requested in the same frame, is dropped
+AnimClip* AnimClipResidencyManager::AcquireCookedClip( JobLoadAnimationClip const& completedJob, ClipRecord& record )
+{
+	record.m_isCookedClip  = true;
+	record.m_cookedClipKey = CookedClipKey( completedJob.m_clipFileName, completedJob.m_removeRootMotion );
+
+	CookedClip& cookedClip = m_cookedClips[ record.m_cookedClipKey ];
+	if ( !cookedClip.m_clip )
+	{
+		cookedClip.m_clip  = completedJob.m_animClip;
+		cookedClip.m_bytes = GetClipMemoryBytes( *cookedClip.m_clip );
+		record.m_bytes	   = cookedClip.m_bytes;
+	}
+	else if ( cookedClip.m_clip != completedJob.m_animClip )
+	{
+		delete completedJob.m_animClip;
+	}
+	cookedClip.m_refCount++;
+
+	return cookedClip.m_clip;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// returns the clip's bytes once the last state sharing it lets go
+size_t AnimClipResidencyManager::ReleaseCookedClip( CookedClipKey const& key )
+{
+	auto cookedClipIter = m_cookedClips.find( key );
+	if ( cookedClipIter == m_cookedClips.end() )
+	{
+		return 0;
+	}
+
+	CookedClip& cookedClip = cookedClipIter->second;
+	cookedClip.m_refCount--;
+	if ( cookedClip.m_refCount > 0 )
+	{
+		return 0;
+	}
+
+	size_t freedBytes = cookedClip.m_bytes;
+	delete cookedClip.m_clip;
+	m_cookedClips.erase( cookedClipIter );
+
+	return freedBytes;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimClipResidencyManager::EvictUntilWithinBudget()
+{
+	if ( !m_isStreamingEnabled )
+	{
+		return;
+	}
+
+	while ( m_stats.m_residentBytes > m_budgetBytes )
+	{
+		// least recently used clip that nothing is sampling
+		AnimationState* evictState	= nullptr;
+		ClipRecord*		evictRecord = nullptr;
+		for ( auto& recordEntry : m_clipRecords )
+		{
+			ClipRecord& record = recordEntry.second;
+			if ( !record.m_isResident || !record.m_ownsClip || record.m_pinCount > 0 || record.m_numPendingJobs > 0 )
+			{
+				// evicting a shared cached clip would free nothing
+				continue;
+			}
+
+			if ( !evictRecord || record.m_lastUsedFrame < evictRecord->m_lastUsedFrame )
+			{
+				evictState	= recordEntry.first;
+				evictRecord = &record;
+			}
+		}
+
+		if ( !evictRecord )
+		{
+			// everything left is pinned, the budget is exceeded until something unpins
+			return;
+		}
+
+		Evict( evictState, *evictRecord );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimClipResidencyManager::Evict( AnimationState* state, ClipRecord& record )
+{
+	size_t freedBytes = ReleaseClip( state, record );
+
+	m_stats.m_numEvictions++;
+	m_stats.m_evictedBytes += freedBytes;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+size_t AnimClipResidencyManager::GetClipMemoryBytes( AnimClip const& clip )
+{
+	size_t numBytes = sizeof( AnimClip );
+	for ( AnimChannel const& channel : clip.m_animChannels )
+	{
+		numBytes += sizeof( AnimChannel ) + channel.m_jointName.capacity();
+		numBytes += channel.m_positionCurve.m_keyframes.capacity() * sizeof( channel.m_positionCurve.m_keyframes[ 0 ] );
+		numBytes += channel.m_rotationCurve.m_keyframes.capacity() * sizeof( channel.m_rotationCurve.m_keyframes[ 0 ] );
+		numBytes += channel.m_scaleCurve.m_keyframes.capacity() * sizeof( channel.m_scaleCurve.m_keyframes[ 0 ] );
+	}
+
+	return numBytes;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+std::string AnimClipResidencyManager::GetStatsString() const
+{
+	float const bytesPerMB = 1024.f * 1024.f;
+
+	return Stringf( "Clips: %d resident, %.2f/%.2f MB (peak %.2f), loads %d/%d, blocking %d, misses %d, evicted %d (%.2f MB)",
+		m_stats.m_numResidentClips, ( float ) m_stats.m_residentBytes / bytesPerMB, ( float ) m_budgetBytes / bytesPerMB, ( float ) m_stats.m_peakResidentBytes / bytesPerMB,
+		m_stats.m_numLoadsCompleted, m_stats.m_numLoadRequests, m_stats.m_numBlockingLoads, m_stats.m_numPrefetchMisses, m_stats.m_numEvictions, ( float ) m_stats.m_evictedBytes / bytesPerMB );
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+class AnimClip;
+class AnimationState;
+struct Job;
+struct JobLoadAnimationClip;
+
+
+//----------------------------------------------------------------------------------------------------------
+constexpr float ANIM_CLIP_MISS_PRIORITY = 100.f; // above any prefetch, a transition is waiting on it
+
+
+//----------------------------------------------------------------------------------------------------------
+struct AnimClipResidencyStats
+{
+	int	   m_numResidentClips  = 0;
+	size_t m_residentBytes	   = 0;
+	size_t m_peakResidentBytes = 0;
+	int	   m_numLoadRequests   = 0;
+	int	   m_numLoadsCompleted = 0;
+	int	   m_numBlockingLoads  = 0;
+	int	   m_numPrefetchMisses = 0;
+	int	   m_numEvictions	   = 0;
+	size_t m_evictedBytes	   = 0;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// owns every clip load after startup: clips come in on first use or on request, and unpinned clips are
+// evicted least recently used first once the resident bytes go over budget
+class AnimClipResidencyManager
+{
+public:
+	void Startup( bool isStreamingEnabled, size_t budgetBytes );
+	void Shutdown();
+	void Update( std::vector<Job*> const& completedJobs );
+
+	bool							   m_isStreamingEnabled = false;
+	size_t							   m_budgetBytes		= 0;
+	int								   m_maxLoadsInFlight	= 4;
+	uint64_t						   m_frameNumber		= 0;
+	std::thread::id					   m_mainThreadId;
+	bool							   IsOnMainThread() const;
+
+	// residency
+	typedef std::pair<std::string, bool> CookedClipKey; // clip file and whether its root motion is removed
+	struct ClipRecord
+	{
+		size_t		  m_bytes			  = 0;
+		uint64_t	  m_lastUsedFrame	  = 0;
+		int			  m_pinCount		  = 0;
+		bool		  m_isResident		  = false;
+		bool		  m_isLoadRequested	  = false;
+		bool		  m_ownsClip		  = false;
+		bool		  m_isCookedClip	  = false;
+		bool		  m_isSourceModified  = false;
+		float		  m_requestPriority	  = 0.f;
+		int			  m_numPendingJobs	  = 0;
+		CookedClipKey m_cookedClipKey;
+	};
+	std::map<AnimationState*, ClipRecord> m_clipRecords;
+	ClipRecord&							   GetRecord( AnimationState* state );
+	bool								   IsResident( AnimationState const* state ) const;
+	void								   Pin( AnimationState* state );
+	void								   Unpin( AnimationState* state );
+	void								   RequestLoad( AnimationState* state, float priority = 0.f );
+	void								   RequestStateClips( AnimationState* state, float priority = 0.f );
+	void								   RequestReload( AnimationState* state );
+	void								   MakeResidentNow( AnimationState* state );
+	void								   MakeStateClipsResidentNow( AnimationState* state );
+	void								   ReportPrefetchMiss( AnimationState* state );
+	bool								   HasPendingLoads() const;
+
+	// loading jobs
+	struct QueuedLoad
+	{
+		AnimationState* m_state	   = nullptr;
+		float			m_priority = 0.f;
+	};
+	std::vector<QueuedLoad>			   m_loadQueue;
+	std::vector<JobLoadAnimationClip*> m_inFlightJobs;
+	void							   IssueQueuedLoads();
+	void							   ApplyCompletedJobs( std::vector<Job*> const& completedJobs );
+	void							   ApplyLoadedClip( JobLoadAnimationClip* completedJob );
+	void							   DiscardLoadedClip( JobLoadAnimationClip* completedJob );
+	size_t							   ReleaseClip( AnimationState* state, ClipRecord& record );
+
+	// cooked clips, one copy per file shared by every state that plays it
+	struct CookedClip
+	{
+		AnimClip* m_clip	 = nullptr;
+		int		  m_refCount = 0;
+		size_t	  m_bytes	 = 0;
+	};
+	std::map<CookedClipKey, CookedClip> m_cookedClips;
+	bool								ShareCookedClip( AnimationState* state, ClipRecord& record );
+	AnimClip*							AcquireCookedClip( JobLoadAnimationClip const& completedJob, ClipRecord& record );
+	size_t								ReleaseCookedClip( CookedClipKey const& key );
+
+	// eviction
+	void							   EvictUntilWithinBudget();
+	void							   Evict( AnimationState* state, ClipRecord& record );
+	static size_t					   GetClipMemoryBytes( AnimClip const& clip );
+
+	// stats
+	AnimClipResidencyStats			   m_stats;
+	std::string						   GetStatsString() const;
+};
@@ -0,0 +1,205 @@
+#include "Game/AnimConfigHotReloader.hpp"
+#include "Game/AnimationState.hpp"
+#include "Game/AnimClipResidencyManager.hpp"
+#include "Game/GameCommon.hpp"
+
+#include "Engine/Core/DevConsole.hpp"
+#include "Engine/Core/JobSystem.hpp"
+#include "Engine/Core/XmlUtils.hpp"
+#include "Engine/Core/StringUtils.hpp"
+#include "Engine/Core/ErrorWarningAssert.hpp"
+
+#include <set>
+
+
+//----------------------------------------------------------------------------------------------------------
+static std::filesystem::file_time_type GetFileWriteTime( std::string const& filePath )
+{
+	std::error_code errorCode;
+	std::filesystem::file_time_type writeTime = std::filesystem::last_write_time( filePath, errorCode );
+	if ( errorCode )
+	{
+		return std::filesystem::file_time_type::min();
+	}
+
+	return writeTime;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimConfigHotReloader::Startup( std::string const& animConfigPath )
+{
+	m_animConfigPath	  = animConfigPath;
+	m_animConfigWriteTime = GetFileWriteTime( m_animConfigPath );
+	m_lastPollTime		  = std::chrono::steady_clock::now();
+
+	RecordClipWriteTimes();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimConfigHotReloader::Shutdown()
+{
+	m_clipWriteTimes.clear();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimConfigHotReloader::Update()
+{
+	// poll the file system a few times a second, not every frame
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	float secondsSinceLastPoll = std::chrono::duration<float>( now - m_lastPollTime ).count();
+	if ( secondsSinceLastPoll < m_pollIntervalSeconds )
+	{
+		return;
+	}
+	m_lastPollTime = now;
+
+	std::filesystem::file_time_type animConfigWriteTime = GetFileWriteTime( m_animConfigPath );
+	if ( animConfigWriteTime != m_animConfigWriteTime )
+	{
+		m_animConfigWriteTime = animConfigWriteTime;
+		ReloadAnimConfig();
+	}
+
+	ReloadChangedClips();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimConfigHotReloader::RecordClipWriteTimes()
+{
+	for ( auto const& stateEntry : AnimationState::s_animationStatesRegistery )
+	{
+		std::string const& clipFilePath = stateEntry.second->m_clipFilePath;
+		if ( m_clipWriteTimes.find( clipFilePath ) == m_clipWriteTimes.end() )
+		{
+			m_clipWriteTimes[ clipFilePath ] = GetFileWriteTime( clipFilePath );
+		}
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimConfigHotReloader::ReloadAnimConfig()
+{
+	XmlDocument animConfigDocument;
+	if ( animConfigDocument.LoadFile( m_animConfigPath.c_str() ) != tinyxml2::XML_SUCCESS || !animConfigDocument.RootElement() )
+	{
+		// usually caught mid save, the next write triggers another attempt
+		g_theDevConsole->AddLine( Rgba8::RED, Stringf( "hot reload: unable to parse %s", m_animConfigPath.c_str() ) );
+		return;
+	}
+
+	// live controllers, the prefetcher and the motion matching database hold state indices, so the reload may only
+	// change what the existing states do, not which states exist
+	std::string addedOrRemovedStateName;
+	if ( !HasSameStates( *animConfigDocument.RootElement(), addedOrRemovedStateName ) )
+	{
+		g_theDevConsole->AddLine( Rgba8::RED, Stringf( "hot reload: state %s was added or removed, restart to apply", addedOrRemovedStateName.c_str() ) );
+		return;
+	}
+
+	if ( !AnimationState::s_stateMachineTable.PatchFromXML( *animConfigDocument.RootElement() ) )
+	{
+		g_theDevConsole->AddLine( Rgba8::RED, Stringf( "hot reload: unable to patch the state machine of %s", m_animConfigPath.c_str() ) );
+		return;
+	}
+
+	int				  numPatchedStates = 0;
+	XmlElement const* animStateElement = animConfigDocument.RootElement()->FirstChildElement( "AnimationState" );
+	while ( animStateElement )
+	{
+		std::string		stateName = ParseXmlAttribute( *animStateElement, "name", "" );
+		AnimationState* state	  = AnimationState::s_animationStatesRegistery[ stateName ];
+		if ( state->PatchFromXML( *animStateElement ) )
+		{
+			PostClipReload( state );
+		}
+
+		// a blend space in use samples any state it gained on the next pose, there is no transition to wait on
+		if ( state->HasBlendSpace() && g_theAnimClipResidencyManager->GetRecord( state ).m_pinCount > 0 )
+		{
+			g_theAnimClipResidencyManager->MakeStateClipsResidentNow( state );
+		}
+		numPatchedStates++;
+
+		animStateElement = animStateElement->NextSiblingElement( "AnimationState" );
+	}
+
+	RecordClipWriteTimes();
+
+	g_theDevConsole->AddLine( Rgba8::GREEN, Stringf( "hot reload: patched %d states", numPatchedStates ) );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool AnimConfigHotReloader::HasSameStates( XmlElement const& animConfigRootElement, std::string& out_addedOrRemovedStateName ) const
+{
+	std::set<std::string> configStateNames;
+	XmlElement const*	  animStateElement = animConfigRootElement.FirstChildElement( "AnimationState" );
+	while ( animStateElement )
+	{
+		std::string stateName = ParseXmlAttribute( *animStateElement, "name", "" );
+		if ( AnimationState::s_animationStatesRegistery.find( stateName ) == AnimationState::s_animationStatesRegistery.end() )
+		{
+			out_addedOrRemovedStateName = stateName;
+			return false;
+		}
+		configStateNames.insert( stateName );
+
+		animStateElement = animStateElement->NextSiblingElement( "AnimationState" );
+	}
+
+	for ( auto const& stateEntry : AnimationState::s_animationStatesRegistery )
+	{
+		if ( configStateNames.find( stateEntry.first ) == configStateNames.end() )
+		{
+			out_addedOrRemovedStateName = stateEntry.first;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimConfigHotReloader::ReloadChangedClips()
+{
+	std::set<std::string> changedClipFilePaths;
+	for ( auto& clipEntry : m_clipWriteTimes )
+	{
+		std::filesystem::file_time_type writeTime = GetFileWriteTime( clipEntry.first );
+		if ( writeTime != clipEntry.second )
+		{
+			clipEntry.second = writeTime;
+			changedClipFilePaths.insert( clipEntry.first );
+		}
+	}
+
+	if ( changedClipFilePaths.empty() )
+	{
+		return;
+	}
+
+	for ( auto const& stateEntry : AnimationState::s_animationStatesRegistery )
+	{
+		AnimationState* state = stateEntry.second;
+		if ( changedClipFilePaths.find( state->m_clipFilePath ) != changedClipFilePaths.end() )
+		{
+			PostClipReload( state );
+		}
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimConfigHotReloader::PostClipReload( AnimationState* state )
+{
+	g_theDevConsole->AddLine( Rgba8::ORANGE, Stringf( "hot reload: reloading clip of %s", state->m_name.c_str() ) );
+
+	g_theAnimClipResidencyManager->RequestReload( state );
+}
+
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Engine/Core/XmlUtils.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <string>
+
+class AnimationState;
+
+
+//----------------------------------------------------------------------------------------------------------
+// watches the anim config and the clips it references, patching the loaded state graph in place
+class AnimConfigHotReloader
+{
+public:
+	void Startup( std::string const& animConfigPath );
+	void Shutdown();
+	void Update();
+
+	std::string											  m_animConfigPath		= "";
+	float												  m_pollIntervalSeconds = 0.5f;
+	std::chrono::steady_clock::time_point				  m_lastPollTime;
+	std::filesystem::file_time_type						  m_animConfigWriteTime;
+	std::map<std::string, std::filesystem::file_time_type> m_clipWriteTimes;
+	void												  RecordClipWriteTimes();
+
+	// reload
+	void												  ReloadAnimConfig();
+	bool												  HasSameStates( XmlElement const& animConfigRootElement, std::string& out_addedOrRemovedStateName ) const;
+	void												  ReloadChangedClips();
+	void												  PostClipReload( AnimationState* state );
+};
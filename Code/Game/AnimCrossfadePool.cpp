@@ -0,0 +1,96 @@
+#include "Game/AnimCrossfadePool.hpp"
+
+#include "Engine/Core/ErrorWarningAssert.hpp"
+
+
+//----------------------------------------------------------------------------------------------------------
+AnimCrossfadePool::~AnimCrossfadePool()
+{
+	Shutdown();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimCrossfadePool::Startup( int numSlots, AnimPose const& skeletonPose )
+{
+	Shutdown();
+
+	// slots are never added after this, so the trees handed out keep stable addresses
+	m_slots.resize( numSlots );
+	for ( AnimCrossfadeSlot& slot : m_slots )
+	{
+		slot.m_lerpNode.m_blendedPose = skeletonPose;
+		slot.m_isInUse				  = false;
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimCrossfadePool::Shutdown()
+{
+	// the lerp nodes live inside the slots, trees must not try to free them
+	for ( AnimCrossfadeSlot& slot : m_slots )
+	{
+		slot.m_blendTree.m_rootNode = nullptr;
+	}
+	m_slots.clear();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+AnimBlendTree* AnimCrossfadePool::Acquire( AnimBlendNode* fadeOutNode, AnimBlendNode* fadeInNode )
+{
+	for ( AnimCrossfadeSlot& slot : m_slots )
+	{
+		if ( slot.m_isInUse )
+		{
+			continue;
+		}
+
+		// the blended pose is overwritten on the next update, only the wiring is reset
+		slot.m_lerpNode.m_childNodeA = fadeOutNode;
+		slot.m_lerpNode.m_childNodeB = fadeInNode;
+		slot.m_blendTree.m_rootNode	 = &slot.m_lerpNode;
+		slot.m_isInUse				 = true;
+
+		return &slot.m_blendTree;
+	}
+
+	m_numExhaustedAcquires++;
+	DebuggerPrintf( "Error: Crossfade pool exhausted with %d slots\n", ( int ) m_slots.size() );
+
+	return nullptr;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimCrossfadePool::Release( AnimBlendTree* crossfadeTree )
+{
+	for ( AnimCrossfadeSlot& slot : m_slots )
+	{
+		if ( &slot.m_blendTree == crossfadeTree )
+		{
+			slot.m_lerpNode.m_childNodeA = nullptr;
+			slot.m_lerpNode.m_childNodeB = nullptr;
+			slot.m_isInUse				 = false;
+
+			return;
+		}
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+int AnimCrossfadePool::GetNumSlotsInUse() const
+{
+	int numSlotsInUse = 0;
+	for ( AnimCrossfadeSlot const& slot : m_slots )
+	{
+		if ( slot.m_isInUse )
+		{
+			numSlotsInUse++;
+		}
+	}
+
+	return numSlotsInUse;
+}
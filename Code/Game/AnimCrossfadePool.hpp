@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Engine/Animation/AnimBlendTree.hpp"
+#include "Engine/Animation/AnimBlendNode.hpp"
+#include "Engine/Animation/AnimPose.hpp"
+
+#include <vector>
+
+
+//----------------------------------------------------------------------------------------------------------
+struct AnimCrossfadeSlot
+{
+	BinaryLerpBlendNode m_lerpNode;
+	AnimBlendTree		m_blendTree;
+	bool				m_isInUse = false;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// crossfade trees allocated once with their blended pose already sized to the skeleton, a transition only
+// rewires the lerp node's children so starting and finishing a fade never touches the heap
+class AnimCrossfadePool
+{
+public:
+	AnimCrossfadePool() {}
+	~AnimCrossfadePool();
+
+	void						   Startup( int numSlots, AnimPose const& skeletonPose );
+	void						   Shutdown();
+	AnimBlendTree*				   Acquire( AnimBlendNode* fadeOutNode, AnimBlendNode* fadeInNode );
+	void						   Release( AnimBlendTree* crossfadeTree );
+	int							   GetNumSlotsInUse() const;
+
+	std::vector<AnimCrossfadeSlot> m_slots;
+	int							   m_numExhaustedAcquires = 0;
+};
@@ -0,0 +1,116 @@
+#include "Game/AnimEventTrack.hpp"
+
+#include "Engine/Core/ErrorWarningAssert.hpp"
+
+#include <algorithm>
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimEventQueue::Push( AnimNameId eventId, AnimationState* state, float timeMs )
+{
+	AnimEventDispatch dispatch;
+	dispatch.m_eventId = eventId;
+	dispatch.m_state   = state;
+	dispatch.m_timeMs  = timeMs;
+	m_events.push_back( dispatch );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// keeps the capacity, so a steady stream of events stops allocating after the first few frames
+void AnimEventQueue::Clear()
+{
+	m_events.clear();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool AnimEventQueue::IsEmpty() const
+{
+	return m_events.empty();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimEventTrack::Clear()
+{
+	m_events.clear();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// <Events> <Event name="footstepLeft" normalizedTime="0.0"/> <Event name="handContact" timeMs="420"/> </Events>
+void AnimEventTrack::LoadFromXML( XmlElement const& animStateElement )
+{
+	Clear();
+
+	XmlElement const* eventsElement = animStateElement.FirstChildElement( "Events" );
+	if ( !eventsElement )
+	{
+		return;
+	}
+
+	XmlElement const* eventElement = eventsElement->FirstChildElement( "Event" );
+	while ( eventElement )
+	{
+		std::string eventName = ParseXmlAttribute( *eventElement, "name", "" );
+		if ( eventName.empty() )
+		{
+			DebuggerPrintf( "Error: Animation event without a name\n" );
+		}
+		else
+		{
+			AnimEvent animEvent;
+			animEvent.m_nameId		   = AnimNameTable::Intern( eventName );
+			animEvent.m_timeMs		   = ParseXmlAttribute( *eventElement, "timeMs", 0.f );
+			animEvent.m_normalizedTime = ParseXmlAttribute( *eventElement, "normalizedTime", -1.f );
+			m_events.push_back( animEvent );
+		}
+
+		eventElement = eventElement->NextSiblingElement( "Event" );
+	}
+
+	SortEvents();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimEventTrack::ResolveNormalizedTimes( float clipDurationMs )
+{
+	for ( AnimEvent& animEvent : m_events )
+	{
+		if ( animEvent.m_normalizedTime >= 0.f )
+		{
+			animEvent.m_timeMs = animEvent.m_normalizedTime * clipDurationMs;
+		}
+	}
+
+	SortEvents();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// pushes the events in [startTimeMs, endTimeMs), or [startTimeMs, endTimeMs] when the tick reached the clip end
+void AnimEventTrack::CollectEvents( float startTimeMs, float endTimeMs, bool isEndInclusive, AnimationState* state, AnimEventQueue& eventQueue ) const
+{
+	auto isEventBefore = []( AnimEvent const& animEvent, float timeMs ) { return animEvent.m_timeMs < timeMs; };
+
+	auto eventIter = std::lower_bound( m_events.begin(), m_events.end(), startTimeMs, isEventBefore );
+	for ( ; eventIter != m_events.end(); ++eventIter )
+	{
+		bool isPastRange = eventIter->m_timeMs > endTimeMs || ( eventIter->m_timeMs == endTimeMs && !isEndInclusive );
+		if ( isPastRange )
+		{
+			break;
+		}
+
+		eventQueue.Push( eventIter->m_nameId, state, eventIter->m_timeMs );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimEventTrack::SortEvents()
+{
+	std::stable_sort( m_events.begin(), m_events.end(), []( AnimEvent const& a, AnimEvent const& b ) { return a.m_timeMs < b.m_timeMs; } );
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Game/AnimNameTable.hpp"
+
+#include "Engine/Core/XmlUtils.hpp"
+
+#include <vector>
+
+class AnimationState;
+
+
+//----------------------------------------------------------------------------------------------------------
+struct AnimEvent
+{
+	AnimNameId m_nameId			= INVALID_ANIM_NAME_ID;
+	float	   m_timeMs			= 0.f;
+	float	   m_normalizedTime = -1.f; // authored as a fraction of the clip, resolved to ms once the clip loads
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+struct AnimEventDispatch
+{
+	AnimNameId		m_eventId = INVALID_ANIM_NAME_ID;
+	AnimationState* m_state	  = nullptr;
+	float			m_timeMs  = 0.f;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// events fired during pose updates, which may run on a worker, wait here until the main thread dispatches them
+class AnimEventQueue
+{
+public:
+	void						   Push( AnimNameId eventId, AnimationState* state, float timeMs );
+	void						   Clear();
+	bool						   IsEmpty() const;
+
+	std::vector<AnimEventDispatch> m_events;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// events of one clip sorted by time, a tick finds everything it crossed with one binary search
+class AnimEventTrack
+{
+public:
+	void				   Clear();
+	void				   LoadFromXML( XmlElement const& animStateElement );
+	void				   ResolveNormalizedTimes( float clipDurationMs );
+	void				   CollectEvents( float startTimeMs, float endTimeMs, bool isEndInclusive, AnimationState* state, AnimEventQueue& eventQueue ) const;
+
+	std::vector<AnimEvent> m_events;
+	void				   SortEvents();
+};
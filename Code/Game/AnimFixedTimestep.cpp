@@ -0,0 +1,75 @@
+#include "Game/AnimFixedTimestep.hpp"
+
+#include <cmath>
+
+
+//----------------------------------------------------------------------------------------------------------
+// a rate of zero or less disables fixed stepping
+void AnimFixedTimestep::Startup( float stepsPerSecond, int maxStepsPerFrame )
+{
+	m_stepMicroseconds		  = stepsPerSecond > 0.f ? ( int64_t ) llroundf( 1000000.f / stepsPerSecond ) : 0;
+	m_maxStepsPerFrame		  = maxStepsPerFrame < 1 ? 1 : maxStepsPerFrame;
+	m_accumulatedMicroseconds = 0;
+	m_numStepsThisFrame		  = 0;
+	m_totalNumSteps			  = 0;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// returns how many steps to simulate this frame
+int AnimFixedTimestep::Advance( float frameDeltaSeconds )
+{
+	m_numStepsThisFrame = 0;
+	if ( !IsEnabled() )
+	{
+		return 0;
+	}
+
+	m_accumulatedMicroseconds += ( int64_t ) llroundf( frameDeltaSeconds * 1000000.f );
+
+	m_numStepsThisFrame		   = ( int ) ( m_accumulatedMicroseconds / m_stepMicroseconds );
+	m_accumulatedMicroseconds -= m_numStepsThisFrame * m_stepMicroseconds;
+
+	// a long frame drops the time it can't catch up on instead of making the next frame longer still
+	if ( m_numStepsThisFrame > m_maxStepsPerFrame )
+	{
+		m_numStepsThisFrame = m_maxStepsPerFrame;
+	}
+
+	m_totalNumSteps += m_numStepsThisFrame;
+	return m_numStepsThisFrame;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool AnimFixedTimestep::IsEnabled() const
+{
+	return m_stepMicroseconds > 0;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+float AnimFixedTimestep::GetStepSeconds() const
+{
+	return ( float ) m_stepMicroseconds / 1000000.f;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+float AnimFixedTimestep::GetSimulatedSecondsThisFrame() const
+{
+	return ( float ) ( m_numStepsThisFrame * m_stepMicroseconds ) / 1000000.f;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// how far render time is past the last simulated step, in steps
+float AnimFixedTimestep::GetInterpolationFraction() const
+{
+	if ( !IsEnabled() )
+	{
+		return 1.f;
+	}
+
+	return ( float ) m_accumulatedMicroseconds / ( float ) m_stepMicroseconds;
+}
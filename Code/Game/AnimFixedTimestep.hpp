@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+
+
+//----------------------------------------------------------------------------------------------------------
+// splits variable frame time into whole simulation steps, time is kept in integer microseconds so the same
+// sequence of frame times always produces the same sequence of steps
+class AnimFixedTimestep
+{
+public:
+	void	Startup( float stepsPerSecond, int maxStepsPerFrame );
+	int		Advance( float frameDeltaSeconds );
+	bool	IsEnabled() const;
+	float	GetStepSeconds() const;
+	float	GetSimulatedSecondsThisFrame() const;
+	float	GetInterpolationFraction() const;
+
+	int64_t m_stepMicroseconds		  = 0;
+	int64_t m_accumulatedMicroseconds = 0;
+	int		m_maxStepsPerFrame		  = 4;
+	int		m_numStepsThisFrame		  = 0;
+	int64_t m_totalNumSteps			  = 0;
+};
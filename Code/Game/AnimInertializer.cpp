@@ -0,0 +1,157 @@
+#include "Game/AnimInertializer.hpp"
+
+#include "Engine/Math/MathUtils.hpp"
+
+#include <utility>
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimInertializer::Startup( AnimPose const& skeletonPose )
+{
+	// every scratch pose is sized to the skeleton once, transitions only overwrite them
+	m_lastOutputPose	 = skeletonPose;
+	m_previousOutputPose = skeletonPose;
+	m_velocity			 = skeletonPose;
+	m_extrapolatedPose	 = skeletonPose;
+	m_offset			 = skeletonPose;
+	m_decayedOffset		 = skeletonPose;
+	m_outputPose		 = skeletonPose;
+	m_identityOffset	 = skeletonPose;
+	m_lastOutputPose.GetDifference( m_previousOutputPose, m_identityOffset );
+
+	m_numRecordedPoses = 0;
+	m_isActive		   = false;
+	m_isOffsetPending  = false;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// the target state is sampled later in the frame, so the offset is recorded on the first update
+void AnimInertializer::Begin( float durationMs )
+{
+	m_isActive		  = true;
+	m_isOffsetPending = true;
+	m_durationMs	  = durationMs;
+	m_elapsedMs		  = 0.f;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimInertializer::Stop()
+{
+	m_isActive		  = false;
+	m_isOffsetPending = false;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimInertializer::Update( AnimPose const& targetPose, float deltaMs )
+{
+	if ( !m_isActive )
+	{
+		return;
+	}
+
+	if ( m_isOffsetPending )
+	{
+		RecordOffset( targetPose );
+		m_isOffsetPending = false;
+	}
+	else
+	{
+		m_elapsedMs += deltaMs;
+	}
+
+	if ( m_elapsedMs >= m_durationMs ) // offset fully decayed
+	{
+		m_isActive = false;
+		return;
+	}
+
+	float decayFraction = GetDecayFraction( m_elapsedMs, m_durationMs );
+	AnimPose::Blend( m_decayedOffset, m_identityOffset, m_offset, decayFraction, -1 );
+	targetPose.GetAddition( m_decayedOffset, m_outputPose );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool AnimInertializer::IsActive() const
+{
+	return m_isActive;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+float AnimInertializer::GetProgress() const
+{
+	if ( !m_isActive || m_durationMs <= 0.f )
+	{
+		return 1.f;
+	}
+
+	return 1.f - GetDecayFraction( m_elapsedMs, m_durationMs );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+AnimPose const& AnimInertializer::GetOutputPose() const
+{
+	return m_outputPose;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimInertializer::RecordOutputPose( AnimPose const& outputPose )
+{
+	std::swap( m_previousOutputPose, m_lastOutputPose );
+	m_lastOutputPose = outputPose;
+	m_numRecordedPoses++;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// the recorded poses are stale once recording stops, so they are never offset from
+void AnimInertializer::ClearRecordedPoses()
+{
+	m_numRecordedPoses = 0;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimInertializer::RecordOffset( AnimPose const& targetPose )
+{
+	// nothing was recorded from the outgoing state, the transition cuts instead of starting from a stale pose
+	if ( m_numRecordedPoses == 0 )
+	{
+		m_offset = m_identityOffset;
+		return;
+	}
+
+	// carry the outgoing motion one frame forward, so the first output continues at the outgoing velocity
+	if ( m_numRecordedPoses >= 2 )
+	{
+		m_lastOutputPose.GetDifference( m_previousOutputPose, m_velocity );
+		m_lastOutputPose.GetAddition( m_velocity, m_extrapolatedPose );
+	}
+	else
+	{
+		m_extrapolatedPose = m_lastOutputPose;
+	}
+
+	// an interrupted inertialization starts from what was on screen, so evaluations never stack
+	m_extrapolatedPose.GetDifference( targetPose, m_offset );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// quintic ease out, starts and ends with zero velocity and acceleration so the offset fades without a pop
+float AnimInertializer::GetDecayFraction( float elapsedMs, float durationMs )
+{
+	if ( durationMs <= 0.f )
+	{
+		return 0.f;
+	}
+
+	float parametricZeroToOne = GetClamped( elapsedMs / durationMs, 0.f, 1.f );
+	return 1.f - SmoothStep5( parametricZeroToOne );
+}
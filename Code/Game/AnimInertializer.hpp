@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Engine/Animation/AnimPose.hpp"
+
+
+//----------------------------------------------------------------------------------------------------------
+// transition without evaluating the outgoing state, the offset between the last output pose and the first
+// pose of the target state is recorded once and decayed to identity on top of the target state's pose
+class AnimInertializer
+{
+public:
+	void			Startup( AnimPose const& skeletonPose );
+	void			Begin( float durationMs );
+	void			Stop();
+	void			Update( AnimPose const& targetPose, float deltaMs );
+	bool			IsActive() const;
+	float			GetProgress() const;
+	AnimPose const& GetOutputPose() const;
+
+	// displayed poses are recorded only while an inertialized transition can start, the last two give the pose and
+	// velocity the offset starts from
+	void			RecordOutputPose( AnimPose const& outputPose );
+	void			ClearRecordedPoses();
+	AnimPose		m_lastOutputPose;
+	AnimPose		m_previousOutputPose;
+	int				m_numRecordedPoses = 0;
+
+	// offset decay
+	bool			m_isActive		   = false;
+	bool			m_isOffsetPending  = false;
+	float			m_durationMs	   = 0.f;
+	float			m_elapsedMs		   = 0.f;
+	AnimPose		m_identityOffset;
+	AnimPose		m_velocity;
+	AnimPose		m_extrapolatedPose;
+	AnimPose		m_offset;
+	AnimPose		m_decayedOffset;
+	AnimPose		m_outputPose;
+	void			RecordOffset( AnimPose const& targetPose );
+	static float	GetDecayFraction( float elapsedMs, float durationMs );
+};
@@ -0,0 +1,110 @@
+#include "Game/AnimNameTable.hpp"
+
+
+//----------------------------------------------------------------------------------------------------------
+// must match the order of AnimName
+static char const* const WELL_KNOWN_ANIM_NAMES[ NUM_WELL_KNOWN_ANIM_NAMES ] = {
+	"idle",
+	"walk",
+	"run",
+	"runStop",
+	"runningSlide",
+	"jump",
+	"runningJump",
+	"crouch",
+	"crouchedIdle",
+	"crouchedWalk",
+	"standToCrouch",
+	"crouchToStand",
+	"vault",
+	"idleToLedgeGrab",
+	"hang",
+	"hangDrop",
+	"hangToIdle",
+	"shimmyRight",
+	"shimmyLeft",
+	"climbOver",
+	"walkingEdgeSlip",
+	"idleToActionIdle",
+	"idleDropToFreeHang",
+	"freeHangToBracedHang",
+	"end",
+	"footstepLeft",
+	"footstepRight",
+	"handContact",
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+AnimNameTable::AnimNameTable()
+{
+	for ( int nameIndex = 0; nameIndex < NUM_WELL_KNOWN_ANIM_NAMES; nameIndex++ )
+	{
+		m_idsByName[ WELL_KNOWN_ANIM_NAMES[ nameIndex ] ] = nameIndex;
+		m_namesById.push_back( WELL_KNOWN_ANIM_NAMES[ nameIndex ] );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+AnimNameTable& AnimNameTable::GetInstance()
+{
+	static AnimNameTable s_nameTable;
+	return s_nameTable;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+AnimNameId AnimNameTable::Intern( std::string const& name )
+{
+	AnimNameTable& nameTable = GetInstance();
+
+	auto iter = nameTable.m_idsByName.find( name );
+	if ( iter != nameTable.m_idsByName.cend() )
+	{
+		return iter->second;
+	}
+
+	AnimNameId nameId			  = ( AnimNameId ) nameTable.m_namesById.size();
+	nameTable.m_idsByName[ name ] = nameId;
+	nameTable.m_namesById.push_back( name );
+
+	return nameId;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+AnimNameId AnimNameTable::Find( std::string const& name )
+{
+	AnimNameTable const& nameTable = GetInstance();
+
+	auto iter = nameTable.m_idsByName.find( name );
+	if ( iter != nameTable.m_idsByName.cend() )
+	{
+		return iter->second;
+	}
+
+	return INVALID_ANIM_NAME_ID;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+std::string const& AnimNameTable::GetName( AnimNameId nameId )
+{
+	static std::string const s_invalidName = "UNKOWN NAME";
+
+	AnimNameTable const& nameTable = GetInstance();
+	if ( nameId < 0 || nameId >= ( AnimNameId ) nameTable.m_namesById.size() )
+	{
+		return s_invalidName;
+	}
+
+	return nameTable.m_namesById[ nameId ];
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+int AnimNameTable::GetNumNames()
+{
+	return ( int ) GetInstance().m_namesById.size();
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+
+//----------------------------------------------------------------------------------------------------------
+typedef int			 AnimNameId;
+constexpr AnimNameId INVALID_ANIM_NAME_ID = -1;
+
+
+//----------------------------------------------------------------------------------------------------------
+// state and transition names the code refers to directly, interned first and in this order so their ids are
+// known at compile time; names that only appear in the anim config are interned when it loads
+enum AnimName : AnimNameId
+{
+	ANIM_NAME_IDLE,
+	ANIM_NAME_WALK,
+	ANIM_NAME_RUN,
+	ANIM_NAME_RUN_STOP,
+	ANIM_NAME_RUNNING_SLIDE,
+	ANIM_NAME_JUMP,
+	ANIM_NAME_RUNNING_JUMP,
+	ANIM_NAME_CROUCH,
+	ANIM_NAME_CROUCHED_IDLE,
+	ANIM_NAME_CROUCHED_WALK,
+	ANIM_NAME_STAND_TO_CROUCH,
+	ANIM_NAME_CROUCH_TO_STAND,
+	ANIM_NAME_VAULT,
+	ANIM_NAME_IDLE_TO_LEDGE_GRAB,
+	ANIM_NAME_HANG,
+	ANIM_NAME_HANG_DROP,
+	ANIM_NAME_HANG_TO_IDLE,
+	ANIM_NAME_SHIMMY_RIGHT,
+	ANIM_NAME_SHIMMY_LEFT,
+	ANIM_NAME_CLIMB_OVER,
+	ANIM_NAME_WALKING_EDGE_SLIP,
+	ANIM_NAME_IDLE_TO_ACTION_IDLE,
+	ANIM_NAME_IDLE_DROP_TO_FREE_HANG,
+	ANIM_NAME_FREE_HANG_TO_BRACED_HANG,
+
+	// animation events
+	ANIM_NAME_EVENT_END,
+	ANIM_NAME_EVENT_FOOTSTEP_LEFT,
+	ANIM_NAME_EVENT_FOOTSTEP_RIGHT,
+	ANIM_NAME_EVENT_HAND_CONTACT,
+	NUM_WELL_KNOWN_ANIM_NAMES
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// dense integer ids for animation state and transition names, strings are kept only for debugging and loading
+class AnimNameTable
+{
+public:
+	static AnimNameId		  Intern( std::string const& name );
+	static AnimNameId		  Find( std::string const& name );
+	static std::string const& GetName( AnimNameId nameId );
+	static int				  GetNumNames();
+
+private:
+	AnimNameTable();
+	static AnimNameTable& GetInstance();
+
+	std::map<std::string, AnimNameId> m_idsByName;
+	std::vector<std::string>		  m_namesById;
+};
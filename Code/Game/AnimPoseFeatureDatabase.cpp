@@ -0,0 +1,261 @@
+#include "Game/AnimPoseFeatureDatabase.hpp"
+
+#include "Engine/Animation/AnimClip.hpp"
+#include "Engine/Animation/AnimPose.hpp"
+#include "Engine/Math/Vec3.hpp"
+
+#include <float.h>
+#include <math.h>
+
+
+//----------------------------------------------------------------------------------------------------------
+static int GetRootJoint( AnimPose const& pose )
+{
+	for ( int jointIndex = 0; jointIndex < pose.GetNumberOfJoints(); jointIndex++ )
+	{
+		if ( pose.GetParentOfJoint( jointIndex ) < 0 )
+		{
+			return jointIndex;
+		}
+	}
+
+	return 0;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+static float GetDistanceSquared( Vec3 const& a, Vec3 const& b )
+{
+	Vec3 displacement = b - a;
+	return displacement.x * displacement.x + displacement.y * displacement.y + displacement.z * displacement.z;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// joints with no children, each picked farthest from the root and the ones already picked, gives the hands,
+// feet and head of a humanoid without looking joints up by name
+void AnimPoseFeatureDatabase::SelectFeatureJoints( AnimPose const& restPose, std::vector<int>& out_featureJoints )
+{
+	out_featureJoints.clear();
+
+	int				  numJoints = restPose.GetNumberOfJoints();
+	std::vector<bool> hasChild( numJoints, false );
+	for ( int jointIndex = 0; jointIndex < numJoints; jointIndex++ )
+	{
+		int parentIndex = restPose.GetParentOfJoint( jointIndex );
+		if ( parentIndex >= 0 && parentIndex < numJoints )
+		{
+			hasChild[ parentIndex ] = true;
+		}
+	}
+
+	int				   rootJoint = GetRootJoint( restPose );
+	std::vector<float> closestPickedDistance( numJoints, 0.f );
+	for ( int jointIndex = 0; jointIndex < numJoints; jointIndex++ )
+	{
+		closestPickedDistance[ jointIndex ] = GetDistanceSquared( restPose.GetGlobalTransformOfJoint( rootJoint ).m_position, restPose.GetGlobalTransformOfJoint( jointIndex ).m_position );
+	}
+
+	while ( ( int ) out_featureJoints.size() < MAX_POSE_FEATURE_JOINTS )
+	{
+		int	  farthestJoint	   = -1;
+		float farthestDistance = 0.f;
+		for ( int jointIndex = 0; jointIndex < numJoints; jointIndex++ )
+		{
+			if ( !hasChild[ jointIndex ] && closestPickedDistance[ jointIndex ] > farthestDistance )
+			{
+				farthestJoint	 = jointIndex;
+				farthestDistance = closestPickedDistance[ jointIndex ];
+			}
+		}
+
+		if ( farthestJoint < 0 )
+		{
+			break;
+		}
+
+		out_featureJoints.push_back( farthestJoint );
+		Vec3 const& pickedPosition = restPose.GetGlobalTransformOfJoint( farthestJoint ).m_position;
+		for ( int jointIndex = 0; jointIndex < numJoints; jointIndex++ )
+		{
+			float distance = GetDistanceSquared( pickedPosition, restPose.GetGlobalTransformOfJoint( jointIndex ).m_position );
+			if ( distance < closestPickedDistance[ jointIndex ] )
+			{
+				closestPickedDistance[ jointIndex ] = distance;
+			}
+		}
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimPoseFeatureDatabase::Build( AnimClip& clip, AnimPose const& restPose, std::vector<int> const& featureJoints, float sampleRateHz )
+{
+	Clear();
+
+	if ( featureJoints.empty() || sampleRateHz <= 0.f )
+	{
+		return;
+	}
+
+	m_startTimeMs	 = clip.GetStartTime();
+	float durationMs = clip.GetEndTime() - m_startTimeMs;
+	int	  numFrames	 = ( int ) ceilf( durationMs * sampleRateHz / 1000.f ) + 1;
+	if ( numFrames < 2 )
+	{
+		numFrames = 2;
+	}
+
+	// the interval is shrunk to fit the clip exactly, so the last frame sits on the clip's end
+	m_sampleIntervalMs = durationMs / ( float ) ( numFrames - 1 );
+	m_featureSize	   = ( int ) featureJoints.size() * POSE_FEATURE_FLOATS_PER_JOINT;
+	m_features.resize( numFrames * m_featureSize, 0.f );
+
+	// positions first, velocities are differenced from the neighbouring frames afterwards
+	AnimPose		  sampledPose = restPose;
+	int				  rootJoint	  = GetRootJoint( restPose );
+	int				  numJoints	  = ( int ) featureJoints.size();
+	std::vector<Vec3> positions( numFrames * numJoints );
+	for ( int frameIndex = 0; frameIndex < numFrames; frameIndex++ )
+	{
+		clip.Sample( GetFrameTimeMs( frameIndex ), sampledPose );
+
+		Vec3 const& rootPosition = sampledPose.GetGlobalTransformOfJoint( rootJoint ).m_position;
+		for ( int featureIndex = 0; featureIndex < numJoints; featureIndex++ )
+		{
+			positions[ frameIndex * numJoints + featureIndex ] = sampledPose.GetGlobalTransformOfJoint( featureJoints[ featureIndex ] ).m_position - rootPosition;
+		}
+	}
+
+	for ( int frameIndex = 0; frameIndex < numFrames; frameIndex++ )
+	{
+		int	   previousFrame = ( frameIndex > 0 ) ? frameIndex - 1 : frameIndex;
+		int	   nextFrame	 = ( frameIndex < numFrames - 1 ) ? frameIndex + 1 : frameIndex;
+		float  spanSeconds	 = ( float ) ( nextFrame - previousFrame ) * m_sampleIntervalMs * 0.001f;
+		float  inverseSpan	 = ( spanSeconds > 0.f ) ? 1.f / spanSeconds : 0.f;
+		float* frameFeatures = &m_features[ frameIndex * m_featureSize ];
+
+		for ( int featureIndex = 0; featureIndex < numJoints; featureIndex++ )
+		{
+			Vec3 const& position = positions[ frameIndex * numJoints + featureIndex ];
+			Vec3		velocity = ( positions[ nextFrame * numJoints + featureIndex ] - positions[ previousFrame * numJoints + featureIndex ] ) * inverseSpan;
+
+			float* jointFeatures = frameFeatures + featureIndex * POSE_FEATURE_FLOATS_PER_JOINT;
+			jointFeatures[ 0 ]	 = position.x;
+			jointFeatures[ 1 ]	 = position.y;
+			jointFeatures[ 2 ]	 = position.z;
+			jointFeatures[ 3 ]	 = velocity.x;
+			jointFeatures[ 4 ]	 = velocity.y;
+			jointFeatures[ 5 ]	 = velocity.z;
+		}
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimPoseFeatureDatabase::Clear()
+{
+	m_features.clear();
+	m_featureSize	   = 0;
+	m_startTimeMs	   = 0.f;
+	m_sampleIntervalMs = 0.f;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool AnimPoseFeatureDatabase::IsEmpty() const
+{
+	return m_features.empty();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+int AnimPoseFeatureDatabase::GetNumFrames() const
+{
+	if ( m_featureSize <= 0 )
+	{
+		return 0;
+	}
+
+	return ( int ) m_features.size() / m_featureSize;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+float AnimPoseFeatureDatabase::GetFrameTimeMs( int frameIndex ) const
+{
+	return m_startTimeMs + ( float ) frameIndex * m_sampleIntervalMs;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// nearest frame, times outside the clip clamp to its ends
+float const* AnimPoseFeatureDatabase::GetFeaturesAtTime( float timeMs ) const
+{
+	int numFrames = GetNumFrames();
+	if ( numFrames == 0 )
+	{
+		return nullptr;
+	}
+
+	int frameIndex = 0;
+	if ( m_sampleIntervalMs > 0.f )
+	{
+		frameIndex = ( int ) floorf( ( timeMs - m_startTimeMs ) / m_sampleIntervalMs + 0.5f );
+	}
+	frameIndex = ( frameIndex < 0 ) ? 0 : ( frameIndex >= numFrames ? numFrames - 1 : frameIndex );
+
+	return &m_features[ frameIndex * m_featureSize ];
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// searches the frames up to searchEndTimeMs, the first frame is always a candidate
+int AnimPoseFeatureDatabase::FindBestFrame( float const* queryFeatures, float searchEndTimeMs, float& out_cost ) const
+{
+	out_cost = FLT_MAX;
+
+	int numFrames = GetNumFrames();
+	if ( numFrames == 0 || !queryFeatures )
+	{
+		return -1;
+	}
+
+	int bestFrame = 0;
+	for ( int frameIndex = 0; frameIndex < numFrames; frameIndex++ )
+	{
+		if ( frameIndex > 0 && GetFrameTimeMs( frameIndex ) > searchEndTimeMs )
+		{
+			break;
+		}
+
+		float const* frameFeatures = &m_features[ frameIndex * m_featureSize ];
+		float		 cost		   = 0.f;
+		for ( int featureIndex = 0; featureIndex < m_featureSize && cost < out_cost; featureIndex += POSE_FEATURE_FLOATS_PER_JOINT )
+		{
+			float const* query = queryFeatures + featureIndex;
+			float const* frame = frameFeatures + featureIndex;
+			for ( int component = 0; component < 3; component++ )
+			{
+				float positionDelta = frame[ component ] - query[ component ];
+				float velocityDelta = frame[ component + 3 ] - query[ component + 3 ];
+				cost += positionDelta * positionDelta + POSE_FEATURE_VELOCITY_WEIGHT * velocityDelta * velocityDelta;
+			}
+		}
+
+		if ( cost < out_cost )
+		{
+			out_cost  = cost;
+			bestFrame = frameIndex;
+		}
+	}
+
+	return bestFrame;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool AnimPoseFeatureDatabase::IsCompatibleWith( AnimPoseFeatureDatabase const& other ) const
+{
+	return !IsEmpty() && !other.IsEmpty() && m_featureSize == other.m_featureSize;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vector>
+
+class AnimClip;
+class AnimPose;
+
+
+//----------------------------------------------------------------------------------------------------------
+constexpr float POSE_FEATURE_SAMPLE_RATE_HZ	  = 30.f;
+constexpr int	MAX_POSE_FEATURE_JOINTS		  = 5;
+constexpr int	POSE_FEATURE_FLOATS_PER_JOINT = 6;	  // position then velocity, both relative to the root
+constexpr float POSE_FEATURE_VELOCITY_WEIGHT  = 0.1f; // velocities are an order of magnitude larger than offsets
+
+
+//----------------------------------------------------------------------------------------------------------
+// a few key joints' positions and velocities relative to the root, sampled at a fixed rate when the clip loads
+// and packed frame after frame into one array; finding the frame closest to another pose is a linear walk over
+// contiguous floats that stops summing a frame as soon as it is worse than the best one found so far
+class AnimPoseFeatureDatabase
+{
+public:
+	void			   Build( AnimClip& clip, AnimPose const& restPose, std::vector<int> const& featureJoints, float sampleRateHz = POSE_FEATURE_SAMPLE_RATE_HZ );
+	void			   Clear();
+	bool			   IsEmpty() const;
+	int				   GetNumFrames() const;
+	float			   GetFrameTimeMs( int frameIndex ) const;
+	float const*	   GetFeaturesAtTime( float timeMs ) const;
+	int				   FindBestFrame( float const* queryFeatures, float searchEndTimeMs, float& out_cost ) const;
+	bool			   IsCompatibleWith( AnimPoseFeatureDatabase const& other ) const;
+
+	std::vector<float> m_features; // frame i starts at i * m_featureSize
+	int				   m_featureSize	  = 0;
+	float			   m_startTimeMs	  = 0.f;
+	float			   m_sampleIntervalMs = 0.f;
+
+	// end effectors spread over the skeleton, picked once from the rest pose since every clip shares it
+	static void		   SelectFeatureJoints( AnimPose const& restPose, std::vector<int>& out_featureJoints );
+};
@@ -0,0 +1,143 @@
+#include "Game/AnimRootMotionTrack.hpp"
+
+#include "Engine/Math/MathUtils.hpp"
+
+#include <math.h>
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimRootMotionTrack::Build( Vec3AnimCurve const& rootTranslationCurve, float sampleRateHz )
+{
+	Clear();
+
+	if ( rootTranslationCurve.IsEmpty() )
+	{
+		return;
+	}
+
+	m_startTimeMs		 = rootTranslationCurve.GetKeyframeAtFirstIndex().m_timeMilliSeconds;
+	m_endTimeMs			 = rootTranslationCurve.GetEndTimeMilliSeconds();
+	m_firstTranslation	 = rootTranslationCurve.Sample( m_startTimeMs, false );
+	float durationMs	 = m_endTimeMs - m_startTimeMs;
+	int	  numIntervals	 = ( int ) ceilf( durationMs * sampleRateHz / 1000.f );
+
+	m_deltas.push_back( Vec3::ZERO );
+	m_prefixSums.push_back( Vec3::ZERO );
+	if ( numIntervals < 1 )
+	{
+		return;
+	}
+
+	// the interval is shrunk to fit the clip exactly, so the last sample sits on the last keyframe
+	m_sampleIntervalMs = durationMs / ( float ) numIntervals;
+	m_deltas.reserve( numIntervals + 1 );
+	m_prefixSums.reserve( numIntervals + 1 );
+
+	Vec3 previousTranslation = m_firstTranslation;
+	for ( int sampleIndex = 1; sampleIndex <= numIntervals; sampleIndex++ )
+	{
+		float sampleTimeMs = ( sampleIndex == numIntervals ) ? m_endTimeMs : m_startTimeMs + ( float ) sampleIndex * m_sampleIntervalMs;
+		Vec3  translation  = rootTranslationCurve.Sample( sampleTimeMs, false );
+		Vec3  delta		   = translation - previousTranslation;
+
+		m_deltas.push_back( delta );
+		m_prefixSums.push_back( m_prefixSums.back() + delta );
+		previousTranslation = translation;
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimRootMotionTrack::Clear()
+{
+	m_firstTranslation = Vec3::ZERO;
+	m_deltas.clear();
+	m_prefixSums.clear();
+	m_startTimeMs	   = 0.f;
+	m_endTimeMs		   = 0.f;
+	m_sampleIntervalMs = 0.f;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool AnimRootMotionTrack::IsEmpty() const
+{
+	return m_prefixSums.empty();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+float AnimRootMotionTrack::GetStartTimeMs() const
+{
+	return m_startTimeMs;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+float AnimRootMotionTrack::GetEndTimeMs() const
+{
+	return m_endTimeMs;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+Vec3 AnimRootMotionTrack::GetFirstTranslation() const
+{
+	return m_firstTranslation;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+Vec3 AnimRootMotionTrack::GetLastTranslation() const
+{
+	return m_firstTranslation + GetTotalDisplacement();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+Vec3 AnimRootMotionTrack::GetTranslationAtTime( float timeMs ) const
+{
+	return m_firstTranslation + GetPrefixSumAtTime( timeMs );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+Vec3 AnimRootMotionTrack::GetDisplacement( float startTimeMs, float endTimeMs ) const
+{
+	return GetPrefixSumAtTime( endTimeMs ) - GetPrefixSumAtTime( startTimeMs );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+Vec3 AnimRootMotionTrack::GetTotalDisplacement() const
+{
+	if ( IsEmpty() )
+	{
+		return Vec3::ZERO;
+	}
+
+	return m_prefixSums.back();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// times outside the clip clamp to its ends, like sampling the curve without looping
+Vec3 AnimRootMotionTrack::GetPrefixSumAtTime( float timeMs ) const
+{
+	if ( IsEmpty() || m_sampleIntervalMs <= 0.f )
+	{
+		return GetTotalDisplacement();
+	}
+
+	float clampedTimeMs	  = GetClamped( timeMs, m_startTimeMs, m_endTimeMs );
+	float sampleIndexTime = ( clampedTimeMs - m_startTimeMs ) / m_sampleIntervalMs;
+	int	  sampleIndex	  = ( int ) sampleIndexTime;
+	int	  lastIndex		  = ( int ) m_prefixSums.size() - 1;
+	if ( sampleIndex >= lastIndex )
+	{
+		return m_prefixSums[ lastIndex ];
+	}
+
+	float fraction = sampleIndexTime - ( float ) sampleIndex;
+	return m_prefixSums[ sampleIndex ] + m_deltas[ sampleIndex + 1 ] * fraction;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Engine/Animation/AnimCurve.hpp"
+#include "Engine/Math/Vec3.hpp"
+
+#include <vector>
+
+
+//----------------------------------------------------------------------------------------------------------
+constexpr float ROOT_MOTION_TRACK_SAMPLE_RATE_HZ = 120.f;
+
+
+//----------------------------------------------------------------------------------------------------------
+// the root joint's translation resampled at a fixed rate into per sample deltas and their running sum, built
+// once when the clip loads; the translation at a time is one index and one lerp, so the displacement between
+// two times, the end position or the height part way through never search the keyframes
+class AnimRootMotionTrack
+{
+public:
+	void			  Build( Vec3AnimCurve const& rootTranslationCurve, float sampleRateHz = ROOT_MOTION_TRACK_SAMPLE_RATE_HZ );
+	void			  Clear();
+	bool			  IsEmpty() const;
+	float			  GetStartTimeMs() const;
+	float			  GetEndTimeMs() const;
+	Vec3			  GetFirstTranslation() const;
+	Vec3			  GetLastTranslation() const;
+	Vec3			  GetTranslationAtTime( float timeMs ) const;
+	Vec3			  GetDisplacement( float startTimeMs, float endTimeMs ) const;
+	Vec3			  GetTotalDisplacement() const;
+
+	Vec3			  m_firstTranslation = Vec3::ZERO;
+	std::vector<Vec3> m_deltas;		// translation at sample i minus sample i - 1, the first is zero
+	std::vector<Vec3> m_prefixSums; // sum of the deltas up to and including sample i
+	float			  m_startTimeMs		 = 0.f;
+	float			  m_endTimeMs		 = 0.f;
+	float			  m_sampleIntervalMs = 0.f;
+	Vec3			  GetPrefixSumAtTime( float timeMs ) const;
+};
@@ -0,0 +1,147 @@
+#include "Game/AnimRootSampler.hpp"
+
+#include "Engine/Animation/AnimClip.hpp"
+
+#include <math.h>
+#include <vector>
+
+
+//----------------------------------------------------------------------------------------------------------
+// leaves the cursor on the last keyframe at or before timeMs, a loop or restart goes back to the first key once
+template <typename KeyframeType>
+static unsigned int SeekCursor( std::vector<KeyframeType> const& keyframes, float timeMs, unsigned int cursor )
+{
+	unsigned int lastIndex = ( unsigned int ) keyframes.size() - 1;
+	if ( cursor > lastIndex || keyframes[ cursor ].m_timeMilliSeconds > timeMs )
+	{
+		cursor = 0;
+	}
+
+	while ( cursor < lastIndex && keyframes[ cursor + 1 ].m_timeMilliSeconds <= timeMs )
+	{
+		cursor++;
+	}
+
+	return cursor;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+template <typename KeyframeType>
+static float GetFractionToNextKeyframe( std::vector<KeyframeType> const& keyframes, float timeMs, unsigned int cursor )
+{
+	float startTimeMs = keyframes[ cursor ].m_timeMilliSeconds;
+	float endTimeMs	  = keyframes[ cursor + 1 ].m_timeMilliSeconds;
+	if ( endTimeMs <= startTimeMs )
+	{
+		return 0.f;
+	}
+
+	float fraction = ( timeMs - startTimeMs ) / ( endTimeMs - startTimeMs );
+	return fraction < 0.f ? 0.f : ( fraction > 1.f ? 1.f : fraction );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// normalized lerp on the shorter arc, keyframes are close enough together that slerp buys nothing here
+static Quaternion NlerpRotation( Quaternion const& start, Quaternion const& end, float fraction )
+{
+	float dot  = start.x * end.x + start.y * end.y + start.z * end.z + start.w * end.w;
+	float sign = ( dot < 0.f ) ? -1.f : 1.f;
+
+	Quaternion result;
+	result.x	 = start.x + ( end.x * sign - start.x ) * fraction;
+	result.y	 = start.y + ( end.y * sign - start.y ) * fraction;
+	result.z	 = start.z + ( end.z * sign - start.z ) * fraction;
+	result.w	 = start.w + ( end.w * sign - start.w ) * fraction;
+	float length = sqrtf( result.x * result.x + result.y * result.y + result.z * result.z + result.w * result.w );
+	if ( length > 0.f )
+	{
+		result.x /= length;
+		result.y /= length;
+		result.z /= length;
+		result.w /= length;
+	}
+
+	return result;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimRootSampler::Bind( AnimClip const* clip )
+{
+	m_clip				= clip;
+	m_translationCursor = 0;
+	m_rotationCursor	= 0;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool AnimRootSampler::IsBoundTo( AnimClip const* clip ) const
+{
+	return m_clip == clip;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+AnimRootSample AnimRootSampler::Sample( float timeMs )
+{
+	AnimRootSample rootSample;
+	rootSample.m_translation = SampleTranslation( timeMs );
+	rootSample.m_rotation	 = SampleRotation( timeMs );
+
+	return rootSample;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+Vec3 AnimRootSampler::SampleTranslation( float timeMs )
+{
+	if ( !m_clip || m_clip->m_animChannels.empty() )
+	{
+		return Vec3::ZERO;
+	}
+
+	auto const& keyframes = m_clip->m_animChannels[ 0 ].m_positionCurve.m_keyframes;
+	if ( keyframes.empty() )
+	{
+		return Vec3::ZERO;
+	}
+
+	m_translationCursor = SeekCursor( keyframes, timeMs, m_translationCursor );
+	if ( m_translationCursor + 1 >= ( unsigned int ) keyframes.size() )
+	{
+		return keyframes[ m_translationCursor ].m_value;
+	}
+
+	float fraction = GetFractionToNextKeyframe( keyframes, timeMs, m_translationCursor );
+	Vec3  start	   = keyframes[ m_translationCursor ].m_value;
+	Vec3  end	   = keyframes[ m_translationCursor + 1 ].m_value;
+
+	return start + ( end - start ) * fraction;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+Quaternion AnimRootSampler::SampleRotation( float timeMs )
+{
+	if ( !m_clip || m_clip->m_animChannels.empty() )
+	{
+		return Quaternion::IDENTITY;
+	}
+
+	auto const& keyframes = m_clip->m_animChannels[ 0 ].m_rotationCurve.m_keyframes;
+	if ( keyframes.empty() )
+	{
+		return Quaternion::IDENTITY;
+	}
+
+	m_rotationCursor = SeekCursor( keyframes, timeMs, m_rotationCursor );
+	if ( m_rotationCursor + 1 >= ( unsigned int ) keyframes.size() )
+	{
+		return keyframes[ m_rotationCursor ].m_value;
+	}
+
+	float fraction = GetFractionToNextKeyframe( keyframes, timeMs, m_rotationCursor );
+	return NlerpRotation( keyframes[ m_rotationCursor ].m_value, keyframes[ m_rotationCursor + 1 ].m_value, fraction );
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Engine/Math/Quaternion.hpp"
+#include "Engine/Math/Vec3.hpp"
+
+class AnimClip;
+
+
+//----------------------------------------------------------------------------------------------------------
+struct AnimRootSample
+{
+	Vec3	   m_translation = Vec3::ZERO;
+	Quaternion m_rotation	 = Quaternion::IDENTITY;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// samples only the root channel of a clip, reading its keyframes in place; a cursor per curve remembers the
+// last keyframe so playback that moves forward a little each frame finds its keys without searching
+class AnimRootSampler
+{
+public:
+	void			Bind( AnimClip const* clip );
+	bool			IsBoundTo( AnimClip const* clip ) const;
+	AnimRootSample	Sample( float timeMs );
+	Vec3			SampleTranslation( float timeMs );
+	Quaternion		SampleRotation( float timeMs );
+
+	AnimClip const* m_clip				= nullptr;
+	unsigned int	m_translationCursor = 0;
+	unsigned int	m_rotationCursor	= 0;
+};
@@ -0,0 +1,427 @@
+#include "Game/AnimStateMachineTable.hpp"
+#include "Game/AnimAssetArchive.hpp"
+
+#include "Engine/Core/ErrorWarningAssert.hpp"
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimStateMachineTable::Clear()
+{
+	m_states.clear();
+	m_transitions.clear();
+	m_stateIndexByNameId.clear();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+static void AddTransitionFromXML( std::vector<AnimStateMachineTransition>& transitions, XmlElement const& transitionElement, std::string const& name,
+	std::vector<int> const& stateIndexByNameId )
+{
+	AnimStateMachineTransition transition;
+	transition.m_nameId			= AnimNameTable::Intern( name );
+	transition.m_fadeDurationMs = ParseXmlAttribute( transitionElement, "fadeDurationMs", 0.f );
+
+	std::string blendModeName = ParseXmlAttribute( transitionElement, "blendMode", "crossfade" );
+	if ( blendModeName == "inertialize" )
+	{
+		transition.m_blendMode = AnimTransitionBlendMode::INERTIALIZE;
+	}
+	else if ( blendModeName != "crossfade" )
+	{
+		DebuggerPrintf( "Error: Transition %s has unknown blend mode %s\n", name.c_str(), blendModeName.c_str() );
+	}
+
+	std::string entryName = ParseXmlAttribute( transitionElement, "entry", "start" );
+	if ( entryName == "poseMatch" )
+	{
+		transition.m_isPoseMatched = true;
+	}
+	else if ( entryName != "start" )
+	{
+		DebuggerPrintf( "Error: Transition %s has unknown entry %s\n", name.c_str(), entryName.c_str() );
+	}
+
+	std::string targetStateName = ParseXmlAttribute( transitionElement, "animationState", "" );
+	if ( !targetStateName.empty() )
+	{
+		AnimNameId targetNameId = AnimNameTable::Intern( targetStateName );
+		if ( targetNameId < ( AnimNameId ) stateIndexByNameId.size() )
+		{
+			transition.m_targetState = stateIndexByNameId[ targetNameId ];
+		}
+
+		if ( transition.m_targetState == INVALID_ANIM_STATE_MACHINE_INDEX )
+		{
+			DebuggerPrintf( "Error: Transition %s targets unknown animation state %s\n", name.c_str(), targetStateName.c_str() );
+		}
+	}
+
+	transitions.push_back( transition );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool AnimStateMachineTable::CompileFromXML( XmlElement const& animConfigRootElement )
+{
+	Clear();
+
+	// states first, so transitions can resolve their targets to indices
+	XmlElement const* animStateElement = animConfigRootElement.FirstChildElement( "AnimationState" );
+	while ( animStateElement )
+	{
+		AnimStateMachineState state;
+		state.m_nameId = AnimNameTable::Intern( ParseXmlAttribute( *animStateElement, "name", "" ) );
+		m_states.push_back( state );
+
+		animStateElement = animStateElement->NextSiblingElement( "AnimationState" );
+	}
+	BuildStateIndexByNameId();
+
+	int stateIndex	 = 0;
+	animStateElement = animConfigRootElement.FirstChildElement( "AnimationState" );
+	while ( animStateElement )
+	{
+		AnimStateMachineState& state		 = m_states[ stateIndex ];
+		state.m_firstTransition				 = ( int ) m_transitions.size();
+		XmlElement const* transitionsElement = animStateElement->FirstChildElement( "Transitions" );
+		if ( transitionsElement )
+		{
+			XmlElement const* transitionElement = transitionsElement->FirstChildElement( "Transition" );
+			while ( transitionElement )
+			{
+				AddTransitionFromXML( m_transitions, *transitionElement, ParseXmlAttribute( *transitionElement, "name", "" ), m_stateIndexByNameId );
+				transitionElement = transitionElement->NextSiblingElement( "Transition" );
+			}
+			state.m_numTransitions = ( int ) m_transitions.size() - state.m_firstTransition;
+
+			XmlElement const* transitionEndElement = transitionsElement->FirstChildElement( "TransitionEnd" );
+			if ( transitionEndElement )
+			{
+				state.m_endTransition = ( int ) m_transitions.size();
+				AddTransitionFromXML( m_transitions, *transitionEndElement, "Transition End", m_stateIndexByNameId );
+			}
+
+			XmlElement const* popOutTransitionElement = transitionsElement->FirstChildElement( "PopOutTransition" );
+			if ( popOutTransitionElement )
+			{
+				state.m_popOutTransition = ( int ) m_transitions.size();
+				AddTransitionFromXML( m_transitions, *popOutTransitionElement, "Pop Out Transition", m_stateIndexByNameId );
+			}
+		}
+
+		stateIndex++;
+		animStateElement = animStateElement->NextSiblingElement( "AnimationState" );
+	}
+
+	return true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool AnimStateMachineTable::CompileFromXmlFile( std::string const& animConfigPath )
+{
+	XmlDocument animConfigDocument;
+	if ( animConfigDocument.LoadFile( animConfigPath.c_str() ) != tinyxml2::XML_SUCCESS || !animConfigDocument.RootElement() )
+	{
+		DebuggerPrintf( "Error: Unable to compile state machine from anim config: %s\n", animConfigPath.c_str() );
+		return false;
+	}
+
+	return CompileFromXML( *animConfigDocument.RootElement() );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+static int AppendPatchedTransition( std::vector<AnimStateMachineTransition>& transitions, AnimStateMachineTransition const& patchedTransition,
+	std::vector<int> const& existingIndexByPatchedIndex )
+{
+	AnimStateMachineTransition transition = patchedTransition;
+	if ( transition.m_targetState != INVALID_ANIM_STATE_MACHINE_INDEX )
+	{
+		transition.m_targetState = existingIndexByPatchedIndex[ transition.m_targetState ];
+	}
+	transitions.push_back( transition );
+
+	return ( int ) transitions.size() - 1;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// hot reload: the transitions are compiled again but every state keeps its index, since controllers, the prefetcher
+// and the motion matching database hold state indices; a config that adds, removes or repeats states is rejected and
+// the table is left untouched
+bool AnimStateMachineTable::PatchFromXML( XmlElement const& animConfigRootElement )
+{
+	AnimStateMachineTable patchedTable;
+	patchedTable.CompileFromXML( animConfigRootElement );
+	if ( patchedTable.GetNumStates() != GetNumStates() )
+	{
+		return false;
+	}
+
+	std::vector<int> existingIndexByPatchedIndex( m_states.size(), INVALID_ANIM_STATE_MACHINE_INDEX );
+	std::vector<int> patchedIndexByExistingIndex( m_states.size(), INVALID_ANIM_STATE_MACHINE_INDEX );
+	for ( int patchedIndex = 0; patchedIndex < patchedTable.GetNumStates(); patchedIndex++ )
+	{
+		int existingIndex = GetStateIndex( patchedTable.m_states[ patchedIndex ].m_nameId );
+		if ( existingIndex == INVALID_ANIM_STATE_MACHINE_INDEX || patchedIndexByExistingIndex[ existingIndex ] != INVALID_ANIM_STATE_MACHINE_INDEX )
+		{
+			return false;
+		}
+
+		existingIndexByPatchedIndex[ patchedIndex ]	 = existingIndex;
+		patchedIndexByExistingIndex[ existingIndex ] = patchedIndex;
+	}
+
+	// lay the transitions out again in the existing state order, with their targets remapped
+	std::vector<AnimStateMachineTransition> transitions;
+	transitions.reserve( patchedTable.m_transitions.size() );
+	for ( int existingIndex = 0; existingIndex < GetNumStates(); existingIndex++ )
+	{
+		AnimStateMachineState const& patchedState = patchedTable.m_states[ patchedIndexByExistingIndex[ existingIndex ] ];
+		AnimStateMachineState&		 state		  = m_states[ existingIndex ];
+
+		state.m_firstTransition					  = ( int ) transitions.size();
+		state.m_numTransitions					  = patchedState.m_numTransitions;
+		for ( int transitionIndex = patchedState.m_firstTransition; transitionIndex < patchedState.m_firstTransition + patchedState.m_numTransitions; transitionIndex++ )
+		{
+			AppendPatchedTransition( transitions, patchedTable.m_transitions[ transitionIndex ], existingIndexByPatchedIndex );
+		}
+
+		state.m_endTransition	 = INVALID_ANIM_STATE_MACHINE_INDEX;
+		state.m_popOutTransition = INVALID_ANIM_STATE_MACHINE_INDEX;
+		if ( patchedState.m_endTransition != INVALID_ANIM_STATE_MACHINE_INDEX )
+		{
+			state.m_endTransition = AppendPatchedTransition( transitions, patchedTable.m_transitions[ patchedState.m_endTransition ], existingIndexByPatchedIndex );
+		}
+		if ( patchedState.m_popOutTransition != INVALID_ANIM_STATE_MACHINE_INDEX )
+		{
+			state.m_popOutTransition = AppendPatchedTransition( transitions, patchedTable.m_transitions[ patchedState.m_popOutTransition ], existingIndexByPatchedIndex );
+		}
+	}
+	m_transitions.swap( transitions );
+
+	// transitions may have interned new names
+	BuildStateIndexByNameId();
+	return true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// ids are only stable within a run, so names are written out and interned again on load
+void AnimStateMachineTable::Serialize( AnimAssetWriteBuffer& buffer ) const
+{
+	buffer.Write( ( uint32_t ) m_states.size() );
+	for ( AnimStateMachineState const& state : m_states )
+	{
+		buffer.WriteString( AnimNameTable::GetName( state.m_nameId ) );
+		buffer.Write( ( int32_t ) state.m_firstTransition );
+		buffer.Write( ( int32_t ) state.m_numTransitions );
+		buffer.Write( ( int32_t ) state.m_endTransition );
+		buffer.Write( ( int32_t ) state.m_popOutTransition );
+	}
+
+	buffer.Write( ( uint32_t ) m_transitions.size() );
+	for ( AnimStateMachineTransition const& transition : m_transitions )
+	{
+		buffer.WriteString( AnimNameTable::GetName( transition.m_nameId ) );
+		buffer.Write( ( int32_t ) transition.m_targetState );
+		buffer.Write( transition.m_fadeDurationMs );
+		buffer.Write( ( uint32_t ) transition.m_blendMode );
+		buffer.Write( ( uint32_t ) transition.m_isPoseMatched );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool AnimStateMachineTable::Deserialize( AnimAssetReadBuffer& buffer )
+{
+	Clear();
+
+	uint32_t numStates = buffer.Read<uint32_t>();
+	for ( uint32_t stateIndex = 0; stateIndex < numStates && buffer.m_isValid; stateIndex++ )
+	{
+		AnimStateMachineState state;
+		state.m_nameId			 = AnimNameTable::Intern( buffer.ReadString() );
+		state.m_firstTransition	 = buffer.Read<int32_t>();
+		state.m_numTransitions	 = buffer.Read<int32_t>();
+		state.m_endTransition	 = buffer.Read<int32_t>();
+		state.m_popOutTransition = buffer.Read<int32_t>();
+		m_states.push_back( state );
+	}
+
+	uint32_t numTransitions = buffer.Read<uint32_t>();
+	for ( uint32_t transitionIndex = 0; transitionIndex < numTransitions && buffer.m_isValid; transitionIndex++ )
+	{
+		AnimStateMachineTransition transition;
+		transition.m_nameId			= AnimNameTable::Intern( buffer.ReadString() );
+		transition.m_targetState	= buffer.Read<int32_t>();
+		transition.m_fadeDurationMs = buffer.Read<float>();
+		transition.m_blendMode		= ( AnimTransitionBlendMode ) buffer.Read<uint32_t>();
+		transition.m_isPoseMatched	= buffer.Read<uint32_t>() != 0;
+		m_transitions.push_back( transition );
+	}
+
+	// reject tables whose indices point outside their own arrays
+	for ( AnimStateMachineState const& state : m_states )
+	{
+		bool isRangeValid = state.m_firstTransition >= 0 && state.m_numTransitions >= 0 && state.m_firstTransition + state.m_numTransitions <= ( int ) m_transitions.size();
+		bool isEndValid	  = state.m_endTransition >= INVALID_ANIM_STATE_MACHINE_INDEX && state.m_endTransition < ( int ) m_transitions.size();
+		bool isPopValid	  = state.m_popOutTransition >= INVALID_ANIM_STATE_MACHINE_INDEX && state.m_popOutTransition < ( int ) m_transitions.size();
+		if ( !isRangeValid || !isEndValid || !isPopValid )
+		{
+			buffer.m_isValid = false;
+		}
+	}
+	for ( AnimStateMachineTransition const& transition : m_transitions )
+	{
+		bool isTargetValid	  = transition.m_targetState >= INVALID_ANIM_STATE_MACHINE_INDEX && transition.m_targetState < ( int ) m_states.size();
+		bool isBlendModeValid = transition.m_blendMode == AnimTransitionBlendMode::CROSSFADE || transition.m_blendMode == AnimTransitionBlendMode::INERTIALIZE;
+		if ( !isTargetValid || !isBlendModeValid )
+		{
+			buffer.m_isValid = false;
+		}
+	}
+
+	if ( !buffer.m_isValid )
+	{
+		Clear();
+		return false;
+	}
+
+	BuildStateIndexByNameId();
+	return true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimStateMachineTable::BuildStateIndexByNameId()
+{
+	m_stateIndexByNameId.assign( AnimNameTable::GetNumNames(), INVALID_ANIM_STATE_MACHINE_INDEX );
+	for ( int stateIndex = 0; stateIndex < ( int ) m_states.size(); stateIndex++ )
+	{
+		m_stateIndexByNameId[ m_states[ stateIndex ].m_nameId ] = stateIndex;
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+int AnimStateMachineTable::GetStateIndex( AnimNameId stateNameId ) const
+{
+	if ( stateNameId < 0 || stateNameId >= ( AnimNameId ) m_stateIndexByNameId.size() )
+	{
+		return INVALID_ANIM_STATE_MACHINE_INDEX;
+	}
+
+	return m_stateIndexByNameId[ stateNameId ];
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// a state has only a handful of transitions, a linear scan over them stays within one or two cache lines
+int AnimStateMachineTable::FindTransition( int stateIndex, AnimNameId transitionNameId ) const
+{
+	if ( stateIndex < 0 || stateIndex >= ( int ) m_states.size() )
+	{
+		return INVALID_ANIM_STATE_MACHINE_INDEX;
+	}
+
+	AnimStateMachineState const& state = m_states[ stateIndex ];
+	for ( int transitionIndex = state.m_firstTransition; transitionIndex < state.m_firstTransition + state.m_numTransitions; transitionIndex++ )
+	{
+		if ( m_transitions[ transitionIndex ].m_nameId == transitionNameId )
+		{
+			return transitionIndex;
+		}
+	}
+
+	return INVALID_ANIM_STATE_MACHINE_INDEX;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+int AnimStateMachineTable::GetEndTransitionTarget( int stateIndex ) const
+{
+	if ( stateIndex < 0 || stateIndex >= ( int ) m_states.size() )
+	{
+		return INVALID_ANIM_STATE_MACHINE_INDEX;
+	}
+
+	int endTransition = m_states[ stateIndex ].m_endTransition;
+	if ( endTransition == INVALID_ANIM_STATE_MACHINE_INDEX )
+	{
+		return INVALID_ANIM_STATE_MACHINE_INDEX;
+	}
+
+	return m_transitions[ endTransition ].m_targetState;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+AnimNameId AnimStateMachineTable::GetStateNameId( int stateIndex ) const
+{
+	if ( stateIndex < 0 || stateIndex >= ( int ) m_states.size() )
+	{
+		return INVALID_ANIM_NAME_ID;
+	}
+
+	return m_states[ stateIndex ].m_nameId;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+int AnimStateMachineTable::GetNumStates() const
+{
+	return ( int ) m_states.size();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// sources are matched from and targets matched into, both need the clip's pose features
+bool AnimStateMachineTable::IsStateInPoseMatchedTransition( int stateIndex ) const
+{
+	if ( stateIndex < 0 || stateIndex >= ( int ) m_states.size() )
+	{
+		return false;
+	}
+
+	AnimStateMachineState const& state = m_states[ stateIndex ];
+	for ( int transitionIndex = 0; transitionIndex < ( int ) m_transitions.size(); transitionIndex++ )
+	{
+		AnimStateMachineTransition const& transition = m_transitions[ transitionIndex ];
+		if ( !transition.m_isPoseMatched )
+		{
+			continue;
+		}
+
+		bool isFromState = transitionIndex >= state.m_firstTransition && transitionIndex < state.m_firstTransition + state.m_numTransitions;
+		if ( isFromState || transition.m_targetState == stateIndex )
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// inertialization only starts from a named transition of the state being left
+bool AnimStateMachineTable::HasInertializedTransition( int stateIndex ) const
+{
+	if ( stateIndex < 0 || stateIndex >= ( int ) m_states.size() )
+	{
+		return false;
+	}
+
+	AnimStateMachineState const& state = m_states[ stateIndex ];
+	for ( int transitionIndex = state.m_firstTransition; transitionIndex < state.m_firstTransition + state.m_numTransitions; transitionIndex++ )
+	{
+		if ( m_transitions[ transitionIndex ].m_blendMode == AnimTransitionBlendMode::INERTIALIZE )
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "Game/AnimNameTable.hpp"
+
+#include "Engine/Core/XmlUtils.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct AnimAssetWriteBuffer;
+struct AnimAssetReadBuffer;
+
+
+//----------------------------------------------------------------------------------------------------------
+constexpr int INVALID_ANIM_STATE_MACHINE_INDEX = -1;
+
+
+//----------------------------------------------------------------------------------------------------------
+// crossfade evaluates both states for the fade duration, inertialize evaluates only the target state and decays
+// the offset from the outgoing pose over the same duration
+enum class AnimTransitionBlendMode : uint32_t
+{
+	CROSSFADE = 0,
+	INERTIALIZE,
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+struct AnimStateMachineTransition
+{
+	AnimNameId				m_nameId		 = INVALID_ANIM_NAME_ID;
+	int						m_targetState	 = INVALID_ANIM_STATE_MACHINE_INDEX;
+	float					m_fadeDurationMs = 0.f;
+	AnimTransitionBlendMode m_blendMode		 = AnimTransitionBlendMode::CROSSFADE;
+	bool					m_isPoseMatched	 = false; // enters the target at the frame closest to the outgoing pose
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// named transitions of a state are contiguous in the transition array, end and pop out transitions follow them
+struct AnimStateMachineState
+{
+	AnimNameId m_nameId			  = INVALID_ANIM_NAME_ID;
+	int		   m_firstTransition  = 0;
+	int		   m_numTransitions	  = 0;
+	int		   m_endTransition	  = INVALID_ANIM_STATE_MACHINE_INDEX;
+	int		   m_popOutTransition = INVALID_ANIM_STATE_MACHINE_INDEX;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// AnimConfig.xml compiled into flat arrays, so evaluating the state machine is index arithmetic over a few
+// contiguous cache lines instead of chasing heap objects linked by name
+class AnimStateMachineTable
+{
+public:
+	void									Clear();
+	bool									CompileFromXML( XmlElement const& animConfigRootElement );
+	bool									CompileFromXmlFile( std::string const& animConfigPath );
+	bool									PatchFromXML( XmlElement const& animConfigRootElement );
+
+	// cooked asset cache
+	void									Serialize( AnimAssetWriteBuffer& buffer ) const;
+	bool									Deserialize( AnimAssetReadBuffer& buffer );
+
+	// evaluation
+	int										GetStateIndex( AnimNameId stateNameId ) const;
+	int										FindTransition( int stateIndex, AnimNameId transitionNameId ) const;
+	int										GetEndTransitionTarget( int stateIndex ) const;
+	AnimNameId								GetStateNameId( int stateIndex ) const;
+	int										GetNumStates() const;
+	bool									IsStateInPoseMatchedTransition( int stateIndex ) const;
+	bool									HasInertializedTransition( int stateIndex ) const;
+
+	std::vector<AnimStateMachineState>		m_states;
+	std::vector<AnimStateMachineTransition> m_transitions;
+	std::vector<int>						m_stateIndexByNameId;
+	void									BuildStateIndexByNameId();
+};
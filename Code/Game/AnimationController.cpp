@@ -2,7 +2,10 @@
 #include "Game/Character.hpp"
 #include "Game/MovementState.hpp"
 #include "Game/AnimationState.hpp"
+#include "Game/AnimationStateInstance.hpp"
 #include "Game/AnimationController.hpp"
+#include "Game/AnimClipResidencyManager.hpp"
+#include "Game/AnimStateMachineTable.hpp"
 #include "Game/Game.hpp"
 #include "Game/GameCommon.hpp"
 
@@ -21,11 +24,14 @@
 #include "Engine/Core/ErrorWarningAssert.hpp"
 
 
+#include <algorithm>
+#include <utility>
 #include <cmath>
 
 
 //----------------------------------------------------------------------------------------------------------
-AnimationController::AnimationController()
+AnimationController::AnimationController( Character* owner )
+	: m_owner( owner )
 {
 }
 
@@ -37,16 +43,51 @@ AnimationController::~AnimationController()
 
 
 //----------------------------------------------------------------------------------------------------------
-void AnimationController::Startup()
+void AnimationController::Startup( Clock* parentClock )
 {
-	Clock* gameClock					= g_theGame->m_GameClock;
-	m_animationClock					= new Clock( *gameClock );
+	if ( !parentClock )
+	{
+		parentClock = g_theGame->m_GameClock;
+	}
+	m_animationClock = new Clock( *parentClock );
+
+	// read before any state instance exists, every instance is created knowing who samples it
+	m_isBlendProgramEnabled = g_gameConfigGlackboard.GetValue( "animBlendProgram", true );
+	m_isPoseMatchingEnabled = g_gameConfigGlackboard.GetValue( "animPoseMatching", true );
 
-	AnimationState* firstAnimationState = AnimationState::GetAnimationStateByName( "idle" );
+	AnimationStateInstance* firstAnimationState = GetStateInstance( ANIM_NAME_IDLE );
 	m_animationStack.push( firstAnimationState );
 
 	InitParentBlendTree();
-	CreateStaticDebugUIVerts();
+	UpdateClipPins();
+
+	// two slots so a new fade can start before the interrupted one is handed back
+	m_crossfadePool.Startup( 2, firstAnimationState->m_state->m_defaultPose );
+	m_inertializer.Startup( firstAnimationState->m_state->m_defaultPose );
+
+	if ( m_isBlendProgramEnabled )
+	{
+		m_blendProgram.Startup( firstAnimationState->m_state->m_defaultPose );
+		CompileBlendProgram();
+		m_blendProgram.Execute();
+	}
+
+	// crowd controllers have no owning character, no debug ui and their graph is loaded up front
+	if ( m_owner )
+	{
+		CreateStaticDebugUIVerts();
+
+		int prefetchHops = g_gameConfigGlackboard.GetValue( "animClipPrefetchHops", 2 );
+		m_clipPrefetcher.Startup( prefetchHops );
+
+		float fixedStepRate	   = g_gameConfigGlackboard.GetValue( "animFixedStepRate", 60.f );
+		int	  maxStepsPerFrame = g_gameConfigGlackboard.GetValue( "animMaxStepsPerFrame", 4 );
+		m_fixedTimestep.Startup( fixedStepRate, maxStepsPerFrame );
+
+		m_currentStepPose  = EvaluateSimulatedPose();
+		m_previousStepPose = m_currentStepPose;
+		m_interpolatedPose = m_currentStepPose;
+	}
 }
 
 
@@ -58,9 +99,104 @@ void AnimationController::Update()
 		m_animationClock->TogglePause();
 	}
 
+	if ( m_fixedTimestep.IsEnabled() )
+	{
+		UpdateFixedSteps();
+		return;
+	}
+
+	UpdateGraph();
+	UpdatePose();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// the steps of a frame are decided once, by root motion or by the pose update, whichever asks first; both then
+// move by the same steps and interpolate with the same fraction
+void AnimationController::AdvanceFixedTimestep()
+{
+	if ( m_isFixedTimestepAdvanced )
+	{
+		return;
+	}
+
+	m_fixedTimestep.Advance( m_animationClock->GetDeltaSeconds() );
+	m_isFixedTimestepAdvanced = true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// simulation cost depends on the step rate instead of the render rate
+void AnimationController::UpdateFixedSteps()
+{
+	AdvanceFixedTimestep();
+	m_isFixedTimestepAdvanced = false;
+
+	int	  numSteps	  = m_fixedTimestep.m_numStepsThisFrame;
+	float stepSeconds = m_fixedTimestep.GetStepSeconds();
+
+	for ( int stepIndex = 0; stepIndex < numSteps; stepIndex++ )
+	{
+		UpdateGraph();
+		UpdatePose( stepSeconds );
+
+		std::swap( m_previousStepPose, m_currentStepPose );
+		m_currentStepPose = EvaluateSimulatedPose();
+	}
+
+	AnimPose::Blend( m_interpolatedPose, m_previousStepPose, m_currentStepPose, m_fixedTimestep.GetInterpolationFraction(), -1 );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// transitions and clip residency, touches shared state so it always runs on the main thread
+void AnimationController::UpdateGraph()
+{
 	UpdateTransition();
+	UpdateClipPins();
+	DispatchEvents();
+
+	if ( m_owner )
+	{
+		m_clipPrefetcher.Update( m_pinnedStates );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// samples and blends the pinned clips, only writes to this controller so crowds run it on worker threads
+void AnimationController::UpdatePose()
+{
+	UpdatePose( m_animationClock->GetDeltaSeconds() );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// callers that skip frames pass the time accumulated since the last evaluation
+void AnimationController::UpdatePose( float deltaSeconds )
+{
+	m_poseDeltaSeconds = deltaSeconds;
+
 	UpdateAnimationState();
 	UpdateCrossfade();
+
+	if ( m_isBlendProgramEnabled )
+	{
+		CompileBlendProgram();
+		m_blendProgram.Execute();
+	}
+
+	UpdateInertialization();
+
+	// copying the output pose every frame is only worth it when the current state can inertialize out
+	if ( AnimationState::s_stateMachineTable.HasInertializedTransition( m_animationStack.top()->m_state->GetStateMachineIndex() ) )
+	{
+		m_inertializer.RecordOutputPose( GetOutputPose() );
+	}
+	else
+	{
+		m_inertializer.ClearRecordedPoses();
+	}
 }
 
 
@@ -73,8 +209,27 @@ void AnimationController::Render()
 //----------------------------------------------------------------------------------------------------------
 void AnimationController::Shutdown()
 {
+	UnpinAllClips();
+
 	delete m_animationClock;
 
+	m_crossfadePool.Shutdown();
+	m_crossfadeBlendTree = nullptr;
+
+	// the root is a node of one of the instances below
+	if ( m_parentBlendTree )
+	{
+		m_parentBlendTree->m_rootNode = nullptr;
+		delete m_parentBlendTree;
+		m_parentBlendTree = nullptr;
+	}
+
+	for ( AnimationStateInstance* stateInstance : m_stateInstancesByNameId )
+	{
+		delete stateInstance;
+	}
+	m_stateInstancesByNameId.clear();
+
 	delete m_debugUiTextBuffer;
 	delete m_debugUiGeometryBuffer;
 }
@@ -83,43 +238,71 @@ void AnimationController::Shutdown()
 //----------------------------------------------------------------------------------------------------------
 void AnimationController::UpdateTransition()
 {
+	AnimStateMachineTable const& stateMachine = AnimationState::s_stateMachineTable;
+
 	// transition to another state
 	if ( m_transitionRequested )
 	{
-		AnimationState* currentState = m_animationStack.top();
-		Transition*		transition	 = currentState->GetTransitionByName( m_nextStateName );
-		if ( transition )
+		AnimationStateInstance* currentState	   = m_animationStack.top();
+		int						transitionIndex	   = stateMachine.FindTransition( currentState->m_state->GetStateMachineIndex(), m_nextTransitionId );
+		AnimationStateInstance* nextAnimationState = nullptr;
+		if ( transitionIndex != INVALID_ANIM_STATE_MACHINE_INDEX )
+		{
+			nextAnimationState = GetStateInstance( AnimationState::GetAnimationStateByIndex( stateMachine.m_transitions[ transitionIndex ].m_targetState ) );
+		}
+
+		if ( nextAnimationState && !AreStateClipsResident( nextAnimationState->m_state ) )
+		{
+			// the current state keeps playing and the request is retried every frame until the clip is in
+		}
+		else if ( nextAnimationState )
 		{
+			AnimStateMachineTransition const& transition = stateMachine.m_transitions[ transitionIndex ];
+
+			// the outgoing pose is read before restarting, a transition may target the state it leaves
+			float const* outgoingFeatures = nullptr;
+			if ( transition.m_isPoseMatched && m_isPoseMatchingEnabled )
+			{
+				outgoingFeatures = currentState->m_state->m_poseFeatures.GetFeaturesAtTime( currentState->m_localTimeMs );
+			}
+
 			// go to next animation
-			AnimationState* nextAnimationState = AnimationState::GetAnimationStateByName( transition->m_animationState );
-			nextAnimationState->m_localTimeMs  = 0.f;
+			nextAnimationState->Restart();
+			nextAnimationState->SyncPhaseWith( *currentState );
+			MatchEntryPose( *currentState, *nextAnimationState, outgoingFeatures, transition.m_fadeDurationMs );
 			m_animationStack.pop();
 			m_animationStack.push( nextAnimationState );
 
-			// start crossfade
-			InitCrossfade( currentState, nextAnimationState, transition->m_fadeDuration );
+			if ( transition.m_blendMode == AnimTransitionBlendMode::INERTIALIZE )
+			{
+				InitInertialization( nextAnimationState, transition.m_fadeDurationMs );
+			}
+			else
+			{
+				InitCrossfade( currentState, nextAnimationState, transition.m_fadeDurationMs );
+			}
 
 			// reset transition request
 			m_transitionRequested = false;
-			m_nextStateName		  = "UNKOWN STATE";
+			m_nextTransitionId	  = INVALID_ANIM_NAME_ID;
 		}
 		else
 		{
-			DebuggerPrintf( "Error: Unable to find transition from %s state to %s\n", currentState->m_name.c_str(), m_nextStateName.c_str() );
+			DebuggerPrintf( "Error: Unable to find transition from %s state to %s\n", currentState->m_state->m_name.c_str(), AnimNameTable::GetName( m_nextTransitionId ).c_str() );
 
 			m_transitionRequested = false;
-			m_nextStateName		  = "UNKOWN STATE";
+			m_nextTransitionId	  = INVALID_ANIM_NAME_ID;
 		}
 	}
 
 	// transition to end state
-	AnimationState* currentState = m_animationStack.top();
+	AnimationStateInstance* currentState = m_animationStack.top();
 	if ( currentState->IsAtEndOfState() )
 	{
-		if ( currentState->HasEndTransition() )
+		AnimationStateInstance* nextAnimationState = GetStateInstance( AnimationState::GetAnimationStateByIndex( stateMachine.GetEndTransitionTarget( currentState->m_state->GetStateMachineIndex() ) ) );
+		if ( nextAnimationState && AreStateClipsResident( nextAnimationState->m_state ) )
 		{
-			AnimationState* nextAnimationState = AnimationState::GetAnimationStateByName( currentState->m_endTransition->m_animationState );
-			nextAnimationState->m_localTimeMs  = 0.f;
+			nextAnimationState->Restart();
 
 			// end transition present - swap with current animation
 			m_animationStack.pop();
@@ -128,11 +311,9 @@ void AnimationController::UpdateTransition()
 			// InitCrossfade( currentState, nextAnimationState, currentState->m_endTransition->m_fadeDuration );
 
 			if ( !m_crossfadeBlendTree )
-				UpdateParentBlendTree( m_animationStack.top()->GetBlendTree() );
+				UpdateParentBlendTree( m_animationStack.top()->GetBlendNode() );
 		}
 
-		// notify the movement state that the animation has ended
-		g_theCharacter->m_movementState->NotifyEndOfAnimationState( false );
 	}
 
 
@@ -142,20 +323,22 @@ void AnimationController::UpdateTransition()
 		// fade out state
 		if ( m_crossfadeOutState->IsAtEndOfState() )
 		{
-			if ( m_crossfadeOutState->HasEndTransition() )
+			AnimationStateInstance* nextFadeOutState = GetStateInstance( AnimationState::GetAnimationStateByIndex( stateMachine.GetEndTransitionTarget( m_crossfadeOutState->m_state->GetStateMachineIndex() ) ) );
+			if ( nextFadeOutState && AreStateClipsResident( nextFadeOutState->m_state ) )
 			{
-				m_crossfadeOutState				   = AnimationState::GetAnimationStateByName( m_crossfadeOutState->m_endTransition->m_animationState );
-				m_crossfadeOutState->m_localTimeMs = 0.f;
+				m_crossfadeOutState = nextFadeOutState;
+				m_crossfadeOutState->Restart();
 			}
 		}
 
 		// fade in state
 		if ( m_crossfadeInState->IsAtEndOfState() )
 		{
-			if ( m_crossfadeInState->HasEndTransition() )
+			AnimationStateInstance* nextFadeInState = GetStateInstance( AnimationState::GetAnimationStateByIndex( stateMachine.GetEndTransitionTarget( m_crossfadeInState->m_state->GetStateMachineIndex() ) ) );
+			if ( nextFadeInState && AreStateClipsResident( nextFadeInState->m_state ) )
 			{
-				m_crossfadeInState				  = AnimationState::GetAnimationStateByName( m_crossfadeInState->m_endTransition->m_animationState );
-				m_crossfadeInState->m_localTimeMs = 0.f;
+				m_crossfadeInState = nextFadeInState;
+				m_crossfadeInState->Restart();
 			}
 		}
 	}
@@ -165,24 +348,64 @@ void AnimationController::UpdateTransition()
 //----------------------------------------------------------------------------------------------------------
 void AnimationController::UpdateAnimationState()
 {
+	float deltaSeconds	 = m_poseDeltaSeconds;
+	float deltaSecondsMs = deltaSeconds * 1000.f;
+
 	if ( !m_crossfadeBlendTree ) // not cross fading
 	{
 		// update current animation
-		AnimationState* currentState = m_animationStack.top();
-		currentState->Update();
+		AnimationStateInstance* currentState = m_animationStack.top();
+		if ( m_hasBlendSpaceParameters )
+		{
+			currentState->SetBlendParameters( m_blendSpaceParameters );
+		}
+		currentState->Update( deltaSecondsMs, &m_eventQueue );
 	}
 	else // cross fading
 	{
-		m_crossfadeInState->Update( true );
-		m_crossfadeOutState->Update( true );
+		if ( m_hasBlendSpaceParameters )
+		{
+			m_crossfadeInState->SetBlendParameters( m_blendSpaceParameters );
+			m_crossfadeOutState->SetBlendParameters( m_blendSpaceParameters );
+		}
+
+		// only the state being faded in reports events
+		m_crossfadeInState->Update( deltaSecondsMs, &m_eventQueue );
+		m_crossfadeOutState->Update( deltaSecondsMs );
+	}
+
+	RebindBlendTreeNodes();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimationController::SetBlendSpaceParameters( Vec2 const& parameters )
+{
+	m_blendSpaceParameters	  = parameters;
+	m_hasBlendSpaceParameters = true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// events collected by the last pose update reach gameplay here, on the main thread
+void AnimationController::DispatchEvents()
+{
+	if ( m_owner )
+	{
+		for ( AnimEventDispatch const& dispatch : m_eventQueue.m_events )
+		{
+			m_owner->OnAnimEvent( dispatch );
+		}
 	}
+
+	m_eventQueue.Clear();
 }
 
 
 //----------------------------------------------------------------------------------------------------------
 bool AnimationController::IsCurrentAnimationAtEndOfState() const
 {
-	AnimationState* currentAnimationState = m_animationStack.top();
+	AnimationStateInstance* currentAnimationState = m_animationStack.top();
 	if ( currentAnimationState->IsAtEndOfState() )
 	{
 		return true;
@@ -197,7 +420,24 @@ bool AnimationController::IsCurrentAnimationAtEndOfState() const
 //----------------------------------------------------------------------------------------------------------
 AnimationState* AnimationController::GetCurrentAnimationState() const
 {
-	return m_animationStack.top();
+	return m_animationStack.top()->m_state;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool AnimationController::IsStatePlaying( AnimationState const* state ) const
+{
+	if ( !m_animationStack.empty() && m_animationStack.top()->m_state == state )
+	{
+		return true;
+	}
+
+	if ( m_crossfadeBlendTree && ( m_crossfadeInState->m_state == state || m_crossfadeOutState->m_state == state ) )
+	{
+		return true;
+	}
+
+	return false;
 }
 
 
@@ -211,22 +451,59 @@ float AnimationController::GetLocalTimeMsOfCurrentAnimation() const
 //----------------------------------------------------------------------------------------------------------
 Vec3AnimCurve const& AnimationController::GetCurrentStateRootMotionTranslation() const
 {
-	AnimationState* currentState = m_animationStack.top();
-	return currentState->m_clip->GetRootJointTranslationCurve();
+	AnimationState* currentState = GetCurrentAnimationState();
+	return currentState->GetClip()->GetRootJointTranslationCurve();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+AnimRootSample AnimationController::SampleCurrentStateRoot() const
+{
+	AnimationStateInstance* currentState = m_animationStack.top();
+	return currentState->SampleRoot( currentState->m_localTimeMs );
 }
 
 
 //----------------------------------------------------------------------------------------------------------
-Vec3AnimCurve& AnimationController::GetCurrentStateRootMotionTranslationByReference()
+// how far the warped root motion moves the rendered pose away from what the clips sampled, faded like the pose
+Vec3 AnimationController::GetRootMotionWarpPoseOffset() const
 {
-	AnimationState* currentState = m_animationStack.top();
-	return currentState->m_clip->GetRootJointTranslationCurveByRefernce();
+	if ( m_crossfadeBlendTree )
+	{
+		Vec3 fadeOutOffset = m_crossfadeOutState->GetRootMotionWarpPoseOffset();
+		Vec3 fadeInOffset  = m_crossfadeInState->GetRootMotionWarpPoseOffset();
+		return Lerp( fadeOutOffset, fadeInOffset, m_crossfadeBlendValue );
+	}
+
+	return m_animationStack.top()->GetRootMotionWarpPoseOffset();
 }
 
 
 //----------------------------------------------------------------------------------------------------------
 AnimPose const AnimationController::GetSampledPose() const
 {
+	if ( m_fixedTimestep.IsEnabled() )
+	{
+		return m_interpolatedPose;
+	}
+
+	return EvaluateSimulatedPose();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+AnimPose const AnimationController::EvaluateSimulatedPose() const
+{
+	if ( m_inertializer.IsActive() )
+	{
+		return m_inertializer.GetOutputPose();
+	}
+
+	if ( m_isBlendProgramEnabled )
+	{
+		return m_blendProgram.GetResultPose();
+	}
+
 	AnimPose pose = m_parentBlendTree->Evaluate();
 	return pose;
 }
@@ -345,24 +622,25 @@ void AnimationController::DebugRender()
 	float						duration		 = 0.f;
 	Vec2						topLeftAlignment = Vec2( 0.f, 1.f );
 
-	std::stack<AnimationState*> animStackCopy	 = m_animationStack;
+	std::stack<AnimationStateInstance*> animStackCopy = m_animationStack;
 	while ( !animStackCopy.empty() )
 	{
-		AnimationState* animState = animStackCopy.top();
+		AnimationStateInstance* animState = animStackCopy.top();
 		animStackCopy.pop();
 
 		topLeftLinePosition.y -= fontSize - 2.f;
 
-		DebugAddScreenText( animState->m_name, topLeftLinePosition, fontSize, topLeftAlignment, duration, Rgba8::RED );
+		DebugAddScreenText( animState->m_state->m_name, topLeftLinePosition, fontSize, topLeftAlignment, duration, Rgba8::RED );
 	}
 
 
 	// animation UI
 	AABB2			screenBounds   = g_theGame->m_screenCamera.GetOrthographicBounds();
 	AABB2			animUiBounds   = screenBounds.GetBoxAtUVs( AABB2( 0.f, 0.6f, 0.2f, 0.7f ) );
-	AnimationState* debugAnimState = m_animationStack.top();
-	DebugRenderAnimationStateUI( debugAnimState->m_name, debugAnimState->m_localTimeMs, debugAnimState->m_clip->GetStartTime(),
-		debugAnimState->m_clip->GetEndTime(), animUiBounds );
+	AnimationStateInstance* debugAnimState = m_animationStack.top();
+	AnimClip*				debugAnimClip  = debugAnimState->m_state->GetClip();
+	DebugRenderAnimationStateUI( debugAnimState->m_state->m_name, debugAnimState->m_localTimeMs, debugAnimClip->GetStartTime(),
+		debugAnimClip->GetEndTime(), animUiBounds );
 
 	// crossfade UI
 	AABB2 animCrossfadeUiBounds = screenBounds.GetBoxAtUVs( AABB2( 0.f, 0.1f, 0.3f, 0.5f ) );
@@ -376,33 +654,36 @@ void AnimationController::DebugRender()
 
 
 //----------------------------------------------------------------------------------------------------------
-void AnimationController::InitCrossfade( AnimationState* currentState, AnimationState* nextState, float fadeDurationMs )
+void AnimationController::InitCrossfade( AnimationStateInstance* currentState, AnimationStateInstance* nextState, float fadeDurationMs )
 {
-	if ( m_crossfadeBlendTree )
-	{
-		delete m_crossfadeBlendTree;
-		m_crossfadeBlendTree = nullptr;
-	}
+	// an offset still decaying keeps decaying on top of the crossfade; the fade starts on the inertialized state, so
+	// the output is continuous and the offset finishes on its own schedule
+	AnimBlendTree* interruptedCrossfade = m_crossfadeBlendTree;
 
 	m_crossfadeDurationMs		   = fadeDurationMs;
 	m_crossfadeTimeLeftMs		   = fadeDurationMs;
 
 	m_crossfadeOutState			   = currentState;
 	m_crossfadeInState			   = nextState;
-	AnimBlendNode* fadeOutClipNode = m_crossfadeOutState->GetBlendTree()->m_rootNode;
+	AnimBlendNode* fadeOutClipNode = m_crossfadeOutState->GetBlendNode();
 	// fadeOutClipNode->m_debug	   = true;
-	AnimBlendNode* fadeInClipNode = m_crossfadeInState->GetBlendTree()->m_rootNode;
+	AnimBlendNode* fadeInClipNode = m_crossfadeInState->GetBlendNode();
 	// fadeInClipNode->m_debug		   = true;
-	BinaryLerpBlendNode* lerpNode	 = new BinaryLerpBlendNode();
-	lerpNode->m_blendedPose			 = currentState->m_defaultPose;
-	lerpNode->m_childNodeA			 = fadeOutClipNode;
-	lerpNode->m_childNodeB			 = fadeInClipNode;
+	m_crossfadeBlendTree		  = m_crossfadePool.Acquire( fadeOutClipNode, fadeInClipNode );
 
-	m_crossfadeBlendTree			 = new AnimBlendTree();
-	m_crossfadeBlendTree->m_rootNode = lerpNode;
+	if ( interruptedCrossfade )
+	{
+		m_crossfadePool.Release( interruptedCrossfade );
+	}
+
+	if ( !m_crossfadeBlendTree ) // pool exhausted, snap to the next state
+	{
+		UpdateParentBlendTree( fadeInClipNode );
+		return;
+	}
 
 	// parent tree evaluates cross fade
-	UpdateParentBlendTree( m_crossfadeBlendTree );
+	UpdateParentBlendTree( m_crossfadeBlendTree->m_rootNode );
 }
 
 
@@ -411,18 +692,18 @@ void AnimationController::UpdateCrossfade()
 {
 	if ( m_crossfadeBlendTree )
 	{
-		float deltaSeconds	   = m_animationClock->GetDeltaSeconds();
+		float deltaSeconds	   = m_poseDeltaSeconds;
 		float deltaMs		   = deltaSeconds * 1000.f;
 
 		m_crossfadeTimeLeftMs -= deltaMs;
 		if ( m_crossfadeTimeLeftMs < 0.f ) // cross fade complete
 		{
-			delete m_crossfadeBlendTree;
+			m_crossfadePool.Release( m_crossfadeBlendTree );
 			m_crossfadeBlendTree = nullptr;
 
 			// point parent blend tree back to current state
-			AnimationState* currentState = m_animationStack.top();
-			UpdateParentBlendTree( currentState->GetBlendTree() );
+			AnimationStateInstance* currentState = m_animationStack.top();
+			UpdateParentBlendTree( currentState->GetBlendNode() );
 
 			return;
 		}
@@ -434,28 +715,221 @@ void AnimationController::UpdateCrossfade()
 			DebuggerPrintf( "ye kaise hua ???" );
 		}
 
-		m_debugCrossfadeBlendValue		   = blendValue;
+		m_debugCrossfadeBlendValue = blendValue;
+		m_crossfadeBlendValue	   = blendValue;
+		if ( m_isBlendProgramEnabled )
+		{
+			return;
+		}
+
 		AnimBlendNode* binaryLerpBlendNode = m_crossfadeBlendTree->m_rootNode;
 		binaryLerpBlendNode->Update( blendValue );
 	}
 }
 
 
+//----------------------------------------------------------------------------------------------------------
+// jumps straight to a state and time without going through the state machine, for motion matching; the jump is
+// inertialized, so the same state at another time blends as smoothly as a different state
+void AnimationController::PlayStateAtTime( AnimNameId stateId, float localTimeMs, float blendDurationMs )
+{
+	AnimationStateInstance* nextState = GetStateInstance( stateId );
+	if ( !nextState )
+	{
+		DebuggerPrintf( "Error: Unable to play unknown animation state %s\n", AnimNameTable::GetName( stateId ).c_str() );
+		return;
+	}
+	if ( !AreStateClipsResident( nextState->m_state ) )
+	{
+		// the matcher searches again in a few frames, by then the clip is on its way in
+		return;
+	}
+
+	nextState->m_localTimeMs = localTimeMs;
+	m_animationStack.pop();
+	m_animationStack.push( nextState );
+	InitInertialization( nextState, blendDurationMs );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// the outgoing features come from the current state's clip at its playback time, so a fade still in progress is
+// matched by its newest state; only frames that leave room for the whole fade before the clip ends are searched
+void AnimationController::MatchEntryPose( AnimationStateInstance const& currentState, AnimationStateInstance& nextState, float const* outgoingFeatures, float fadeDurationMs )
+{
+	if ( !outgoingFeatures || nextState.IsInSyncGroupWith( currentState ) )
+	{
+		return;
+	}
+
+	AnimPoseFeatureDatabase const& entryFeatures = nextState.m_state->m_poseFeatures;
+	if ( !entryFeatures.IsCompatibleWith( currentState.m_state->m_poseFeatures ) )
+	{
+		return;
+	}
+
+	AnimClip* clip			  = nextState.m_state->GetClip();
+	float	  searchEndTimeMs = clip->GetEndTime() - fadeDurationMs;
+	float	  entryCost		  = 0.f;
+	int		  entryFrame	  = entryFeatures.FindBestFrame( outgoingFeatures, searchEndTimeMs, entryCost );
+	if ( entryFrame >= 0 )
+	{
+		nextState.m_localTimeMs = entryFeatures.GetFrameTimeMs( entryFrame );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimationController::InitInertialization( AnimationStateInstance* nextState, float durationMs )
+{
+	// the outgoing pose is already recorded, an interrupted crossfade has nothing left to evaluate
+	if ( m_crossfadeBlendTree )
+	{
+		m_crossfadePool.Release( m_crossfadeBlendTree );
+		m_crossfadeBlendTree = nullptr;
+	}
+
+	m_crossfadeDurationMs = durationMs;
+	m_inertializer.Begin( durationMs );
+
+	// only the target state is evaluated from here on
+	UpdateParentBlendTree( nextState->GetBlendNode() );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimationController::UpdateInertialization()
+{
+	if ( !m_inertializer.IsActive() )
+	{
+		return;
+	}
+
+	float deltaMs = m_poseDeltaSeconds * 1000.f;
+	m_inertializer.Update( GetGraphPose(), deltaMs );
+
+	if ( !m_crossfadeBlendTree )
+	{
+		m_debugCrossfadeBlendValue = m_inertializer.GetProgress();
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// the pose shown this frame, recorded so a later inertialization can start from it
+AnimPose const& AnimationController::GetOutputPose()
+{
+	if ( m_inertializer.IsActive() )
+	{
+		return m_inertializer.GetOutputPose();
+	}
+
+	return GetGraphPose();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// the current state, or the crossfade, before inertialization is layered on top
+AnimPose const& AnimationController::GetGraphPose()
+{
+	if ( m_isBlendProgramEnabled )
+	{
+		return m_blendProgram.GetResultPose();
+	}
+
+	if ( m_crossfadeBlendTree )
+	{
+		BinaryLerpBlendNode* lerpNode = ( BinaryLerpBlendNode* ) m_crossfadeBlendTree->m_rootNode;
+		return lerpNode->m_blendedPose;
+	}
+
+	return m_animationStack.top()->GetSampledPose();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// emitted from the live state instances, so transitions and crossfades never need a recompile step of their own
+void AnimationController::CompileBlendProgram()
+{
+	m_blendProgram.Clear();
+
+	if ( m_crossfadeBlendTree )
+	{
+		int fadeOutRegister = m_crossfadeOutState->EmitToBlendProgram( m_blendProgram );
+		int fadeInRegister	= m_crossfadeInState->EmitToBlendProgram( m_blendProgram );
+		m_blendProgram.EmitBlend( fadeOutRegister, fadeInRegister, m_crossfadeBlendValue );
+	}
+	else
+	{
+		m_animationStack.top()->EmitToBlendProgram( m_blendProgram );
+	}
+}
+
+
 //----------------------------------------------------------------------------------------------------------
 void AnimationController::InitParentBlendTree()
 {
 	m_parentBlendTree = new AnimBlendTree();
 
 	// parent tree evaluates only one state
-	AnimationState* currentState  = m_animationStack.top();
-	m_parentBlendTree->m_rootNode = currentState->GetBlendTree()->m_rootNode;
+	AnimationStateInstance* currentState = m_animationStack.top();
+	m_parentBlendTree->m_rootNode		 = currentState->GetBlendNode();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimationController::UpdateParentBlendTree( AnimBlendNode* newRootNode )
+{
+	m_parentBlendTree->m_rootNode = newRootNode;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// an instance rebuilds its clip node when the shared clip is reloaded, so the trees follow the live nodes
+void AnimationController::RebindBlendTreeNodes()
+{
+	if ( m_crossfadeBlendTree )
+	{
+		BinaryLerpBlendNode* lerpNode = ( BinaryLerpBlendNode* ) m_crossfadeBlendTree->m_rootNode;
+		lerpNode->m_childNodeA		  = m_crossfadeOutState->GetBlendNode();
+		lerpNode->m_childNodeB		  = m_crossfadeInState->GetBlendNode();
+	}
+	else
+	{
+		UpdateParentBlendTree( m_animationStack.top()->GetBlendNode() );
+	}
 }
 
 
 //----------------------------------------------------------------------------------------------------------
-void AnimationController::UpdateParentBlendTree( AnimBlendTree* newBlendTree )
+AnimationStateInstance* AnimationController::GetStateInstance( AnimationState* state )
 {
-	m_parentBlendTree->m_rootNode = newBlendTree->m_rootNode;
+	if ( !state )
+	{
+		return nullptr;
+	}
+
+	AnimNameId stateNameId = state->m_nameId;
+	if ( stateNameId >= ( AnimNameId ) m_stateInstancesByNameId.size() )
+	{
+		m_stateInstancesByNameId.resize( stateNameId + 1, nullptr );
+	}
+
+	AnimationStateInstance*& stateInstance = m_stateInstancesByNameId[ stateNameId ];
+	if ( !stateInstance )
+	{
+		stateInstance							 = new AnimationStateInstance( state );
+		stateInstance->m_isSampledByBlendProgram = m_isBlendProgramEnabled;
+	}
+
+	return stateInstance;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+AnimationStateInstance* AnimationController::GetStateInstance( AnimNameId stateNameId )
+{
+	return GetStateInstance( AnimationState::GetAnimationStateById( stateNameId ) );
 }
 
 
@@ -523,15 +997,15 @@ void AnimationController::DebugRenderCrossfadeUI( AABB2 const& uiBounds )
 	AABB2 uiFadeOutdata		= uiFadeOut.GetBoxAtUVs( 0.3f, 0.f, 1.f, 1.f );
 	if ( m_crossfadeBlendTree )
 	{
-		m_debugFadeInStateName	  = m_crossfadeInState->m_name;
+		m_debugFadeInStateName	  = m_crossfadeInState->m_state->m_name;
 		m_debugFadeInLocalTimeMs  = m_crossfadeInState->m_localTimeMs;
-		m_debugFadeInStartTimeMs  = m_crossfadeInState->m_clip->GetStartTime();
-		m_debugFadeInEndTimeMs	  = m_crossfadeInState->m_clip->GetEndTime();
+		m_debugFadeInStartTimeMs  = m_crossfadeInState->m_state->GetClip()->GetStartTime();
+		m_debugFadeInEndTimeMs	  = m_crossfadeInState->m_state->GetClip()->GetEndTime();
 
-		m_debugFadeOutStateName	  = m_crossfadeOutState->m_name;
+		m_debugFadeOutStateName	  = m_crossfadeOutState->m_state->m_name;
 		m_debugFadeOutLocalTimeMs = m_crossfadeOutState->m_localTimeMs;
-		m_debugFadeOutStartTimeMs = m_crossfadeOutState->m_clip->GetStartTime();
-		m_debugFadeOutEndTimeMs	  = m_crossfadeOutState->m_clip->GetEndTime();
+		m_debugFadeOutStartTimeMs = m_crossfadeOutState->m_state->GetClip()->GetStartTime();
+		m_debugFadeOutEndTimeMs	  = m_crossfadeOutState->m_state->GetClip()->GetEndTime();
 	}
 
 	DebugRenderAnimationStateUI( m_debugFadeInStateName, m_debugFadeInLocalTimeMs, m_debugFadeInStartTimeMs, m_debugFadeInEndTimeMs, uiFadeInData );
@@ -568,4 +1042,114 @@ void AnimationController::DebugRenderCrossfadeUI( AABB2 const& uiBounds )
 	g_theRenderer->SetModelConstants();
 	g_theRenderer->BindTexture( &g_simpleBitmapFont->GetTexture() );
 	g_theRenderer->DrawVertexArray( textVerts );
-}
\ No newline at end of file
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// keeps the clips being sampled resident, the residency manager only evicts unpinned clips
+void AnimationController::UpdateClipPins()
+{
+	if ( !g_theAnimClipResidencyManager )
+	{
+		return;
+	}
+
+	// built into a scratch vector kept across frames and swapped with the pinned list, so no frame allocates
+	std::vector<AnimationState*>& statesInUse = m_statesInUseScratch;
+	statesInUse.clear();
+	statesInUse.push_back( m_animationStack.top()->m_state );
+	if ( m_crossfadeBlendTree )
+	{
+		statesInUse.push_back( m_crossfadeInState->m_state );
+		statesInUse.push_back( m_crossfadeOutState->m_state );
+
+		// keep the states the crossfade started with until it completes
+		for ( AnimationState* pinnedState : m_pinnedStates )
+		{
+			statesInUse.push_back( pinnedState );
+		}
+	}
+
+	// blend spaces sample the clips of other states
+	size_t numStatesInUse = statesInUse.size();
+	for ( size_t stateIndex = 0; stateIndex < numStatesInUse; stateIndex++ )
+	{
+		if ( statesInUse[ stateIndex ]->HasBlendSpace() )
+		{
+			for ( AnimBlendSpaceSample const& sample : statesInUse[ stateIndex ]->m_blendSpace.m_samples )
+			{
+				statesInUse.push_back( AnimationState::GetAnimationStateById( sample.m_stateNameId ) );
+			}
+		}
+	}
+
+	std::sort( statesInUse.begin(), statesInUse.end() );
+	statesInUse.erase( std::unique( statesInUse.begin(), statesInUse.end() ), statesInUse.end() );
+
+	for ( AnimationState* state : statesInUse )
+	{
+		if ( !std::binary_search( m_pinnedStates.begin(), m_pinnedStates.end(), state ) )
+		{
+			g_theAnimClipResidencyManager->Pin( state );
+		}
+	}
+
+	for ( AnimationState* pinnedState : m_pinnedStates )
+	{
+		if ( !std::binary_search( statesInUse.begin(), statesInUse.end(), pinnedState ) )
+		{
+			g_theAnimClipResidencyManager->Unpin( pinnedState );
+		}
+	}
+
+	m_pinnedStates.swap( statesInUse );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimationController::UnpinAllClips()
+{
+	if ( g_theAnimClipResidencyManager )
+	{
+		for ( AnimationState* pinnedState : m_pinnedStates )
+		{
+			g_theAnimClipResidencyManager->Unpin( pinnedState );
+		}
+	}
+
+	m_pinnedStates.clear();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// a state whose clips the prefetcher did not bring in is not entered yet, the pose holds on the state being left
+// while the missing clips load on the job system instead of blocking the frame
+bool AnimationController::AreStateClipsResident( AnimationState* state )
+{
+	if ( !g_theAnimClipResidencyManager || !state )
+	{
+		return true;
+	}
+
+	bool areResident = true;
+	if ( !g_theAnimClipResidencyManager->IsResident( state ) )
+	{
+		g_theAnimClipResidencyManager->ReportPrefetchMiss( state );
+		areResident = false;
+	}
+
+	if ( state->HasBlendSpace() )
+	{
+		for ( AnimBlendSpaceSample const& sample : state->m_blendSpace.m_samples )
+		{
+			AnimationState* sampleState = AnimationState::GetAnimationStateById( sample.m_stateNameId );
+			if ( sampleState && !g_theAnimClipResidencyManager->IsResident( sampleState ) )
+			{
+				g_theAnimClipResidencyManager->ReportPrefetchMiss( sampleState );
+				areResident = false;
+			}
+		}
+	}
+
+	return areResident;
+}
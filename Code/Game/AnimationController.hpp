@@ -1,14 +1,28 @@
 #pragma once
 
+#include "Game/AnimBlendProgram.hpp"
+#include "Game/AnimClipPrefetcher.hpp"
+#include "Game/AnimCrossfadePool.hpp"
+#include "Game/AnimEventTrack.hpp"
+#include "Game/AnimFixedTimestep.hpp"
+#include "Game/AnimInertializer.hpp"
+#include "Game/AnimNameTable.hpp"
+#include "Game/AnimRootSampler.hpp"
+
 #include "Engine/Animation/AnimPose.hpp"
+#include "Engine/Math/Vec2.hpp"
 
 #include <stack>
 #include <string>
+#include <vector>
 
 class Clock;
 class AnimPose;
 class AnimationState;
+class AnimationStateInstance;
 class AnimBlendTree;
+class AnimBlendNode;
+class Character;
 class AABB2;
 class VertexBuffer;
 struct Vec3AnimCurve;
@@ -18,26 +32,48 @@ struct Vec3AnimCurve;
 class AnimationController
 {
 public:
-	AnimationController();
+	AnimationController( Character* owner );
 	~AnimationController();
 
-	void						Startup();
+	void						Startup( Clock* parentClock = nullptr );
 	void						Update();
+	void						UpdateGraph();
+	void						UpdatePose();
+	void						UpdatePose( float deltaSeconds );
+	float						m_poseDeltaSeconds = 0.f;
 	void						Render();
 	void						Shutdown();
 
-	Clock*						m_animationClock	  = nullptr;
-	bool						m_transitionRequested = false;
-	std::string					m_nextStateName		  = "UNKOWN STATE";
-	std::stack<AnimationState*> m_animationStack	  = {};
-	void						UpdateAnimationState();
-	void						UpdateTransition();
-	AnimPose const				GetSampledPose() const;
-	bool						IsCurrentAnimationAtEndOfState() const;
-	AnimationState*				GetCurrentAnimationState() const;
-	float						GetLocalTimeMsOfCurrentAnimation() const;
-	Vec3AnimCurve const&		GetCurrentStateRootMotionTranslation() const;
-	Vec3AnimCurve&				GetCurrentStateRootMotionTranslationByReference();
+	Character*							m_owner				  = nullptr;
+	Clock*								m_animationClock	  = nullptr;
+	bool								m_transitionRequested = false;
+	AnimNameId							m_nextTransitionId	  = INVALID_ANIM_NAME_ID;
+	std::stack<AnimationStateInstance*> m_animationStack	  = {};
+	void								UpdateAnimationState();
+	void								UpdateTransition();
+	void								PlayStateAtTime( AnimNameId stateId, float localTimeMs, float blendDurationMs );
+	AnimPose const						GetSampledPose() const;
+	bool								IsCurrentAnimationAtEndOfState() const;
+	AnimationState*						GetCurrentAnimationState() const;
+	bool								IsStatePlaying( AnimationState const* state ) const;
+	float								GetLocalTimeMsOfCurrentAnimation() const;
+	Vec3AnimCurve const&				GetCurrentStateRootMotionTranslation() const;
+	Vec3								GetRootMotionWarpPoseOffset() const;
+	AnimRootSample						SampleCurrentStateRoot() const;
+
+	// blend space parameters (speed, direction) handed to every state instance this controller updates
+	Vec2								 m_blendSpaceParameters;
+	bool								 m_hasBlendSpaceParameters = false;
+	void								 SetBlendSpaceParameters( Vec2 const& parameters );
+
+	// clip events, queued by pose updates and dispatched to the owner by the graph update
+	AnimEventQueue						 m_eventQueue;
+	void								 DispatchEvents();
+
+	// playback records of the shared animation states, one per state this controller has entered
+	std::vector<AnimationStateInstance*> m_stateInstancesByNameId;
+	AnimationStateInstance*				 GetStateInstance( AnimationState* state );
+	AnimationStateInstance*				 GetStateInstance( AnimNameId stateNameId );
 
 	// debug drawing
 	float		  m_debugCrossfadeBlendValue = 0.f;
@@ -59,16 +95,53 @@ public:
 	void		  DebugRenderCrossfadeUI( AABB2 const& uiBounds );
 
 	// cross fade
-	AnimBlendTree*	m_crossfadeBlendTree  = nullptr;
-	float			m_crossfadeDurationMs = 0.f;
-	float			m_crossfadeTimeLeftMs = 0.f;
-	AnimationState* m_crossfadeInState	  = nullptr;
-	AnimationState* m_crossfadeOutState	  = nullptr;
-	void			InitCrossfade( AnimationState* currentState, AnimationState* nextState, float fadeDurationMs );
-	void			UpdateCrossfade();
+	AnimCrossfadePool		m_crossfadePool;
+	AnimBlendTree*			m_crossfadeBlendTree  = nullptr;
+	float					m_crossfadeDurationMs = 0.f;
+	float					m_crossfadeTimeLeftMs = 0.f;
+	AnimationStateInstance* m_crossfadeInState	  = nullptr;
+	AnimationStateInstance* m_crossfadeOutState	  = nullptr;
+	float					m_crossfadeBlendValue = 0.f;
+	void					InitCrossfade( AnimationStateInstance* currentState, AnimationStateInstance* nextState, float fadeDurationMs );
+	void					UpdateCrossfade();
+
+	// inertialization
+	AnimInertializer		m_inertializer;
+	void					InitInertialization( AnimationStateInstance* nextState, float durationMs );
+	void					UpdateInertialization();
+	AnimPose const&			GetOutputPose();
+
+	// pose matched entry, transitions that opt in start the target at its frame closest to the outgoing pose
+	bool					m_isPoseMatchingEnabled = false;
+	void					MatchEntryPose( AnimationStateInstance const& currentState, AnimationStateInstance& nextState, float const* outgoingFeatures, float fadeDurationMs );
 
 	// blend tree
 	AnimBlendTree* m_parentBlendTree = nullptr;
 	void		   InitParentBlendTree();
-	void		   UpdateParentBlendTree( AnimBlendTree* newBlendTree );
+	void		   UpdateParentBlendTree( AnimBlendNode* newRootNode );
+	void		   RebindBlendTreeNodes();
+
+	// the same graph compiled into a flat program each pose update, used instead of the trees when enabled
+	bool			 m_isBlendProgramEnabled = false;
+	AnimBlendProgram m_blendProgram;
+	void			 CompileBlendProgram();
+	AnimPose const&	 GetGraphPose();
+
+	// fixed step simulation, the rendered pose is interpolated between the last two simulated steps
+	AnimFixedTimestep	 m_fixedTimestep;
+	AnimPose			 m_previousStepPose;
+	AnimPose			 m_currentStepPose;
+	AnimPose			 m_interpolatedPose;
+	bool				 m_isFixedTimestepAdvanced = false;
+	void				 AdvanceFixedTimestep();
+	void				 UpdateFixedSteps();
+	AnimPose const		 EvaluateSimulatedPose() const;
+
+	// clip residency
+	std::vector<AnimationState*> m_pinnedStates; // sorted
+	std::vector<AnimationState*> m_statesInUseScratch;
+	void						 UpdateClipPins();
+	void						 UnpinAllClips();
+	bool						 AreStateClipsResident( AnimationState* state );
+	AnimClipPrefetcher			 m_clipPrefetcher;
 };
\ No newline at end of file
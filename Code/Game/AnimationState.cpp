@@ -1,5 +1,7 @@
 #include "Game/AnimationState.hpp"
+#include "Game/AnimAssetArchive.hpp"
 #include "Game/AnimationController.hpp"
+#include "Game/AnimClipResidencyManager.hpp"
 #include "Game/GameCommon.hpp"
 
 #include "Engine/Core/DevConsole.hpp"
@@ -13,99 +15,178 @@
 //----------------------------------------------------------------------------------------------------------
 void JobLoadAnimationClip::Execute()
 {
-	g_theDevConsole->AddLine( Rgba8::RED, Stringf( "loading (%i) %s: %s", m_jobNum, m_stateName.c_str(), m_clipFileName.c_str() ) );
+	if ( g_theDevConsole )
+	{
+		g_theDevConsole->AddLine( Rgba8::RED, Stringf( "loading (%i) %s: %s", m_jobNum, m_stateName.c_str(), m_clipFileName.c_str() ) );
+	}
 
-	m_animClip					   = AnimClip::LoadOrGetAnimationClip( m_clipFileName );
-	m_animClip->m_removeRootMotion = m_removeRootMotion;
+	// prefer the cooked archive, fall back to the loose fbx
+	if ( g_theCookedAnimArchive && !m_bypassCookedArchive )
+	{
+		AnimClip* cookedClip = new AnimClip();
+		if ( g_theCookedAnimArchive->LoadAnimClip( m_clipFileName, *cookedClip ) )
+		{
+			m_animClip	   = cookedClip;
+			m_isCookedClip = true;
+		}
+		else
+		{
+			delete cookedClip;
+		}
+	}
 
-	FbxFileImporter::LoadRestPoseFromFile( "Data/Animations/XBot/TPose.fbx", m_defaultPose );
+	if ( !m_animClip && m_bypassClipCache )
+	{
+		// clip owned by the state, so it can be evicted or replaced without touching the engine cache
+		m_animClip = new AnimClip();
+		FbxFileImporter::LoadAnimClipFromFile( m_clipFileName.c_str(), *m_animClip );
+	}
 
-	m_blendTree				= new AnimBlendTree();
-	AnimClipNode* clipNode	= new AnimClipNode( *m_animClip );
-	clipNode->m_sampledPose = m_defaultPose;
+	if ( !m_animClip )
+	{
+		m_animClip	   = AnimClip::LoadOrGetAnimationClip( m_clipFileName );
+		m_isCachedClip = true;
+	}
+	m_animClip->m_removeRootMotion = m_removeRootMotion;
 
-	m_blendTree->m_rootNode = clipNode;
+	m_defaultPose = AnimationState::LoadOrGetRestPose( ANIM_REST_POSE_FILE_PATH );
+
+	// the manager shut down while this was loading, nobody will collect the clip
+	if ( m_isFinishedOrOrphaned.exchange( true ) && !m_isCachedClip )
+	{
+		delete m_animClip;
+		m_animClip = nullptr;
+	}
 }
 
 
 //----------------------------------------------------------------------------------------------------------
 std::map<std::string, AnimationState*> AnimationState::s_animationStatesRegistery;
+std::vector<AnimationState*>		   AnimationState::s_animationStatesById;
+AnimStateMachineTable				   AnimationState::s_stateMachineTable;
+std::vector<int>					   AnimationState::s_poseFeatureJoints;
+std::map<std::string, AnimPose>		   AnimationState::s_restPoses;
+std::mutex							   AnimationState::s_restPosesMutex;
 
 
 //----------------------------------------------------------------------------------------------------------
-Transition::Transition( XmlElement const& xmlElement )
+AnimationState::AnimationState( XmlElement const& animStateElement )
 {
-	m_name			 = ParseXmlAttribute( xmlElement, "name", m_name );
-	m_animationState = ParseXmlAttribute( xmlElement, "animationState", m_animationState );
-	m_fadeDuration	 = ParseXmlAttribute( xmlElement, "fadeDurationMs", m_fadeDuration );
+	m_name			   = ParseXmlAttribute( animStateElement, "name", m_name );
+	m_nameId		   = AnimNameTable::Intern( m_name );
+	m_clipFilePath	   = ParseXmlAttribute( animStateElement, "clip", "UNKOWN CLIP" );
+	m_removeRootMotion = ParseXmlAttribute( animStateElement, "removeRootMotion", false );
+	//m_clip					   = AnimClip::LoadOrGetAnimationClip( clipFilePath );
+	//m_clip->m_removeRootMotion = removeRootMotion;
+
+	m_eventTrack.LoadFromXML( animStateElement );
+	m_blendSpace.LoadFromXML( animStateElement );
+
+	// InitSampledPose();
 }
 
 
 //----------------------------------------------------------------------------------------------------------
-AnimationState::AnimationState( XmlElement const& animStateElement )
+JobLoadAnimationClip* AnimationState::CreateLoadClipJob( bool bypassClipCache, bool bypassCookedArchive ) const
 {
-	m_name								   = ParseXmlAttribute( animStateElement, "name", m_name );
-	std::string			  clipFilePath	   = ParseXmlAttribute( animStateElement, "clip", "UNKOWN CLIP" );
-	bool				  removeRootMotion = ParseXmlAttribute( animStateElement, "removeRootMotion", false );
-	int					  stateNum		   = s_animationStatesRegistery.size() + 1;
-	JobLoadAnimationClip* newJob		   = new JobLoadAnimationClip( stateNum, m_name, clipFilePath, removeRootMotion );
-	g_theJobSystem->PostNewJob( newJob );
-	//m_clip					   = AnimClip::LoadOrGetAnimationClip( clipFilePath );
-	//m_clip->m_removeRootMotion = removeRootMotion;
+	int					  stateNum = ( int ) s_animationStatesRegistery.size() + 1;
+	JobLoadAnimationClip* newJob   = new JobLoadAnimationClip( stateNum, m_name, m_clipFilePath, m_removeRootMotion );
+	newJob->m_bypassClipCache	   = bypassClipCache;
+	newJob->m_bypassCookedArchive  = bypassCookedArchive;
 
-	XmlElement const* transitionElementRoot = animStateElement.FirstChildElement( "Transitions" );
-	if ( transitionElementRoot )
-	{
-		// transitions
-		XmlElement const* transitionElement = transitionElementRoot->FirstChildElement( "Transition" );
-		while ( transitionElement )
-		{
-			Transition* transition				= new Transition( *transitionElement );
-			m_transitions[ transition->m_name ] = transition;
+	return newJob;
+}
 
-			transitionElement = transitionElement->NextSiblingElement( "Transition" );
-		}
 
-		// end transition
-		XmlElement const* transitionEndElement = transitionElementRoot->FirstChildElement( "TransitionEnd" );
-		if ( transitionEndElement )
-		{
-			m_endTransition			= new Transition( *transitionEndElement );
-			m_endTransition->m_name = "Transition End";
-		}
+//----------------------------------------------------------------------------------------------------------
+void AnimationState::ApplyLoadedClip( JobLoadAnimationClip const& completedJob )
+{
+	bool isClipChanged = m_clip != completedJob.m_animClip;
+	m_clip			   = completedJob.m_animClip;
+	m_defaultPose	   = completedJob.m_defaultPose;
+	m_isLoaded		   = true;
+	m_eventTrack.ResolveNormalizedTimes( m_clip->GetEndTime() );
+	RebuildRootMotionTrack();
+	RebuildPoseFeatures();
+
+	// instances holding a clip node over the previous clip rebind on their next sample
+	if ( isClipChanged )
+	{
+		m_clipVersion++;
+	}
+}
 
-		// pop out transition
-		XmlElement const* popOutTransitionElement = transitionElementRoot->FirstChildElement( "PopOutTransition" );
-		if ( popOutTransitionElement )
-		{
-			m_popOutTransition		   = new Transition( *popOutTransitionElement );
-			m_popOutTransition->m_name = "Pop Out Transition";
-		}
+
+//----------------------------------------------------------------------------------------------------------
+void AnimationState::UnloadClip( bool deleteClip )
+{
+	if ( deleteClip )
+	{
+		delete m_clip;
 	}
 
-	/*InitSampledPose();
-	InitBlendTree();*/
+	if ( m_clip )
+	{
+		m_clipVersion++;
+	}
+	m_clip	   = nullptr;
+	m_isLoaded = false;
 }
 
 
 //----------------------------------------------------------------------------------------------------------
-Transition* AnimationState::GetTransitionByName( std::string const& name ) const
+// nothing loads here: states are only sampled once transitions or startup made their clips resident, a clip that is
+// not is a missing wait on the residency manager
+AnimClip* AnimationState::GetClip() const
 {
-	auto iter = m_transitions.find( name );
-	if ( iter != m_transitions.cend() )
+	if ( !m_clip )
 	{
-		return iter->second;
+		ERROR_AND_DIE( Stringf( "Error: Clip for %s was read before it was resident", m_name.c_str() ) );
 	}
-	else
+
+	return m_clip;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// returns true if the clip has to be reloaded
+bool AnimationState::PatchFromXML( XmlElement const& animStateElement )
+{
+	std::string clipFilePath	 = ParseXmlAttribute( animStateElement, "clip", m_clipFilePath );
+	bool		removeRootMotion = ParseXmlAttribute( animStateElement, "removeRootMotion", false );
+	bool		isClipChanged	 = ( clipFilePath != m_clipFilePath ) || ( removeRootMotion != m_removeRootMotion );
+	if ( removeRootMotion != m_removeRootMotion )
 	{
-		DebuggerPrintf( "Error: Unable to find Transition by name: %s. No Transition from current state to this state.\n", name.c_str() );
+		// a new clip path bumps the version once its reload applies, nodes bound to the current clip stay valid
+		m_clipVersion++;
+	}
+	m_clipFilePath	   = clipFilePath;
+	m_removeRootMotion = removeRootMotion;
 
-		return nullptr;
+	// transitions are patched into the state machine table by the hot reloader
+	m_eventTrack.LoadFromXML( animStateElement );
+	if ( m_isLoaded && m_clip )
+	{
+		m_eventTrack.ResolveNormalizedTimes( m_clip->GetEndTime() );
 	}
+
+	// the clip is untouched until a reload applies, only instances' blend space players are rebuilt now
+	m_blendSpace.LoadFromXML( animStateElement );
+	m_blendSpaceVersion++;
+
+	return isClipChanged;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+int AnimationState::GetStateMachineIndex() const
+{
+	return s_stateMachineTable.GetStateIndex( m_nameId );
 }
 
 
 //----------------------------------------------------------------------------------------------------------
+// empty while the clip is not resident, callers copying the curve wait for it first
 Vec3AnimCurve AnimationState::GetRootMotionTranslation() const
 {
 	Vec3AnimCurve rootMotionTranslationCurve;
@@ -119,62 +200,70 @@ Vec3AnimCurve AnimationState::GetRootMotionTranslation() const
 
 
 //----------------------------------------------------------------------------------------------------------
-Vec3 AnimationState::GetFirstKeyframeRootMotionTranslation() const
+// built the first time the clip is applied and kept through eviction, empty until then
+AnimRootMotionTrack const& AnimationState::GetRootMotionTrack() const
 {
-	Vec3AnimCurve const& rootMotionTranslationCurve = m_clip->GetRootJointTranslationCurve();
-	Vec3				 firstRootMotionTranslation = rootMotionTranslationCurve.GetKeyframeAtFirstIndex().m_value;
-
-	return firstRootMotionTranslation;
+	return m_rootMotionTrack;
 }
 
 
 //----------------------------------------------------------------------------------------------------------
-Vec3 AnimationState::GetLastKeyframeRootMotionTranslation() const
+// gameplay code that still edits the clip's root curve in place calls this afterwards
+void AnimationState::RebuildRootMotionTrack()
 {
-	Vec3AnimCurve const& rootMotionTranslationCurve = m_clip->GetRootJointTranslationCurve();
-	Vec3				 lastRootMotionTranslation	= rootMotionTranslationCurve.GetKeyframeAtLastIndex().m_value;
+	if ( !m_clip )
+	{
+		return;
+	}
 
-	return lastRootMotionTranslation;
+	m_rootMotionTrack.Build( m_clip->GetRootJointTranslationCurve() );
 }
 
 
 //----------------------------------------------------------------------------------------------------------
-Vec3 AnimationState::GetLastAndFirstKeyframeRootMotionTranslationDelta() const
+// only states on either end of a pose matched transition pay for sampling every frame of their clip
+void AnimationState::RebuildPoseFeatures()
 {
-	Vec3 lastKeyframeRMT  = GetLastKeyframeRootMotionTranslation();
-	Vec3 firstKeyframeRMT = GetFirstKeyframeRootMotionTranslation();
-	Vec3 translationDelta = lastKeyframeRMT - firstKeyframeRMT;
+	bool isPoseMatchingEnabled = g_gameConfigGlackboard.GetValue( "animPoseMatching", true );
+	if ( !m_clip || !isPoseMatchingEnabled || !s_stateMachineTable.IsStateInPoseMatchedTransition( GetStateMachineIndex() ) )
+	{
+		return;
+	}
 
-	return translationDelta;
+	if ( s_poseFeatureJoints.empty() )
+	{
+		AnimPoseFeatureDatabase::SelectFeatureJoints( m_defaultPose, s_poseFeatureJoints );
+	}
+
+	m_poseFeatures.Build( *m_clip, m_defaultPose, s_poseFeatureJoints );
 }
 
 
 //----------------------------------------------------------------------------------------------------------
-void AnimationState::EndRootMotionZPosAtFollowingZValue( float newZValue )
+Vec3 AnimationState::GetFirstKeyframeRootMotionTranslation() const
 {
-	Vec3AnimCurve& rmtCurve	   = m_clip->GetRootJointTranslationCurveByRefernce();
-	float		   lastZValue = rmtCurve.GetKeyframeAtLastIndex().m_value.z;
-	float		   diff		   = lastZValue - newZValue;
+	return GetRootMotionTrack().GetFirstTranslation();
+}
 
-	for ( unsigned int index = 0; index < rmtCurve.GetSize(); index++ )
-	{
-		Vec3&  rootBonePosInCurve = rmtCurve.m_keyframes[ index ].m_value;
-		float& rootBoneZInCurve	  = rootBonePosInCurve.z;
-		rootBoneZInCurve -= diff;
-	}
+
+//----------------------------------------------------------------------------------------------------------
+Vec3 AnimationState::GetLastKeyframeRootMotionTranslation() const
+{
+	return GetRootMotionTrack().GetLastTranslation();
 }
 
 
 //----------------------------------------------------------------------------------------------------------
-void AnimationState::RemoveRootMotionTranslationOfYPos()
+Vec3 AnimationState::GetLastAndFirstKeyframeRootMotionTranslationDelta() const
 {
-	Vec3AnimCurve& rmtCurve = m_clip->GetRootJointTranslationCurveByRefernce();
-	for ( unsigned int index = 0; index < rmtCurve.GetSize(); index++ )
-	{
-		Vec3&  rootBonePosInCurve = rmtCurve.m_keyframes[ index ].m_value;
-		float& rootBoneYInCurve	  = rootBonePosInCurve.y;
-		rootBoneYInCurve		  = 0.f;
-	}
+	return GetRootMotionTrack().GetTotalDisplacement();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+Vec3 AnimationState::GetRootMotionTranslationAtTime( float timeMs ) const
+{
+	return GetRootMotionTrack().GetTranslationAtTime( timeMs );
 }
 
 
@@ -188,118 +277,130 @@ void AnimationState::LoadAnimationStateFromXML( std::string const& xmlFilePath )
 	XmlElement* animationDefElement = rootElement->FirstChildElement( "AnimationState" );
 	while ( animationDefElement )
 	{
-		AnimationState* state						= new AnimationState( *animationDefElement );
-		s_animationStatesRegistery[ state->m_name ] = state;
+		AnimationState* state = new AnimationState( *animationDefElement );
+		RegisterAnimationState( state );
 
 		animationDefElement = animationDefElement->NextSiblingElement();
 	}
+
+	for ( auto const& registeredState : s_animationStatesRegistery )
+	{
+		if ( !registeredState.second->m_blendSpace.IsEmpty() && !registeredState.second->m_blendSpace.AreSamplesResolved() )
+		{
+			DebuggerPrintf( "Error: Blend space of %s names an unknown state, playing its clip alone\n", registeredState.first.c_str() );
+		}
+	}
+
+	LoadStateMachineTable( xmlFilePath, *rootElement );
 }
 
 
 //----------------------------------------------------------------------------------------------------------
-AnimationState* AnimationState::GetAnimationStateByName( std::string const& name )
+// the cooked table is used only while the xml it was compiled from is unchanged, byte for byte
+void AnimationState::LoadStateMachineTable( std::string const& xmlFilePath, XmlElement const& rootElement )
 {
-	std::map<std::string, AnimationState*>::const_iterator iter = s_animationStatesRegistery.find( name );
-	if ( iter != s_animationStatesRegistery.cend() )
+	if ( g_theCookedAnimArchive && g_theCookedAnimArchive->LoadStateMachineTable( xmlFilePath, s_stateMachineTable ) )
 	{
-		return iter->second;
+		return;
 	}
-	else
-	{
-		DebuggerPrintf( "Error: Unable to find Animation by name: %s\n", name.c_str() );
 
-		return nullptr;
-	}
+	s_stateMachineTable.CompileFromXML( rootElement );
 }
 
 
 //----------------------------------------------------------------------------------------------------------
-void AnimationState::Update( bool loop )
+AnimationState* AnimationState::GetAnimationStateByIndex( int stateMachineIndex )
 {
-	UNUSED( loop );
-
-	// advance local time of the animation and sample
-	float deltaSeconds	 = g_theAnimationController->m_animationClock->GetDeltaSeconds();
-	float deltaSecondsMs = deltaSeconds * 1000.f;
-	m_localTimeMs += deltaSecondsMs;
-
-	if ( m_localTimeMs > m_clip->GetEndTime() )
+	if ( stateMachineIndex == INVALID_ANIM_STATE_MACHINE_INDEX )
 	{
-		// m_localTimeMs = m_clip->GetStartTime();
-		m_localTimeMs = m_clip->GetEndTime();
-		// m_localTimeMs = m_clip->GetEndTime() - 500;
+		return nullptr;
 	}
 
-	/*if (loop)
-	{
-		if (m_localTimeMs > m_clip->GetEndTime())
-		{
-			m_localTimeMs = m_clip->GetStartTime();
-		}
-	}*/
-
-	UpdateBlendTree();
+	return GetAnimationStateById( s_stateMachineTable.GetStateNameId( stateMachineIndex ) );
 }
 
 
 //----------------------------------------------------------------------------------------------------------
-bool AnimationState::IsAtEndOfState()
+void AnimationState::RegisterAnimationState( AnimationState* state )
 {
-	if ( m_localTimeMs >= m_clip->GetEndTime() )
+	s_animationStatesRegistery[ state->m_name ] = state;
+
+	if ( state->m_nameId >= ( AnimNameId ) s_animationStatesById.size() )
 	{
-		return true;
+		s_animationStatesById.resize( state->m_nameId + 1, nullptr );
 	}
-
-	return false;
+	s_animationStatesById[ state->m_nameId ] = state;
 }
 
 
 //----------------------------------------------------------------------------------------------------------
-bool AnimationState::HasEndTransition() const
+AnimationState* AnimationState::GetAnimationStateByName( std::string const& name )
 {
-	if ( m_endTransition )
+	std::map<std::string, AnimationState*>::const_iterator iter = s_animationStatesRegistery.find( name );
+	if ( iter != s_animationStatesRegistery.cend() )
 	{
-		return true;
+		return iter->second;
 	}
+	else
+	{
+		DebuggerPrintf( "Error: Unable to find Animation by name: %s\n", name.c_str() );
 
-	return false;
+		return nullptr;
+	}
 }
 
 
 //----------------------------------------------------------------------------------------------------------
-void AnimationState::InitSampledPose()
+AnimationState* AnimationState::GetAnimationStateById( AnimNameId stateNameId )
 {
-	FbxFileImporter::LoadRestPoseFromFile( "Data/Animations/XBot/TPose.fbx", m_defaultPose );
+	if ( stateNameId >= 0 && stateNameId < ( AnimNameId ) s_animationStatesById.size() && s_animationStatesById[ stateNameId ] )
+	{
+		return s_animationStatesById[ stateNameId ];
+	}
+	else
+	{
+		DebuggerPrintf( "Error: Unable to find Animation by name: %s\n", AnimNameTable::GetName( stateNameId ).c_str() );
+
+		return nullptr;
+	}
 }
 
 
 //----------------------------------------------------------------------------------------------------------
-void AnimationState::InitBlendTree()
+AnimPose const& AnimationState::LoadOrGetRestPose( std::string const& fbxFilePath )
 {
-	m_blendTree				= new AnimBlendTree();
-	AnimClipNode* clipNode	= new AnimClipNode( *m_clip );
-	clipNode->m_sampledPose = m_defaultPose;
+	// clip loading jobs ask from worker threads, the first caller imports while the others wait for it
+	std::lock_guard<std::mutex> lock( s_restPosesMutex );
 
-	m_blendTree->m_rootNode = clipNode;
+	auto foundRestPose = s_restPoses.find( fbxFilePath );
+	if ( foundRestPose != s_restPoses.end() )
+	{
+		return foundRestPose->second;
+	}
+
+	AnimPose& restPose = s_restPoses[ fbxFilePath ];
+	FbxFileImporter::LoadRestPoseFromFile( fbxFilePath.c_str(), restPose );
+
+	return restPose;
 }
 
 
 //----------------------------------------------------------------------------------------------------------
-void AnimationState::UpdateBlendTree()
+bool AnimationState::HasEndTransition() const
 {
-	float clipStartTimeMs	  = m_clip->GetStartTime();
-	float clipEndTimeMs		  = m_clip->GetEndTime();
-	float parametricZeroToOne = m_localTimeMs / ( clipEndTimeMs - clipStartTimeMs );
+	return s_stateMachineTable.GetEndTransitionTarget( GetStateMachineIndex() ) != INVALID_ANIM_STATE_MACHINE_INDEX;
+}
 
-	// DebuggerPrintf( "" );
 
-	AnimBlendNode* clipNode = m_blendTree->m_rootNode;
-	clipNode->Update( parametricZeroToOne );
+//----------------------------------------------------------------------------------------------------------
+bool AnimationState::HasBlendSpace() const
+{
+	return !m_blendSpace.IsEmpty() && m_blendSpace.AreSamplesResolved();
 }
 
 
 //----------------------------------------------------------------------------------------------------------
-AnimBlendTree* AnimationState::GetBlendTree() const
+void AnimationState::InitSampledPose()
 {
-	return m_blendTree;
+	m_defaultPose = LoadOrGetRestPose( ANIM_REST_POSE_FILE_PATH );
 }
@@ -1,28 +1,46 @@
 #pragma once
 
+#include "Game/AnimBlendSpace.hpp"
+#include "Game/AnimEventTrack.hpp"
+#include "Game/AnimNameTable.hpp"
+#include "Game/AnimPoseFeatureDatabase.hpp"
+#include "Game/AnimRootMotionTrack.hpp"
+#include "Game/AnimStateMachineTable.hpp"
+
 #include "Engine/Core/JobSystem.hpp"
 #include "Engine/Animation/AnimBlendTree.hpp"
 #include "Engine/Animation/AnimPose.hpp"
 #include "Engine/Animation/AnimCurve.hpp"
 #include "Engine/Core/XmlUtils.hpp"
 
+#include <atomic>
 #include <string>
 #include <vector>
 #include <map>
+#include <mutex>
 
 class AnimClip;
 
+char const* const ANIM_REST_POSE_FILE_PATH = "Data/Animations/XBot/TPose.fbx";
+
 
 //----------------------------------------------------------------------------------------------------------
 struct JobLoadAnimationClip : public Job
 {
 	int			   m_jobNum			  = 0;
-	std::string m_stateName		   = "";
-	AnimClip*	m_animClip		   = nullptr;
-	std::string m_clipFileName	   = "";
-	bool		m_removeRootMotion = false;
+	std::string m_stateName			  = "";
+	AnimClip*	m_animClip			  = nullptr;
+	std::string m_clipFileName		  = "";
+	bool		m_removeRootMotion	  = false;
+	bool		m_bypassClipCache	  = false;
+	bool		m_bypassCookedArchive = false;
+	bool		m_isReload			  = false;
+	bool		m_isCachedClip		  = false;
+	bool		m_isCookedClip		  = false;
 	AnimPose	m_defaultPose;
-	AnimBlendTree* m_blendTree = nullptr;
+
+	// set by whichever of the worker and a shutting down manager gets to the job first
+	std::atomic<bool> m_isFinishedOrOrphaned = { false };
 
 	JobLoadAnimationClip( int jobNum, std::string stateName, std::string clipFileName, bool removeRootMotion )
 		: m_jobNum(jobNum), m_stateName( stateName ), m_clipFileName( clipFileName ), m_removeRootMotion( removeRootMotion )
@@ -36,17 +54,6 @@ struct JobLoadAnimationClip : public Job
 };
 
 
-//----------------------------------------------------------------------------------------------------------
-struct Transition
-{
-	std::string m_name			 = "UNKOWN TRANSITION";
-	std::string m_animationState = "UNKOWN ANIMATION STATE";
-	float		m_fadeDuration	 = 0.f;
-
-	Transition( XmlElement const& xmlElement );
-};
-
-
 //----------------------------------------------------------------------------------------------------------
 class AnimationState
 {
@@ -55,39 +62,67 @@ public:
 
 	bool							   m_isLoaded		  = false;
 	std::string						   m_name			  = "";
+	AnimNameId						   m_nameId			  = INVALID_ANIM_NAME_ID;
+	std::string						   m_clipFilePath	  = "";
+	bool							   m_removeRootMotion = false;
 	AnimClip*						   m_clip			  = nullptr;
-	std::map<std::string, Transition*> m_transitions	  = {};
-	Transition*						   m_endTransition	  = nullptr;
-	Transition*						   m_popOutTransition = nullptr;
-	Transition*						   GetTransitionByName( std::string const& name ) const;
-
-	// root motion utils
-	Vec3AnimCurve GetRootMotionTranslation() const;
-	Vec3		  GetFirstKeyframeRootMotionTranslation() const;
-	Vec3		  GetLastKeyframeRootMotionTranslation() const;
-	Vec3		  GetLastAndFirstKeyframeRootMotionTranslationDelta() const;
-	void		  EndRootMotionZPosAtFollowingZValue( float newZValue );
-	void		  RemoveRootMotionTranslationOfYPos();
+
+	// transitions live in the state machine table, keyed by this state's index
+	int								   GetStateMachineIndex() const;
+
+	// clip loading, driven by the clip residency manager
+	AnimClip*						   GetClip() const;
+	JobLoadAnimationClip*			   CreateLoadClipJob( bool bypassClipCache, bool bypassCookedArchive ) const;
+	void							   ApplyLoadedClip( JobLoadAnimationClip const& completedJob );
+	void							   UnloadClip( bool deleteClip );
+	bool							   PatchFromXML( XmlElement const& animStateElement );
+
+	// clip events, reported by each instance for the time range it advanced over
+	AnimEventTrack					   m_eventTrack;
+
+	// optional blend space over other states' clips, this state's own clip still sets the playback timeline
+	AnimBlendSpace					   m_blendSpace;
+	bool							   HasBlendSpace() const;
+
+	// root motion utils, queries go through the track extracted at load and stay valid while the clip is streamed out
+	AnimRootMotionTrack		   m_rootMotionTrack;
+	AnimRootMotionTrack const& GetRootMotionTrack() const;
+	void					   RebuildRootMotionTrack();
+	Vec3AnimCurve			   GetRootMotionTranslation() const;
+	Vec3					   GetFirstKeyframeRootMotionTranslation() const;
+	Vec3					   GetLastKeyframeRootMotionTranslation() const;
+	Vec3					   GetLastAndFirstKeyframeRootMotionTranslationDelta() const;
+	Vec3					   GetRootMotionTranslationAtTime( float timeMs ) const;
+
+	// pose features for picking the entry frame of pose matched transitions, built at load like the root motion track
+	AnimPoseFeatureDatabase	   m_poseFeatures;
+	void					   RebuildPoseFeatures();
+	static std::vector<int>	   s_poseFeatureJoints;
 
 	// static animation registry
 	static void									  LoadAnimationStateFromXML( std::string const& xmlFilePath );
 	static std::map<std::string, AnimationState*> s_animationStatesRegistery;
+	static std::vector<AnimationState*>			  s_animationStatesById;
+	static void									  RegisterAnimationState( AnimationState* state );
 	static AnimationState*						  GetAnimationStateByName( std::string const& name );
+	static AnimationState*						  GetAnimationStateById( AnimNameId stateNameId );
 
-	// animation pose
-	float	 m_localTimeMs = 0.f;
+	// rest poses imported from their fbx once, every later state or mesh copies the cached pose
+	static AnimPose const&						  LoadOrGetRestPose( std::string const& fbxFilePath );
+	static std::map<std::string, AnimPose>		  s_restPoses;
+	static std::mutex							  s_restPosesMutex;
+
+	// compiled state machine, evaluated by the controller
+	static AnimStateMachineTable				  s_stateMachineTable;
+	static void									  LoadStateMachineTable( std::string const& xmlFilePath, XmlElement const& rootElement );
+	static AnimationState*						  GetAnimationStateByIndex( int stateMachineIndex );
+
+	// animation pose, playback time and blend nodes live on each controller's AnimationStateInstance
 	AnimPose m_defaultPose;
+	int		 m_clipVersion		 = 0;
+	int		 m_blendSpaceVersion = 0;
 	void	 InitSampledPose();
-	void	 Update( bool loop = false );
 
 	// state data
-	bool IsAtEndOfState();
 	bool HasEndTransition() const;
-
-	// animation blend tree
-	AnimBlendTree* GetBlendTree() const;
-//protected:
-	AnimBlendTree* m_blendTree = nullptr;
-	void		   InitBlendTree();
-	void		   UpdateBlendTree();
 };
\ No newline at end of file
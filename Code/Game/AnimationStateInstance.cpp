@@ -0,0 +1,317 @@
+#include "Game/AnimationStateInstance.hpp"
+#include "Game/AnimationState.hpp"
+#include "Game/AnimBlendProgram.hpp"
+#include "Game/AnimBlendSpace.hpp"
+#include "Game/AnimEventTrack.hpp"
+
+#include "Engine/Animation/AnimClip.hpp"
+#include "Engine/Animation/AnimBlendNode.hpp"
+
+
+//----------------------------------------------------------------------------------------------------------
+AnimationStateInstance::AnimationStateInstance( AnimationState* state )
+	: m_state( state )
+{
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+AnimationStateInstance::~AnimationStateInstance()
+{
+	ReleaseClipNode();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimationStateInstance::Restart()
+{
+	m_localTimeMs = 0.f;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimationStateInstance::Update( float deltaSecondsMs, AnimEventQueue* eventQueue )
+{
+	AnimClip* clip = m_state->GetClip();
+
+	// a blend space plays its own clip's timeline at the rate of the blended cycle, so every sample stays in phase
+	BindClipNode();
+	if ( m_blendSpacePlayer )
+	{
+		m_blendSpacePlayer->UpdateWeights( GetBlendParameters() );
+		float weightedDurationMs = m_blendSpacePlayer->GetWeightedDurationMs();
+		if ( weightedDurationMs > 0.f )
+		{
+			deltaSecondsMs *= ( clip->GetEndTime() - clip->GetStartTime() ) / weightedDurationMs;
+		}
+	}
+
+	// advance local time of the animation and sample
+	float previousLocalTimeMs  = m_localTimeMs;
+	m_localTimeMs			  += deltaSecondsMs;
+
+	if ( m_localTimeMs > clip->GetEndTime() )
+	{
+		m_localTimeMs = clip->GetEndTime();
+	}
+
+	if ( eventQueue && m_localTimeMs > previousLocalTimeMs )
+	{
+		// a looping state restarts at zero, so the range reaching the end includes it and nothing is lost between passes
+		bool isEndReached = m_localTimeMs >= clip->GetEndTime();
+		m_state->m_eventTrack.CollectEvents( previousLocalTimeMs, m_localTimeMs, isEndReached, m_state, *eventQueue );
+
+		if ( isEndReached )
+		{
+			eventQueue->Push( ANIM_NAME_EVENT_END, m_state, m_localTimeMs );
+		}
+	}
+
+	float clipStartTimeMs	  = clip->GetStartTime();
+	float clipEndTimeMs		  = clip->GetEndTime();
+	float parametricZeroToOne = m_localTimeMs / ( clipEndTimeMs - clipStartTimeMs );
+
+	if ( m_isSampledByBlendProgram )
+	{
+		return;
+	}
+
+	if ( m_blendSpacePlayer )
+	{
+		m_blendSpacePlayer->Update( parametricZeroToOne );
+	}
+	else
+	{
+		GetBlendNode()->Update( parametricZeroToOne );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool AnimationStateInstance::IsAtEndOfState() const
+{
+	if ( m_localTimeMs >= m_state->GetClip()->GetEndTime() )
+	{
+		return true;
+	}
+
+	return false;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+float AnimationStateInstance::GetNormalizedTime() const
+{
+	AnimClip* clip			 = m_state->GetClip();
+	float	  clipDurationMs = clip->GetEndTime() - clip->GetStartTime();
+	if ( clipDurationMs <= 0.f )
+	{
+		return 0.f;
+	}
+
+	return m_localTimeMs / clipDurationMs;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// entering a state of the same sync group continues the leader's cycle instead of restarting it
+void AnimationStateInstance::SyncPhaseWith( AnimationStateInstance const& leader )
+{
+	if ( !IsInSyncGroupWith( leader ) )
+	{
+		return;
+	}
+
+	AnimClip* clip = m_state->GetClip();
+	m_localTimeMs  = leader.GetNormalizedTime() * ( clip->GetEndTime() - clip->GetStartTime() );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+AnimBlendNode* AnimationStateInstance::GetBlendNode()
+{
+	BindClipNode();
+	if ( m_blendSpacePlayer )
+	{
+		return m_blendSpacePlayer->GetRootNode();
+	}
+
+	return m_clipNode;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+AnimPose const& AnimationStateInstance::GetSampledPose()
+{
+	BindClipNode();
+	if ( m_blendSpacePlayer )
+	{
+		return m_blendSpacePlayer->GetBlendedPose();
+	}
+
+	return m_clipNode->m_sampledPose;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimationStateInstance::BindClipNode()
+{
+	AnimClip* clip = m_state->GetClip();
+	if ( m_boundClipVersion != m_state->m_clipVersion )
+	{
+		// the engine node holds its clip by reference, so another clip gets another node; the controller points its
+		// trees at the live node again in RebindBlendTreeNodes before the next evaluation
+		AnimClipNode* previousClipNode = m_clipNode;
+		m_clipNode					   = new AnimClipNode( *clip );
+		m_clipNode->m_sampledPose	   = previousClipNode ? previousClipNode->m_sampledPose : m_state->m_defaultPose;
+		m_boundClipVersion			   = m_state->m_clipVersion;
+		delete previousClipNode;
+	}
+
+	// the player's sample nodes follow their own states' clips, it is only rebuilt when the blend space changes
+	if ( m_boundBlendSpaceVersion != m_state->m_blendSpaceVersion )
+	{
+		delete m_blendSpacePlayer;
+		m_blendSpacePlayer = nullptr;
+
+		if ( m_state->HasBlendSpace() )
+		{
+			m_blendSpacePlayer = new AnimBlendSpacePlayer( m_state->m_blendSpace, m_state->m_defaultPose );
+			m_blendSpacePlayer->UpdateWeights( GetBlendParameters() );
+		}
+		m_boundBlendSpaceVersion = m_state->m_blendSpaceVersion;
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimationStateInstance::ReleaseClipNode()
+{
+	delete m_clipNode;
+	m_clipNode		   = nullptr;
+	m_boundClipVersion = -1;
+
+	delete m_blendSpacePlayer;
+	m_blendSpacePlayer		 = nullptr;
+	m_boundBlendSpaceVersion = -1;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+int AnimationStateInstance::EmitToBlendProgram( AnimBlendProgram& program )
+{
+	BindClipNode();
+	if ( m_blendSpacePlayer )
+	{
+		return m_blendSpacePlayer->EmitToBlendProgram( program, GetNormalizedTime() );
+	}
+
+	return program.EmitSampleClip( m_state->GetClip(), m_localTimeMs );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void AnimationStateInstance::SetBlendParameters( Vec2 const& parameters )
+{
+	m_blendParameters	 = parameters;
+	m_hasBlendParameters = true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// until gameplay drives it, a blend space sits on this state's own sample and plays exactly like its clip
+Vec2 AnimationStateInstance::GetBlendParameters() const
+{
+	if ( m_hasBlendParameters )
+	{
+		return m_blendParameters;
+	}
+
+	AnimBlendSpace const& blendSpace  = m_state->m_blendSpace;
+	int					  sampleIndex = blendSpace.FindSampleIndex( m_state->m_nameId );
+	if ( sampleIndex < 0 )
+	{
+		sampleIndex = 0;
+	}
+
+	return blendSpace.m_samples[ sampleIndex ].m_position;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool AnimationStateInstance::IsInSyncGroupWith( AnimationStateInstance const& other ) const
+{
+	AnimNameId syncGroupId = m_state->m_blendSpace.m_syncGroupId;
+	return syncGroupId != INVALID_ANIM_NAME_ID && syncGroupId == other.m_state->m_blendSpace.m_syncGroupId;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+Vec3AnimCurve const& AnimationStateInstance::GetSourceRootMotionCurve() const
+{
+	return m_state->GetClip()->GetRootJointTranslationCurve();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+Vec3 AnimationStateInstance::SampleRootMotionTranslation( float timeMs ) const
+{
+	return m_rootMotionWarp.Apply( m_state->GetRootMotionTrack().GetTranslationAtTime( timeMs ) );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// offsets cancel out of a displacement, only the warp's scale is left
+Vec3 AnimationStateInstance::GetRootMotionDisplacement( float startTimeMs, float endTimeMs ) const
+{
+	Vec3 displacement = m_state->GetRootMotionTrack().GetDisplacement( startTimeMs, endTimeMs );
+	Vec3 const& scale = m_rootMotionWarp.m_scale;
+
+	return Vec3( displacement.x * scale.x, displacement.y * scale.y, displacement.z * scale.z );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+Vec3 AnimationStateInstance::GetFirstRootMotionTranslation() const
+{
+	return m_rootMotionWarp.Apply( m_state->GetRootMotionTrack().GetFirstTranslation() );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+Vec3 AnimationStateInstance::GetLastRootMotionTranslation() const
+{
+	return m_rootMotionWarp.Apply( m_state->GetRootMotionTrack().GetLastTranslation() );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// clips that keep their root motion carry the unwarped root in the sampled pose, the renderer shifts the model
+// by this much so the pose follows the warp as well
+Vec3 AnimationStateInstance::GetRootMotionWarpPoseOffset() const
+{
+	if ( m_rootMotionWarp.IsIdentity() || m_state->m_removeRootMotion )
+	{
+		return Vec3::ZERO;
+	}
+
+	Vec3 sourceTranslation = m_state->GetRootMotionTrack().GetTranslationAtTime( m_localTimeMs );
+	return m_rootMotionWarp.Apply( sourceTranslation ) - sourceTranslation;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// the warp applies to the translation the same way it does for the track
+AnimRootSample AnimationStateInstance::SampleRoot( float timeMs ) const
+{
+	AnimClip* clip = m_state->GetClip();
+	if ( !m_rootSampler.IsBoundTo( clip ) )
+	{
+		m_rootSampler.Bind( clip );
+	}
+
+	AnimRootSample rootSample = m_rootSampler.Sample( timeMs );
+	rootSample.m_translation  = m_rootMotionWarp.Apply( rootSample.m_translation );
+
+	return rootSample;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Game/AnimRootSampler.hpp"
+#include "Game/RootMotionWarp.hpp"
+
+#include "Engine/Math/Vec2.hpp"
+
+class AnimationState;
+class AnimBlendSpacePlayer;
+class AnimBlendProgram;
+class AnimPose;
+class AnimBlendNode;
+class AnimClipNode;
+class AnimEventQueue;
+struct Vec3AnimCurve;
+
+
+//----------------------------------------------------------------------------------------------------------
+// per controller playback record of a shared AnimationState, the definition holds the clip and transitions and
+// any number of instances sample it at their own local time
+class AnimationStateInstance
+{
+public:
+	AnimationStateInstance( AnimationState* state );
+	~AnimationStateInstance();
+
+	AnimationState* m_state		  = nullptr;
+	float			m_localTimeMs = 0.f;
+	void			Restart();
+	void			Update( float deltaSecondsMs, AnimEventQueue* eventQueue = nullptr );
+	bool			IsAtEndOfState() const;
+	float			GetNormalizedTime() const;
+	void			SyncPhaseWith( AnimationStateInstance const& leader );
+
+	// blend node sampling the shared clip, rebuilt when the definition's clip is reloaded or evicted
+	AnimClipNode*	m_clipNode		   = nullptr;
+	int				m_boundClipVersion = -1;
+	AnimBlendNode*	GetBlendNode();
+	AnimPose const& GetSampledPose();
+	void			BindClipNode();
+	void			ReleaseClipNode();
+
+	// controllers evaluating through a blend program only advance time here and emit the sampling instead
+	bool			m_isSampledByBlendProgram = false;
+	int				EmitToBlendProgram( AnimBlendProgram& program );
+
+	// blend space playback for states that have one, rebuilt when the definition's blend space is reloaded
+	AnimBlendSpacePlayer* m_blendSpacePlayer	   = nullptr;
+	int					  m_boundBlendSpaceVersion = -1;
+	Vec2				  m_blendParameters;
+	bool				  m_hasBlendParameters = false;
+	void				  SetBlendParameters( Vec2 const& parameters );
+	Vec2				  GetBlendParameters() const;
+	bool				  IsInSyncGroupWith( AnimationStateInstance const& other ) const;
+
+	// root motion read through this instance's warp, the shared clip's curve is never written
+	RootMotionWarp		  m_rootMotionWarp;
+	Vec3AnimCurve const&  GetSourceRootMotionCurve() const;
+	Vec3				  SampleRootMotionTranslation( float timeMs ) const;
+	Vec3				  GetRootMotionDisplacement( float startTimeMs, float endTimeMs ) const;
+	Vec3				  GetFirstRootMotionTranslation() const;
+	Vec3				  GetLastRootMotionTranslation() const;
+	Vec3				  GetRootMotionWarpPoseOffset() const;
+
+	// root only sampling straight from the clip's keyframes, for gameplay following playback frame by frame
+	mutable AnimRootSampler m_rootSampler;
+	AnimRootSample			SampleRoot( float timeMs ) const;
+};
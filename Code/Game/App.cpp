@@ -1,5 +1,6 @@
 #include "Game/Game.hpp"
 #include "Game/App.hpp"
+#include "Game/AnimAssetArchive.hpp"
 
 #include "Engine/Core/JobSystem.hpp"
 #include "Engine/Renderer/Renderer.hpp"
@@ -72,6 +73,7 @@ void App::Startup()
 	DebugRenderSystemStartup(debugRendererConfig);
 
 	LoadGameConfig();
+	LoadCookedAssets();
 	LoadFonts();
 	LoadTextures();
 	LoadShaders();
@@ -118,6 +120,7 @@ void App::Shutdown()
 	delete g_theInput;			g_theInput = nullptr;
 	delete g_theEventSystem;	g_theEventSystem = nullptr;
 	delete g_theDevConsole;		g_theDevConsole = nullptr;
+	delete g_theCookedAnimArchive;	g_theCookedAnimArchive = nullptr;
 }
 
 void App::RunFrame()
@@ -252,6 +255,18 @@ void App::LoadGameConfig()
 }
 
 
+void App::LoadCookedAssets()
+{
+	// cooked archive is optional, loose fbx files are used when it is missing
+	g_theCookedAnimArchive = new AnimAssetArchive();
+	if (!g_theCookedAnimArchive->OpenForRead(COOKED_ANIM_ARCHIVE_PATH))
+	{
+		delete g_theCookedAnimArchive;
+		g_theCookedAnimArchive = nullptr;
+	}
+}
+
+
 void App::LoadFonts()
 {
 	// test font
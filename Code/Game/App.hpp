@@ -33,6 +33,7 @@ protected:
 	bool m_isQuitting = false;
 
 	void LoadGameConfig();
+	void LoadCookedAssets();
 	void LoadFonts();
 	void LoadTextures();
 	void LoadShaders();
@@ -1,10 +1,12 @@
 #include "Game/GameFinalShowcase.hpp"
 #include "Game/App.hpp"
 #include "Game/Map.hpp"
+#include "Game/AnimAssetArchive.hpp"
 #include "Game/GameVaultingTest.hpp"
 #include "Game/AnimationState.hpp"
 #include "Game/GameBasicMovement.hpp"
 #include "Game/MovementState.hpp"
+#include "Game/MotionMatcher.hpp"
 #include "Game/AnimationController.hpp"
 #include "Game/ThirdPersonController.hpp"
 #include "Game/Character.hpp"
@@ -51,6 +53,12 @@ Character::Character()
 
 Character::~Character()
 {
+	if ( m_motionMatcher )
+	{
+		m_motionMatcher->Shutdown();
+		delete m_motionMatcher;
+		m_motionMatcher = nullptr;
+	}
 }
 
 
@@ -59,7 +67,7 @@ void Character::Startup()
 {
 	InitSpriteLitShader();
 	InitMovementState();
-	InitRaycast();
+	m_isMotionMatchingEnabled = g_gameConfigGlackboard.GetValue( "animMotionMatching", false );
 	InitDebugRootMotionTranslation();
 	CreateRootMotionTranslationGraphVerts();
 	//LoadMeshData();
@@ -96,6 +104,7 @@ void Character::Update()
 	UpdateHeadRaycast();
 	UpdateShoulderRaycasts();
 	UpdateGroundRaycast();
+	CastRaycasts();
 	ToggleMeshRender();
 
 	UpdateDebugRootMotionTranslation();
@@ -194,14 +203,68 @@ void Character::DebugRenderBasisVectors() const
 //----------------------------------------------------------------------------------------------------------
 void Character::UpdateAnimations()
 {
-	g_theAnimationController->Update();
+	UpdateMotionMatching();
+	m_animationController->Update();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// built on first use, the controller and the locomotion clips are only there once the game mode has started
+void Character::UpdateMotionMatching()
+{
+	if ( !m_isMotionMatchingEnabled )
+	{
+		return;
+	}
+
+	if ( !m_motionMatcher )
+	{
+		m_motionMatcher = new MotionMatcher();
+		if ( !m_motionMatcher->Startup() )
+		{
+			m_isMotionMatchingEnabled = false;
+			return;
+		}
+	}
+
+	if ( IsMotionMatchingMovementState( m_movementState ) )
+	{
+		m_motionMatcher->Update( *m_animationController, g_theThirdPersonController->GetCharacterSpeed(), g_theThirdPersonController->GetDesiredCharacterSpeed() );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool Character::IsMotionMatchingMovementState( MovementState const* movementState ) const
+{
+	return m_motionMatcher && m_motionMatcher->IsReady() && m_motionMatcher->IsMatchedState( movementState->GetStateId() );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// events are queued by one pose update and dispatched in the next frame's graph update, after the movement state
+// may have changed; an event from any animation but the current state's belongs to a state that is gone
+void Character::OnAnimEvent( AnimEventDispatch const& animEvent )
+{
+	if ( !animEvent.m_state || animEvent.m_state->m_nameId != m_movementState->GetStateId() )
+	{
+		return;
+	}
+
+	if ( animEvent.m_eventId == ANIM_NAME_EVENT_END )
+	{
+		m_movementState->NotifyEndOfAnimationState( false );
+		return;
+	}
+
+	m_movementState->OnAnimEvent( animEvent );
 }
 
 
 //----------------------------------------------------------------------------------------------------------
 void Character::RenderAnimations() const
 {
-	AnimPose const& sampledPose = g_theAnimationController->GetSampledPose();
+	AnimPose const& sampledPose = m_animationController->GetSampledPose();
 	RenderPose( sampledPose, Rgba8::WHITE );
 	RenderMeshData( sampledPose );
 }
@@ -220,7 +283,7 @@ void Character::RenderPose( AnimPose const& pose, Rgba8 color ) const
 	{
 		Transform const& self = pose.GetGlobalTransformOfJoint( index );
 
-		if ( g_theCharacter->m_movementState->GetStateName() == "hangDrop" )
+		if ( g_theCharacter->m_movementState->GetStateId() == ANIM_NAME_HANG_DROP )
 		{
 			if ( index == 0 )
 			{
@@ -246,6 +309,7 @@ void Character::RenderPose( AnimPose const& pose, Rgba8 color ) const
 	Mat44 modelTransformMatrix;
 	modelTransformMatrix.AppendTranslation3D( m_physics.m_position );
 	modelTransformMatrix.Append( m_physics.m_orientation.GetAsMatrix_XFwd_YLeft_ZUp() );
+	modelTransformMatrix.AppendTranslation3D( m_animationController->GetRootMotionWarpPoseOffset() );
 
 	g_theRenderer->SetModelConstants( modelTransformMatrix, color );
 	// g_theRenderer->SetModelConstants();
@@ -279,13 +343,23 @@ void Character::UpdateMovementState()
 	MovementState* newState = m_movementState->UpdateTransition();
 	if ( newState )
 	{
+		// between locomotion states the motion matcher chooses the clip, it searches right away instead of a transition
+		bool isMatchedChange = IsMotionMatchingMovementState( m_movementState ) && IsMotionMatchingMovementState( newState );
+
 		// swap mpvement state
 		delete m_movementState;
 		m_movementState = newState;
 
 		//  request animation change
-		g_theAnimationController->m_transitionRequested = true;
-		g_theAnimationController->m_nextStateName		= m_movementState->GetStateName();
+		if ( isMatchedChange )
+		{
+			m_motionMatcher->RequestSearch();
+		}
+		else
+		{
+			m_animationController->m_transitionRequested = true;
+			m_animationController->m_nextTransitionId	 = m_movementState->GetStateId();
+		}
 
 		CreateRootMotionTranslationGraphVerts();
 	}
@@ -317,14 +391,6 @@ void Character::DebugRenderCurrentMovementState() const
 }
 
 
-//----------------------------------------------------------------------------------------------------------
-void Character::InitRaycast()
-{
-	if ( m_map )
-		m_obstacles = m_map->m_obstacleConvexHulls;
-}
-
-
 //----------------------------------------------------------------------------------------------------------
 void Character::UpdateFootRaycast()
 {
@@ -332,16 +398,37 @@ void Character::UpdateFootRaycast()
 	Vec3  rayForwardnormal = m_physics.m_orientation.GetVector_XFwd();
 	float rayLength		   = m_footRaycastMaxDistance;
 
-	for ( int index = 0; index < m_obstacles.size(); index++ )
-	{
-		ConvexHull3 const& obstacleHull = m_obstacles[ index ];
-		m_footRaycastResult				= RaycastVsConvexHull3D( rayStartPos, rayForwardnormal, rayLength, obstacleHull );
+	MapRaycastQuery& query = m_raycastQueries[ CHARACTER_RAYCAST_FOOT ];
+	query.m_startPos	   = rayStartPos;
+	query.m_fwdNormal	   = rayForwardnormal;
+	query.m_maxLength	   = rayLength;
+	query.m_isAnyHitEnough = false;
+}
+
 
-		if ( m_footRaycastResult.m_didImpact )
+//----------------------------------------------------------------------------------------------------------
+// all five probes go to the map as one batch, a packet of four and a single ray
+void Character::CastRaycasts()
+{
+	MapRaycastHit hits[ NUM_CHARACTER_RAYCASTS ];
+	if ( m_map )
+	{
+		m_map->Raycast( m_raycastQueries, NUM_CHARACTER_RAYCASTS, hits );
+	}
+	else
+	{
+		// nothing to hit, the rays are still recorded for debug drawing
+		for ( int raycastIndex = 0; raycastIndex < NUM_CHARACTER_RAYCASTS; raycastIndex++ )
 		{
-			break;
+			InitRaycastMiss( m_raycastQueries[ raycastIndex ], hits[ raycastIndex ] );
 		}
 	}
+
+	m_footRaycastResult			 = hits[ CHARACTER_RAYCAST_FOOT ].m_result;
+	m_headRaycast				 = hits[ CHARACTER_RAYCAST_HEAD ].m_result;
+	m_rightShoulderRaycastResult = hits[ CHARACTER_RAYCAST_RIGHT_SHOULDER ].m_result;
+	m_leftShoulderRaycastResult	 = hits[ CHARACTER_RAYCAST_LEFT_SHOULDER ].m_result;
+	m_groundRaycastResult		 = hits[ CHARACTER_RAYCAST_GROUND ].m_result;
 }
 
 
@@ -438,33 +525,11 @@ void Character::UpdateHeadRaycast()
 	Vec3  rayForwardnormal = m_physics.m_orientation.GetVector_XFwd();
 	float rayLength		   = m_headraycastMaxDistance;
 
-	for ( int index = 0; index < m_obstacles.size(); index++ )
-	{
-		ConvexHull3 const& obstacleHull = m_obstacles[ index ];
-		m_headRaycast					= RaycastVsConvexHull3D( rayStartPos, rayForwardnormal, rayLength, obstacleHull );
-
-		if ( m_headRaycast.m_didImpact )
-		{
-			// calculate the height of obstacle
-			for (int planeIndex = 0; planeIndex < obstacleHull.m_boundingPlanes.size(); planeIndex++)
-			{
-				Plane3 plane = obstacleHull.m_boundingPlanes[ planeIndex ];
-				Vec3   planeNormal = plane.m_normal;
-				Vec3   skyward	   = Vec3( 0.f, 0.f, 1.f );
-				float dotProduct = DotProduct3D( planeNormal, skyward );
-				if (dotProduct >= 0.99f)
-				{
-					Vec3 pointOnPlane = planeNormal * plane.m_distanceFromOrigin;
-					m_latestObstacleHeight = pointOnPlane.z;
-					DebuggerPrintf( "plane height: %f\n", pointOnPlane.z );
-					break;
-				}
-			}
-			
-
-			break;
-		}
-	}
+	MapRaycastQuery& query = m_raycastQueries[ CHARACTER_RAYCAST_HEAD ];
+	query.m_startPos	   = rayStartPos;
+	query.m_fwdNormal	   = rayForwardnormal;
+	query.m_maxLength	   = rayLength;
+	query.m_isAnyHitEnough = false;
 }
 
 
@@ -507,27 +572,18 @@ void Character::UpdateShoulderRaycasts()
 	Vec3	   rayForwardnormal		   = m_physics.m_orientation.GetVector_XFwd();
 	float	   rayLength			   = m_rightShoulderRaycastMaxDistance;
 
-	// check for right shoulder raycast
-	for ( int index = 0; index < m_obstacles.size(); index++ )
-	{
-		ConvexHull3 const& obstacleHull = m_obstacles[ index ];
-		m_rightShoulderRaycastResult	= RaycastVsConvexHull3D( rightRaycastStartPos, rayForwardnormal, rayLength, obstacleHull );
-		if ( m_rightShoulderRaycastResult.m_didImpact )
-		{
-			break;
-		}
-	}
-
-	// check for left shoulder raycast
-	for ( int index = 0; index < m_obstacles.size(); index++ )
-	{
-		ConvexHull3 const& obstacleHull = m_obstacles[ index ];
-		m_leftShoulderRaycastResult		= RaycastVsConvexHull3D( leftRaycastStartPos, rayForwardnormal, rayLength, obstacleHull );
-		if ( m_leftShoulderRaycastResult.m_didImpact )
-		{
-			break;
-		}
-	}
+	// shoulders only care whether anything is there, so either cast stops at the first hit
+	MapRaycastQuery& rightQuery = m_raycastQueries[ CHARACTER_RAYCAST_RIGHT_SHOULDER ];
+	rightQuery.m_startPos		= rightRaycastStartPos;
+	rightQuery.m_fwdNormal		= rayForwardnormal;
+	rightQuery.m_maxLength		= rayLength;
+	rightQuery.m_isAnyHitEnough = true;
+
+	MapRaycastQuery& leftQuery = m_raycastQueries[ CHARACTER_RAYCAST_LEFT_SHOULDER ];
+	leftQuery.m_startPos	   = leftRaycastStartPos;
+	leftQuery.m_fwdNormal	   = rayForwardnormal;
+	leftQuery.m_maxLength	   = rayLength;
+	leftQuery.m_isAnyHitEnough = true;
 }
 
 
@@ -550,11 +606,11 @@ bool Character::IsLeftShoulderRaycastHittinSomething() const
 //----------------------------------------------------------------------------------------------------------
 void Character::UpdateGroundRaycast()
 {
-	if ( g_theCharacter->m_movementState->GetStateName() == "walk" )
+	if ( g_theCharacter->m_movementState->GetStateId() == ANIM_NAME_WALK )
 	{
 		m_groundRaycastStartOffset = Vec3( 0.45f, 0.f, -0.2f );
 	}
-	else if ( g_theCharacter->m_movementState->GetStateName() == "run" )
+	else if ( g_theCharacter->m_movementState->GetStateId() == ANIM_NAME_RUN )
 	{
 		m_groundRaycastStartOffset = Vec3( 2.f, 0.f, -0.2f );
 	}
@@ -567,15 +623,11 @@ void Character::UpdateGroundRaycast()
 	Vec3  groundRaycastFwdNormal	  = -1.f * characterOrientation.GetVector_ZUp();
 	float raycastLegth				  = 1.5f;
 
-	for ( int index = 0; index < m_obstacles.size(); index++ )
-	{
-		ConvexHull3 const& convexHull = m_obstacles[ index ];
-		m_groundRaycastResult		  = RaycastVsConvexHull3D( groundRaycastStartPos, groundRaycastFwdNormal, raycastLegth, convexHull );
-		if ( m_groundRaycastResult.m_didImpact )
-		{
-			break;
-		}
-	}
+	MapRaycastQuery& query = m_raycastQueries[ CHARACTER_RAYCAST_GROUND ];
+	query.m_startPos	   = groundRaycastStartPos;
+	query.m_fwdNormal	   = groundRaycastFwdNormal;
+	query.m_maxLength	   = raycastLegth;
+	query.m_isAnyHitEnough = true;
 }
 
 
@@ -607,6 +659,107 @@ bool Character::IsCharacterOnTheGround() const
 }
 
 
+//----------------------------------------------------------------------------------------------------------
+bool Character::FindLedgeInReach( MapLedgeQuery const& query )
+{
+	if ( !m_map )
+	{
+		return false;
+	}
+
+	MapLedgeHit ledgeHit;
+	if ( !m_map->FindNearestLedge( query, ledgeHit ) )
+	{
+		return false;
+	}
+
+	m_latestLedge		   = ledgeHit;
+	m_latestObstacleHeight = ledgeHit.m_ledge.m_height;
+	return true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// a lip above the head right in front, where the head ray used to stop
+bool Character::FindLedgeToGrab()
+{
+	MapLedgeQuery query;
+	query.m_position		 = m_physics.m_position;
+	query.m_facing			 = m_physics.m_orientation.GetVector_XFwd();
+	query.m_distanceRange	 = m_ledgeGrabDistanceRange;
+	query.m_heightAboveRange = m_ledgeGrabHeightRange;
+	query.m_needsGrabbable	 = true;
+	return FindLedgeInReach( query );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// a low, shallow top a run up away, what the foot ray hitting and the head ray missing used to mean
+bool Character::FindLedgeToVault()
+{
+	MapLedgeQuery query;
+	query.m_position		 = m_physics.m_position;
+	query.m_facing			 = m_physics.m_orientation.GetVector_XFwd();
+	query.m_distanceRange	 = m_vaultDistanceRange;
+	query.m_heightAboveRange = m_vaultHeightRange;
+	query.m_needsVaultable	 = true;
+	return FindLedgeInReach( query );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// the edge being walked off, level with the feet and facing the way the character walks
+bool Character::FindLedgeToDropFrom()
+{
+	MapLedgeQuery query;
+	query.m_position		 = m_physics.m_position;
+	query.m_facing			 = -1.f * m_physics.m_orientation.GetVector_XFwd();
+	query.m_distanceRange	 = m_edgeDropDistanceRange;
+	query.m_heightAboveRange = FloatRange( -m_ledgeHeightTolerance, m_ledgeHeightTolerance );
+	query.m_needsGrabbable	 = true;
+	return FindLedgeInReach( query );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool Character::IsLedgeContinuingToRight() const
+{
+	Vec3 characterRightDirection = m_physics.m_orientation * Vec3( 0.f, -1.f, 0.f );
+	return IsLedgeContinuingToSide( characterRightDirection );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool Character::IsLedgeContinuingToLeft() const
+{
+	Vec3 characterLeftDirection = m_physics.m_orientation.GetVector_YLeft();
+	return IsLedgeContinuingToSide( characterLeftDirection );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// a grabbable lip at the hanging height still in front of a point one step to the side, from the same place the
+// shoulder rays start; adjoining boxes of the same height count as the same ledge
+bool Character::IsLedgeContinuingToSide( Vec3 const& sideDirection ) const
+{
+	if ( !m_map )
+	{
+		return false;
+	}
+
+	MapLedgeQuery query;
+	query.m_position		 = m_physics.m_position + Vec3( sideDirection.x, sideDirection.y, 0.f );
+	query.m_position.z		 = m_latestObstacleHeight;
+	query.m_facing			 = m_physics.m_orientation.GetVector_XFwd();
+	query.m_distanceRange	 = FloatRange( 0.f, m_rightShoulderRaycastMaxDistance );
+	query.m_heightAboveRange = FloatRange( -m_ledgeHeightTolerance, m_ledgeHeightTolerance );
+	query.m_needsGrabbable	 = true;
+
+	MapLedgeHit ledgeHit;
+	return m_map->FindNearestLedge( query, ledgeHit );
+}
+
+
 //----------------------------------------------------------------------------------------------------------
 void Character::InitDebugRootMotionTranslation()
 {
@@ -618,7 +771,7 @@ void Character::UpdateDebugRootMotionTranslation()
 {
 	/*if (m_movementState->m_applyRootMotionTranslation)
 	{*/
-	m_debugRootMotionTraslation.m_positionCurve	  = m_movementState->m_rootMotionTranslationCurve;
+	m_debugRootMotionTraslation.m_positionCurve	  = m_movementState->GetRootMotionCurveForDebug();
 	m_debugRootMotionTraslation.m_sampleTime	  = m_movementState->m_sampleTimeMs;
 	m_debugRootMotionTraslation.m_sampledPosition = m_movementState->m_debugSampledUnrotatedtranslation;
 	//}
@@ -809,7 +962,7 @@ void Character::CreateRootMotionTranslationGraphVerts()
 {
 	ClearGraphVerts();
 
-	m_debugRootMotionTraslation.m_positionCurve	  = m_movementState->m_rootMotionTranslationCurve;
+	m_debugRootMotionTraslation.m_positionCurve	  = m_movementState->GetRootMotionCurveForDebug();
 	m_debugRootMotionTraslation.m_sampleTime	  = m_movementState->m_sampleTimeMs;
 	m_debugRootMotionTraslation.m_sampledPosition = m_movementState->m_debugSampledUnrotatedtranslation;
 
@@ -1001,8 +1154,12 @@ void Character::InitSpriteLitShader()
 //----------------------------------------------------------------------------------------------------------
 void Character::LoadMeshData()
 {
-	FbxFileImporter::LoadPreRiggedAndPreSkinnedMeshBindPoseFromFile( "Data/Meshes/XBotTPose.fbx", m_meshVerts, m_vertexJointIdWeightMapping );
-	FbxFileImporter::LoadRestPoseFromFile( "Data/Meshes/XBotTPose.fbx", m_bindPose );
+	bool isMeshCooked = g_theCookedAnimArchive && g_theCookedAnimArchive->LoadSkinnedMesh( "Data/Meshes/XBotTPose.fbx", m_meshVerts, m_vertexJointIdWeightMapping );
+	if ( !isMeshCooked )
+	{
+		FbxFileImporter::LoadPreRiggedAndPreSkinnedMeshBindPoseFromFile( "Data/Meshes/XBotTPose.fbx", m_meshVerts, m_vertexJointIdWeightMapping );
+	}
+	m_bindPose = AnimationState::LoadOrGetRestPose( "Data/Meshes/XBotTPose.fbx" );
 	m_bindPose.CalculateGlobalInverseBindPoseMatrices();
 }
 
@@ -1069,6 +1226,7 @@ void Character::RenderMeshData( AnimPose const& sampledPose ) const
 	Mat44 modelTransformMatrix;
 	modelTransformMatrix.AppendTranslation3D( m_physics.m_position );
 	modelTransformMatrix.Append( m_physics.m_orientation.GetAsMatrix_XFwd_YLeft_ZUp() );
+	modelTransformMatrix.AppendTranslation3D( m_animationController->GetRootMotionWarpPoseOffset() );
 	g_theRenderer->SetModelConstants( modelTransformMatrix );
 	g_theRenderer->DrawVertexArrayPCUTBN( vertsTransformedToNewAnimatedPos );
 }
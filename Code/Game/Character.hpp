@@ -1,6 +1,8 @@
 #pragma once
 
 #include "Game/GameCommon.hpp"
+#include "Game/MapObstacleBVH.hpp"
+#include "Game/MapLedgeIndex.hpp"
 
 #include "Engine/Animation/AnimPose.hpp"
 #include "Engine/Animation/AnimCurve.hpp"
@@ -14,9 +16,24 @@
 
 class VertexBuffer;
 class ThirdPersonController;
+class AnimationController;
 class AnimPose;
 class MovementState;
+class MotionMatcher;
 class Map;
+struct AnimEventDispatch;
+
+
+//----------------------------------------------------------------------------------------------------------
+enum CharacterRaycast
+{
+	CHARACTER_RAYCAST_FOOT,
+	CHARACTER_RAYCAST_HEAD,
+	CHARACTER_RAYCAST_RIGHT_SHOULDER,
+	CHARACTER_RAYCAST_LEFT_SHOULDER,
+	CHARACTER_RAYCAST_GROUND,
+	NUM_CHARACTER_RAYCASTS
+};
 
 
 //----------------------------------------------------------------------------------------------------------
@@ -62,15 +79,23 @@ public:
 	void		   DebugRenderPhysicsSphere() const;
 	void		   DebugRenderBasisVectors() const;
 
-	void		   UpdateAnimations();
-	void		   RenderAnimations() const;
-	void		   RenderPose( AnimPose const& pose, Rgba8 color ) const;
+	AnimationController*	m_animationController = nullptr;
+	void					UpdateAnimations();
+	void					RenderAnimations() const;
+	void					RenderPose( AnimPose const& pose, Rgba8 color ) const;
+	void					OnAnimEvent( AnimEventDispatch const& animEvent );
 
 	MovementState* m_movementState = nullptr;
 	void		   InitMovementState();
 	void		   UpdateMovementState();
 	void		   DebugRenderCurrentMovementState() const;
 
+	// optional motion matching, picks the locomotion clips that idle, walk and run would otherwise transition to
+	MotionMatcher* m_motionMatcher			 = nullptr;
+	bool		   m_isMotionMatchingEnabled = false;
+	void		   UpdateMotionMatching();
+	bool		   IsMotionMatchingMovementState( MovementState const* movementState ) const;
+
 	// raycast
 	float m_latestObstacleHeight = 0.f;
 	struct RaycastResult3DEx : public RaycastResult3D
@@ -102,8 +127,8 @@ public:
 	float					 m_lefttShoulderRaycastMaxDistance = 2.f;
 	Vec3					 m_groundRaycastStartOffset		   = Vec3( 0.65f, 0.f, -0.2f );
 	float					 m_groundRaycastMaxDistance		   = 0.5f;
-	std::vector<ConvexHull3> m_obstacles;
-	void					 InitRaycast();
+	MapRaycastQuery			 m_raycastQueries[ NUM_CHARACTER_RAYCASTS ]; // filled by the update functions below, cast together
+	void					 CastRaycasts();
 	void					 UpdateFootRaycast();
 	void					 DebugRenderRaycast() const;
 	bool					 IsFootInFrontOfAnObstacle( float obstacleDistance ) const;
@@ -119,6 +144,22 @@ public:
 	bool					 IsGroundRaycastHittingSomething() const;
 	bool					 IsCharacterOnTheGround() const;
 
+	// ledges, looked up in the map's ledge index; a successful lookup also sets m_latestObstacleHeight
+	MapLedgeHit				 m_latestLedge;
+	FloatRange				 m_ledgeGrabHeightRange	  = FloatRange( 2.f, 5.f );
+	FloatRange				 m_ledgeGrabDistanceRange = FloatRange( 0.f, 0.6f );
+	FloatRange				 m_vaultHeightRange		  = FloatRange( 0.1f, 2.f );
+	FloatRange				 m_vaultDistanceRange	  = FloatRange( 2.f, 3.f );
+	FloatRange				 m_edgeDropDistanceRange  = FloatRange( 0.f, 1.5f );
+	float					 m_ledgeHeightTolerance	  = 0.25f;
+	bool					 FindLedgeInReach( MapLedgeQuery const& query );
+	bool					 FindLedgeToGrab();
+	bool					 FindLedgeToVault();
+	bool					 FindLedgeToDropFrom();
+	bool					 IsLedgeContinuingToRight() const;
+	bool					 IsLedgeContinuingToLeft() const;
+	bool					 IsLedgeContinuingToSide( Vec3 const& sideDirection ) const;
+
 	// debug rendering of root motion translation curves
 	struct DebugRootMotionTranslation
 	{
@@ -0,0 +1,87 @@
+#include "Game/CollisionWorld.hpp"
+
+
+//----------------------------------------------------------------------------------------------------------
+void CollisionWorld::Build( std::vector<AABB3> const& obstacleAABBs )
+{
+	Build( obstacleAABBs, std::vector<AABB3>() );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// border boxes stand just outside this world's part of the map, they trim its ledges but are not collided with
+void CollisionWorld::Build( std::vector<AABB3> const& obstacleAABBs, std::vector<AABB3> const& borderAABBs )
+{
+	Clear();
+
+	m_bvh.Build( obstacleAABBs );
+	m_ledgeIndex.Build( obstacleAABBs, borderAABBs );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// streamed regions carry their ledges in the region file, so loading one only builds the bvh and the ledge cells
+void CollisionWorld::BuildFromBakedLedges( std::vector<AABB3> const& obstacleAABBs, std::vector<MapLedge>& bakedLedges )
+{
+	Clear();
+
+	m_bvh.Build( obstacleAABBs );
+	m_ledgeIndex.BuildFromBakedLedges( bakedLedges );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void CollisionWorld::Clear()
+{
+	m_bvh.Clear();
+	m_ledgeIndex.Clear();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool CollisionWorld::IsEmpty() const
+{
+	return m_bvh.IsEmpty();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+int CollisionWorld::GetNumObstacles() const
+{
+	return ( int ) m_bvh.m_obstacleIndices.size();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void CollisionWorld::Raycast( MapRaycastQuery const* queries, int numQueries, MapRaycastHit* out_hits ) const
+{
+	m_bvh.Raycast( queries, numQueries, out_hits );
+	for ( int queryIndex = 0; queryIndex < numQueries; queryIndex++ )
+	{
+		if ( out_hits[ queryIndex ].m_obstacleIndex >= 0 )
+		{
+			out_hits[ queryIndex ].m_collisionWorld = this;
+		}
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+RaycastResult3D CollisionWorld::RaycastClosest( Vec3 const& startPos, Vec3 const& fwdNormal, float maxLength, int& out_obstacleIndex ) const
+{
+	return m_bvh.RaycastClosest( startPos, fwdNormal, maxLength, out_obstacleIndex );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+RaycastResult3D CollisionWorld::RaycastAny( Vec3 const& startPos, Vec3 const& fwdNormal, float maxLength, int& out_obstacleIndex ) const
+{
+	return m_bvh.RaycastAny( startPos, fwdNormal, maxLength, out_obstacleIndex );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool CollisionWorld::FindNearestLedge( MapLedgeQuery const& query, MapLedgeHit& out_hit ) const
+{
+	return m_ledgeIndex.FindNearestLedge( query, out_hit );
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Game/MapObstacleBVH.hpp"
+#include "Game/MapLedgeIndex.hpp"
+
+#include "Engine/Math/AABB3.hpp"
+
+#include <vector>
+
+
+//----------------------------------------------------------------------------------------------------------
+// the obstacles every character probes against, built once from the map's boxes and never written again; boxes
+// live in the bvh leaves and their grabbable top edges in the ledge index, so memory does not grow with the number
+// of characters and job threads can query it at the same time without a lock
+class CollisionWorld
+{
+public:
+	void							Build( std::vector<AABB3> const& obstacleAABBs );
+	void							Build( std::vector<AABB3> const& obstacleAABBs, std::vector<AABB3> const& borderAABBs );
+	void							BuildFromBakedLedges( std::vector<AABB3> const& obstacleAABBs, std::vector<MapLedge>& bakedLedges );
+	void							Clear();
+	bool							IsEmpty() const;
+	int								GetNumObstacles() const;
+	void							Raycast( MapRaycastQuery const* queries, int numQueries, MapRaycastHit* out_hits ) const;
+	RaycastResult3D					RaycastClosest( Vec3 const& startPos, Vec3 const& fwdNormal, float maxLength, int& out_obstacleIndex ) const;
+	RaycastResult3D					RaycastAny( Vec3 const& startPos, Vec3 const& fwdNormal, float maxLength, int& out_obstacleIndex ) const;
+	bool							FindNearestLedge( MapLedgeQuery const& query, MapLedgeHit& out_hit ) const;
+
+	MapObstacleBVH					m_bvh;
+	MapLedgeIndex					m_ledgeIndex;
+};
@@ -0,0 +1,148 @@
+#include "Game/CrowdBenchmark.hpp"
+#include "Game/CrowdManager.hpp"
+#include "Game/AnimationState.hpp"
+#include "Game/AnimAssetArchive.hpp"
+#include "Game/AnimClipResidencyManager.hpp"
+#include "Game/GameCommon.hpp"
+
+#include "Engine/Core/JobSystem.hpp"
+#include "Engine/Core/Clock.hpp"
+#include "Engine/Core/StringUtils.hpp"
+#include "Engine/Core/ErrorWarningAssert.hpp"
+
+#include <cstdlib>
+#include <thread>
+#include <unordered_set>
+
+
+//----------------------------------------------------------------------------------------------------------
+bool CrowdBenchmark::IsBenchmarkRequested( std::string const& commandLine )
+{
+	return commandLine.find( CROWD_BENCH_COMMAND_LINE_FLAG ) != std::string::npos;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// usage: -crowdbench [numCharacters] [numFrames] [noskin]
+int CrowdBenchmark::RunFromCommandLine( std::string const& commandLine )
+{
+	int	 numCharacters	   = 256;
+	int	 numFrames		   = 600;
+	bool isSkinningEnabled = true;
+
+	Strings arguments = SplitStringOnDelimiter( commandLine, ' ' );
+	for ( size_t argIndex = 0; argIndex < arguments.size(); argIndex++ )
+	{
+		if ( arguments[ argIndex ] != CROWD_BENCH_COMMAND_LINE_FLAG )
+		{
+			continue;
+		}
+
+		if ( argIndex + 1 < arguments.size() && !arguments[ argIndex + 1 ].empty() )
+		{
+			numCharacters = atoi( arguments[ argIndex + 1 ].c_str() );
+		}
+		if ( argIndex + 2 < arguments.size() && !arguments[ argIndex + 2 ].empty() )
+		{
+			numFrames = atoi( arguments[ argIndex + 2 ].c_str() );
+		}
+		if ( argIndex + 3 < arguments.size() && arguments[ argIndex + 3 ] == "noskin" )
+		{
+			isSkinningEnabled = false;
+		}
+	}
+
+	if ( numCharacters <= 0 || numFrames <= 0 )
+	{
+		WriteBenchmarkResults( "Error: Crowd benchmark needs a positive character and frame count\n", CROWD_BENCH_RESULTS_FILE_PATH );
+		return 1;
+	}
+
+	std::string results;
+	bool		succeeded = RunBenchmark( numCharacters, numFrames, isSkinningEnabled, results );
+	succeeded			  = WriteBenchmarkResults( results, CROWD_BENCH_RESULTS_FILE_PATH ) && succeeded;
+	return succeeded ? 0 : 1;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool CrowdBenchmark::RunBenchmark( int numCharacters, int numFrames, bool isSkinningEnabled, std::string& out_results )
+{
+	JobSystemConfig jobSystemConfig;
+	g_theJobSystem = new JobSystem( jobSystemConfig );
+	g_theJobSystem->Startup();
+
+	// cooked archive is optional, same as the app
+	g_theCookedAnimArchive = new AnimAssetArchive();
+	if ( !g_theCookedAnimArchive->OpenForRead( COOKED_ANIM_ARCHIVE_PATH ) )
+	{
+		delete g_theCookedAnimArchive;
+		g_theCookedAnimArchive = nullptr;
+	}
+
+	// whole graph resident before timing starts
+	AnimationState::LoadAnimationStateFromXML( "Data/Animations/AnimConfig.xml" );
+	g_theAnimClipResidencyManager = new AnimClipResidencyManager();
+	g_theAnimClipResidencyManager->Startup( false, 0 );
+	for ( auto const& stateEntry : AnimationState::s_animationStatesRegistery )
+	{
+		g_theAnimClipResidencyManager->RequestLoad( stateEntry.second, 1.f );
+	}
+
+	while ( g_theAnimClipResidencyManager->HasPendingLoads() )
+	{
+		std::unordered_set<Job*> completedJobs = g_theJobSystem->RetrieveAllCompleteJobs();
+		g_theAnimClipResidencyManager->Update( std::vector<Job*>( completedJobs.begin(), completedJobs.end() ) );
+		std::this_thread::yield();
+	}
+
+	Clock::TickSystemClock();
+	Clock*		 benchClock = new Clock();
+	CrowdManager crowdManager;
+	crowdManager.Startup( numCharacters, benchClock, isSkinningEnabled );
+
+	for ( int frameNum = 0; frameNum < numFrames; frameNum++ )
+	{
+		Clock::TickSystemClock();
+		g_theJobSystem->BeginFrame();
+
+		std::unordered_set<Job*> completedJobSet = g_theJobSystem->RetrieveAllCompleteJobs();
+		std::vector<Job*>		 completedJobs( completedJobSet.begin(), completedJobSet.end() );
+		g_theAnimClipResidencyManager->Update( completedJobs );
+		crowdManager.ReleaseCompletedBatches( completedJobs );
+		crowdManager.Update();
+
+		g_theJobSystem->EndFrame();
+	}
+
+	CrowdStats const& stats		= crowdManager.m_stats;
+	bool			  succeeded = stats.m_numFramesMeasured > 0;
+	if ( succeeded )
+	{
+		out_results = Stringf( "Crowd benchmark: %d characters, %d frames, skinning %s, %.3f ms per frame, %.2f characters per ms\n", numCharacters, numFrames,
+			isSkinningEnabled ? "on" : "off", stats.m_accumulatedTotalMs / ( float ) stats.m_numFramesMeasured, stats.GetAverageCharactersPerMs() );
+	}
+	else
+	{
+		out_results = Stringf( "Error: Crowd benchmark measured no frames for %d characters over %d frames\n", numCharacters, numFrames );
+	}
+
+	crowdManager.Shutdown();
+	delete benchClock;
+
+	std::unordered_set<Job*> completedJobs = g_theJobSystem->RetrieveAllCompleteJobs();
+	crowdManager.ReleaseCompletedBatches( std::vector<Job*>( completedJobs.begin(), completedJobs.end() ) );
+
+	g_theAnimClipResidencyManager->Shutdown();
+	delete g_theAnimClipResidencyManager;
+	g_theAnimClipResidencyManager = nullptr;
+
+	delete g_theCookedAnimArchive;
+	g_theCookedAnimArchive = nullptr;
+
+	g_theJobSystem->Shutdown();
+	delete g_theJobSystem;
+	g_theJobSystem = nullptr;
+
+	return succeeded;
+}
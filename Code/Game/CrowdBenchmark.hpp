@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+
+
+//----------------------------------------------------------------------------------------------------------
+char const* const CROWD_BENCH_COMMAND_LINE_FLAG = "-crowdbench";
+char const* const CROWD_BENCH_RESULTS_FILE_PATH = "CrowdBenchmarkResults.txt";
+
+
+//----------------------------------------------------------------------------------------------------------
+// headless crowd run without a window or renderer, reports how many characters are animated per millisecond to
+// stdout and the results file, the exit code is non zero if the run measured nothing
+class CrowdBenchmark
+{
+public:
+	static bool IsBenchmarkRequested( std::string const& commandLine );
+	static int	RunFromCommandLine( std::string const& commandLine );
+	static bool RunBenchmark( int numCharacters, int numFrames, bool isSkinningEnabled, std::string& out_results );
+};
@@ -0,0 +1,473 @@
+#include "Game/CrowdManager.hpp"
+#include "Game/AnimationController.hpp"
+#include "Game/AnimationState.hpp"
+#include "Game/AnimAssetArchive.hpp"
+#include "Game/GameCommon.hpp"
+
+#include "Engine/Animation/FbxFileImporter.hpp"
+#include "Engine/Renderer/Shader.hpp"
+#include "Engine/Core/Clock.hpp"
+#include "Engine/Core/VertexUtils.hpp"
+#include "Engine/Core/StringUtils.hpp"
+#include "Engine/Core/EngineCommon.hpp"
+#include "Engine/Math/MathUtils.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <utility>
+
+
+//----------------------------------------------------------------------------------------------------------
+Mat44 CrowdAgent::GetModelMatrix() const
+{
+	Mat44 modelMatrix;
+	modelMatrix.AppendTranslation3D( m_position );
+	modelMatrix.Append( m_orientation.GetAsMatrix_XFwd_YLeft_ZUp() );
+
+	return modelMatrix;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void JobUpdateCrowdBatch::Execute()
+{
+	m_crowdManager->UpdateAgentPoses( m_firstAgent, m_numAgents );
+
+	// last touch of the manager, it may return from the frame as soon as the count reaches zero
+	m_crowdManager->m_numBatchesInFlight--;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+float CrowdStats::GetAverageCharactersPerMs() const
+{
+	if ( m_numFramesMeasured == 0 || m_accumulatedTotalMs <= 0.f )
+	{
+		return 0.f;
+	}
+
+	float averageFrameMs = m_accumulatedTotalMs / ( float ) m_numFramesMeasured;
+	return ( float ) m_numAgents / averageFrameMs;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void CrowdManager::Startup( int numAgents, Clock* parentClock, bool isSkinningEnabled )
+{
+	m_crowdClock		= new Clock( *parentClock );
+	m_agentSpacing		= g_gameConfigGlackboard.GetValue( "crowdAgentSpacing", m_agentSpacing );
+	m_agentsPerBatch	= g_gameConfigGlackboard.GetValue( "crowdAgentsPerBatch", m_agentsPerBatch );
+	m_agentsPerBatch	= m_agentsPerBatch < 1 ? 1 : m_agentsPerBatch;
+	m_isSkinningEnabled = isSkinningEnabled;
+
+	m_isLodEnabled		  = g_gameConfigGlackboard.GetValue( "crowdAnimationLod", m_isLodEnabled );
+	m_lodFullRateDistance = g_gameConfigGlackboard.GetValue( "crowdLodFullRateDistance", m_lodFullRateDistance );
+	m_lodHalfRateDistance = g_gameConfigGlackboard.GetValue( "crowdLodHalfRateDistance", m_lodHalfRateDistance );
+	m_frameIndex		  = 0;
+
+	if ( m_isSkinningEnabled )
+	{
+		LoadMeshData();
+	}
+
+	SpawnAgents( numAgents );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void CrowdManager::Shutdown()
+{
+	for ( CrowdAgent& agent : m_agents )
+	{
+		agent.m_animationController->Shutdown();
+		delete agent.m_animationController;
+		agent.m_animationController = nullptr;
+	}
+	m_agents.clear();
+
+	delete m_crowdClock;
+	m_crowdClock = nullptr;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void CrowdManager::SpawnAgents( int numAgents )
+{
+	m_agents.resize( numAgents );
+
+	// square grid centered on the origin
+	int	  numAgentsPerRow = ( int ) ceilf( sqrtf( ( float ) numAgents ) );
+	float gridHalfWidth	  = 0.5f * m_agentSpacing * ( float ) ( numAgentsPerRow - 1 );
+
+	for ( int agentIndex = 0; agentIndex < numAgents; agentIndex++ )
+	{
+		CrowdAgent& agent = m_agents[ agentIndex ];
+		int			row	  = agentIndex / numAgentsPerRow;
+		int			col	  = agentIndex % numAgentsPerRow;
+
+		agent.m_position	= Vec3( ( float ) col * m_agentSpacing - gridHalfWidth, ( float ) row * m_agentSpacing - gridHalfWidth, 0.f );
+		float yawDegrees	= m_rng.RollRandomFloatInRange( 0.f, 360.f );
+		agent.m_orientation = Quaternion::MakeFromAxisOfRotationAndAngleDegrees( Vec3( 0.f, 0.f, 1.f ), yawDegrees );
+
+		// crowd agents have no character, so their controllers only follow the state machine
+		agent.m_animationController = new AnimationController( nullptr );
+		agent.m_animationController->Startup( m_crowdClock );
+
+		// spread the first transitions out so the crowd does not move in lock step
+		agent.m_secondsUntilNextTransition = m_rng.RollRandomFloatInRange( 0.f, 4.f );
+
+		if ( m_isSkinningEnabled )
+		{
+			agent.m_skinningMatrices.resize( m_bindPose.GetNumberOfJoints() );
+			agent.m_skinnedVerts = m_meshVerts;
+		}
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void CrowdManager::Update()
+{
+	std::chrono::steady_clock::time_point frameStartTime = std::chrono::steady_clock::now();
+
+	UpdateGraphs();
+	std::chrono::steady_clock::time_point graphEndTime = std::chrono::steady_clock::now();
+
+	UpdatePosesInBatches();
+	std::chrono::steady_clock::time_point poseEndTime = std::chrono::steady_clock::now();
+
+	m_stats.m_numAgents			  = ( int ) m_agents.size();
+	m_stats.m_graphMs			  = std::chrono::duration<float, std::milli>( graphEndTime - frameStartTime ).count();
+	m_stats.m_poseMs			  = std::chrono::duration<float, std::milli>( poseEndTime - graphEndTime ).count();
+	m_stats.m_totalMs			  = m_stats.m_graphMs + m_stats.m_poseMs;
+	m_stats.m_charactersPerMs	  = m_stats.m_totalMs > 0.f ? ( float ) m_stats.m_numAgents / m_stats.m_totalMs : 0.f;
+	m_stats.m_accumulatedTotalMs += m_stats.m_totalMs;
+	m_stats.m_numFramesMeasured++;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// transitions and clip pins go through shared state, so every agent's graph advances on the main thread
+void CrowdManager::UpdateGraphs()
+{
+	float deltaSeconds = m_crowdClock->GetDeltaSeconds();
+
+	m_stats.m_numEvaluatedAgents = 0;
+	for ( int agentIndex = 0; agentIndex < ( int ) m_agents.size(); agentIndex++ )
+	{
+		CrowdAgent& agent = m_agents[ agentIndex ];
+		UpdateAgentTransitionRequests( agent, deltaSeconds );
+
+		// the graph only moves with the pose, a request waits for the agent's next evaluation
+		UpdateAgentLod( agent, agentIndex, deltaSeconds );
+		if ( agent.m_isEvaluatedThisFrame )
+		{
+			agent.m_animationController->UpdateGraph();
+			m_stats.m_numEvaluatedAgents++;
+		}
+	}
+
+	m_frameIndex++;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void CrowdManager::SetLodViewPosition( Vec3 const& viewPosition )
+{
+	m_lodViewPosition = viewPosition;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void CrowdManager::UpdateAgentLod( CrowdAgent& agent, int agentIndex, float deltaSeconds )
+{
+	agent.m_pendingDeltaSeconds += deltaSeconds;
+	agent.m_framesSinceEvaluation++;
+
+	agent.m_updateInterval = 1;
+	if ( m_isLodEnabled )
+	{
+		Vec3 viewToAgent	   = agent.m_position - m_lodViewPosition;
+		agent.m_updateInterval = GetUpdateIntervalForDistanceSquared( DotProduct3D( viewToAgent, viewToAgent ) );
+	}
+
+	// offsetting by agent index spreads agents of the same interval evenly over the frames
+	bool isAgentsTurn			 = ( ( m_frameIndex + agentIndex ) % agent.m_updateInterval ) == 0;
+	bool isOverdue				 = agent.m_framesSinceEvaluation > agent.m_updateInterval;
+	agent.m_isEvaluatedThisFrame = !agent.m_hasEvaluatedPose || isAgentsTurn || isOverdue;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+int CrowdManager::GetUpdateIntervalForDistanceSquared( float distanceSquared ) const
+{
+	if ( distanceSquared <= m_lodFullRateDistance * m_lodFullRateDistance )
+	{
+		return 1;
+	}
+
+	if ( distanceSquared <= m_lodHalfRateDistance * m_lodHalfRateDistance )
+	{
+		return 2;
+	}
+
+	return 4;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void CrowdManager::UpdateAgentTransitionRequests( CrowdAgent& agent, float deltaSeconds )
+{
+	agent.m_secondsUntilNextTransition -= deltaSeconds;
+	if ( agent.m_secondsUntilNextTransition > 0.f )
+	{
+		return;
+	}
+	agent.m_secondsUntilNextTransition = m_rng.RollRandomFloatInRange( 2.f, 6.f );
+
+	// pick any named transition out of the current state
+	AnimStateMachineTable const& stateMachine = AnimationState::s_stateMachineTable;
+	int							 stateIndex	  = agent.m_animationController->GetCurrentAnimationState()->GetStateMachineIndex();
+	if ( stateIndex == INVALID_ANIM_STATE_MACHINE_INDEX )
+	{
+		return;
+	}
+
+	AnimStateMachineState const& state = stateMachine.m_states[ stateIndex ];
+	if ( state.m_numTransitions == 0 )
+	{
+		return;
+	}
+
+	int transitionIndex									   = state.m_firstTransition + m_rng.RollRandomIntInRange( 0, state.m_numTransitions - 1 );
+	agent.m_animationController->m_transitionRequested = true;
+	agent.m_animationController->m_nextTransitionId	   = stateMachine.m_transitions[ transitionIndex ].m_nameId;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// the main thread takes the last batch itself instead of idling while the workers run
+void CrowdManager::UpdatePosesInBatches()
+{
+	int numAgents  = ( int ) m_agents.size();
+	int numBatches = ( numAgents + m_agentsPerBatch - 1 ) / m_agentsPerBatch;
+	m_stats.m_numBatches = numBatches;
+	if ( numBatches == 0 )
+	{
+		return;
+	}
+
+	m_numBatchesInFlight = numBatches - 1;
+	for ( int batchIndex = 0; batchIndex < numBatches - 1; batchIndex++ )
+	{
+		int firstAgent = batchIndex * m_agentsPerBatch;
+		g_theJobSystem->PostNewJob( new JobUpdateCrowdBatch( this, firstAgent, m_agentsPerBatch ) );
+	}
+
+	int lastBatchFirstAgent = ( numBatches - 1 ) * m_agentsPerBatch;
+	UpdateAgentPoses( lastBatchFirstAgent, numAgents - lastBatchFirstAgent );
+
+	while ( m_numBatchesInFlight > 0 )
+	{
+		std::this_thread::yield();
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// runs on worker threads, only writes to the agents in the range
+void CrowdManager::UpdateAgentPoses( int firstAgent, int numAgents )
+{
+	for ( int agentIndex = firstAgent; agentIndex < firstAgent + numAgents; agentIndex++ )
+	{
+		CrowdAgent& agent = m_agents[ agentIndex ];
+		if ( agent.m_isEvaluatedThisFrame )
+		{
+			EvaluateAgentPose( agent );
+		}
+
+		if ( !m_isSkinningEnabled )
+		{
+			InterpolateAgentPose( agent );
+			continue;
+		}
+
+		// skinning costs far more than the pose, so a skinned agent keeps its mesh until its next evaluation
+		if ( agent.m_isEvaluatedThisFrame )
+		{
+			agent.m_sampledPose = agent.m_lastEvaluatedPose;
+			SkinAgent( agent );
+		}
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// advances the controller by all the time skipped since its last evaluation
+void CrowdManager::EvaluateAgentPose( CrowdAgent& agent ) const
+{
+	agent.m_animationController->UpdatePose( agent.m_pendingDeltaSeconds );
+	agent.m_pendingDeltaSeconds	  = 0.f;
+	agent.m_framesSinceEvaluation = 0;
+
+	std::swap( agent.m_previousEvaluatedPose, agent.m_lastEvaluatedPose );
+	agent.m_lastEvaluatedPose = agent.m_animationController->GetSampledPose();
+
+	if ( !agent.m_hasEvaluatedPose )
+	{
+		agent.m_previousEvaluatedPose = agent.m_lastEvaluatedPose;
+		agent.m_hasEvaluatedPose	  = true;
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// trails the evaluated poses by up to one interval, which keeps the motion continuous across evaluations
+void CrowdManager::InterpolateAgentPose( CrowdAgent& agent ) const
+{
+	float blendValue = ( float ) ( agent.m_framesSinceEvaluation + 1 ) / ( float ) agent.m_updateInterval;
+	if ( blendValue >= 1.f )
+	{
+		agent.m_sampledPose = agent.m_lastEvaluatedPose;
+		return;
+	}
+
+	AnimPose::Blend( agent.m_sampledPose, agent.m_previousEvaluatedPose, agent.m_lastEvaluatedPose, blendValue, -1 );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void CrowdManager::ReleaseCompletedBatches( std::vector<Job*> const& completedJobs )
+{
+	for ( Job* completedJob : completedJobs )
+	{
+		JobUpdateCrowdBatch* completedBatch = dynamic_cast<JobUpdateCrowdBatch*>( completedJob );
+		if ( completedBatch && completedBatch->m_crowdManager == this )
+		{
+			delete completedBatch;
+		}
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void CrowdManager::LoadMeshData()
+{
+	bool isMeshCooked = g_theCookedAnimArchive && g_theCookedAnimArchive->LoadSkinnedMesh( "Data/Meshes/XBotTPose.fbx", m_meshVerts, m_vertexJointIdWeightMapping );
+	if ( !isMeshCooked )
+	{
+		FbxFileImporter::LoadPreRiggedAndPreSkinnedMeshBindPoseFromFile( "Data/Meshes/XBotTPose.fbx", m_meshVerts, m_vertexJointIdWeightMapping );
+	}
+	m_bindPose = AnimationState::LoadOrGetRestPose( "Data/Meshes/XBotTPose.fbx" );
+	m_bindPose.CalculateGlobalInverseBindPoseMatrices();
+
+	if ( g_theRenderer )
+	{
+		m_spriteLitShader = g_theRenderer->CreateOrGetShaderByName( "Data/Shaders/SpriteLit", VertexType::Vertex_PCUTBN );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// same smooth skinning as Character::RenderMeshData, writing into the agent's own buffers
+void CrowdManager::SkinAgent( CrowdAgent& agent ) const
+{
+	int numJoints = m_bindPose.GetNumberOfJoints();
+	for ( int jointIndex = 0; jointIndex < numJoints; jointIndex++ )
+	{
+		Mat44 const& inverseBindPoseTransformMatrix = m_bindPose.GetGlobalInverseBindPoseMatrixOfJoint( jointIndex );
+
+		Transform animatedJointGlobalTransform = agent.m_sampledPose.GetGlobalTransformOfJoint( jointIndex );
+		animatedJointGlobalTransform.m_scale   = Vec3( 1.f, 1.f, 1.f );
+
+		Mat44 skinningMatrix = Mat44::CreateFromTransform( animatedJointGlobalTransform );
+		skinningMatrix.Append( inverseBindPoseTransformMatrix );
+		agent.m_skinningMatrices[ jointIndex ] = skinningMatrix;
+	}
+
+	size_t numMeshVerts = m_meshVerts.size();
+	for ( size_t vertexNum = 0; vertexNum < numMeshVerts; vertexNum++ )
+	{
+		Vec3 const&								  bindPosePosition		 = m_meshVerts[ vertexNum ].m_position;
+		Vec3									  overallTransformedPos	 = Vec3::ZERO;
+		std::vector<std::pair<int, float>> const& jointIdToWeightMapping = m_vertexJointIdWeightMapping[ vertexNum ];
+
+		for ( std::pair<int, float> const& mapping : jointIdToWeightMapping )
+		{
+			Vec3 transformedPos	   = agent.m_skinningMatrices[ mapping.first ].TransformPosition3D( bindPosePosition );
+			overallTransformedPos += ( mapping.second * transformedPos );
+		}
+
+		agent.m_skinnedVerts[ vertexNum ].m_position = overallTransformedPos;
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void CrowdManager::Render( LightConstants const& lightConstants ) const
+{
+	if ( m_isSkinningEnabled )
+	{
+		RenderSkinnedAgents( lightConstants );
+	}
+	else
+	{
+		RenderAgentSkeletons();
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void CrowdManager::RenderSkinnedAgents( LightConstants const& lightConstants ) const
+{
+	g_theRenderer->SetLightingConstatnts( lightConstants );
+	g_theRenderer->BindTexture( nullptr );
+	g_theRenderer->BindShader( m_spriteLitShader );
+
+	for ( CrowdAgent const& agent : m_agents )
+	{
+		g_theRenderer->SetModelConstants( agent.GetModelMatrix() );
+		g_theRenderer->DrawVertexArrayPCUTBN( agent.m_skinnedVerts );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// every skeleton goes into one vertex array, already in world space
+void CrowdManager::RenderAgentSkeletons() const
+{
+	std::vector<Vertex_PCU> verts;
+
+	for ( CrowdAgent const& agent : m_agents )
+	{
+		Mat44			modelMatrix = agent.GetModelMatrix();
+		AnimPose const& pose		= agent.m_sampledPose;
+
+		for ( int index = 0; index < pose.GetNumberOfJoints(); index++ )
+		{
+			int parentIndex = pose.GetParentOfJoint( index );
+			if ( parentIndex < 0 )
+			{
+				continue;
+			}
+
+			Vec3 selfPosition	= modelMatrix.TransformPosition3D( pose.GetGlobalTransformOfJoint( index ).m_position );
+			Vec3 parentPosition = modelMatrix.TransformPosition3D( pose.GetGlobalTransformOfJoint( parentIndex ).m_position );
+			AddVertsForCone3D( verts, parentPosition, selfPosition, 0.03f );
+		}
+	}
+
+	g_theRenderer->SetModelConstants();
+	g_theRenderer->BindShader( nullptr );
+	g_theRenderer->BindTexture( nullptr );
+	g_theRenderer->DrawVertexArray( verts );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+std::string CrowdManager::GetStatsString() const
+{
+	return Stringf( "Crowd: %d characters, %d evaluated, %d batches, graph %.2f ms, pose %.2f ms, %.1f characters/ms", m_stats.m_numAgents,
+		m_stats.m_numEvaluatedAgents, m_stats.m_numBatches, m_stats.m_graphMs, m_stats.m_poseMs, m_stats.m_charactersPerMs );
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "Game/GameCommon.hpp"
+
+#include "Engine/Animation/AnimPose.hpp"
+#include "Engine/Core/JobSystem.hpp"
+#include "Engine/Core/Vertex_PCUTBN.hpp"
+#include "Engine/Math/RandomNumberGenerator.hpp"
+#include "Engine/Math/Quaternion.hpp"
+#include "Engine/Math/Mat44.hpp"
+#include "Engine/Math/Vec3.hpp"
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+class AnimationController;
+class CrowdManager;
+class Clock;
+class Shader;
+
+
+//----------------------------------------------------------------------------------------------------------
+struct CrowdAgent
+{
+	Vec3					   m_position					 = Vec3::ZERO;
+	Quaternion				   m_orientation				 = Quaternion::IDENTITY;
+	AnimationController*	   m_animationController		 = nullptr;
+	float					   m_secondsUntilNextTransition = 0.f;
+	AnimPose				   m_sampledPose;
+	std::vector<Mat44>		   m_skinningMatrices;
+	std::vector<Vertex_PCUTBN> m_skinnedVerts;
+	Mat44					   GetModelMatrix() const;
+
+	// update rate lod, between evaluations a skeleton shows a pose interpolated from the last two evaluated ones
+	// and a skinned agent keeps the mesh skinned at its last evaluation
+	int						   m_updateInterval				 = 1;
+	int						   m_framesSinceEvaluation		 = 0;
+	float					   m_pendingDeltaSeconds		 = 0.f;
+	bool					   m_isEvaluatedThisFrame		 = false;
+	bool					   m_hasEvaluatedPose			 = false;
+	AnimPose				   m_previousEvaluatedPose;
+	AnimPose				   m_lastEvaluatedPose;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// samples, blends and skins a contiguous range of agents, completed batches come back through the job system
+// and are released with CrowdManager::ReleaseCompletedBatches
+struct JobUpdateCrowdBatch : public Job
+{
+	CrowdManager* m_crowdManager = nullptr;
+	int			  m_firstAgent	 = 0;
+	int			  m_numAgents	 = 0;
+
+	JobUpdateCrowdBatch( CrowdManager* crowdManager, int firstAgent, int numAgents )
+		: m_crowdManager( crowdManager ), m_firstAgent( firstAgent ), m_numAgents( numAgents )
+	{
+	}
+
+	virtual ~JobUpdateCrowdBatch() override {}
+
+	virtual void Execute() override;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+struct CrowdStats
+{
+	int	  m_numAgents			   = 0;
+	int	  m_numBatches			   = 0;
+	int	  m_numEvaluatedAgents	   = 0;
+	float m_graphMs				   = 0.f;
+	float m_poseMs				   = 0.f;
+	float m_totalMs				   = 0.f;
+	float m_charactersPerMs		   = 0.f;
+	int	  m_numFramesMeasured	   = 0;
+	float m_accumulatedTotalMs	   = 0.f;
+	float GetAverageCharactersPerMs() const;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// owns many animated agents sharing the loaded animation graph, each frame the state machines advance on the
+// main thread and then pose sampling, blending and skinning fan out over g_theJobSystem in batches
+class CrowdManager
+{
+public:
+	void Startup( int numAgents, Clock* parentClock, bool isSkinningEnabled );
+	void Shutdown();
+	void Update();
+	void Render( LightConstants const& lightConstants ) const;
+
+	Clock*					m_crowdClock		= nullptr;
+	std::vector<CrowdAgent> m_agents;
+	float					m_agentSpacing		= 2.f;
+	int						m_agentsPerBatch	= 8;
+	RandomNumberGenerator	m_rng;
+	void					SpawnAgents( int numAgents );
+	void					UpdateAgentTransitionRequests( CrowdAgent& agent, float deltaSeconds );
+
+	// parallel pose update
+	std::atomic<int>		m_numBatchesInFlight = { 0 };
+	void					UpdateGraphs();
+	void					UpdatePosesInBatches();
+	void					UpdateAgentPoses( int firstAgent, int numAgents );
+	void					ReleaseCompletedBatches( std::vector<Job*> const& completedJobs );
+
+	// update rate lod, chosen by distance to the view and staggered by agent index
+	bool					m_isLodEnabled			= true;
+	float					m_lodFullRateDistance	= 15.f;
+	float					m_lodHalfRateDistance	= 30.f;
+	Vec3					m_lodViewPosition		= Vec3::ZERO;
+	int						m_frameIndex			= 0;
+	void					SetLodViewPosition( Vec3 const& viewPosition );
+	void					UpdateAgentLod( CrowdAgent& agent, int agentIndex, float deltaSeconds );
+	int						GetUpdateIntervalForDistanceSquared( float distanceSquared ) const;
+	void					EvaluateAgentPose( CrowdAgent& agent ) const;
+	void					InterpolateAgentPose( CrowdAgent& agent ) const;
+
+	// skinning, mesh data shared by every agent
+	bool										   m_isSkinningEnabled = false;
+	std::vector<Vertex_PCUTBN>					   m_meshVerts;
+	std::vector<std::vector<std::pair<int, float>>> m_vertexJointIdWeightMapping;
+	AnimPose									   m_bindPose;
+	Shader*										   m_spriteLitShader	= nullptr;
+	void										   LoadMeshData();
+	void										   SkinAgent( CrowdAgent& agent ) const;
+	void										   RenderSkinnedAgents( LightConstants const& lightConstants ) const;
+	void										   RenderAgentSkeletons() const;
+
+	// stats
+	CrowdStats	m_stats;
+	std::string GetStatsString() const;
+};
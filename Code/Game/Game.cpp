@@ -1,5 +1,6 @@
 #include "Game/GameFixCameraIdleTurn.hpp"
 #include "Game/GameFinalShowcase.hpp"
+#include "Game/GameCrowdShowcase.hpp"
 #include "Game/GameLoadFbxOnThread.hpp"
 #include "Game/GameSkinning.hpp"
 #include "Game/GameLoadMesh.hpp"
@@ -57,6 +58,7 @@ Game* Game::CreateNewGameOfType( GameMode type )
 		case GAMEMODE_FINAL_SHOWCASE:											return new GameFinalShowcase();
 		case GAMEMODE_LOAD_FBX_THREAD:											return new GameLoadFbxOnThread();
 		case GAMEMODE_FIX_CAMERA_IDLE_TURN:										return new GameFixCameraIdleTurn();
+		case GAMEMODE_CROWD_SHOWCASE:											return new GameCrowdShowcase();
 		default:
 		{
 			ERROR_AND_DIE( Stringf( "Error: GameMode #%i not set", type ) );
@@ -35,10 +35,12 @@ void GameBasicMovement::Startup()
 
 	PrintTitleText( "Basic Movement\n F6: Lock/Free Camera, F5: Camera Freeze" );
 
-	g_theAnimationController = new AnimationController();
+	g_theCharacter = new Character();
+
+	g_theAnimationController = new AnimationController( g_theCharacter );
 	g_theAnimationController->Startup();
+	g_theCharacter->m_animationController = g_theAnimationController;
 
-	g_theCharacter = new Character();
 	g_theCharacter->Startup();
 	g_theCharacter->CreateVerts();
 
@@ -1,14 +1,41 @@
 #include "Game/GameCommon.hpp"
 
+#include "Engine/Core/ErrorWarningAssert.hpp"
+
+#include <cstdio>
+#include <fstream>
+
 
 //----------------------------------------------------------------------------------------------------------
-BitmapFont*			   g_simpleBitmapFont		  = nullptr; // Created by App in LoadFonts()
-Game*				   g_theGame				  = nullptr; // Created and Owned by App
-AnimationController*   g_theAnimationController	  = nullptr; // Created and owned by Game
-ThirdPersonController* g_theThirdPersonController = nullptr; // Created ans owned by Game
-Character*			   g_theCharacter			  = nullptr; // Created and owned by Game
+BitmapFont*				  g_simpleBitmapFont			= nullptr; // Created by App in LoadFonts()
+Game*					  g_theGame						= nullptr; // Created and Owned by App
+AnimationController*	  g_theAnimationController		= nullptr; // Created and owned by Game, drives the player character
+ThirdPersonController*	  g_theThirdPersonController	= nullptr; // Created ans owned by Game
+Character*				  g_theCharacter				= nullptr; // Created and owned by Game
+AnimAssetArchive*		  g_theCookedAnimArchive		= nullptr; // Created and owned by App, open only if the cooked archive exists
+AnimClipResidencyManager* g_theAnimClipResidencyManager = nullptr; // Created and owned by Game
 
 
 //----------------------------------------------------------------------------------------------------------
 GameMode	   STARTUP_GAME_MODE   = GAMEMODE_FIX_CAMERA_IDLE_TURN;
-DebugDrawState g_theDebugDrawState = DEBUGDRAW_NONE;
\ No newline at end of file
+DebugDrawState g_theDebugDrawState = DEBUGDRAW_NONE;
+
+
+//----------------------------------------------------------------------------------------------------------
+bool WriteBenchmarkResults( std::string const& results, std::string const& resultsFilePath )
+{
+	fputs( results.c_str(), stdout );
+	fflush( stdout );
+	DebuggerPrintf( "%s", results.c_str() );
+
+	std::ofstream resultsFile( resultsFilePath, std::ios::trunc );
+	resultsFile << results;
+	resultsFile.close();
+	if ( resultsFile.fail() )
+	{
+		DebuggerPrintf( "Error: Unable to write benchmark results to %s\n", resultsFilePath.c_str() );
+		return false;
+	}
+
+	return true;
+}
@@ -8,6 +8,8 @@
 #include "Engine/Input/InputSystem.hpp"
 #include "Engine/Renderer/Renderer.hpp"
 
+#include <string>
+
 constexpr int TOTAL_NUM_KEYS = 255;
 
 constexpr float DEBUG_LINE_THICKNESS = 0.3f;
@@ -56,6 +58,7 @@ enum GameMode
 	GAMEMODE_FINAL_SHOWCASE,
 	GAMEMODE_LOAD_FBX_THREAD,
 	GAMEMODE_FIX_CAMERA_IDLE_TURN,
+	GAMEMODE_CROWD_SHOWCASE,
 	/*GAMEMODE_MOVEMENT_ACCERLERATION,
 	GAMEMODE_STRIDE_WHEEL,*/
 
@@ -96,6 +99,12 @@ extern ThirdPersonController* g_theThirdPersonController;
 class Character;
 extern Character* g_theCharacter;
 
+class AnimAssetArchive;
+extern AnimAssetArchive* g_theCookedAnimArchive;
+
+class AnimClipResidencyManager;
+extern AnimClipResidencyManager* g_theAnimClipResidencyManager;
+
 
 //----------------------------------------------------------------------------------------------------------
 enum DebugDrawState
@@ -106,4 +115,9 @@ enum DebugDrawState
 	DEBUGDRAW_NONE,
 	NUM_DEBUG_DRAW_STATE
 };
-extern DebugDrawState g_theDebugDrawState;
\ No newline at end of file
+extern DebugDrawState g_theDebugDrawState;
+
+
+//----------------------------------------------------------------------------------------------------------
+// headless runs report to stdout, which the launcher attaches to the parent console, and to a results file
+bool WriteBenchmarkResults( std::string const& results, std::string const& resultsFilePath );
\ No newline at end of file
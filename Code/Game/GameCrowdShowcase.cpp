@@ -0,0 +1,165 @@
+#include "Game/GameCrowdShowcase.hpp"
+#include "Game/AnimationState.hpp"
+#include "Game/AnimClipResidencyManager.hpp"
+#include "Game/Player.hpp"
+
+#include "Engine/Core/JobSystem.hpp"
+#include "Engine/Renderer/DebugRenderSystem.hpp"
+#include "Engine/Core/Clock.hpp"
+#include "Engine/Core/StringUtils.hpp"
+
+#include <unordered_set>
+
+
+//----------------------------------------------------------------------------------------------------------
+void GameCrowdShowcase::Startup()
+{
+	m_screenCamera.SetOrthographicView( SCREEN_BOTTOM_LEFT_ORTHO, SCREEN_TOP_RIGHT_ORTHO );
+	m_GameClock = new Clock();
+
+	CreateScene();
+	m_player->m_position	= Vec3( -30.f, -30.f, 15.f );
+	m_player->m_orientation = EulerAngles( 45.f, 25.f, 0.f );
+
+	PrintTitleText( "Crowd Showcase" );
+	InitLightConstants();
+
+	StartLoadAnimationData();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void GameCrowdShowcase::Shutdown()
+{
+	m_crowdManager.Shutdown();
+
+	// batches completed on the last frame have not been collected yet
+	std::unordered_set<Job*> completedJobs = g_theJobSystem->RetrieveAllCompleteJobs();
+	m_crowdManager.ReleaseCompletedBatches( std::vector<Job*>( completedJobs.begin(), completedJobs.end() ) );
+
+	g_theAnimClipResidencyManager->Shutdown();
+	delete g_theAnimClipResidencyManager;
+	g_theAnimClipResidencyManager = nullptr;
+
+	delete m_player;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void GameCrowdShowcase::Update()
+{
+	UpdateGameState();
+	UpdatePlayer();
+	PrintDebugScreenMessage();
+
+	std::unordered_set<Job*> completedJobSet = g_theJobSystem->RetrieveAllCompleteJobs();
+	std::vector<Job*>		 completedJobs( completedJobSet.begin(), completedJobSet.end() );
+	g_theAnimClipResidencyManager->Update( completedJobs );
+	m_crowdManager.ReleaseCompletedBatches( completedJobs );
+
+	SpawnCrowdOnceLoaded();
+	if ( !m_isCrowdSpawned )
+	{
+		return;
+	}
+
+	m_crowdManager.SetLodViewPosition( m_player->m_position );
+	m_crowdManager.Update();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void GameCrowdShowcase::Render() const
+{
+	g_theRenderer->ClearScreen( m_backGroundColor );
+
+	// world
+	g_theRenderer->BeginCamera( *m_player->m_worldCamera );
+	RenderGridLines();
+	m_crowdManager.Render( m_lightConstants );
+	DebugRenderWorld( *m_player->m_worldCamera );
+	g_theRenderer->EndCamera( *m_player->m_worldCamera );
+
+	// screen
+	g_theRenderer->BeginCamera( m_screenCamera );
+	DebugRenderScreen( m_screenCamera );
+	g_theRenderer->EndCamera( m_screenCamera );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void GameCrowdShowcase::PrintDebugScreenMessage()
+{
+	float fontSize = 15.f;
+	AABB2 cameraBounds( m_screenCamera.GetOrthographicBottomLeft(), m_screenCamera.GetOrthographicTopRight() );
+	float duration = 0.f; // one frame
+
+	// time and fps
+	Vec2  topRightLinePosition( cameraBounds.m_maxs.x, cameraBounds.m_maxs.y - fontSize );
+	Vec2  topRightAlignment = Vec2( 1.f, 1.f );
+	float totalSeconds		= m_GameClock->GetTotalSeconds();
+
+	float deltaSeconds = m_GameClock->GetDeltaSeconds();
+	float fps		   = 1.f / deltaSeconds;
+	float ms		   = deltaSeconds * 1000.f;
+
+	std::string timeValuesStr = Stringf( "Time: %.2f, FPS: %.1f, MS: %.1f", totalSeconds, fps, ms );
+	DebugAddScreenText( timeValuesStr, topRightLinePosition, fontSize, topRightAlignment, duration );
+
+	// crowd
+	topRightLinePosition.y -= fontSize;
+	std::string crowdStatus = m_isCrowdSpawned ? m_crowdManager.GetStatsString() : "Crowd: loading animation clips";
+	DebugAddScreenText( crowdStatus, topRightLinePosition, fontSize, topRightAlignment, duration );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// every agent can reach every state, so the whole graph is loaded before the crowd spawns
+void GameCrowdShowcase::StartLoadAnimationData()
+{
+	AnimationState::LoadAnimationStateFromXML( "Data/Animations/AnimConfig.xml" );
+
+	bool  isClipStreamingEnabled = g_gameConfigGlackboard.GetValue( "animClipStreaming", false );
+	float clipBudgetMB			 = g_gameConfigGlackboard.GetValue( "animClipBudgetMB", 64.f );
+
+	g_theAnimClipResidencyManager = new AnimClipResidencyManager();
+	g_theAnimClipResidencyManager->Startup( isClipStreamingEnabled, ( size_t ) ( clipBudgetMB * 1024.f * 1024.f ) );
+
+	for ( auto const& stateEntry : AnimationState::s_animationStatesRegistery )
+	{
+		g_theAnimClipResidencyManager->RequestLoad( stateEntry.second, 1.f );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void GameCrowdShowcase::SpawnCrowdOnceLoaded()
+{
+	if ( m_isCrowdSpawned || g_theAnimClipResidencyManager->HasPendingLoads() )
+	{
+		return;
+	}
+
+	int	 numCharacters	   = g_gameConfigGlackboard.GetValue( "crowdNumCharacters", 100 );
+	bool isSkinningEnabled = g_gameConfigGlackboard.GetValue( "crowdSkinning", true );
+	m_crowdManager.Startup( numCharacters, m_GameClock, isSkinningEnabled );
+
+	m_isCrowdSpawned = true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void GameCrowdShowcase::InitLightConstants()
+{
+	Quaternion sunRotation = Quaternion( 0.289f, 0.914f, -0.277f, -0.058f );
+	sunRotation.Normalize();
+
+	m_lightConstants.m_sunDirection		 = sunRotation * Vec3( 1.f, 0.f, 0.f );
+	m_lightConstants.m_sunIntensity		 = 0.6f;
+	m_lightConstants.m_ambientIntensity	 = 0.4f;
+	m_lightConstants.m_worldEyePosition	 = m_player->m_position;
+	m_lightConstants.m_normalMode		 = 0;
+	m_lightConstants.m_specularMode		 = 0;
+	m_lightConstants.m_specularIntensity = 1.f;
+	m_lightConstants.m_specularPower	 = 32.f;
+}
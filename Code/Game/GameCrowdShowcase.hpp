@@ -0,0 +1,28 @@
+#pragma once
+
+#include "Game/Game.hpp"
+#include "Game/CrowdManager.hpp"
+
+
+//----------------------------------------------------------------------------------------------------------
+// a grid of characters sharing one loaded animation graph, updated in parallel batches by the crowd manager
+class GameCrowdShowcase : public Game
+{
+public:
+	virtual void Startup() override;
+	virtual void Shutdown() override;
+	virtual void Update() override;
+	virtual void Render() const override;
+
+	virtual void PrintDebugScreenMessage() override;
+
+	// crowd
+	CrowdManager   m_crowdManager;
+	bool		   m_isCrowdSpawned = false;
+	void		   StartLoadAnimationData();
+	void		   SpawnCrowdOnceLoaded();
+
+	// light data
+	LightConstants m_lightConstants;
+	void		   InitLightConstants();
+};
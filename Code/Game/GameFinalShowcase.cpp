@@ -68,8 +68,9 @@ void GameFinalShowcase::Startup()
 
 	g_theThirdPersonController = new ThirdPersonController();
 
-	g_theAnimationController = new AnimationController();
+	g_theAnimationController = new AnimationController( g_theCharacter );
 	g_theAnimationController->Startup();
+	g_theCharacter->m_animationController = g_theAnimationController;
 
 
 	
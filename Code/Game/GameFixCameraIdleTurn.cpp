@@ -1,6 +1,7 @@
 #include "Game/Map.hpp"
 #include "Game/AnimationState.hpp"
 #include "Game/AnimationController.hpp"
+#include "Game/AnimClipResidencyManager.hpp"
 #include "Game/Player.hpp"
 #include "Game/GameFixCameraIdleTurn.hpp"
 #include "Game/App.hpp"
@@ -15,6 +16,7 @@
 #include "Engine/Core/StringUtils.hpp"
 #include "Engine/Core/VertexUtils.hpp"
 #include "Engine/Core/EngineCommon.hpp"
+#include "Engine/Core/NamedStrings.hpp"
 
 
 constexpr int			MAX_VERTEXAS		 = 3;
@@ -74,8 +76,9 @@ void GameFixCameraIdleTurn::DeferedStartupAfterLoadingMeshData()
 
 	g_theThirdPersonController = new ThirdPersonController();
 
-	g_theAnimationController   = new AnimationController();
+	g_theAnimationController   = new AnimationController( g_theCharacter );
 	g_theAnimationController->Startup();
+	g_theCharacter->m_animationController = g_theAnimationController;
 }
 
 
@@ -85,10 +88,16 @@ void GameFixCameraIdleTurn::Shutdown()
 {
 	delete m_player;
 
+	m_animConfigHotReloader.Shutdown();
+
 	g_theAnimationController->Shutdown();
 	delete g_theAnimationController;
 	g_theAnimationController = nullptr;
 
+	g_theAnimClipResidencyManager->Shutdown();
+	delete g_theAnimClipResidencyManager;
+	g_theAnimClipResidencyManager = nullptr;
+
 	delete g_theThirdPersonController;
 	g_theThirdPersonController = nullptr;
 
@@ -102,13 +111,18 @@ void GameFixCameraIdleTurn::Update()
 {
 	PrintDebugScreenMessage();
 
-	UpdateLoadedAnimationData();
+	std::unordered_set<Job*> completedJobSet = g_theJobSystem->RetrieveAllCompleteJobs();
+	std::vector<Job*>		 completedJobs( completedJobSet.begin(), completedJobSet.end() );
+	g_theAnimClipResidencyManager->Update( completedJobs );
+	UpdateLoadedAnimationData( completedJobs );
 	if ( !m_isAllAnimationDataLoaded )
 		return;
 
 	if ( !m_isAllMeshDataLoaded )
 		return;
 
+	m_animConfigHotReloader.Update();
+
 	UpdateGameState();
 	UpdatePlayer();
 	UpdateLightConstants();
@@ -179,6 +193,10 @@ void GameFixCameraIdleTurn::PrintDebugScreenMessage()
 
 	std::string timeValuesStr = Stringf( "Time: %.2f, FPS: %.1f, MS: %.1f", totalSeconds, fps, ms );
 	DebugAddScreenText( timeValuesStr, topRightLinePosition, fontSize, topRightAlignment, duration );
+
+	// clip residency
+	topRightLinePosition.y -= fontSize;
+	DebugAddScreenText( g_theAnimClipResidencyManager->GetStatsString(), topRightLinePosition, fontSize, topRightAlignment, duration );
 }
 
 
@@ -302,46 +320,41 @@ void GameFixCameraIdleTurn::StartLoadAnimationData()
 {
 	g_theDevConsole->ToggleOpen(true);
 	AnimationState::LoadAnimationStateFromXML( "Data/Animations/AnimConfig.xml" );
+
+	// with streaming only idle is needed before the character spawns, everything else loads on demand
+	bool  isClipStreamingEnabled = g_gameConfigGlackboard.GetValue( "animClipStreaming", false );
+	float clipBudgetMB			 = g_gameConfigGlackboard.GetValue( "animClipBudgetMB", 64.f );
+
+	g_theAnimClipResidencyManager = new AnimClipResidencyManager();
+	g_theAnimClipResidencyManager->Startup( isClipStreamingEnabled, ( size_t ) ( clipBudgetMB * 1024.f * 1024.f ) );
+	g_theAnimClipResidencyManager->RequestStateClips( AnimationState::GetAnimationStateById( ANIM_NAME_IDLE ), 1.f );
 }
 
 
 //-------------------------------------------------------------------------------------------------
-void GameFixCameraIdleTurn::UpdateLoadedAnimationData()
+void GameFixCameraIdleTurn::UpdateLoadedAnimationData( std::vector<Job*> const& completedJobs )
 {
 	if ( m_isAllAnimationDataLoaded && m_isAllMeshDataLoaded )
 		return;
 
-	std::unordered_set<Job*> completedJobs = g_theJobSystem->RetrieveAllCompleteJobs();
 	for (auto iter = completedJobs.begin(); iter != completedJobs.end(); iter++)
 	{
 		Job* completedJob = *iter;
-		JobLoadAnimationClip* animationCompletedJob = dynamic_cast<JobLoadAnimationClip*>( completedJob );
-		if (animationCompletedJob)
-		{
-			AnimationState* state = AnimationState::s_animationStatesRegistery[ animationCompletedJob->m_stateName ];
-			state->m_clip		  = animationCompletedJob->m_animClip;
-			state->m_defaultPose  = animationCompletedJob->m_defaultPose;
-			state->m_blendTree	  = animationCompletedJob->m_blendTree;
-
-			m_statesLoaded++;
-		}
-		else
+		JobLoadCharacter2* loadCharacterCompleted = dynamic_cast<JobLoadCharacter2*>(completedJob);
+		if (loadCharacterCompleted)
 		{
-			JobLoadCharacter2* loadCharacterCompleted = dynamic_cast<JobLoadCharacter2*>(completedJob);
-			if (loadCharacterCompleted)
-			{
-				m_isAllMeshDataLoaded = true;
-				DeferedStartupAfterLoadingMeshData();
-			}
+			m_isAllMeshDataLoaded = true;
+			DeferedStartupAfterLoadingMeshData();
 		}
 	}
 
 
 	if (!m_isAllAnimationDataLoaded)
 	{
-		if ( m_statesLoaded >= AnimationState::s_animationStatesRegistery.size() )
+		if ( !g_theAnimClipResidencyManager->HasPendingLoads() )
 		{
 			m_isAllAnimationDataLoaded = true;
+			m_animConfigHotReloader.Startup( "Data/Animations/AnimConfig.xml" );
 			DeferedStartupAfterLoadingAnimationData();
 		}
 	}
@@ -4,6 +4,7 @@
 #include "Game/Game.hpp"
 #include "Game/Character.hpp"
 #include "Game/ThirdPersonController.hpp"
+#include "Game/AnimConfigHotReloader.hpp"
 
 #include "Engine/Core/JobSystem.hpp"
 #include "Engine/Math/AABB3.hpp"
@@ -47,10 +48,11 @@ public:
 
 	bool m_isAllAnimationDataLoaded = false;
 	bool m_isAllMeshDataLoaded		= false;
-	int	 m_statesLoaded	   = 0;
 	void DeferedStartupAfterLoadingAnimationData();
 	void StartLoadAnimationData();
-	void UpdateLoadedAnimationData();
+	void UpdateLoadedAnimationData( std::vector<Job*> const& completedJobs );
+
+	AnimConfigHotReloader m_animConfigHotReloader;
 
 	void DeferedStartupAfterLoadingMeshData();
 };
\ No newline at end of file
@@ -44,8 +44,9 @@ void GameLedgeGrabTest::Startup()
 
 	g_theThirdPersonController = new ThirdPersonController();
 
-	g_theAnimationController = new AnimationController();
+	g_theAnimationController = new AnimationController( g_theCharacter );
 	g_theAnimationController->Startup();
+	g_theCharacter->m_animationController = g_theAnimationController;
 }
 
 
@@ -1,6 +1,8 @@
 #include "Game/Map.hpp"
+#include "Game/MapRegionGrid.hpp"
 #include "Game/AnimationState.hpp"
 #include "Game/AnimationController.hpp"
+#include "Game/AnimClipResidencyManager.hpp"
 #include "Game/Player.hpp"
 #include "Game/GameLoadFbxOnThread.hpp"
 #include "Game/App.hpp"
@@ -15,6 +17,7 @@
 #include "Engine/Core/StringUtils.hpp"
 #include "Engine/Core/VertexUtils.hpp"
 #include "Engine/Core/EngineCommon.hpp"
+#include "Engine/Core/NamedStrings.hpp"
 
 
 constexpr int			MAX_VERTEXAS		 = 3;
@@ -74,8 +77,9 @@ void GameLoadFbxOnThread::DeferedStartupAfterLoadingMeshData()
 
 	g_theThirdPersonController = new ThirdPersonController();
 
-	g_theAnimationController   = new AnimationController();
+	g_theAnimationController   = new AnimationController( g_theCharacter );
 	g_theAnimationController->Startup();
+	g_theCharacter->m_animationController = g_theAnimationController;
 }
 
 
@@ -85,10 +89,19 @@ void GameLoadFbxOnThread::Shutdown()
 {
 	delete m_player;
 
+	m_animConfigHotReloader.Shutdown();
+
 	g_theAnimationController->Shutdown();
 	delete g_theAnimationController;
 	g_theAnimationController = nullptr;
 
+	delete m_map;
+	m_map = nullptr;
+
+	g_theAnimClipResidencyManager->Shutdown();
+	delete g_theAnimClipResidencyManager;
+	g_theAnimClipResidencyManager = nullptr;
+
 	delete g_theThirdPersonController;
 	g_theThirdPersonController = nullptr;
 
@@ -102,13 +115,19 @@ void GameLoadFbxOnThread::Update()
 {
 	PrintDebugScreenMessage();
 
-	UpdateLoadedAnimationData();
+	std::unordered_set<Job*> completedJobSet = g_theJobSystem->RetrieveAllCompleteJobs();
+	std::vector<Job*>		 completedJobs( completedJobSet.begin(), completedJobSet.end() );
+	g_theAnimClipResidencyManager->Update( completedJobs );
+	UpdateMapStreaming( completedJobs );
+	UpdateLoadedAnimationData( completedJobs );
 	if ( !m_isAllAnimationDataLoaded )
 		return;
 
 	if ( !m_isAllMeshDataLoaded )
 		return;
 
+	m_animConfigHotReloader.Update();
+
 	UpdateGameState();
 	UpdatePlayer();
 	UpdateLightConstants();
@@ -179,12 +198,24 @@ void GameLoadFbxOnThread::PrintDebugScreenMessage()
 
 	std::string timeValuesStr = Stringf( "Time: %.2f, FPS: %.1f, MS: %.1f", totalSeconds, fps, ms );
 	DebugAddScreenText( timeValuesStr, topRightLinePosition, fontSize, topRightAlignment, duration );
+
+	// clip residency
+	topRightLinePosition.y -= fontSize;
+	DebugAddScreenText( g_theAnimClipResidencyManager->GetStatsString(), topRightLinePosition, fontSize, topRightAlignment, duration );
 }
 
 
 //----------------------------------------------------------------------------------------------------------
 void GameLoadFbxOnThread::CreateObstacle()
 {
+	// a map file streams its regions in around the character instead of the test obstacles below
+	std::string mapRegionFile = g_gameConfigGlackboard.GetValue( "mapRegionFile", std::string( "" ) );
+	if ( !mapRegionFile.empty() )
+	{
+		m_map = new Map( mapRegionFile, g_gameConfigGlackboard.GetValue( "mapStreamingRadius", 96.f ) );
+		return;
+	}
+
 	AABB3 vaultObstacle = AABB3( Vec3( 10.f, -20.f, 0.f ), Vec3( 11.5f, 0.f, 1.4f ) );
 	AABB3 vaultObstacle2 = AABB3( Vec3( 20.f, -30.f, 0.f ), Vec3( 30.f, -28.5f, 1.4f ) );
 	AABB3 vaultObstacle3 = AABB3( Vec3( -10.f, -45.f, 0.f ), Vec3( -8.5f, -8.5f, 1.4f ) );
@@ -203,17 +234,44 @@ void GameLoadFbxOnThread::CreateObstacle()
 
 
 //----------------------------------------------------------------------------------------------------------
-void GameLoadFbxOnThread::RenderObstacle() const
+// the camera stands in for the character until it has loaded
+void GameLoadFbxOnThread::UpdateMapStreaming( std::vector<Job*> const& completedJobs )
 {
-	std::vector<Vertex_PCU> verts;
+	Vec3 focusPosition = g_theCharacter ? g_theCharacter->m_physics.m_position : m_player->m_position;
+	m_map->UpdateStreaming( std::vector<Vec3>{ focusPosition }, completedJobs );
+}
+
 
-	for (int index = 0; index < m_map->m_obstacleAABBs.size(); index++)
+//----------------------------------------------------------------------------------------------------------
+static void AddVertsForObstacles( std::vector<Vertex_PCU>& verts, std::vector<AABB3> const& obstacles )
+{
+	for (int index = 0; index < obstacles.size(); index++)
 	{
-		AABB3 const& obstacle = m_map->m_obstacleAABBs[ index ];
+		AABB3 const& obstacle = obstacles[ index ];
 
 		AddVertsForAABB3D( verts, obstacle, Rgba8::DUSTY_ROSE );
 		AddVertsForWireframeAABB3D( verts, obstacle, 0.01f, Rgba8::RED );
 	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void GameLoadFbxOnThread::RenderObstacle() const
+{
+	std::vector<Vertex_PCU> verts;
+
+	// a region only holds the boxes it owns, a box stored near a border for its neighbour's ledges is drawn once
+	if ( m_map->m_regionGrid )
+	{
+		for ( auto const& regionEntry : m_map->m_regionGrid->m_regions )
+		{
+			AddVertsForObstacles( verts, regionEntry.second.m_obstacleAABBs );
+		}
+	}
+	else
+	{
+		AddVertsForObstacles( verts, m_map->m_obstacleAABBs );
+	}
 
 	g_theRenderer->BindTexture( nullptr );
 	g_theRenderer->BindShader( nullptr );
@@ -302,46 +360,41 @@ void GameLoadFbxOnThread::StartLoadAnimationData()
 {
 	g_theDevConsole->ToggleOpen(true);
 	AnimationState::LoadAnimationStateFromXML( "Data/Animations/AnimConfig.xml" );
+
+	// with streaming only idle is needed before the character spawns, everything else loads on demand
+	bool  isClipStreamingEnabled = g_gameConfigGlackboard.GetValue( "animClipStreaming", false );
+	float clipBudgetMB			 = g_gameConfigGlackboard.GetValue( "animClipBudgetMB", 64.f );
+
+	g_theAnimClipResidencyManager = new AnimClipResidencyManager();
+	g_theAnimClipResidencyManager->Startup( isClipStreamingEnabled, ( size_t ) ( clipBudgetMB * 1024.f * 1024.f ) );
+	g_theAnimClipResidencyManager->RequestStateClips( AnimationState::GetAnimationStateById( ANIM_NAME_IDLE ), 1.f );
 }
 
 
 //-------------------------------------------------------------------------------------------------
-void GameLoadFbxOnThread::UpdateLoadedAnimationData()
+void GameLoadFbxOnThread::UpdateLoadedAnimationData( std::vector<Job*> const& completedJobs )
 {
 	if ( m_isAllAnimationDataLoaded && m_isAllMeshDataLoaded )
 		return;
 
-	std::unordered_set<Job*> completedJobs = g_theJobSystem->RetrieveAllCompleteJobs();
 	for (auto iter = completedJobs.begin(); iter != completedJobs.end(); iter++)
 	{
 		Job* completedJob = *iter;
-		JobLoadAnimationClip* animationCompletedJob = dynamic_cast<JobLoadAnimationClip*>( completedJob );
-		if (animationCompletedJob)
-		{
-			AnimationState* state = AnimationState::s_animationStatesRegistery[ animationCompletedJob->m_stateName ];
-			state->m_clip		  = animationCompletedJob->m_animClip;
-			state->m_defaultPose  = animationCompletedJob->m_defaultPose;
-			state->m_blendTree	  = animationCompletedJob->m_blendTree;
-
-			m_statesLoaded++;
-		}
-		else
+		JobLoadCharacter* loadCharacterCompleted = dynamic_cast<JobLoadCharacter*>(completedJob);
+		if (loadCharacterCompleted)
 		{
-			JobLoadCharacter* loadCharacterCompleted = dynamic_cast<JobLoadCharacter*>(completedJob);
-			if (loadCharacterCompleted)
-			{
-				m_isAllMeshDataLoaded = true;
-				DeferedStartupAfterLoadingMeshData();
-			}
+			m_isAllMeshDataLoaded = true;
+			DeferedStartupAfterLoadingMeshData();
 		}
 	}
 
 
 	if (!m_isAllAnimationDataLoaded)
 	{
-		if ( m_statesLoaded >= AnimationState::s_animationStatesRegistery.size() )
+		if ( !g_theAnimClipResidencyManager->HasPendingLoads() )
 		{
 			m_isAllAnimationDataLoaded = true;
+			m_animConfigHotReloader.Startup( "Data/Animations/AnimConfig.xml" );
 			DeferedStartupAfterLoadingAnimationData();
 		}
 	}
@@ -1,13 +1,52 @@
 #define WIN32_LEAN_AND_MEAN		// Always #define this before #including <windows.h>
 #include <windows.h>			// #include this (massive, platform-specific) header in very few places
+#include <stdio.h>
 #include "App.hpp"
+#include "AnimAssetCooker.hpp"
+#include "CrowdBenchmark.hpp"
+#include "MotionMatchingBenchmark.hpp"
 
 extern App* g_theApp;
 
 
 //-----------------------------------------------------------------------------------------------
-int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
+// a GUI subsystem exe has no console of its own, headless runs print into the one they were launched from
+static void AttachParentConsole()
 {
+	if ( !AttachConsole( ATTACH_PARENT_PROCESS ) )
+	{
+		return;
+	}
+
+	FILE* consoleStream = nullptr;
+	freopen_s( &consoleStream, "CONOUT$", "w", stdout );
+	freopen_s( &consoleStream, "CONOUT$", "w", stderr );
+}
+
+
+//-----------------------------------------------------------------------------------------------
+int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR commandLineString, int)
+{
+	// headless asset cook, no window or renderer
+	if ( AnimAssetCooker::IsCookRequested( commandLineString ) )
+	{
+		return AnimAssetCooker::RunFromCommandLine( commandLineString );
+	}
+
+	// headless crowd benchmark, no window or renderer
+	if ( CrowdBenchmark::IsBenchmarkRequested( commandLineString ) )
+	{
+		AttachParentConsole();
+		return CrowdBenchmark::RunFromCommandLine( commandLineString );
+	}
+
+	// headless motion matching search benchmark, no window or renderer
+	if ( MotionMatchingBenchmark::IsBenchmarkRequested( commandLineString ) )
+	{
+		AttachParentConsole();
+		return MotionMatchingBenchmark::RunFromCommandLine( commandLineString );
+	}
+
 	g_theApp = new App();
 	g_theApp->Startup();
 
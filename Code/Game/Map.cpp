@@ -1,20 +1,70 @@
 #include "Map.hpp"
+#include "Game/MapRegionGrid.hpp"
 
 
 //----------------------------------------------------------------------------------------------------------
 Map::Map( std::vector<AABB3> const& obstacles )
 	: m_obstacleAABBs( obstacles )
 {
-	CreateConvexHulls();
+	m_collisionWorld.Build( m_obstacleAABBs );
 }
 
 
 //----------------------------------------------------------------------------------------------------------
-void Map::CreateConvexHulls()
+Map::Map( std::string const& regionFilePath, float streamingRadius )
 {
-	for (int index = 0; index < m_obstacleAABBs.size(); index++)
+	m_regionGrid = new MapRegionGrid();
+	if ( !m_regionGrid->Startup( regionFilePath, streamingRadius ) )
 	{
-		ConvexHull3 convexHull = ConvexHull3( m_obstacleAABBs[ index ] );
-		m_obstacleConvexHulls.push_back( convexHull );
+		delete m_regionGrid;
+		m_regionGrid = nullptr;
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+Map::~Map()
+{
+	if ( m_regionGrid )
+	{
+		m_regionGrid->Shutdown();
+		delete m_regionGrid;
+		m_regionGrid = nullptr;
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void Map::Raycast( MapRaycastQuery const* queries, int numQueries, MapRaycastHit* out_hits ) const
+{
+	if ( m_regionGrid )
+	{
+		m_regionGrid->Raycast( queries, numQueries, out_hits );
+		return;
+	}
+
+	m_collisionWorld.Raycast( queries, numQueries, out_hits );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool Map::FindNearestLedge( MapLedgeQuery const& query, MapLedgeHit& out_hit ) const
+{
+	if ( m_regionGrid )
+	{
+		return m_regionGrid->FindNearestLedge( query, out_hit );
+	}
+
+	return m_collisionWorld.FindNearestLedge( query, out_hit );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// focus positions are wherever characters are, regions around them load on the job system
+void Map::UpdateStreaming( std::vector<Vec3> const& focusPositions, std::vector<Job*> const& completedJobs )
+{
+	if ( m_regionGrid )
+	{
+		m_regionGrid->Update( focusPositions, completedJobs );
 	}
 }
@@ -1,20 +1,30 @@
 #pragma once
 
-#include "Engine/Math/ConvexHull3.hpp"
+#include "Game/CollisionWorld.hpp"
+
 #include "Engine/Math/AABB3.hpp"
 
+#include <string>
 #include <vector>
 
+class MapRegionGrid;
+struct Job;
+
 //----------------------------------------------------------------------------------------------------------
 class Map
 {
 public:
 	Map(std::vector<AABB3> const& obstacles);
+	Map( std::string const& regionFilePath, float streamingRadius );
+	~Map();
 
 
 	//----------------------------------------------------------------------------------------------------------
-	std::vector<AABB3> m_obstacleAABBs;
-	std::vector<ConvexHull3> m_obstacleConvexHulls;
+	std::vector<AABB3> m_obstacleAABBs; // empty for a streamed map
+	CollisionWorld m_collisionWorld; // built once here, every character queries this one
+	MapRegionGrid* m_regionGrid = nullptr; // set when obstacles stream in by region from a map file
 
-	void CreateConvexHulls();
+	void Raycast( MapRaycastQuery const* queries, int numQueries, MapRaycastHit* out_hits ) const;
+	bool FindNearestLedge( MapLedgeQuery const& query, MapLedgeHit& out_hit ) const;
+	void UpdateStreaming( std::vector<Vec3> const& focusPositions, std::vector<Job*> const& completedJobs );
 };
\ No newline at end of file
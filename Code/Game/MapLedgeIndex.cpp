@@ -0,0 +1,356 @@
+#include "Game/MapLedgeIndex.hpp"
+
+#include <algorithm>
+#include <math.h>
+#include <utility>
+
+
+//----------------------------------------------------------------------------------------------------------
+static float GetVec3Axis( Vec3 const& vec, int axis )
+{
+	if ( axis == 0 )
+	{
+		return vec.x;
+	}
+	if ( axis == 1 )
+	{
+		return vec.y;
+	}
+	return vec.z;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+static int GetCellCoord( float position )
+{
+	return ( int ) floorf( position / MAP_LEDGE_CELL_SIZE );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// boxes are bucketed the same way as the ledges, only to find the neighbours that can cover an edge; border boxes
+// belong to a neighbouring region and only cover edges here, they have no ledges of their own in this index
+void MapLedgeIndex::Build( std::vector<AABB3> const& obstacleAABBs, std::vector<AABB3> const& borderAABBs )
+{
+	Clear();
+
+	std::vector<AABB3> coveringAABBs = obstacleAABBs;
+	coveringAABBs.insert( coveringAABBs.end(), borderAABBs.begin(), borderAABBs.end() );
+
+	std::unordered_map<uint64_t, std::vector<int>> obstacleCells;
+	for ( int obstacleIndex = 0; obstacleIndex < ( int ) coveringAABBs.size(); obstacleIndex++ )
+	{
+		AABB3 const& box = coveringAABBs[ obstacleIndex ];
+		for ( int cellY = GetCellCoord( box.m_mins.y ); cellY <= GetCellCoord( box.m_maxs.y ); cellY++ )
+		{
+			for ( int cellX = GetCellCoord( box.m_mins.x ); cellX <= GetCellCoord( box.m_maxs.x ); cellX++ )
+			{
+				obstacleCells[ GetCellKey( cellX, cellY ) ].push_back( obstacleIndex );
+			}
+		}
+	}
+
+	std::vector<int> nearbyObstacles;
+	for ( int obstacleIndex = 0; obstacleIndex < ( int ) obstacleAABBs.size(); obstacleIndex++ )
+	{
+		AABB3 const& box = obstacleAABBs[ obstacleIndex ];
+		nearbyObstacles.clear();
+		for ( int cellY = GetCellCoord( box.m_mins.y - MAP_LEDGE_HAND_CLEARANCE ); cellY <= GetCellCoord( box.m_maxs.y + MAP_LEDGE_HAND_CLEARANCE ); cellY++ )
+		{
+			for ( int cellX = GetCellCoord( box.m_mins.x - MAP_LEDGE_HAND_CLEARANCE ); cellX <= GetCellCoord( box.m_maxs.x + MAP_LEDGE_HAND_CLEARANCE ); cellX++ )
+			{
+				auto cellIter = obstacleCells.find( GetCellKey( cellX, cellY ) );
+				if ( cellIter != obstacleCells.end() )
+				{
+					nearbyObstacles.insert( nearbyObstacles.end(), cellIter->second.begin(), cellIter->second.end() );
+				}
+			}
+		}
+		std::sort( nearbyObstacles.begin(), nearbyObstacles.end() );
+		nearbyObstacles.erase( std::unique( nearbyObstacles.begin(), nearbyObstacles.end() ), nearbyObstacles.end() );
+
+		ExtractBoxLedges( coveringAABBs, obstacleIndex, nearbyObstacles );
+	}
+
+	BuildCells();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// ledges read back from a region file, only the cells are left to build
+void MapLedgeIndex::BuildFromBakedLedges( std::vector<MapLedge>& bakedLedges )
+{
+	Clear();
+
+	m_ledges.swap( bakedLedges );
+	BuildCells();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void MapLedgeIndex::Clear()
+{
+	m_ledges.clear();
+	m_cells.clear();
+	m_cellLedges.clear();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool MapLedgeIndex::IsEmpty() const
+{
+	return m_ledges.empty();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+int MapLedgeIndex::GetNumLedges() const
+{
+	return ( int ) m_ledges.size();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// the closest ledge that passes every test in the query, ties go to the lower ledge index so results are stable
+bool MapLedgeIndex::FindNearestLedge( MapLedgeQuery const& query, MapLedgeHit& out_hit ) const
+{
+	out_hit = MapLedgeHit();
+	if ( m_ledges.empty() )
+	{
+		return false;
+	}
+
+	// ledges face back against the flattened facing direction
+	float facingX	   = query.m_facing.x;
+	float facingY	   = query.m_facing.y;
+	float facingLength = sqrtf( facingX * facingX + facingY * facingY );
+	if ( facingLength <= 0.f )
+	{
+		return false;
+	}
+	facingX /= facingLength;
+	facingY /= facingLength;
+
+	float maxDistance = query.m_distanceRange.m_max;
+	int	  minCellX	  = GetCellCoord( query.m_position.x - maxDistance );
+	int	  minCellY	  = GetCellCoord( query.m_position.y - maxDistance );
+	int	  maxCellX	  = GetCellCoord( query.m_position.x + maxDistance );
+	int	  maxCellY	  = GetCellCoord( query.m_position.y + maxDistance );
+	for ( int cellY = minCellY; cellY <= maxCellY; cellY++ )
+	{
+		for ( int cellX = minCellX; cellX <= maxCellX; cellX++ )
+		{
+			auto cellIter = m_cells.find( GetCellKey( cellX, cellY ) );
+			if ( cellIter == m_cells.end() )
+			{
+				continue;
+			}
+
+			MapLedgeCell const& cell = cellIter->second;
+			for ( int slotIndex = cell.m_firstLedge; slotIndex < cell.m_firstLedge + cell.m_numLedges; slotIndex++ )
+			{
+				int				ledgeIndex = m_cellLedges[ slotIndex ];
+				MapLedge const& ledge	   = m_ledges[ ledgeIndex ];
+				if ( ( query.m_needsGrabbable && !ledge.m_isGrabbable ) || ( query.m_needsVaultable && !ledge.m_isVaultable ) )
+				{
+					continue;
+				}
+				if ( !query.m_heightAboveRange.IsOnRange( ledge.m_height - query.m_position.z ) )
+				{
+					continue;
+				}
+				float facingDot = -( ledge.m_outwardNormal.x * facingX + ledge.m_outwardNormal.y * facingY );
+				if ( facingDot < query.m_minFacingDot )
+				{
+					continue;
+				}
+
+				// nearest point on the lip in xy, the lip is level so z is its height
+				float segmentX		 = ledge.m_end.x - ledge.m_start.x;
+				float segmentY		 = ledge.m_end.y - ledge.m_start.y;
+				float segmentLengthSq = segmentX * segmentX + segmentY * segmentY;
+				float fraction		 = 0.f;
+				if ( segmentLengthSq > 0.f )
+				{
+					fraction = ( ( query.m_position.x - ledge.m_start.x ) * segmentX + ( query.m_position.y - ledge.m_start.y ) * segmentY ) / segmentLengthSq;
+					fraction = std::max( 0.f, std::min( fraction, 1.f ) );
+				}
+				Vec3  nearestPoint = Vec3( ledge.m_start.x + segmentX * fraction, ledge.m_start.y + segmentY * fraction, ledge.m_height );
+				float deltaX	   = nearestPoint.x - query.m_position.x;
+				float deltaY	   = nearestPoint.y - query.m_position.y;
+				float distance	   = sqrtf( deltaX * deltaX + deltaY * deltaY );
+				if ( !query.m_distanceRange.IsOnRange( distance ) )
+				{
+					continue;
+				}
+
+				bool isCloser = out_hit.m_ledgeIndex < 0 || distance < out_hit.m_distance ||
+								( distance == out_hit.m_distance && ledgeIndex < out_hit.m_ledgeIndex );
+				if ( isCloser )
+				{
+					out_hit.m_ledge		   = ledge;
+					out_hit.m_nearestPoint = nearestPoint;
+					out_hit.m_distance	   = distance;
+					out_hit.m_ledgeIndex   = ledgeIndex;
+				}
+			}
+		}
+	}
+
+	return out_hit.m_ledgeIndex >= 0;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// the four top edges of a box, each cut back to the parts no neighbour covers
+void MapLedgeIndex::ExtractBoxLedges( std::vector<AABB3> const& obstacleAABBs, int obstacleIndex, std::vector<int> const& nearbyObstacles )
+{
+	AABB3 const& box = obstacleAABBs[ obstacleIndex ];
+	float		 top = box.m_maxs.z;
+
+	MapLedge edge;
+	edge.m_height		 = top;
+	edge.m_obstacleIndex = obstacleIndex;
+	edge.m_isGrabbable	 = true;
+
+	// edges running along y, facing -x and +x
+	edge.m_depth		 = box.m_maxs.x - box.m_mins.x;
+	edge.m_isVaultable	 = edge.m_depth <= MAP_LEDGE_MAX_VAULT_DEPTH;
+	edge.m_outwardNormal = Vec3( -1.f, 0.f, 0.f );
+	edge.m_start		 = Vec3( box.m_mins.x, box.m_mins.y, top );
+	edge.m_end			 = Vec3( box.m_mins.x, box.m_maxs.y, top );
+	AddUncoveredPieces( edge, 1, obstacleAABBs, nearbyObstacles );
+	edge.m_outwardNormal = Vec3( 1.f, 0.f, 0.f );
+	edge.m_start		 = Vec3( box.m_maxs.x, box.m_mins.y, top );
+	edge.m_end			 = Vec3( box.m_maxs.x, box.m_maxs.y, top );
+	AddUncoveredPieces( edge, 1, obstacleAABBs, nearbyObstacles );
+
+	// edges running along x, facing -y and +y
+	edge.m_depth		 = box.m_maxs.y - box.m_mins.y;
+	edge.m_isVaultable	 = edge.m_depth <= MAP_LEDGE_MAX_VAULT_DEPTH;
+	edge.m_outwardNormal = Vec3( 0.f, -1.f, 0.f );
+	edge.m_start		 = Vec3( box.m_mins.x, box.m_mins.y, top );
+	edge.m_end			 = Vec3( box.m_maxs.x, box.m_mins.y, top );
+	AddUncoveredPieces( edge, 0, obstacleAABBs, nearbyObstacles );
+	edge.m_outwardNormal = Vec3( 0.f, 1.f, 0.f );
+	edge.m_start		 = Vec3( box.m_mins.x, box.m_maxs.y, top );
+	edge.m_end			 = Vec3( box.m_maxs.x, box.m_maxs.y, top );
+	AddUncoveredPieces( edge, 0, obstacleAABBs, nearbyObstacles );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// a neighbour covers part of an edge when it stands flush against the face at lip height or taller, or when it
+// takes the space above the lip where the hands would go; what is left over becomes ledges
+void MapLedgeIndex::AddUncoveredPieces( MapLedge const& edge, int edgeAxis, std::vector<AABB3> const& obstacleAABBs, std::vector<int> const& nearbyObstacles )
+{
+	int	  normalAxis   = 1 - edgeAxis;
+	float normalSign   = GetVec3Axis( edge.m_outwardNormal, normalAxis );
+	float edgeLine	   = GetVec3Axis( edge.m_start, normalAxis );
+	float edgeStart	   = GetVec3Axis( edge.m_start, edgeAxis );
+	float edgeEnd	   = GetVec3Axis( edge.m_end, edgeAxis );
+	float outsideMin   = normalSign > 0.f ? edgeLine : edgeLine - MAP_LEDGE_HAND_CLEARANCE;
+	float outsideMax   = normalSign > 0.f ? edgeLine + MAP_LEDGE_HAND_CLEARANCE : edgeLine;
+	float insideMin	   = normalSign > 0.f ? edgeLine - MAP_LEDGE_HAND_CLEARANCE : edgeLine;
+	float insideMax	   = normalSign > 0.f ? edgeLine : edgeLine + MAP_LEDGE_HAND_CLEARANCE;
+	float clearanceTop = edge.m_height + MAP_LEDGE_HAND_CLEARANCE;
+
+	std::vector<std::pair<float, float>> coveredSpans;
+	for ( int neighbourIndex : nearbyObstacles )
+	{
+		if ( neighbourIndex == edge.m_obstacleIndex )
+		{
+			continue;
+		}
+
+		AABB3 const& neighbour	  = obstacleAABBs[ neighbourIndex ];
+		float		 neighbourMin = GetVec3Axis( neighbour.m_mins, normalAxis );
+		float		 neighbourMax = GetVec3Axis( neighbour.m_maxs, normalAxis );
+		bool		 isOutside	  = neighbourMin < outsideMax && neighbourMax > outsideMin && neighbour.m_maxs.z > edge.m_height - MAP_LEDGE_FLUSH_TOLERANCE &&
+						 neighbour.m_mins.z < clearanceTop;
+		bool isAbove = neighbourMin < insideMax && neighbourMax > insideMin && neighbour.m_maxs.z > edge.m_height + MAP_LEDGE_FLUSH_TOLERANCE &&
+					   neighbour.m_mins.z < clearanceTop;
+		if ( !isOutside && !isAbove )
+		{
+			continue;
+		}
+
+		float spanStart = std::max( edgeStart, GetVec3Axis( neighbour.m_mins, edgeAxis ) );
+		float spanEnd	= std::min( edgeEnd, GetVec3Axis( neighbour.m_maxs, edgeAxis ) );
+		if ( spanStart < spanEnd )
+		{
+			coveredSpans.push_back( std::make_pair( spanStart, spanEnd ) );
+		}
+	}
+	std::sort( coveredSpans.begin(), coveredSpans.end() );
+
+	// walk the covered spans in order, every gap between them long enough to hold a hand is a ledge
+	float pieceStart = edgeStart;
+	for ( int spanIndex = 0; spanIndex <= ( int ) coveredSpans.size(); spanIndex++ )
+	{
+		float pieceEnd = spanIndex < ( int ) coveredSpans.size() ? coveredSpans[ spanIndex ].first : edgeEnd;
+		if ( pieceEnd - pieceStart >= MAP_LEDGE_MIN_LENGTH )
+		{
+			MapLedge piece = edge;
+			if ( edgeAxis == 0 )
+			{
+				piece.m_start.x = pieceStart;
+				piece.m_end.x	= pieceEnd;
+			}
+			else
+			{
+				piece.m_start.y = pieceStart;
+				piece.m_end.y	= pieceEnd;
+			}
+			m_ledges.push_back( piece );
+		}
+
+		if ( spanIndex < ( int ) coveredSpans.size() )
+		{
+			pieceStart = std::max( pieceStart, coveredSpans[ spanIndex ].second );
+		}
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// a ledge goes in every cell its lip passes over, cells are runs of one flat array sorted by cell key
+void MapLedgeIndex::BuildCells()
+{
+	std::vector<std::pair<uint64_t, int>> cellEntries;
+	for ( int ledgeIndex = 0; ledgeIndex < ( int ) m_ledges.size(); ledgeIndex++ )
+	{
+		MapLedge const& ledge = m_ledges[ ledgeIndex ];
+		int				minCellX = GetCellCoord( std::min( ledge.m_start.x, ledge.m_end.x ) );
+		int				minCellY = GetCellCoord( std::min( ledge.m_start.y, ledge.m_end.y ) );
+		int				maxCellX = GetCellCoord( std::max( ledge.m_start.x, ledge.m_end.x ) );
+		int				maxCellY = GetCellCoord( std::max( ledge.m_start.y, ledge.m_end.y ) );
+		for ( int cellY = minCellY; cellY <= maxCellY; cellY++ )
+		{
+			for ( int cellX = minCellX; cellX <= maxCellX; cellX++ )
+			{
+				cellEntries.push_back( std::make_pair( GetCellKey( cellX, cellY ), ledgeIndex ) );
+			}
+		}
+	}
+	std::sort( cellEntries.begin(), cellEntries.end() );
+
+	m_cellLedges.reserve( cellEntries.size() );
+	for ( int entryIndex = 0; entryIndex < ( int ) cellEntries.size(); entryIndex++ )
+	{
+		MapLedgeCell& cell = m_cells[ cellEntries[ entryIndex ].first ];
+		if ( cell.m_numLedges == 0 )
+		{
+			cell.m_firstLedge = ( int ) m_cellLedges.size();
+		}
+		cell.m_numLedges++;
+		m_cellLedges.push_back( cellEntries[ entryIndex ].second );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+uint64_t MapLedgeIndex::GetCellKey( int cellX, int cellY )
+{
+	return ( ( uint64_t ) ( uint32_t ) cellX << 32 ) | ( uint64_t ) ( uint32_t ) cellY;
+}
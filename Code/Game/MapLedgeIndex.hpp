@@ -0,0 +1,91 @@
+#pragma once
+
+#include "Engine/Math/FloatRange.hpp"
+#include "Engine/Math/AABB3.hpp"
+#include "Engine/Math/Vec3.hpp"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+
+//----------------------------------------------------------------------------------------------------------
+constexpr float MAP_LEDGE_CELL_SIZE			= 4.f;
+constexpr float MAP_LEDGE_HAND_CLEARANCE	= 0.5f;	 // free space needed above a lip for the hands
+constexpr float MAP_LEDGE_FLUSH_TOLERANCE	= 0.05f; // neighbours whose tops are this close count as the same surface
+constexpr float MAP_LEDGE_MIN_LENGTH		= 0.5f;	 // shorter uncovered pieces of an edge are dropped
+constexpr float MAP_LEDGE_MAX_VAULT_DEPTH	= 2.f;	 // tops deeper than this are climbed, not vaulted over
+
+
+//----------------------------------------------------------------------------------------------------------
+// one top edge of an obstacle box, the part of it nothing else covers; the normal is horizontal and points away
+// from the box, toward where a character would stand to grab it
+struct MapLedge
+{
+	Vec3  m_start;
+	Vec3  m_end;
+	Vec3  m_outwardNormal;
+	float m_height		  = 0.f; // world z of the lip
+	float m_depth		  = 0.f; // box size along the normal
+	int	  m_obstacleIndex = -1;
+	bool  m_isGrabbable	  = false;
+	bool  m_isVaultable	  = false;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+struct MapLedgeQuery
+{
+	Vec3	   m_position;						 // the character's feet
+	Vec3	   m_facing;						 // ledges must face back against this
+	FloatRange m_distanceRange;					 // horizontal distance to the nearest point on the lip
+	FloatRange m_heightAboveRange;				 // lip height over m_position
+	float	   m_minFacingDot	  = 0.7f;
+	bool	   m_needsGrabbable	  = false;
+	bool	   m_needsVaultable	  = false;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+struct MapLedgeHit
+{
+	MapLedge m_ledge;
+	Vec3	 m_nearestPoint;
+	float	 m_distance	 = 0.f;
+	int		 m_ledgeIndex = -1; // -1 when nothing was in reach
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+struct MapLedgeCell
+{
+	int m_firstLedge = 0;
+	int m_numLedges	 = 0;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// ledges extracted from the obstacle boxes once, when the region file is written or, for a map held in memory, when
+// the collision world is built, and bucketed into square cells by their xy bounds; a query looks at the few cells its
+// reach covers instead of casting rays at the map
+class MapLedgeIndex
+{
+public:
+	void									   Build( std::vector<AABB3> const& obstacleAABBs, std::vector<AABB3> const& borderAABBs );
+	void									   BuildFromBakedLedges( std::vector<MapLedge>& bakedLedges );
+	void									   Clear();
+	bool									   IsEmpty() const;
+	int										   GetNumLedges() const;
+	bool									   FindNearestLedge( MapLedgeQuery const& query, MapLedgeHit& out_hit ) const;
+
+	std::vector<MapLedge>					   m_ledges;
+	std::unordered_map<uint64_t, MapLedgeCell> m_cells;
+	std::vector<int>						   m_cellLedges; // ledge indices, each cell owns one run
+
+protected:
+	void ExtractBoxLedges( std::vector<AABB3> const& obstacleAABBs, int obstacleIndex, std::vector<int> const& nearbyObstacles );
+	void AddUncoveredPieces( MapLedge const& edge, int edgeAxis, std::vector<AABB3> const& obstacleAABBs, std::vector<int> const& nearbyObstacles );
+	void BuildCells();
+
+	static uint64_t GetCellKey( int cellX, int cellY );
+};
@@ -0,0 +1,373 @@
+#include "Game/MapObstacleBVH.hpp"
+
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+#include <xmmintrin.h>
+
+
+//----------------------------------------------------------------------------------------------------------
+static float GetAxisValue( Vec3 const& vector, int axis )
+{
+	return ( axis == 0 ) ? vector.x : ( ( axis == 1 ) ? vector.y : vector.z );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+static float GetCentroidOnAxis( AABB3 const& box, int axis )
+{
+	return 0.5f * ( GetAxisValue( box.m_mins, axis ) + GetAxisValue( box.m_maxs, axis ) );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// a zero component gets a huge inverse rather than infinity, so a ray lying on a slab face never produces nan
+static float GetSafeInverse( float value )
+{
+	if ( fabsf( value ) < 1e-20f )
+	{
+		return ( value < 0.f ) ? -1e30f : 1e30f;
+	}
+
+	return 1.f / value;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+struct MapRayPacket
+{
+	__m128 m_startX;
+	__m128 m_startY;
+	__m128 m_startZ;
+	__m128 m_inverseX;
+	__m128 m_inverseY;
+	__m128 m_inverseZ;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// slab test of every lane against one box, returns the lanes that enter it no farther than maxDist; out_entryDist
+// is 0 for a lane that starts inside, a lane with a negative maxDist never hits
+static int GetPacketHitMaskVsBox( MapRayPacket const& packet, AABB3 const& box, __m128 maxDist, __m128& out_entryDist )
+{
+	__m128 nearX = _mm_mul_ps( _mm_sub_ps( _mm_set1_ps( box.m_mins.x ), packet.m_startX ), packet.m_inverseX );
+	__m128 farX	 = _mm_mul_ps( _mm_sub_ps( _mm_set1_ps( box.m_maxs.x ), packet.m_startX ), packet.m_inverseX );
+	__m128 nearY = _mm_mul_ps( _mm_sub_ps( _mm_set1_ps( box.m_mins.y ), packet.m_startY ), packet.m_inverseY );
+	__m128 farY	 = _mm_mul_ps( _mm_sub_ps( _mm_set1_ps( box.m_maxs.y ), packet.m_startY ), packet.m_inverseY );
+	__m128 nearZ = _mm_mul_ps( _mm_sub_ps( _mm_set1_ps( box.m_mins.z ), packet.m_startZ ), packet.m_inverseZ );
+	__m128 farZ	 = _mm_mul_ps( _mm_sub_ps( _mm_set1_ps( box.m_maxs.z ), packet.m_startZ ), packet.m_inverseZ );
+
+	__m128 entryDist = _mm_max_ps( _mm_max_ps( _mm_min_ps( nearX, farX ), _mm_min_ps( nearY, farY ) ), _mm_max_ps( _mm_min_ps( nearZ, farZ ), _mm_setzero_ps() ) );
+	__m128 exitDist	 = _mm_min_ps( _mm_min_ps( _mm_max_ps( nearX, farX ), _mm_max_ps( nearY, farY ) ), _mm_min_ps( _mm_max_ps( nearZ, farZ ), maxDist ) );
+	out_entryDist	 = entryDist;
+
+	return _mm_movemask_ps( _mm_cmple_ps( entryDist, exitDist ) );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// the face a ray enters a box through is on the axis whose near slab it crosses last
+static Vec3 GetEntryNormalVsBox( Vec3 const& startPos, Vec3 const& fwdNormal, AABB3 const& box )
+{
+	int	  entryAxis = -1;
+	float entryDist = 0.f;
+	for ( int axis = 0; axis < 3; axis++ )
+	{
+		float direction = GetAxisValue( fwdNormal, axis );
+		if ( fabsf( direction ) < 1e-20f )
+		{
+			continue;
+		}
+
+		float nearPlane = ( direction > 0.f ) ? GetAxisValue( box.m_mins, axis ) : GetAxisValue( box.m_maxs, axis );
+		float nearDist	= ( nearPlane - GetAxisValue( startPos, axis ) ) / direction;
+		if ( nearDist > entryDist )
+		{
+			entryDist = nearDist;
+			entryAxis = axis;
+		}
+	}
+
+	// started inside the box, there is no face to report
+	if ( entryAxis < 0 )
+	{
+		return -1.f * fwdNormal;
+	}
+
+	float sign = ( GetAxisValue( fwdNormal, entryAxis ) > 0.f ) ? -1.f : 1.f;
+	return Vec3( ( entryAxis == 0 ) ? sign : 0.f, ( entryAxis == 1 ) ? sign : 0.f, ( entryAxis == 2 ) ? sign : 0.f );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// the ray itself is kept on a miss so it can still be drawn
+void InitRaycastMiss( MapRaycastQuery const& query, MapRaycastHit& out_hit )
+{
+	out_hit.m_result				= RaycastResult3D();
+	out_hit.m_result.m_didImpact	= false;
+	out_hit.m_result.m_rayStartPos	= query.m_startPos;
+	out_hit.m_result.m_rayFwdNormal = query.m_fwdNormal;
+	out_hit.m_result.m_rayMaxLength = query.m_maxLength;
+	out_hit.m_obstacleIndex			= -1;
+	out_hit.m_collisionWorld		= nullptr;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void MapObstacleBVH::Build( std::vector<AABB3> const& obstacleAABBs )
+{
+	Clear();
+
+	if ( obstacleAABBs.empty() )
+	{
+		return;
+	}
+
+	int numObstacles = ( int ) obstacleAABBs.size();
+	m_obstacleIndices.resize( numObstacles );
+	for ( int obstacleIndex = 0; obstacleIndex < numObstacles; obstacleIndex++ )
+	{
+		m_obstacleIndices[ obstacleIndex ] = obstacleIndex;
+	}
+
+	m_nodes.reserve( 2 * numObstacles / MAP_BVH_LEAF_SIZE + 1 );
+	BuildNode( obstacleAABBs, 0, numObstacles, 0 );
+
+	// boxes copied in leaf order once the partitioning is final
+	m_leafBoxes.resize( numObstacles );
+	for ( int slot = 0; slot < numObstacles; slot++ )
+	{
+		m_leafBoxes[ slot ] = obstacleAABBs[ m_obstacleIndices[ slot ] ];
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+int MapObstacleBVH::BuildNode( std::vector<AABB3> const& obstacleAABBs, int firstObstacle, int numObstacles, int depth )
+{
+	int nodeIndex = ( int ) m_nodes.size();
+	m_nodes.push_back( MapObstacleBVHNode() );
+
+	AABB3 bounds = obstacleAABBs[ m_obstacleIndices[ firstObstacle ] ];
+	Vec3  centroidMins( FLT_MAX, FLT_MAX, FLT_MAX );
+	Vec3  centroidMaxs( -FLT_MAX, -FLT_MAX, -FLT_MAX );
+	for ( int slot = firstObstacle; slot < firstObstacle + numObstacles; slot++ )
+	{
+		AABB3 const& box = obstacleAABBs[ m_obstacleIndices[ slot ] ];
+		bounds.m_mins.x	 = ( box.m_mins.x < bounds.m_mins.x ) ? box.m_mins.x : bounds.m_mins.x;
+		bounds.m_mins.y	 = ( box.m_mins.y < bounds.m_mins.y ) ? box.m_mins.y : bounds.m_mins.y;
+		bounds.m_mins.z	 = ( box.m_mins.z < bounds.m_mins.z ) ? box.m_mins.z : bounds.m_mins.z;
+		bounds.m_maxs.x	 = ( box.m_maxs.x > bounds.m_maxs.x ) ? box.m_maxs.x : bounds.m_maxs.x;
+		bounds.m_maxs.y	 = ( box.m_maxs.y > bounds.m_maxs.y ) ? box.m_maxs.y : bounds.m_maxs.y;
+		bounds.m_maxs.z	 = ( box.m_maxs.z > bounds.m_maxs.z ) ? box.m_maxs.z : bounds.m_maxs.z;
+
+		Vec3 centroid  = ( box.m_mins + box.m_maxs ) * 0.5f;
+		centroidMins.x = ( centroid.x < centroidMins.x ) ? centroid.x : centroidMins.x;
+		centroidMins.y = ( centroid.y < centroidMins.y ) ? centroid.y : centroidMins.y;
+		centroidMins.z = ( centroid.z < centroidMins.z ) ? centroid.z : centroidMins.z;
+		centroidMaxs.x = ( centroid.x > centroidMaxs.x ) ? centroid.x : centroidMaxs.x;
+		centroidMaxs.y = ( centroid.y > centroidMaxs.y ) ? centroid.y : centroidMaxs.y;
+		centroidMaxs.z = ( centroid.z > centroidMaxs.z ) ? centroid.z : centroidMaxs.z;
+	}
+	m_nodes[ nodeIndex ].m_bounds		 = bounds;
+	m_nodes[ nodeIndex ].m_firstObstacle = firstObstacle;
+	m_nodes[ nodeIndex ].m_numObstacles	 = numObstacles;
+
+	// the depth cap keeps the traversal stack bounded even for badly clustered maps
+	if ( numObstacles <= MAP_BVH_LEAF_SIZE || depth >= MAP_BVH_MAX_STACK_DEPTH - 2 )
+	{
+		return nodeIndex;
+	}
+
+	int	  splitAxis		= 0;
+	float longestExtent = -1.f;
+	for ( int axis = 0; axis < 3; axis++ )
+	{
+		float extent = GetAxisValue( centroidMaxs, axis ) - GetAxisValue( centroidMins, axis );
+		if ( extent > longestExtent )
+		{
+			longestExtent = extent;
+			splitAxis	  = axis;
+		}
+	}
+
+	// every centroid in the same spot, splitting would not separate anything
+	if ( longestExtent <= 0.f )
+	{
+		return nodeIndex;
+	}
+
+	int						   numLeftObstacles = numObstacles / 2;
+	std::vector<int>::iterator first			= m_obstacleIndices.begin() + firstObstacle;
+	std::nth_element( first, first + numLeftObstacles, first + numObstacles, [ &obstacleAABBs, splitAxis ]( int a, int b )
+		{ return GetCentroidOnAxis( obstacleAABBs[ a ], splitAxis ) < GetCentroidOnAxis( obstacleAABBs[ b ], splitAxis ); } );
+
+	int leftChild  = BuildNode( obstacleAABBs, firstObstacle, numLeftObstacles, depth + 1 );
+	int rightChild = BuildNode( obstacleAABBs, firstObstacle + numLeftObstacles, numObstacles - numLeftObstacles, depth + 1 );
+
+	// children push onto the node array, so the node is looked up again rather than held by reference
+	MapObstacleBVHNode& node = m_nodes[ nodeIndex ];
+	node.m_leftChild		 = leftChild;
+	node.m_rightChild		 = rightChild;
+	node.m_splitAxis		 = splitAxis;
+
+	return nodeIndex;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void MapObstacleBVH::Clear()
+{
+	m_nodes.clear();
+	m_obstacleIndices.clear();
+	m_leafBoxes.clear();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool MapObstacleBVH::IsEmpty() const
+{
+	return m_nodes.empty();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void MapObstacleBVH::Raycast( MapRaycastQuery const* queries, int numQueries, MapRaycastHit* out_hits ) const
+{
+	for ( int firstQuery = 0; firstQuery < numQueries; firstQuery += MAP_RAY_PACKET_SIZE )
+	{
+		int packetSize = ( numQueries - firstQuery < MAP_RAY_PACKET_SIZE ) ? numQueries - firstQuery : MAP_RAY_PACKET_SIZE;
+		RaycastPacket( queries + firstQuery, packetSize, out_hits + firstQuery );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+RaycastResult3D MapObstacleBVH::RaycastClosest( Vec3 const& startPos, Vec3 const& fwdNormal, float maxLength, int& out_obstacleIndex ) const
+{
+	MapRaycastQuery query;
+	query.m_startPos  = startPos;
+	query.m_fwdNormal = fwdNormal;
+	query.m_maxLength = maxLength;
+
+	MapRaycastHit hit;
+	RaycastPacket( &query, 1, &hit );
+	out_obstacleIndex = hit.m_obstacleIndex;
+	return hit.m_result;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+RaycastResult3D MapObstacleBVH::RaycastAny( Vec3 const& startPos, Vec3 const& fwdNormal, float maxLength, int& out_obstacleIndex ) const
+{
+	MapRaycastQuery query;
+	query.m_startPos	   = startPos;
+	query.m_fwdNormal	   = fwdNormal;
+	query.m_maxLength	   = maxLength;
+	query.m_isAnyHitEnough = true;
+
+	MapRaycastHit hit;
+	RaycastPacket( &query, 1, &hit );
+	out_obstacleIndex = hit.m_obstacleIndex;
+	return hit.m_result;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// unused lanes and lanes that already have their answer carry a negative best distance, so they fail every slab
+// test and the walk ends early once no lane is still searching
+void MapObstacleBVH::RaycastPacket( MapRaycastQuery const* queries, int numQueries, MapRaycastHit* out_hits ) const
+{
+	float startX[ MAP_RAY_PACKET_SIZE ]	  = {};
+	float startY[ MAP_RAY_PACKET_SIZE ]	  = {};
+	float startZ[ MAP_RAY_PACKET_SIZE ]	  = {};
+	float inverseX[ MAP_RAY_PACKET_SIZE ] = {};
+	float inverseY[ MAP_RAY_PACKET_SIZE ] = {};
+	float inverseZ[ MAP_RAY_PACKET_SIZE ] = {};
+	float bestDist[ MAP_RAY_PACKET_SIZE ] = { -1.f, -1.f, -1.f, -1.f };
+	for ( int lane = 0; lane < numQueries; lane++ )
+	{
+		MapRaycastQuery const& query = queries[ lane ];
+		startX[ lane ]				 = query.m_startPos.x;
+		startY[ lane ]				 = query.m_startPos.y;
+		startZ[ lane ]				 = query.m_startPos.z;
+		inverseX[ lane ]			 = GetSafeInverse( query.m_fwdNormal.x );
+		inverseY[ lane ]			 = GetSafeInverse( query.m_fwdNormal.y );
+		inverseZ[ lane ]			 = GetSafeInverse( query.m_fwdNormal.z );
+		bestDist[ lane ]			 = query.m_maxLength;
+
+		InitRaycastMiss( query, out_hits[ lane ] );
+	}
+
+	if ( IsEmpty() )
+	{
+		return;
+	}
+
+	MapRayPacket packet;
+	packet.m_startX	  = _mm_loadu_ps( startX );
+	packet.m_startY	  = _mm_loadu_ps( startY );
+	packet.m_startZ	  = _mm_loadu_ps( startZ );
+	packet.m_inverseX = _mm_loadu_ps( inverseX );
+	packet.m_inverseY = _mm_loadu_ps( inverseY );
+	packet.m_inverseZ = _mm_loadu_ps( inverseZ );
+
+	__m128 bestDistLanes = _mm_loadu_ps( bestDist );
+
+	int nodeStack[ MAP_BVH_MAX_STACK_DEPTH ];
+	int stackSize			 = 0;
+	nodeStack[ stackSize++ ] = 0;
+	while ( stackSize > 0 )
+	{
+		MapObstacleBVHNode const& node = m_nodes[ nodeStack[ --stackSize ] ];
+
+		__m128 entryDist;
+		if ( GetPacketHitMaskVsBox( packet, node.m_bounds, bestDistLanes, entryDist ) == 0 )
+		{
+			continue;
+		}
+
+		if ( node.m_leftChild >= 0 )
+		{
+			// the first ray picks which child is walked first, the probes in a packet point roughly the same way
+			bool isLeftNearer		 = GetAxisValue( queries[ 0 ].m_fwdNormal, node.m_splitAxis ) >= 0.f;
+			nodeStack[ stackSize++ ] = isLeftNearer ? node.m_rightChild : node.m_leftChild;
+			nodeStack[ stackSize++ ] = isLeftNearer ? node.m_leftChild : node.m_rightChild;
+			continue;
+		}
+
+		for ( int slot = node.m_firstObstacle; slot < node.m_firstObstacle + node.m_numObstacles; slot++ )
+		{
+			int hitMask = GetPacketHitMaskVsBox( packet, m_leafBoxes[ slot ], bestDistLanes, entryDist );
+			if ( hitMask == 0 )
+			{
+				continue;
+			}
+
+			float entryDistLanes[ MAP_RAY_PACKET_SIZE ];
+			_mm_storeu_ps( entryDistLanes, entryDist );
+			for ( int lane = 0; lane < numQueries; lane++ )
+			{
+				if ( ( hitMask & ( 1 << lane ) ) == 0 )
+				{
+					continue;
+				}
+
+				MapRaycastQuery const& query = queries[ lane ];
+				MapRaycastHit&		   hit	 = out_hits[ lane ];
+				hit.m_result.m_didImpact	 = true;
+				hit.m_result.m_impactDist	 = entryDistLanes[ lane ];
+				hit.m_result.m_impactPos	 = query.m_startPos + query.m_fwdNormal * entryDistLanes[ lane ];
+				hit.m_result.m_impactNormal	 = GetEntryNormalVsBox( query.m_startPos, query.m_fwdNormal, m_leafBoxes[ slot ] );
+				hit.m_obstacleIndex			 = m_obstacleIndices[ slot ];
+				bestDist[ lane ]			 = query.m_isAnyHitEnough ? -1.f : entryDistLanes[ lane ];
+			}
+			bestDistLanes = _mm_loadu_ps( bestDist );
+		}
+
+		if ( _mm_movemask_ps( _mm_cmpge_ps( bestDistLanes, _mm_setzero_ps() ) ) == 0 )
+		{
+			return;
+		}
+	}
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "Engine/Math/RaycastUtils.hpp"
+#include "Engine/Math/AABB3.hpp"
+#include "Engine/Math/Vec3.hpp"
+
+#include <vector>
+
+class CollisionWorld;
+
+
+//----------------------------------------------------------------------------------------------------------
+constexpr int MAP_BVH_LEAF_SIZE		  = 4;
+constexpr int MAP_BVH_MAX_STACK_DEPTH = 64;
+constexpr int MAP_RAY_PACKET_SIZE	  = 4; // rays tested together, one per sse lane
+
+
+//----------------------------------------------------------------------------------------------------------
+struct MapRaycastQuery
+{
+	Vec3  m_startPos;
+	Vec3  m_fwdNormal;
+	float m_maxLength	   = 0.f;
+	bool  m_isAnyHitEnough = false; // stop at the first obstacle found rather than the closest
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+struct MapRaycastHit
+{
+	RaycastResult3D		  m_result;
+	int					  m_obstacleIndex  = -1;	  // -1 on a miss
+	CollisionWorld const* m_collisionWorld = nullptr; // world the obstacle index belongs to, set by CollisionWorld
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+void InitRaycastMiss( MapRaycastQuery const& query, MapRaycastHit& out_hit );
+
+
+//----------------------------------------------------------------------------------------------------------
+// internal nodes split their obstacles at the median centroid along the longest axis, leaves hold a run of
+// m_obstacleIndices; bounds always enclose every obstacle below the node
+struct MapObstacleBVHNode
+{
+	AABB3 m_bounds;
+	int	  m_leftChild	  = -1; // -1 for a leaf
+	int	  m_rightChild	  = -1;
+	int	  m_splitAxis	  = 0;
+	int	  m_firstObstacle = 0;
+	int	  m_numObstacles  = 0;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// ray queries against the map obstacles, which are all boxes; rays go down the tree four at a time and every node
+// or obstacle box is one slab test across the whole packet, a node is skipped once no ray in the packet can still
+// hit something closer inside it
+class MapObstacleBVH
+{
+public:
+	void							Build( std::vector<AABB3> const& obstacleAABBs );
+	void							Clear();
+	bool							IsEmpty() const;
+	void							Raycast( MapRaycastQuery const* queries, int numQueries, MapRaycastHit* out_hits ) const;
+	RaycastResult3D					RaycastClosest( Vec3 const& startPos, Vec3 const& fwdNormal, float maxLength, int& out_obstacleIndex ) const;
+	RaycastResult3D					RaycastAny( Vec3 const& startPos, Vec3 const& fwdNormal, float maxLength, int& out_obstacleIndex ) const;
+
+	std::vector<MapObstacleBVHNode> m_nodes;
+	std::vector<int>				m_obstacleIndices; // obstacle index of each leaf slot
+	std::vector<AABB3>				m_leafBoxes;	   // obstacle boxes in leaf slot order
+
+protected:
+	int								BuildNode( std::vector<AABB3> const& obstacleAABBs, int firstObstacle, int numObstacles, int depth );
+	void							RaycastPacket( MapRaycastQuery const* queries, int numQueries, MapRaycastHit* out_hits ) const;
+};
@@ -0,0 +1,269 @@
+#include "Game/MapRegionFile.hpp"
+#include "Game/MapLedgeIndex.hpp"
+#include "Game/AnimAssetArchive.hpp"
+
+#include "Engine/Core/ErrorWarningAssert.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <math.h>
+
+
+//----------------------------------------------------------------------------------------------------------
+constexpr size_t MAP_REGION_FILE_HEADER_BYTES = 16;
+constexpr size_t MAP_REGION_FILE_ENTRY_BYTES  = 24;
+constexpr size_t MAP_REGION_FILE_BOX_BYTES	  = 6 * sizeof( float );
+constexpr size_t MAP_REGION_FILE_LEDGE_BYTES  = 11 * sizeof( float ) + sizeof( int32_t ) + 2 * sizeof( uint8_t );
+
+
+//----------------------------------------------------------------------------------------------------------
+// layout: header | region table | one block of boxes then ledges per region, in table order
+bool MapRegionFile::Write( std::string const& filePath, std::vector<AABB3> const& obstacleAABBs, float regionSize )
+{
+	if ( regionSize <= 0.f )
+	{
+		DebuggerPrintf( "Error: Map region size must be positive\n" );
+		return false;
+	}
+
+	// ordered so the same obstacles always write the same file
+	std::map<uint64_t, std::vector<int>> regionObstacles;
+	for ( int obstacleIndex = 0; obstacleIndex < ( int ) obstacleAABBs.size(); obstacleIndex++ )
+	{
+		AABB3 const& box	 = obstacleAABBs[ obstacleIndex ];
+		int			 minX	 = ( int ) floorf( ( box.m_mins.x - MAP_LEDGE_HAND_CLEARANCE ) / regionSize );
+		int			 minY	 = ( int ) floorf( ( box.m_mins.y - MAP_LEDGE_HAND_CLEARANCE ) / regionSize );
+		int			 maxX	 = ( int ) floorf( ( box.m_maxs.x + MAP_LEDGE_HAND_CLEARANCE ) / regionSize );
+		int			 maxY	 = ( int ) floorf( ( box.m_maxs.y + MAP_LEDGE_HAND_CLEARANCE ) / regionSize );
+		for ( int regionY = minY; regionY <= maxY; regionY++ )
+		{
+			for ( int regionX = minX; regionX <= maxX; regionX++ )
+			{
+				regionObstacles[ GetRegionKey( regionX, regionY ) ].push_back( obstacleIndex );
+			}
+		}
+	}
+
+	// the ledges are baked here, boxes within the hand clearance of a region only trim them and are not stored with it
+	std::map<uint64_t, std::vector<AABB3>>	  regionAABBs;
+	std::map<uint64_t, std::vector<MapLedge>> regionLedges;
+	for ( auto const& regionEntry : regionObstacles )
+	{
+		int				   regionX = ( int32_t ) ( uint32_t ) ( regionEntry.first >> 32 );
+		int				   regionY = ( int32_t ) ( uint32_t ) ( regionEntry.first & 0xFFFFFFFF );
+		std::vector<AABB3> inRegionAABBs;
+		std::vector<AABB3> borderAABBs;
+		for ( int obstacleIndex : regionEntry.second )
+		{
+			AABB3 const& box = obstacleAABBs[ obstacleIndex ];
+			if ( IsObstacleInRegion( box, regionX, regionY, regionSize ) )
+			{
+				inRegionAABBs.push_back( box );
+			}
+			else
+			{
+				borderAABBs.push_back( box );
+			}
+		}
+
+		if ( inRegionAABBs.empty() )
+		{
+			continue;
+		}
+
+		MapLedgeIndex ledgeIndex;
+		ledgeIndex.Build( inRegionAABBs, borderAABBs );
+		regionLedges[ regionEntry.first ].swap( ledgeIndex.m_ledges );
+		regionAABBs[ regionEntry.first ].swap( inRegionAABBs );
+	}
+
+	AnimAssetWriteBuffer buffer;
+	buffer.Write( MAP_REGION_FILE_MAGIC );
+	buffer.Write( MAP_REGION_FILE_VERSION );
+	buffer.Write( regionSize );
+	buffer.Write( ( uint32_t ) regionAABBs.size() );
+
+	uint64_t offset = MAP_REGION_FILE_HEADER_BYTES + regionAABBs.size() * MAP_REGION_FILE_ENTRY_BYTES;
+	for ( auto const& regionEntry : regionAABBs )
+	{
+		std::vector<MapLedge> const& ledges = regionLedges[ regionEntry.first ];
+		buffer.Write( ( int32_t ) ( uint32_t ) ( regionEntry.first >> 32 ) );
+		buffer.Write( ( int32_t ) ( uint32_t ) ( regionEntry.first & 0xFFFFFFFF ) );
+		buffer.Write( offset );
+		buffer.Write( ( uint32_t ) regionEntry.second.size() );
+		buffer.Write( ( uint32_t ) ledges.size() );
+		offset += regionEntry.second.size() * MAP_REGION_FILE_BOX_BYTES + ledges.size() * MAP_REGION_FILE_LEDGE_BYTES;
+	}
+
+	for ( auto const& regionEntry : regionAABBs )
+	{
+		for ( AABB3 const& box : regionEntry.second )
+		{
+			float values[ 6 ] = { box.m_mins.x, box.m_mins.y, box.m_mins.z, box.m_maxs.x, box.m_maxs.y, box.m_maxs.z };
+			buffer.WriteBytes( values, sizeof( values ) );
+		}
+
+		for ( MapLedge const& ledge : regionLedges[ regionEntry.first ] )
+		{
+			float values[ 11 ] = { ledge.m_start.x, ledge.m_start.y, ledge.m_start.z, ledge.m_end.x, ledge.m_end.y, ledge.m_end.z, ledge.m_outwardNormal.x,
+				ledge.m_outwardNormal.y, ledge.m_outwardNormal.z, ledge.m_height, ledge.m_depth };
+			buffer.WriteBytes( values, sizeof( values ) );
+			buffer.Write( ( int32_t ) ledge.m_obstacleIndex );
+			buffer.Write( ( uint8_t ) ledge.m_isGrabbable );
+			buffer.Write( ( uint8_t ) ledge.m_isVaultable );
+		}
+	}
+
+	FILE* file = nullptr;
+	if ( fopen_s( &file, filePath.c_str(), "wb" ) != 0 || !file )
+	{
+		DebuggerPrintf( "Error: Unable to open map region file for writing: %s\n", filePath.c_str() );
+		return false;
+	}
+
+	fwrite( buffer.m_bytes.data(), 1, buffer.m_bytes.size(), file );
+	fclose( file );
+
+	return true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+uint64_t MapRegionFile::GetRegionKey( int regionX, int regionY )
+{
+	return ( ( uint64_t ) ( uint32_t ) regionX << 32 ) | ( uint64_t ) ( uint32_t ) regionY;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// the box itself touches the region, rather than only standing within the hand clearance of it
+bool MapRegionFile::IsObstacleInRegion( AABB3 const& box, int regionX, int regionY, float regionSize )
+{
+	int minX = ( int ) floorf( box.m_mins.x / regionSize );
+	int minY = ( int ) floorf( box.m_mins.y / regionSize );
+	int maxX = ( int ) floorf( box.m_maxs.x / regionSize );
+	int maxY = ( int ) floorf( box.m_maxs.y / regionSize );
+
+	return regionX >= minX && regionX <= maxX && regionY >= minY && regionY <= maxY;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// only the region table is read here, obstacle blocks are read per region as they stream in
+bool MapRegionFile::Open( std::string const& filePath )
+{
+	m_regions.clear();
+	m_filePath = filePath;
+
+	FILE* file = nullptr;
+	if ( fopen_s( &file, filePath.c_str(), "rb" ) != 0 || !file )
+	{
+		DebuggerPrintf( "Error: Unable to open map region file: %s\n", filePath.c_str() );
+		return false;
+	}
+
+	std::vector<uint8_t> headerBytes( MAP_REGION_FILE_HEADER_BYTES );
+	bool				 isHeaderRead = fread( headerBytes.data(), 1, headerBytes.size(), file ) == headerBytes.size();
+	AnimAssetReadBuffer	 header( headerBytes );
+	uint32_t			 magic		  = header.Read<uint32_t>();
+	uint32_t			 version	  = header.Read<uint32_t>();
+	float				 regionSize	  = header.Read<float>();
+	uint32_t			 numRegions	  = header.Read<uint32_t>();
+	if ( !isHeaderRead || magic != MAP_REGION_FILE_MAGIC || version != MAP_REGION_FILE_VERSION || regionSize <= 0.f )
+	{
+		DebuggerPrintf( "Error: %s is not a map region file of version %u\n", filePath.c_str(), MAP_REGION_FILE_VERSION );
+		fclose( file );
+		return false;
+	}
+	m_regionSize = regionSize;
+
+	std::vector<uint8_t> tableBytes( numRegions * MAP_REGION_FILE_ENTRY_BYTES );
+	bool				 isTableRead = fread( tableBytes.data(), 1, tableBytes.size(), file ) == tableBytes.size();
+	fclose( file );
+
+	AnimAssetReadBuffer table( tableBytes );
+	m_regions.reserve( numRegions );
+	for ( uint32_t regionIndex = 0; regionIndex < numRegions && isTableRead; regionIndex++ )
+	{
+		MapRegionFileEntry entry;
+		entry.m_regionX		 = table.Read<int32_t>();
+		entry.m_regionY		 = table.Read<int32_t>();
+		entry.m_offset		 = table.Read<uint64_t>();
+		entry.m_numObstacles = table.Read<uint32_t>();
+		entry.m_numLedges	 = table.Read<uint32_t>();
+
+		m_regions[ GetRegionKey( entry.m_regionX, entry.m_regionY ) ] = entry;
+	}
+
+	if ( !isTableRead || !table.m_isValid )
+	{
+		DebuggerPrintf( "Error: Map region table is truncated: %s\n", filePath.c_str() );
+		m_regions.clear();
+		return false;
+	}
+
+	return true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+MapRegionFileEntry const* MapRegionFile::FindRegion( int regionX, int regionY ) const
+{
+	auto regionIter = m_regions.find( GetRegionKey( regionX, regionY ) );
+	if ( regionIter == m_regions.cend() )
+	{
+		return nullptr;
+	}
+
+	return &regionIter->second;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// opens its own handle so several regions can load on job threads at once
+bool MapRegionFile::ReadRegion( std::string const& filePath, MapRegionFileEntry const& entry, std::vector<AABB3>& out_obstacleAABBs, std::vector<MapLedge>& out_ledges )
+{
+	FILE* file = nullptr;
+	if ( fopen_s( &file, filePath.c_str(), "rb" ) != 0 || !file )
+	{
+		return false;
+	}
+
+	std::vector<uint8_t> blockBytes( entry.m_numObstacles * MAP_REGION_FILE_BOX_BYTES + entry.m_numLedges * MAP_REGION_FILE_LEDGE_BYTES );
+	_fseeki64( file, ( int64_t ) entry.m_offset, SEEK_SET );
+	bool isRead = fread( blockBytes.data(), 1, blockBytes.size(), file ) == blockBytes.size();
+	fclose( file );
+	if ( !isRead )
+	{
+		return false;
+	}
+
+	AnimAssetReadBuffer block( blockBytes );
+	out_obstacleAABBs.resize( entry.m_numObstacles );
+	for ( uint32_t obstacleIndex = 0; obstacleIndex < entry.m_numObstacles; obstacleIndex++ )
+	{
+		float values[ 6 ];
+		block.ReadBytes( values, sizeof( values ) );
+		out_obstacleAABBs[ obstacleIndex ] = AABB3( Vec3( values[ 0 ], values[ 1 ], values[ 2 ] ), Vec3( values[ 3 ], values[ 4 ], values[ 5 ] ) );
+	}
+
+	out_ledges.resize( entry.m_numLedges );
+	for ( uint32_t ledgeIndex = 0; ledgeIndex < entry.m_numLedges; ledgeIndex++ )
+	{
+		float values[ 11 ];
+		block.ReadBytes( values, sizeof( values ) );
+
+		MapLedge& ledge		  = out_ledges[ ledgeIndex ];
+		ledge.m_start		  = Vec3( values[ 0 ], values[ 1 ], values[ 2 ] );
+		ledge.m_end			  = Vec3( values[ 3 ], values[ 4 ], values[ 5 ] );
+		ledge.m_outwardNormal = Vec3( values[ 6 ], values[ 7 ], values[ 8 ] );
+		ledge.m_height		  = values[ 9 ];
+		ledge.m_depth		  = values[ 10 ];
+		ledge.m_obstacleIndex = block.Read<int32_t>();
+		ledge.m_isGrabbable	  = block.Read<uint8_t>() != 0;
+		ledge.m_isVaultable	  = block.Read<uint8_t>() != 0;
+	}
+
+	return block.m_isValid;
+}
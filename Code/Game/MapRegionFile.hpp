@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Game/MapLedgeIndex.hpp"
+
+#include "Engine/Math/AABB3.hpp"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+//----------------------------------------------------------------------------------------------------------
+constexpr uint32_t MAP_REGION_FILE_MAGIC   = 0x5250414D; // "MAPR"
+constexpr uint32_t MAP_REGION_FILE_VERSION = 3;
+
+
+//----------------------------------------------------------------------------------------------------------
+struct MapRegionFileEntry
+{
+	int		 m_regionX		= 0;
+	int		 m_regionY		= 0;
+	uint64_t m_offset		= 0;
+	uint32_t m_numObstacles = 0;
+	uint32_t m_numLedges	= 0;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// obstacles bucketed into square columns of m_regionSize on x and y, each region's boxes and the ledges baked from
+// them stored as one block so a region loads with a single seek and read; an obstacle that crosses a region border is
+// stored in every region it touches, and the ledges are extracted when the file is written, trimmed against flush
+// neighbours on the other side of the border, so streaming a region in never extracts ledges
+class MapRegionFile
+{
+public:
+	static bool										   Write( std::string const& filePath, std::vector<AABB3> const& obstacleAABBs, float regionSize );
+	static uint64_t									   GetRegionKey( int regionX, int regionY );
+	static bool										   IsObstacleInRegion( AABB3 const& box, int regionX, int regionY, float regionSize );
+	static bool										   ReadRegion( std::string const& filePath, MapRegionFileEntry const& entry, std::vector<AABB3>& out_obstacleAABBs,
+												   std::vector<MapLedge>& out_ledges );
+
+	bool											   Open( std::string const& filePath );
+	MapRegionFileEntry const*						   FindRegion( int regionX, int regionY ) const;
+
+	std::string										   m_filePath	= "";
+	float											   m_regionSize = 0.f;
+	std::unordered_map<uint64_t, MapRegionFileEntry> m_regions;
+};
@@ -0,0 +1,332 @@
+#include "Game/MapRegionGrid.hpp"
+#include "Game/GameCommon.hpp"
+
+#include "Engine/Core/ErrorWarningAssert.hpp"
+
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+
+
+//----------------------------------------------------------------------------------------------------------
+void JobLoadMapRegion::Execute()
+{
+	std::vector<MapLedge> bakedLedges;
+	if ( !MapRegionFile::ReadRegion( m_filePath, m_entry, m_obstacleAABBs, bakedLedges ) )
+	{
+		m_isFinishedOrOrphaned = true;
+		return;
+	}
+
+	m_collisionWorld = new CollisionWorld();
+	m_collisionWorld->BuildFromBakedLedges( m_obstacleAABBs, bakedLedges );
+
+	// the grid shut down while this was loading, nobody will collect the world
+	if ( m_isFinishedOrOrphaned.exchange( true ) )
+	{
+		delete m_collisionWorld;
+		m_collisionWorld = nullptr;
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool MapRegionGrid::Startup( std::string const& filePath, float streamingRadius )
+{
+	m_streamingRadius = streamingRadius;
+	return m_regionFile.Open( filePath );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// the job system may already be shut down, so loads still in flight are never waited on: whichever of the worker and
+// the grid gets to a job second frees its collision world, the job objects stay with the job system
+void MapRegionGrid::Shutdown()
+{
+	for ( JobLoadMapRegion* inFlightJob : m_inFlightJobs )
+	{
+		if ( inFlightJob->m_isFinishedOrOrphaned.exchange( true ) )
+		{
+			delete inFlightJob->m_collisionWorld;
+			inFlightJob->m_collisionWorld = nullptr;
+		}
+	}
+
+	for ( auto& regionEntry : m_regions )
+	{
+		delete regionEntry.second.m_collisionWorld;
+	}
+	m_regions.clear();
+	m_inFlightJobs.clear();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// queries must not run on other threads during this call, it is the only place regions are added or removed
+void MapRegionGrid::Update( std::vector<Vec3> const& focusPositions, std::vector<Job*> const& completedJobs )
+{
+	ApplyCompletedJobs( completedJobs );
+	EvictDistantRegions( focusPositions );
+	RequestNearbyRegions( focusPositions );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+MapRegion const* MapRegionGrid::FindRegionAt( Vec3 const& position ) const
+{
+	int	 regionX	= ( int ) floorf( position.x / m_regionFile.m_regionSize );
+	int	 regionY	= ( int ) floorf( position.y / m_regionFile.m_regionSize );
+	auto regionIter = m_regions.find( MapRegionFile::GetRegionKey( regionX, regionY ) );
+	if ( regionIter == m_regions.cend() )
+	{
+		return nullptr;
+	}
+
+	return &regionIter->second;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void MapRegionGrid::Raycast( MapRaycastQuery const* queries, int numQueries, MapRaycastHit* out_hits ) const
+{
+	for ( int firstQuery = 0; firstQuery < numQueries; firstQuery += MAP_REGION_RAYCAST_CHUNK )
+	{
+		int chunkSize = std::min( numQueries - firstQuery, MAP_REGION_RAYCAST_CHUNK );
+		RaycastChunk( queries + firstQuery, chunkSize, out_hits + firstQuery );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// every resident region under the chunk's rays gets the whole chunk as one batch and the closest hit per ray wins,
+// a chunk is normally one character's probes and spans a region or two
+void MapRegionGrid::RaycastChunk( MapRaycastQuery const* queries, int numQueries, MapRaycastHit* out_hits ) const
+{
+	float minX = FLT_MAX;
+	float minY = FLT_MAX;
+	float maxX = -FLT_MAX;
+	float maxY = -FLT_MAX;
+	for ( int queryIndex = 0; queryIndex < numQueries; queryIndex++ )
+	{
+		MapRaycastQuery const& query  = queries[ queryIndex ];
+		Vec3				   endPos = query.m_startPos + query.m_fwdNormal * query.m_maxLength;
+		minX						  = std::min( minX, std::min( query.m_startPos.x, endPos.x ) );
+		minY						  = std::min( minY, std::min( query.m_startPos.y, endPos.y ) );
+		maxX						  = std::max( maxX, std::max( query.m_startPos.x, endPos.x ) );
+		maxY						  = std::max( maxY, std::max( query.m_startPos.y, endPos.y ) );
+
+		InitRaycastMiss( query, out_hits[ queryIndex ] );
+	}
+
+	int minRegionX = ( int ) floorf( minX / m_regionFile.m_regionSize );
+	int minRegionY = ( int ) floorf( minY / m_regionFile.m_regionSize );
+	int maxRegionX = ( int ) floorf( maxX / m_regionFile.m_regionSize );
+	int maxRegionY = ( int ) floorf( maxY / m_regionFile.m_regionSize );
+
+	MapRaycastHit regionHits[ MAP_REGION_RAYCAST_CHUNK ];
+	for ( auto const& regionEntry : m_regions )
+	{
+		MapRegion const& region = regionEntry.second;
+		if ( !region.m_collisionWorld || region.m_regionX < minRegionX || region.m_regionX > maxRegionX || region.m_regionY < minRegionY ||
+			 region.m_regionY > maxRegionY )
+		{
+			continue;
+		}
+
+		region.m_collisionWorld->Raycast( queries, numQueries, regionHits );
+		for ( int queryIndex = 0; queryIndex < numQueries; queryIndex++ )
+		{
+			MapRaycastHit const& regionHit = regionHits[ queryIndex ];
+			MapRaycastHit&		 bestHit   = out_hits[ queryIndex ];
+			if ( regionHit.m_result.m_didImpact && ( !bestHit.m_result.m_didImpact || regionHit.m_result.m_impactDist < bestHit.m_result.m_impactDist ) )
+			{
+				bestHit = regionHit;
+			}
+		}
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// every region extracts ledges from its own boxes, trimmed against the boxes just across its border as well;
+// reach is far smaller than a region, a query asks at most four of them
+bool MapRegionGrid::FindNearestLedge( MapLedgeQuery const& query, MapLedgeHit& out_hit ) const
+{
+	out_hit			  = MapLedgeHit();
+	float maxDistance = query.m_distanceRange.m_max;
+	int	  minRegionX  = ( int ) floorf( ( query.m_position.x - maxDistance ) / m_regionFile.m_regionSize );
+	int	  minRegionY  = ( int ) floorf( ( query.m_position.y - maxDistance ) / m_regionFile.m_regionSize );
+	int	  maxRegionX  = ( int ) floorf( ( query.m_position.x + maxDistance ) / m_regionFile.m_regionSize );
+	int	  maxRegionY  = ( int ) floorf( ( query.m_position.y + maxDistance ) / m_regionFile.m_regionSize );
+	for ( int regionY = minRegionY; regionY <= maxRegionY; regionY++ )
+	{
+		for ( int regionX = minRegionX; regionX <= maxRegionX; regionX++ )
+		{
+			auto regionIter = m_regions.find( MapRegionFile::GetRegionKey( regionX, regionY ) );
+			if ( regionIter == m_regions.cend() || !regionIter->second.m_collisionWorld )
+			{
+				continue;
+			}
+
+			MapLedgeHit regionHit;
+			if ( regionIter->second.m_collisionWorld->FindNearestLedge( query, regionHit ) && ( out_hit.m_ledgeIndex < 0 || regionHit.m_distance < out_hit.m_distance ) )
+			{
+				out_hit = regionHit;
+			}
+		}
+	}
+
+	return out_hit.m_ledgeIndex >= 0;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+int MapRegionGrid::GetNumResidentRegions() const
+{
+	int numResidentRegions = 0;
+	for ( auto const& regionEntry : m_regions )
+	{
+		if ( regionEntry.second.m_collisionWorld )
+		{
+			numResidentRegions++;
+		}
+	}
+
+	return numResidentRegions;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void MapRegionGrid::ApplyCompletedJobs( std::vector<Job*> const& completedJobs )
+{
+	for ( Job* completedJob : completedJobs )
+	{
+		JobLoadMapRegion* regionJob	   = dynamic_cast<JobLoadMapRegion*>( completedJob );
+		auto			  inFlightIter = std::find( m_inFlightJobs.begin(), m_inFlightJobs.end(), regionJob );
+		if ( !regionJob || inFlightIter == m_inFlightJobs.end() )
+		{
+			continue;
+		}
+		m_inFlightJobs.erase( inFlightIter );
+
+		MapRegion& region = m_regions[ MapRegionFile::GetRegionKey( regionJob->m_entry.m_regionX, regionJob->m_entry.m_regionY ) ];
+		if ( regionJob->m_collisionWorld )
+		{
+			region.m_collisionWorld = regionJob->m_collisionWorld;
+			region.m_obstacleAABBs.swap( regionJob->m_obstacleAABBs );
+		}
+		else
+		{
+			// an empty world keeps a bad region from being requested again every frame
+			DebuggerPrintf( "Error: Unable to read map region %d, %d from %s\n", region.m_regionX, region.m_regionY, m_regionFile.m_filePath.c_str() );
+			region.m_collisionWorld = new CollisionWorld();
+		}
+
+		delete regionJob;
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// half a region past the streaming radius, so a character walking along a region border does not reload it
+// every few steps
+void MapRegionGrid::EvictDistantRegions( std::vector<Vec3> const& focusPositions )
+{
+	float evictionRadius = m_streamingRadius + m_regionFile.m_regionSize * 0.5f;
+	for ( auto regionIter = m_regions.begin(); regionIter != m_regions.end(); )
+	{
+		MapRegion& region	= regionIter->second;
+		bool	   isNeeded = !region.m_collisionWorld;
+		for ( Vec3 const& focusPosition : focusPositions )
+		{
+			if ( isNeeded )
+			{
+				break;
+			}
+			isNeeded = GetDistanceToRegion( region.m_regionX, region.m_regionY, focusPosition ) <= evictionRadius;
+		}
+
+		if ( isNeeded )
+		{
+			++regionIter;
+			continue;
+		}
+
+		delete region.m_collisionWorld;
+		regionIter = m_regions.erase( regionIter );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// the nearest missing regions are posted first, anything past the in-flight limit is asked for again next frame
+void MapRegionGrid::RequestNearbyRegions( std::vector<Vec3> const& focusPositions )
+{
+	int numFreeSlots = MAP_REGION_MAX_LOADS_IN_FLIGHT - ( int ) m_inFlightJobs.size();
+	if ( numFreeSlots <= 0 )
+	{
+		return;
+	}
+
+	std::vector<std::pair<float, MapRegionFileEntry const*>> missingRegions;
+	for ( Vec3 const& focusPosition : focusPositions )
+	{
+		int minRegionX = ( int ) floorf( ( focusPosition.x - m_streamingRadius ) / m_regionFile.m_regionSize );
+		int minRegionY = ( int ) floorf( ( focusPosition.y - m_streamingRadius ) / m_regionFile.m_regionSize );
+		int maxRegionX = ( int ) floorf( ( focusPosition.x + m_streamingRadius ) / m_regionFile.m_regionSize );
+		int maxRegionY = ( int ) floorf( ( focusPosition.y + m_streamingRadius ) / m_regionFile.m_regionSize );
+		for ( int regionY = minRegionY; regionY <= maxRegionY; regionY++ )
+		{
+			for ( int regionX = minRegionX; regionX <= maxRegionX; regionX++ )
+			{
+				MapRegionFileEntry const* entry = m_regionFile.FindRegion( regionX, regionY );
+				if ( !entry || m_regions.find( MapRegionFile::GetRegionKey( regionX, regionY ) ) != m_regions.end() )
+				{
+					continue;
+				}
+
+				float distance = GetDistanceToRegion( regionX, regionY, focusPosition );
+				if ( distance <= m_streamingRadius )
+				{
+					missingRegions.push_back( std::make_pair( distance, entry ) );
+				}
+			}
+		}
+	}
+
+	std::sort( missingRegions.begin(), missingRegions.end(), []( std::pair<float, MapRegionFileEntry const*> const& a, std::pair<float, MapRegionFileEntry const*> const& b )
+		{ return a.first < b.first; } );
+
+	for ( size_t missingIndex = 0; missingIndex < missingRegions.size() && numFreeSlots > 0; missingIndex++ )
+	{
+		MapRegionFileEntry const& entry = *missingRegions[ missingIndex ].second;
+		uint64_t				  key	= MapRegionFile::GetRegionKey( entry.m_regionX, entry.m_regionY );
+		if ( m_regions.find( key ) != m_regions.end() )
+		{
+			// two focus positions asked for the same region
+			continue;
+		}
+
+		MapRegion& region = m_regions[ key ];
+		region.m_regionX  = entry.m_regionX;
+		region.m_regionY  = entry.m_regionY;
+
+		JobLoadMapRegion* loadJob = new JobLoadMapRegion( m_regionFile.m_filePath, entry );
+		m_inFlightJobs.push_back( loadJob );
+		g_theJobSystem->PostNewJob( loadJob );
+		numFreeSlots--;
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+float MapRegionGrid::GetDistanceToRegion( int regionX, int regionY, Vec3 const& position ) const
+{
+	float regionSize = m_regionFile.m_regionSize;
+	float minX		 = ( float ) regionX * regionSize;
+	float minY		 = ( float ) regionY * regionSize;
+	float deltaX	 = std::max( 0.f, std::max( minX - position.x, position.x - ( minX + regionSize ) ) );
+	float deltaY	 = std::max( 0.f, std::max( minY - position.y, position.y - ( minY + regionSize ) ) );
+
+	return sqrtf( deltaX * deltaX + deltaY * deltaY );
+}
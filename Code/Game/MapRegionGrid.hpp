@@ -0,0 +1,80 @@
+#pragma once
+
+#include "Game/MapRegionFile.hpp"
+#include "Game/CollisionWorld.hpp"
+
+#include "Engine/Core/JobSystem.hpp"
+
+#include <atomic>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+//----------------------------------------------------------------------------------------------------------
+constexpr int MAP_REGION_MAX_LOADS_IN_FLIGHT = 4;
+constexpr int MAP_REGION_RAYCAST_CHUNK		 = 16;
+
+
+//----------------------------------------------------------------------------------------------------------
+// reads one region's boxes and baked ledges and builds its collision world on a job thread, handed back through
+// MapRegionGrid::Update with the other completed jobs
+struct JobLoadMapRegion : public Job
+{
+	std::string		   m_filePath = "";
+	MapRegionFileEntry m_entry;
+	std::vector<AABB3> m_obstacleAABBs;
+	CollisionWorld*	   m_collisionWorld = nullptr;
+
+	// set by whichever of the worker and a shutting down grid gets to the job first
+	std::atomic<bool>  m_isFinishedOrOrphaned = { false };
+
+	JobLoadMapRegion( std::string const& filePath, MapRegionFileEntry const& entry )
+		: m_filePath( filePath ), m_entry( entry )
+	{
+		m_type = JobType::DISK_IO;
+	}
+
+	virtual ~JobLoadMapRegion() override {}
+
+	virtual void Execute() override;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+struct MapRegion
+{
+	int				   m_regionX		= 0;
+	int				   m_regionY		= 0;
+	CollisionWorld*	   m_collisionWorld = nullptr; // null while the region is still loading
+	std::vector<AABB3> m_obstacleAABBs;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// sparse grid of square regions over a map file, only the regions within m_streamingRadius of a focus position
+// stay resident; finding the region under a point is one hash lookup, and every resident region keeps its own
+// collision world so a query only touches the regions its rays cross
+class MapRegionGrid
+{
+public:
+	bool									 Startup( std::string const& filePath, float streamingRadius );
+	void									 Shutdown();
+	void									 Update( std::vector<Vec3> const& focusPositions, std::vector<Job*> const& completedJobs );
+	MapRegion const*						 FindRegionAt( Vec3 const& position ) const;
+	void									 Raycast( MapRaycastQuery const* queries, int numQueries, MapRaycastHit* out_hits ) const;
+	bool									 FindNearestLedge( MapLedgeQuery const& query, MapLedgeHit& out_hit ) const;
+	int										 GetNumResidentRegions() const;
+
+	MapRegionFile							 m_regionFile;
+	float									 m_streamingRadius = 96.f;
+	std::unordered_map<uint64_t, MapRegion> m_regions; // resident and loading
+	std::vector<JobLoadMapRegion*>			 m_inFlightJobs;
+
+protected:
+	void									 ApplyCompletedJobs( std::vector<Job*> const& completedJobs );
+	void									 EvictDistantRegions( std::vector<Vec3> const& focusPositions );
+	void									 RequestNearbyRegions( std::vector<Vec3> const& focusPositions );
+	float									 GetDistanceToRegion( int regionX, int regionY, Vec3 const& position ) const;
+	void									 RaycastChunk( MapRaycastQuery const* queries, int numQueries, MapRaycastHit* out_hits ) const;
+};
@@ -0,0 +1,141 @@
+#include "Game/MotionMatcher.hpp"
+#include "Game/AnimationController.hpp"
+#include "Game/AnimationState.hpp"
+#include "Game/GameCommon.hpp"
+
+#include "Engine/Core/ErrorWarningAssert.hpp"
+
+#include <math.h>
+#include <string>
+
+
+//----------------------------------------------------------------------------------------------------------
+bool MotionMatcher::Startup()
+{
+	std::string stateNames = g_gameConfigGlackboard.GetValue( "motionMatchingStates", std::string( "idle,walk,run" ) );
+	m_isKdTreeEnabled	   = g_gameConfigGlackboard.GetValue( "motionMatchingKdTree", true );
+	m_searchIntervalFrames = g_gameConfigGlackboard.GetValue( "motionMatchingSearchInterval", 6 );
+	m_blendDurationMs	   = g_gameConfigGlackboard.GetValue( "motionMatchingBlendMs", 200.f );
+	m_framesUntilSearch	   = 0;
+
+	std::vector<AnimationState*> states;
+	if ( !MotionMatchingDatabase::ParseStateNames( stateNames, states ) || !m_database.BuildFromStates( states ) )
+	{
+		DebuggerPrintf( "Error: Motion matching database is empty, locomotion stays on the movement state machine\n" );
+		return false;
+	}
+
+	m_kdTree.Build( m_database.m_features.data(), m_database.GetNumEntries(), MOTION_MATCHING_FEATURE_STRIDE, MOTION_MATCHING_FEATURE_SIZE );
+	return true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void MotionMatcher::Shutdown()
+{
+	m_kdTree.Clear();
+	m_database.Clear();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool MotionMatcher::IsReady() const
+{
+	return !m_database.IsEmpty();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool MotionMatcher::IsMatchedState( AnimNameId stateId ) const
+{
+	return m_database.FindEntry( stateId, 0.f ) >= 0;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void MotionMatcher::RequestSearch()
+{
+	m_framesUntilSearch = 0;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void MotionMatcher::Update( AnimationController& controller, float currentSpeed, float desiredSpeed )
+{
+	if ( !IsReady() )
+	{
+		return;
+	}
+
+	m_framesUntilSearch--;
+	if ( m_framesUntilSearch > 0 )
+	{
+		return;
+	}
+	m_framesUntilSearch = m_searchIntervalFrames;
+
+	// playback outside the database belongs to the state machine, a parkour move or a transition out of locomotion
+	AnimationState* currentState  = controller.GetCurrentAnimationState();
+	float			currentTimeMs = controller.GetLocalTimeMsOfCurrentAnimation();
+	int				currentEntry  = m_database.FindEntry( currentState->m_nameId, currentTimeMs );
+	if ( currentEntry < 0 )
+	{
+		return;
+	}
+
+	// the pose part of the query is the frame playing now, only the trajectory comes from the input
+	float		 rawQuery[ MOTION_MATCHING_FEATURE_STRIDE ];
+	float const* currentFeatures = m_database.GetRawFeatures( currentEntry );
+	for ( int featureIndex = 0; featureIndex < MOTION_MATCHING_FEATURE_STRIDE; featureIndex++ )
+	{
+		rawQuery[ featureIndex ] = currentFeatures[ featureIndex ];
+	}
+	BuildTrajectory( currentSpeed, desiredSpeed, rawQuery );
+
+	float query[ MOTION_MATCHING_FEATURE_STRIDE ];
+	m_database.NormalizeFeatures( rawQuery, query );
+
+	float bestCost	= 0.f;
+	int	  bestEntry = Search( query, bestCost );
+	if ( bestEntry < 0 )
+	{
+		return;
+	}
+
+	MotionMatchingEntry const& entry = m_database.m_entries[ bestEntry ];
+	if ( entry.m_stateId == currentState->m_nameId && fabsf( entry.m_timeMs - currentTimeMs ) < m_continueWindowMs )
+	{
+		return;
+	}
+
+	controller.PlayStateAtTime( entry.m_stateId, entry.m_timeMs, m_blendDurationMs );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+int MotionMatcher::Search( float const* normalizedQuery, float& out_cost ) const
+{
+	if ( m_isKdTreeEnabled )
+	{
+		return m_kdTree.FindNearest( normalizedQuery, out_cost );
+	}
+
+	return FindNearestBruteForce( m_database.m_features.data(), m_database.GetNumEntries(), MOTION_MATCHING_FEATURE_STRIDE, normalizedQuery, out_cost );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// the speed closes on the requested one exponentially, integrated in closed form to each horizon; locomotion only
+// moves forward for now, so the trajectory has no sideways part
+void MotionMatcher::BuildTrajectory( float currentSpeed, float desiredSpeed, float* out_rawFeatures ) const
+{
+	float decayRate = 0.6931f / ( m_speedHalfLifeMs * 0.001f );
+	for ( int sampleIndex = 0; sampleIndex < MOTION_MATCHING_TRAJECTORY_SAMPLES; sampleIndex++ )
+	{
+		float horizonSeconds	  = MotionMatchingDatabase::GetTrajectoryHorizonMs( sampleIndex ) * 0.001f;
+		float forwardDisplacement = desiredSpeed * horizonSeconds + ( currentSpeed - desiredSpeed ) * ( 1.f - expf( -decayRate * horizonSeconds ) ) / decayRate;
+
+		out_rawFeatures[ MOTION_MATCHING_TRAJECTORY_OFFSET + sampleIndex * 2 + 0 ] = forwardDisplacement;
+		out_rawFeatures[ MOTION_MATCHING_TRAJECTORY_OFFSET + sampleIndex * 2 + 1 ] = 0.f;
+	}
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Game/AnimNameTable.hpp"
+#include "Game/MotionMatchingDatabase.hpp"
+#include "Game/MotionMatchingSearch.hpp"
+
+class AnimationController;
+
+
+//----------------------------------------------------------------------------------------------------------
+// picks the locomotion clip and frame for the player every few frames, in place of the movement state machine's
+// idle, walk and run transitions; the query is the pose playing now with the trajectory the input asks for
+class MotionMatcher
+{
+public:
+	bool				   Startup();
+	void				   Shutdown();
+	bool				   IsReady() const;
+	bool				   IsMatchedState( AnimNameId stateId ) const;
+	void				   RequestSearch();
+	void				   Update( AnimationController& controller, float currentSpeed, float desiredSpeed );
+	int					   Search( float const* normalizedQuery, float& out_cost ) const;
+	void				   BuildTrajectory( float currentSpeed, float desiredSpeed, float* out_rawFeatures ) const;
+
+	MotionMatchingDatabase m_database;
+	MotionMatchingKdTree   m_kdTree;
+	bool				   m_isKdTreeEnabled	  = true;
+	int					   m_searchIntervalFrames = 6;
+	int					   m_framesUntilSearch	  = 0;
+	float				   m_blendDurationMs	  = 200.f;
+	float				   m_continueWindowMs	  = 200.f; // a best frame this close to the one playing lets playback carry on
+	float				   m_speedHalfLifeMs	  = 250.f; // how quickly the predicted speed closes on the requested one
+};
@@ -0,0 +1,189 @@
+#include "Game/MotionMatchingBenchmark.hpp"
+#include "Game/MotionMatchingDatabase.hpp"
+#include "Game/MotionMatchingSearch.hpp"
+#include "Game/AnimationState.hpp"
+#include "Game/AnimAssetArchive.hpp"
+#include "Game/AnimClipResidencyManager.hpp"
+#include "Game/GameCommon.hpp"
+
+#include "Engine/Core/JobSystem.hpp"
+#include "Engine/Core/StringUtils.hpp"
+#include "Engine/Core/ErrorWarningAssert.hpp"
+#include "Engine/Math/RandomNumberGenerator.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <math.h>
+
+
+//----------------------------------------------------------------------------------------------------------
+constexpr float BENCH_REPLICA_JITTER = 0.05f; // normalized units, copies of the database stay distinct rows
+constexpr float BENCH_QUERY_JITTER	 = 0.25f;
+
+
+//----------------------------------------------------------------------------------------------------------
+bool MotionMatchingBenchmark::IsBenchmarkRequested( std::string const& commandLine )
+{
+	return commandLine.find( MOTION_MATCHING_BENCH_COMMAND_LINE_FLAG ) != std::string::npos;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// usage: -mmbench [maxEntries] [numQueries]
+int MotionMatchingBenchmark::RunFromCommandLine( std::string const& commandLine )
+{
+	int maxEntries = 100000;
+	int numQueries = 2000;
+
+	Strings arguments = SplitStringOnDelimiter( commandLine, ' ' );
+	for ( size_t argIndex = 0; argIndex < arguments.size(); argIndex++ )
+	{
+		if ( arguments[ argIndex ] != MOTION_MATCHING_BENCH_COMMAND_LINE_FLAG )
+		{
+			continue;
+		}
+
+		if ( argIndex + 1 < arguments.size() && !arguments[ argIndex + 1 ].empty() )
+		{
+			maxEntries = atoi( arguments[ argIndex + 1 ].c_str() );
+		}
+		if ( argIndex + 2 < arguments.size() && !arguments[ argIndex + 2 ].empty() )
+		{
+			numQueries = atoi( arguments[ argIndex + 2 ].c_str() );
+		}
+	}
+
+	if ( maxEntries <= 0 || numQueries <= 0 )
+	{
+		WriteBenchmarkResults( "Error: Motion matching benchmark needs a positive entry and query count\n", MOTION_MATCHING_BENCH_RESULTS_FILE_PATH );
+		return 1;
+	}
+
+	std::string results;
+	bool		succeeded = RunBenchmark( maxEntries, numQueries, results );
+	succeeded			  = WriteBenchmarkResults( results, MOTION_MATCHING_BENCH_RESULTS_FILE_PATH ) && succeeded;
+	return succeeded ? 0 : 1;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool MotionMatchingBenchmark::RunBenchmark( int maxEntries, int numQueries, std::string& out_results )
+{
+	JobSystemConfig jobSystemConfig;
+	g_theJobSystem = new JobSystem( jobSystemConfig );
+	g_theJobSystem->Startup();
+
+	// cooked archive is optional, same as the app
+	g_theCookedAnimArchive = new AnimAssetArchive();
+	if ( !g_theCookedAnimArchive->OpenForRead( COOKED_ANIM_ARCHIVE_PATH ) )
+	{
+		delete g_theCookedAnimArchive;
+		g_theCookedAnimArchive = nullptr;
+	}
+
+	AnimationState::LoadAnimationStateFromXML( "Data/Animations/AnimConfig.xml" );
+	g_theAnimClipResidencyManager = new AnimClipResidencyManager();
+	g_theAnimClipResidencyManager->Startup( false, 0 );
+
+	std::vector<AnimationState*> states;
+	MotionMatchingDatabase		 database;
+	bool						 isBuilt	   = MotionMatchingDatabase::ParseStateNames( "idle,walk,run", states ) && database.BuildFromStates( states );
+	int							 numMismatches = 0;
+	if ( isBuilt )
+	{
+		out_results = Stringf( "Motion matching benchmark: %d entries from %d clips, %d queries per size\n", database.GetNumEntries(), ( int ) states.size(), numQueries );
+
+		// each size is four times the last, rows past the real database are jittered copies of it
+		RandomNumberGenerator rng;
+		std::vector<float>	  features	 = database.m_features;
+		int					  numEntries = database.GetNumEntries();
+		while ( true )
+		{
+			numMismatches += RunSearchesAtSize( features, numEntries, numQueries, out_results );
+			if ( numEntries * 4 > maxEntries )
+			{
+				break;
+			}
+
+			features.resize( numEntries * 4 * MOTION_MATCHING_FEATURE_STRIDE, 0.f );
+			for ( int entryIndex = numEntries; entryIndex < numEntries * 4; entryIndex++ )
+			{
+				int sourceEntry = entryIndex % database.GetNumEntries();
+				for ( int featureIndex = 0; featureIndex < MOTION_MATCHING_FEATURE_SIZE; featureIndex++ )
+				{
+					float jitter = rng.RollRandomFloatInRange( -BENCH_REPLICA_JITTER, BENCH_REPLICA_JITTER );
+					features[ entryIndex * MOTION_MATCHING_FEATURE_STRIDE + featureIndex ] = database.GetFeatures( sourceEntry )[ featureIndex ] + jitter;
+				}
+			}
+			numEntries *= 4;
+		}
+	}
+	else
+	{
+		out_results = "Error: Motion matching benchmark could not build the locomotion database\n";
+	}
+
+	g_theAnimClipResidencyManager->Shutdown();
+	delete g_theAnimClipResidencyManager;
+	g_theAnimClipResidencyManager = nullptr;
+
+	delete g_theCookedAnimArchive;
+	g_theCookedAnimArchive = nullptr;
+
+	g_theJobSystem->Shutdown();
+	delete g_theJobSystem;
+	g_theJobSystem = nullptr;
+
+	return isBuilt && numMismatches == 0;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// both searches answer the same queries, any disagreement on the best cost means the tree pruned a real match;
+// appends one line to the results and returns the number of disagreements
+int MotionMatchingBenchmark::RunSearchesAtSize( std::vector<float> const& features, int numEntries, int numQueries, std::string& out_results )
+{
+	RandomNumberGenerator rng;
+	std::vector<float>	  queries( numQueries * MOTION_MATCHING_FEATURE_STRIDE, 0.f );
+	for ( int queryIndex = 0; queryIndex < numQueries; queryIndex++ )
+	{
+		int sourceEntry = ( queryIndex * 7919 ) % numEntries;
+		for ( int featureIndex = 0; featureIndex < MOTION_MATCHING_FEATURE_SIZE; featureIndex++ )
+		{
+			float jitter = rng.RollRandomFloatInRange( -BENCH_QUERY_JITTER, BENCH_QUERY_JITTER );
+			queries[ queryIndex * MOTION_MATCHING_FEATURE_STRIDE + featureIndex ] = features[ sourceEntry * MOTION_MATCHING_FEATURE_STRIDE + featureIndex ] + jitter;
+		}
+	}
+
+	std::chrono::steady_clock::time_point buildStartTime = std::chrono::steady_clock::now();
+	MotionMatchingKdTree				  kdTree;
+	kdTree.Build( features.data(), numEntries, MOTION_MATCHING_FEATURE_STRIDE, MOTION_MATCHING_FEATURE_SIZE );
+	std::chrono::steady_clock::time_point buildEndTime = std::chrono::steady_clock::now();
+
+	std::vector<float> bruteForceCosts( numQueries, 0.f );
+	for ( int queryIndex = 0; queryIndex < numQueries; queryIndex++ )
+	{
+		FindNearestBruteForce( features.data(), numEntries, MOTION_MATCHING_FEATURE_STRIDE, &queries[ queryIndex * MOTION_MATCHING_FEATURE_STRIDE ], bruteForceCosts[ queryIndex ] );
+	}
+	std::chrono::steady_clock::time_point bruteForceEndTime = std::chrono::steady_clock::now();
+
+	int numMismatches = 0;
+	for ( int queryIndex = 0; queryIndex < numQueries; queryIndex++ )
+	{
+		float kdTreeCost = 0.f;
+		kdTree.FindNearest( &queries[ queryIndex * MOTION_MATCHING_FEATURE_STRIDE ], kdTreeCost );
+		if ( fabsf( kdTreeCost - bruteForceCosts[ queryIndex ] ) > 0.0001f * ( 1.f + bruteForceCosts[ queryIndex ] ) )
+		{
+			numMismatches++;
+		}
+	}
+	std::chrono::steady_clock::time_point kdTreeEndTime = std::chrono::steady_clock::now();
+
+	float buildMs			= std::chrono::duration<float, std::milli>( buildEndTime - buildStartTime ).count();
+	float bruteForceQueryUs = std::chrono::duration<float, std::micro>( bruteForceEndTime - buildEndTime ).count() / ( float ) numQueries;
+	float kdTreeQueryUs		= std::chrono::duration<float, std::micro>( kdTreeEndTime - bruteForceEndTime ).count() / ( float ) numQueries;
+	out_results += Stringf( "  %8d entries: simd scan %9.2f us per query, kd tree %9.2f us per query, build %8.2f ms, %d mismatches\n", numEntries, bruteForceQueryUs,
+		kdTreeQueryUs, buildMs, numMismatches );
+
+	return numMismatches;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+
+//----------------------------------------------------------------------------------------------------------
+char const* const MOTION_MATCHING_BENCH_COMMAND_LINE_FLAG = "-mmbench";
+char const* const MOTION_MATCHING_BENCH_RESULTS_FILE_PATH = "MotionMatchingBenchmarkResults.txt";
+
+
+//----------------------------------------------------------------------------------------------------------
+// headless search timing without a window or renderer, the locomotion database is replicated with jitter up to
+// the requested size and every size reports the kd tree and the simd scan latency per query side by side, to stdout
+// and the results file; the exit code is non zero if the database failed to build or the kd tree missed a match
+class MotionMatchingBenchmark
+{
+public:
+	static bool IsBenchmarkRequested( std::string const& commandLine );
+	static int	RunFromCommandLine( std::string const& commandLine );
+	static bool RunBenchmark( int maxEntries, int numQueries, std::string& out_results );
+	static int	RunSearchesAtSize( std::vector<float> const& features, int numEntries, int numQueries, std::string& out_results );
+};
@@ -0,0 +1,372 @@
+#include "Game/MotionMatchingDatabase.hpp"
+#include "Game/AnimationState.hpp"
+#include "Game/AnimClipResidencyManager.hpp"
+#include "Game/AnimPoseFeatureDatabase.hpp"
+#include "Game/AnimRootMotionTrack.hpp"
+#include "Game/GameCommon.hpp"
+
+#include "Engine/Animation/AnimClip.hpp"
+#include "Engine/Animation/AnimPose.hpp"
+#include "Engine/Core/ErrorWarningAssert.hpp"
+#include "Engine/Core/StringUtils.hpp"
+
+#include <math.h>
+#include <utility>
+
+
+//----------------------------------------------------------------------------------------------------------
+static float const TRAJECTORY_HORIZONS_MS[ MOTION_MATCHING_TRAJECTORY_SAMPLES ] = { 333.f, 666.f, 1000.f };
+
+
+//----------------------------------------------------------------------------------------------------------
+// feature groups share one scale, so a group's dimensions keep their proportions to each other
+struct FeatureGroup
+{
+	int m_firstFeature = 0;
+	int m_numFeatures  = 0;
+};
+
+static FeatureGroup const FEATURE_GROUPS[] = {
+	{ MOTION_MATCHING_TRAJECTORY_OFFSET, MOTION_MATCHING_TRAJECTORY_SAMPLES * 2 },
+	{ MOTION_MATCHING_FOOT_OFFSET, 6 },
+	{ MOTION_MATCHING_FOOT_VELOCITY_OFFSET, 6 },
+	{ MOTION_MATCHING_HIP_VELOCITY_OFFSET, 3 },
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// a looping clip carries on into its next pass, a one shot clip holds its last translation
+static Vec3 GetRootDisplacementAhead( AnimRootMotionTrack const& track, float timeMs, float horizonMs, bool isLooping )
+{
+	float startTimeMs  = track.GetStartTimeMs();
+	float endTimeMs	   = track.GetEndTimeMs();
+	float durationMs   = endTimeMs - startTimeMs;
+	float targetTimeMs = timeMs + horizonMs;
+	if ( !isLooping || targetTimeMs <= endTimeMs || durationMs <= 0.f )
+	{
+		return track.GetDisplacement( timeMs, targetTimeMs );
+	}
+
+	Vec3 displacement  = track.GetDisplacement( timeMs, endTimeMs );
+	targetTimeMs	  -= durationMs;
+	while ( targetTimeMs > endTimeMs )
+	{
+		displacement += track.GetTotalDisplacement();
+		targetTimeMs -= durationMs;
+	}
+	displacement += track.GetDisplacement( startTimeMs, targetTimeMs );
+
+	return displacement;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+static int GetRootJoint( AnimPose const& pose )
+{
+	for ( int jointIndex = 0; jointIndex < pose.GetNumberOfJoints(); jointIndex++ )
+	{
+		if ( pose.GetParentOfJoint( jointIndex ) < 0 )
+		{
+			return jointIndex;
+		}
+	}
+
+	return 0;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// usage: a comma separated list of animation state names, as written in GameConfig.xml
+bool MotionMatchingDatabase::ParseStateNames( std::string const& stateNames, std::vector<AnimationState*>& out_states )
+{
+	out_states.clear();
+
+	Strings names = SplitStringOnDelimiter( stateNames, ',' );
+	for ( std::string const& name : names )
+	{
+		if ( name.empty() )
+		{
+			continue;
+		}
+
+		AnimationState* state = AnimationState::GetAnimationStateByName( name );
+		if ( !state )
+		{
+			DebuggerPrintf( "Error: Motion matching names unknown animation state %s\n", name.c_str() );
+			continue;
+		}
+		out_states.push_back( state );
+	}
+
+	return !out_states.empty();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool MotionMatchingDatabase::BuildFromStates( std::vector<AnimationState*> const& states, float sampleRateHz )
+{
+	Clear();
+
+	if ( states.empty() || sampleRateHz <= 0.f )
+	{
+		return false;
+	}
+
+	// built once before the first frame, so the clips are loaded here instead of waited for
+	if ( g_theAnimClipResidencyManager )
+	{
+		for ( AnimationState* state : states )
+		{
+			g_theAnimClipResidencyManager->MakeResidentNow( state );
+		}
+	}
+
+	// the feet are the two end effectors lowest in the rest pose
+	AnimPose const& restPose = states[ 0 ]->m_defaultPose;
+	AnimPoseFeatureDatabase::SelectFeatureJoints( restPose, m_footJoints );
+	for ( int pass = 0; pass < 2 && pass < ( int ) m_footJoints.size(); pass++ )
+	{
+		for ( int jointIndex = pass + 1; jointIndex < ( int ) m_footJoints.size(); jointIndex++ )
+		{
+			float lowestZ = restPose.GetGlobalTransformOfJoint( m_footJoints[ pass ] ).m_position.z;
+			if ( restPose.GetGlobalTransformOfJoint( m_footJoints[ jointIndex ] ).m_position.z < lowestZ )
+			{
+				std::swap( m_footJoints[ pass ], m_footJoints[ jointIndex ] );
+			}
+		}
+	}
+
+	if ( m_footJoints.size() < 2 )
+	{
+		DebuggerPrintf( "Error: Motion matching found no feet in the rest pose\n" );
+		return false;
+	}
+	m_footJoints.resize( 2 );
+
+	for ( AnimationState* state : states )
+	{
+		AppendState( state, sampleRateHz );
+	}
+
+	ComputeNormalization();
+	return !IsEmpty();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void MotionMatchingDatabase::AppendState( AnimationState* state, float sampleRateHz )
+{
+	if ( !state->m_isLoaded )
+	{
+		return;
+	}
+	AnimClip* clip = state->GetClip();
+
+	AnimRootMotionTrack const& rootTrack  = state->GetRootMotionTrack();
+	int						   stateIndex = state->GetStateMachineIndex();
+	bool					   isLooping  = AnimationState::s_stateMachineTable.GetEndTransitionTarget( stateIndex ) == stateIndex;
+
+	float durationMs = clip->GetEndTime() - clip->GetStartTime();
+	int	  numFrames	 = ( int ) ceilf( durationMs * sampleRateHz / 1000.f ) + 1;
+	if ( numFrames < 2 )
+	{
+		numFrames = 2;
+	}
+
+	MotionMatchingClipRange clipRange;
+	clipRange.m_stateId			 = state->m_nameId;
+	clipRange.m_firstEntry		 = ( int ) m_entries.size();
+	clipRange.m_numEntries		 = numFrames;
+	clipRange.m_sampleIntervalMs = durationMs / ( float ) ( numFrames - 1 );
+	m_clipRanges.push_back( clipRange );
+
+	// foot positions first, velocities are differenced from the neighbouring frames afterwards
+	AnimPose		  sampledPose = state->m_defaultPose;
+	int				  rootJoint	  = GetRootJoint( sampledPose );
+	std::vector<Vec3> footPositions( numFrames * 2 );
+	for ( int frameIndex = 0; frameIndex < numFrames; frameIndex++ )
+	{
+		float timeMs = clip->GetStartTime() + ( float ) frameIndex * clipRange.m_sampleIntervalMs;
+		clip->Sample( timeMs, sampledPose );
+
+		Vec3 const& rootPosition = sampledPose.GetGlobalTransformOfJoint( rootJoint ).m_position;
+		for ( int footIndex = 0; footIndex < 2; footIndex++ )
+		{
+			footPositions[ frameIndex * 2 + footIndex ] = sampledPose.GetGlobalTransformOfJoint( m_footJoints[ footIndex ] ).m_position - rootPosition;
+		}
+	}
+
+	m_rawFeatures.resize( ( clipRange.m_firstEntry + numFrames ) * MOTION_MATCHING_FEATURE_STRIDE, 0.f );
+	for ( int frameIndex = 0; frameIndex < numFrames; frameIndex++ )
+	{
+		MotionMatchingEntry entry;
+		entry.m_stateId = state->m_nameId;
+		entry.m_timeMs	= clip->GetStartTime() + ( float ) frameIndex * clipRange.m_sampleIntervalMs;
+		m_entries.push_back( entry );
+
+		float* features = &m_rawFeatures[ ( clipRange.m_firstEntry + frameIndex ) * MOTION_MATCHING_FEATURE_STRIDE ];
+		for ( int sampleIndex = 0; sampleIndex < MOTION_MATCHING_TRAJECTORY_SAMPLES; sampleIndex++ )
+		{
+			Vec3 displacement = GetRootDisplacementAhead( rootTrack, entry.m_timeMs, TRAJECTORY_HORIZONS_MS[ sampleIndex ], isLooping );
+			features[ MOTION_MATCHING_TRAJECTORY_OFFSET + sampleIndex * 2 + 0 ] = displacement.x;
+			features[ MOTION_MATCHING_TRAJECTORY_OFFSET + sampleIndex * 2 + 1 ] = displacement.y;
+		}
+
+		int	  previousFrame = ( frameIndex > 0 ) ? frameIndex - 1 : frameIndex;
+		int	  nextFrame		= ( frameIndex < numFrames - 1 ) ? frameIndex + 1 : frameIndex;
+		float spanSeconds	= ( float ) ( nextFrame - previousFrame ) * clipRange.m_sampleIntervalMs * 0.001f;
+		float inverseSpan	= ( spanSeconds > 0.f ) ? 1.f / spanSeconds : 0.f;
+		for ( int footIndex = 0; footIndex < 2; footIndex++ )
+		{
+			Vec3 const& position = footPositions[ frameIndex * 2 + footIndex ];
+			Vec3		velocity = ( footPositions[ nextFrame * 2 + footIndex ] - footPositions[ previousFrame * 2 + footIndex ] ) * inverseSpan;
+			features[ MOTION_MATCHING_FOOT_OFFSET + footIndex * 3 + 0 ]			 = position.x;
+			features[ MOTION_MATCHING_FOOT_OFFSET + footIndex * 3 + 1 ]			 = position.y;
+			features[ MOTION_MATCHING_FOOT_OFFSET + footIndex * 3 + 2 ]			 = position.z;
+			features[ MOTION_MATCHING_FOOT_VELOCITY_OFFSET + footIndex * 3 + 0 ] = velocity.x;
+			features[ MOTION_MATCHING_FOOT_VELOCITY_OFFSET + footIndex * 3 + 1 ] = velocity.y;
+			features[ MOTION_MATCHING_FOOT_VELOCITY_OFFSET + footIndex * 3 + 2 ] = velocity.z;
+		}
+
+		float previousTimeMs = clip->GetStartTime() + ( float ) previousFrame * clipRange.m_sampleIntervalMs;
+		float nextTimeMs	 = clip->GetStartTime() + ( float ) nextFrame * clipRange.m_sampleIntervalMs;
+		Vec3  hipVelocity	 = rootTrack.GetDisplacement( previousTimeMs, nextTimeMs ) * inverseSpan;
+		features[ MOTION_MATCHING_HIP_VELOCITY_OFFSET + 0 ] = hipVelocity.x;
+		features[ MOTION_MATCHING_HIP_VELOCITY_OFFSET + 1 ] = hipVelocity.y;
+		features[ MOTION_MATCHING_HIP_VELOCITY_OFFSET + 2 ] = hipVelocity.z;
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void MotionMatchingDatabase::ComputeNormalization()
+{
+	int numEntries = GetNumEntries();
+	if ( numEntries == 0 )
+	{
+		return;
+	}
+
+	for ( int featureIndex = 0; featureIndex < MOTION_MATCHING_FEATURE_SIZE; featureIndex++ )
+	{
+		float sum = 0.f;
+		for ( int entryIndex = 0; entryIndex < numEntries; entryIndex++ )
+		{
+			sum += m_rawFeatures[ entryIndex * MOTION_MATCHING_FEATURE_STRIDE + featureIndex ];
+		}
+		m_means[ featureIndex ] = sum / ( float ) numEntries;
+	}
+
+	for ( FeatureGroup const& group : FEATURE_GROUPS )
+	{
+		float sumOfSquares = 0.f;
+		for ( int featureIndex = group.m_firstFeature; featureIndex < group.m_firstFeature + group.m_numFeatures; featureIndex++ )
+		{
+			for ( int entryIndex = 0; entryIndex < numEntries; entryIndex++ )
+			{
+				float deviation	  = m_rawFeatures[ entryIndex * MOTION_MATCHING_FEATURE_STRIDE + featureIndex ] - m_means[ featureIndex ];
+				sumOfSquares	 += deviation * deviation;
+			}
+		}
+
+		// a group that never changes, like sideways motion in forward only clips, is left unscaled
+		float standardDeviation = sqrtf( sumOfSquares / ( float ) ( numEntries * group.m_numFeatures ) );
+		float inverseScale		= ( standardDeviation > 0.0001f ) ? 1.f / standardDeviation : 1.f;
+		for ( int featureIndex = group.m_firstFeature; featureIndex < group.m_firstFeature + group.m_numFeatures; featureIndex++ )
+		{
+			m_inverseScales[ featureIndex ] = inverseScale;
+		}
+	}
+
+	m_features.assign( m_rawFeatures.size(), 0.f );
+	for ( int entryIndex = 0; entryIndex < numEntries; entryIndex++ )
+	{
+		NormalizeFeatures( GetRawFeatures( entryIndex ), &m_features[ entryIndex * MOTION_MATCHING_FEATURE_STRIDE ] );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void MotionMatchingDatabase::Clear()
+{
+	m_entries.clear();
+	m_clipRanges.clear();
+	m_rawFeatures.clear();
+	m_features.clear();
+	m_footJoints.clear();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool MotionMatchingDatabase::IsEmpty() const
+{
+	return m_entries.empty();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+int MotionMatchingDatabase::GetNumEntries() const
+{
+	return ( int ) m_entries.size();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+float const* MotionMatchingDatabase::GetFeatures( int entryIndex ) const
+{
+	return &m_features[ entryIndex * MOTION_MATCHING_FEATURE_STRIDE ];
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+float const* MotionMatchingDatabase::GetRawFeatures( int entryIndex ) const
+{
+	return &m_rawFeatures[ entryIndex * MOTION_MATCHING_FEATURE_STRIDE ];
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// nearest sampled frame of the state, -1 when the state is not in the database
+int MotionMatchingDatabase::FindEntry( AnimNameId stateId, float timeMs ) const
+{
+	for ( MotionMatchingClipRange const& clipRange : m_clipRanges )
+	{
+		if ( clipRange.m_stateId != stateId )
+		{
+			continue;
+		}
+
+		int frameIndex = 0;
+		if ( clipRange.m_sampleIntervalMs > 0.f )
+		{
+			frameIndex = ( int ) floorf( ( timeMs - m_entries[ clipRange.m_firstEntry ].m_timeMs ) / clipRange.m_sampleIntervalMs + 0.5f );
+		}
+		frameIndex = ( frameIndex < 0 ) ? 0 : ( frameIndex >= clipRange.m_numEntries ? clipRange.m_numEntries - 1 : frameIndex );
+
+		return clipRange.m_firstEntry + frameIndex;
+	}
+
+	return -1;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// the padding past the feature size stays zero, so it adds nothing to a distance
+void MotionMatchingDatabase::NormalizeFeatures( float const* rawFeatures, float* out_normalizedFeatures ) const
+{
+	for ( int featureIndex = 0; featureIndex < MOTION_MATCHING_FEATURE_SIZE; featureIndex++ )
+	{
+		out_normalizedFeatures[ featureIndex ] = ( rawFeatures[ featureIndex ] - m_means[ featureIndex ] ) * m_inverseScales[ featureIndex ];
+	}
+	for ( int featureIndex = MOTION_MATCHING_FEATURE_SIZE; featureIndex < MOTION_MATCHING_FEATURE_STRIDE; featureIndex++ )
+	{
+		out_normalizedFeatures[ featureIndex ] = 0.f;
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+float MotionMatchingDatabase::GetTrajectoryHorizonMs( int sampleIndex )
+{
+	return TRAJECTORY_HORIZONS_MS[ sampleIndex ];
+}
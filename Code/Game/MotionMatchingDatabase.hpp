@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Game/AnimNameTable.hpp"
+
+#include <string>
+#include <vector>
+
+class AnimationState;
+
+
+//----------------------------------------------------------------------------------------------------------
+// feature layout, the trajectory is planar root displacement in clip space with x forward and y to the left
+constexpr int	MOTION_MATCHING_TRAJECTORY_SAMPLES	 = 3;
+constexpr int	MOTION_MATCHING_TRAJECTORY_OFFSET	 = 0;
+constexpr int	MOTION_MATCHING_FOOT_OFFSET			 = 6;	 // two feet, position relative to the root
+constexpr int	MOTION_MATCHING_FOOT_VELOCITY_OFFSET = 12;	 // two feet, velocity relative to the root
+constexpr int	MOTION_MATCHING_HIP_VELOCITY_OFFSET	 = 18;
+constexpr int	MOTION_MATCHING_FEATURE_SIZE		 = 21;
+constexpr int	MOTION_MATCHING_FEATURE_STRIDE		 = 24;	 // padded with zeros to whole groups of four floats for the simd scan
+constexpr float MOTION_MATCHING_SAMPLE_RATE_HZ		 = 30.f;
+
+
+//----------------------------------------------------------------------------------------------------------
+struct MotionMatchingEntry
+{
+	AnimNameId m_stateId = INVALID_ANIM_NAME_ID;
+	float	   m_timeMs	 = 0.f;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// entries of one state are contiguous, so the entry playing at a time is one division away
+struct MotionMatchingClipRange
+{
+	AnimNameId m_stateId		  = INVALID_ANIM_NAME_ID;
+	int		   m_firstEntry		  = 0;
+	int		   m_numEntries		  = 0;
+	float	   m_sampleIntervalMs = 0.f;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// every frame of the locomotion clips as one row of features, normalized per feature group so trajectory, foot
+// and hip terms weigh the same however their units differ; rows are padded to the stride and packed back to back
+class MotionMatchingDatabase
+{
+public:
+	bool								 BuildFromStates( std::vector<AnimationState*> const& states, float sampleRateHz = MOTION_MATCHING_SAMPLE_RATE_HZ );
+	static bool							 ParseStateNames( std::string const& stateNames, std::vector<AnimationState*>& out_states );
+	void								 Clear();
+	bool								 IsEmpty() const;
+	int									 GetNumEntries() const;
+	float const*						 GetFeatures( int entryIndex ) const;
+	float const*						 GetRawFeatures( int entryIndex ) const;
+	int									 FindEntry( AnimNameId stateId, float timeMs ) const;
+	void								 NormalizeFeatures( float const* rawFeatures, float* out_normalizedFeatures ) const;
+	static float						 GetTrajectoryHorizonMs( int sampleIndex );
+
+	std::vector<MotionMatchingEntry>	 m_entries;
+	std::vector<MotionMatchingClipRange> m_clipRanges;
+	std::vector<float>					 m_rawFeatures; // MOTION_MATCHING_FEATURE_STRIDE floats per entry
+	std::vector<float>					 m_features;	// normalized, same layout
+	float								 m_means[ MOTION_MATCHING_FEATURE_SIZE ]		 = {};
+	float								 m_inverseScales[ MOTION_MATCHING_FEATURE_SIZE ] = {};
+
+protected:
+	void								 AppendState( AnimationState* state, float sampleRateHz );
+	void								 ComputeNormalization();
+	std::vector<int>					 m_footJoints;
+};
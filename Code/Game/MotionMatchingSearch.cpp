@@ -0,0 +1,205 @@
+#include "Game/MotionMatchingSearch.hpp"
+
+#include <algorithm>
+#include <float.h>
+#include <xmmintrin.h>
+
+
+//----------------------------------------------------------------------------------------------------------
+static float GetSquaredDistance( float const* rowFeatures, float const* query, int numDimensions, float costToBeat )
+{
+	float cost = 0.f;
+	for ( int dimension = 0; dimension < numDimensions && cost < costToBeat; dimension++ )
+	{
+		float delta	 = rowFeatures[ dimension ] - query[ dimension ];
+		cost		+= delta * delta;
+	}
+
+	return cost;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+int FindNearestBruteForce( float const* features, int numEntries, int stride, float const* query, float& out_cost )
+{
+	out_cost	  = FLT_MAX;
+	int bestEntry = -1;
+
+	for ( int entryIndex = 0; entryIndex < numEntries; entryIndex++ )
+	{
+		float const* row = features + entryIndex * stride;
+		__m128		 sum = _mm_setzero_ps();
+		for ( int dimension = 0; dimension < stride; dimension += 4 )
+		{
+			__m128 delta = _mm_sub_ps( _mm_loadu_ps( row + dimension ), _mm_loadu_ps( query + dimension ) );
+			sum			 = _mm_add_ps( sum, _mm_mul_ps( delta, delta ) );
+		}
+
+		// horizontal add of the four lanes
+		sum		   = _mm_add_ps( sum, _mm_movehl_ps( sum, sum ) );
+		sum		   = _mm_add_ss( sum, _mm_shuffle_ps( sum, sum, 1 ) );
+		float cost = _mm_cvtss_f32( sum );
+		if ( cost < out_cost )
+		{
+			out_cost  = cost;
+			bestEntry = entryIndex;
+		}
+	}
+
+	return bestEntry;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void MotionMatchingKdTree::Build( float const* features, int numEntries, int stride, int numDimensions )
+{
+	Clear();
+
+	if ( numEntries <= 0 )
+	{
+		return;
+	}
+
+	m_stride		= stride;
+	m_numDimensions = numDimensions;
+	m_rowEntries.resize( numEntries );
+	for ( int entryIndex = 0; entryIndex < numEntries; entryIndex++ )
+	{
+		m_rowEntries[ entryIndex ] = entryIndex;
+	}
+
+	m_nodes.reserve( 2 * numEntries / MOTION_MATCHING_KD_LEAF_SIZE + 1 );
+	BuildNode( features, 0, numEntries );
+
+	// rows copied in leaf order once the partitioning is final
+	m_rowFeatures.resize( numEntries * stride );
+	for ( int rowIndex = 0; rowIndex < numEntries; rowIndex++ )
+	{
+		float const* source = features + m_rowEntries[ rowIndex ] * stride;
+		std::copy( source, source + stride, m_rowFeatures.begin() + rowIndex * stride );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+int MotionMatchingKdTree::BuildNode( float const* features, int firstRow, int numRows )
+{
+	int nodeIndex = ( int ) m_nodes.size();
+	m_nodes.push_back( MotionMatchingKdNode() );
+	m_nodes[ nodeIndex ].m_firstRow = firstRow;
+	m_nodes[ nodeIndex ].m_numRows	= numRows;
+
+	if ( numRows <= MOTION_MATCHING_KD_LEAF_SIZE )
+	{
+		return nodeIndex;
+	}
+
+	int	  splitDimension = 0;
+	float widestSpread	 = -1.f;
+	for ( int dimension = 0; dimension < m_numDimensions; dimension++ )
+	{
+		float minValue = FLT_MAX;
+		float maxValue = -FLT_MAX;
+		for ( int rowIndex = firstRow; rowIndex < firstRow + numRows; rowIndex++ )
+		{
+			float value = features[ m_rowEntries[ rowIndex ] * m_stride + dimension ];
+			minValue	= ( value < minValue ) ? value : minValue;
+			maxValue	= ( value > maxValue ) ? value : maxValue;
+		}
+
+		if ( maxValue - minValue > widestSpread )
+		{
+			widestSpread   = maxValue - minValue;
+			splitDimension = dimension;
+		}
+	}
+
+	// every row identical, nothing left to split on
+	if ( widestSpread <= 0.f )
+	{
+		return nodeIndex;
+	}
+
+	int						   numLowRows = numRows / 2;
+	std::vector<int>::iterator first	  = m_rowEntries.begin() + firstRow;
+	int						   stride	  = m_stride;
+	std::nth_element( first, first + numLowRows, first + numRows, [ features, stride, splitDimension ]( int a, int b )
+		{ return features[ a * stride + splitDimension ] < features[ b * stride + splitDimension ]; } );
+
+	float splitValue = features[ m_rowEntries[ firstRow + numLowRows ] * m_stride + splitDimension ];
+	int	  lowChild	 = BuildNode( features, firstRow, numLowRows );
+	int	  highChild	 = BuildNode( features, firstRow + numLowRows, numRows - numLowRows );
+
+	// children push onto the node array, so the node is looked up again rather than held by reference
+	MotionMatchingKdNode& node = m_nodes[ nodeIndex ];
+	node.m_splitDimension	   = splitDimension;
+	node.m_splitValue		   = splitValue;
+	node.m_lowChild			   = lowChild;
+	node.m_highChild		   = highChild;
+
+	return nodeIndex;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void MotionMatchingKdTree::Clear()
+{
+	m_nodes.clear();
+	m_rowEntries.clear();
+	m_rowFeatures.clear();
+	m_stride		= 0;
+	m_numDimensions = 0;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool MotionMatchingKdTree::IsEmpty() const
+{
+	return m_nodes.empty();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+int MotionMatchingKdTree::FindNearest( float const* query, float& out_cost ) const
+{
+	out_cost = FLT_MAX;
+	if ( IsEmpty() )
+	{
+		return -1;
+	}
+
+	int bestRow = -1;
+	SearchNode( 0, query, bestRow, out_cost );
+
+	return ( bestRow >= 0 ) ? m_rowEntries[ bestRow ] : -1;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void MotionMatchingKdTree::SearchNode( int nodeIndex, float const* query, int& bestRow, float& bestCost ) const
+{
+	MotionMatchingKdNode const& node = m_nodes[ nodeIndex ];
+	if ( node.m_splitDimension < 0 )
+	{
+		for ( int rowIndex = node.m_firstRow; rowIndex < node.m_firstRow + node.m_numRows; rowIndex++ )
+		{
+			float cost = GetSquaredDistance( &m_rowFeatures[ rowIndex * m_stride ], query, m_numDimensions, bestCost );
+			if ( cost < bestCost )
+			{
+				bestCost = cost;
+				bestRow	 = rowIndex;
+			}
+		}
+		return;
+	}
+
+	float planeDistance = query[ node.m_splitDimension ] - node.m_splitValue;
+	int	  nearChild		= ( planeDistance < 0.f ) ? node.m_lowChild : node.m_highChild;
+	int	  farChild		= ( planeDistance < 0.f ) ? node.m_highChild : node.m_lowChild;
+
+	SearchNode( nearChild, query, bestRow, bestCost );
+	if ( planeDistance * planeDistance < bestCost )
+	{
+		SearchNode( farChild, query, bestRow, bestCost );
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <vector>
+
+
+//----------------------------------------------------------------------------------------------------------
+constexpr int MOTION_MATCHING_KD_LEAF_SIZE = 8;
+
+
+//----------------------------------------------------------------------------------------------------------
+// baseline, every row scored four floats at a time; rows are stride floats apart and the stride is a multiple of four
+int FindNearestBruteForce( float const* features, int numEntries, int stride, float const* query, float& out_cost );
+
+
+//----------------------------------------------------------------------------------------------------------
+// internal nodes split on the dimension with the widest spread at its median, leaves keep a copy of their rows
+// so a leaf is scanned in one contiguous block; the nearest row is exact, a far side is only visited while the
+// split plane is closer than the best row found so far
+struct MotionMatchingKdNode
+{
+	int	  m_splitDimension = -1; // -1 for a leaf
+	float m_splitValue	   = 0.f;
+	int	  m_lowChild	   = -1;
+	int	  m_highChild	   = -1;
+	int	  m_firstRow	   = 0;
+	int	  m_numRows		   = 0;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+class MotionMatchingKdTree
+{
+public:
+	void							  Build( float const* features, int numEntries, int stride, int numDimensions );
+	void							  Clear();
+	bool							  IsEmpty() const;
+	int								  FindNearest( float const* query, float& out_cost ) const;
+
+	std::vector<MotionMatchingKdNode> m_nodes;
+	std::vector<int>				  m_rowEntries;	 // entry index of each row
+	std::vector<float>				  m_rowFeatures; // rows in leaf order, stride floats each
+	int								  m_stride		  = 0;
+	int								  m_numDimensions = 0;
+
+protected:
+	int								  BuildNode( float const* features, int firstRow, int numRows );
+	void							  SearchNode( int nodeIndex, float const* query, int& bestRow, float& bestCost ) const;
+};
@@ -6,6 +6,8 @@
 #include "Game/ParkourMovementStates.hpp"
 #include "Game/MovementState.hpp"
 #include "Game/AnimationState.hpp"
+#include "Game/AnimationStateInstance.hpp"
+#include "Game/AnimClipResidencyManager.hpp"
 #include "Game/GameCommon.hpp"
 
 #include "Engine/Animation/AnimClip.hpp"
@@ -19,65 +21,221 @@ MovementState::MovementState()
 {
 }
 
+
+//----------------------------------------------------------------------------------------------------------
+// interned on first use, once per movement state rather than every frame
+AnimNameId MovementState::GetStateId() const
+{
+	if ( m_stateId == INVALID_ANIM_NAME_ID )
+	{
+		m_stateId = AnimNameTable::Intern( GetStateName() );
+	}
+
+	return m_stateId;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// states that copy a clip's root curve when they are built wait for the clip, the same way animation transitions do
+bool MovementState::IsRootMotionClipResident( AnimNameId animStateId )
+{
+	AnimationState* state = AnimationState::GetAnimationStateById( animStateId );
+	if ( !state || !g_theAnimClipResidencyManager || state->m_isLoaded )
+	{
+		return true;
+	}
+
+	g_theAnimClipResidencyManager->ReportPrefetchMiss( state );
+	return false;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// the animation state this movement state's root motion comes from, the one playing or the one its transition goes to
+AnimationState* MovementState::FindRootMotionAnimationState() const
+{
+	AnimationState* currentAnimationState = g_theAnimationController->GetCurrentAnimationState();
+	AnimNameId		movementStateId		  = GetStateId();
+	if ( currentAnimationState->m_nameId == movementStateId )
+	{
+		return currentAnimationState;
+	}
+
+	AnimStateMachineTable const& stateMachine	 = AnimationState::s_stateMachineTable;
+	int							 transitionIndex = stateMachine.FindTransition( currentAnimationState->GetStateMachineIndex(), movementStateId );
+	if ( transitionIndex != INVALID_ANIM_STATE_MACHINE_INDEX )
+	{
+		return AnimationState::GetAnimationStateByIndex( stateMachine.m_transitions[ transitionIndex ].m_targetState );
+	}
+
+	return nullptr;
+}
+
+
 //----------------------------------------------------------------------------------------------------------
 void MovementState::InitRootMotionTranslation()
 {
 	// set the root motion translation for next translation state
-	AnimationState* currentAnimationState = g_theAnimationController->m_animationStack.top();
-	std::string		movementStateName	  = GetStateName();
-	if ( currentAnimationState->m_name == movementStateName )
+	AnimationState* rootMotionState = FindRootMotionAnimationState();
+	if ( rootMotionState )
 	{
-		AnimClip*		   animClip				= currentAnimationState->m_clip;
-		AnimChannel const& rootJoint			= animClip->m_animChannels[ 0 ];
-		Vec3AnimCurve	   rootJointTranslation = rootJoint.m_positionCurve;
+		BindRootMotionInstance( rootMotionState->m_nameId );
+		return;
+	}
 
-		m_rootMotionTranslationCurve			= rootJointTranslation;
+	m_sampleTimeMs			   = 0.f;
+	m_steppedTimeMs			   = 0.f;
+	m_isRootMotionStartSampled = false;
+	m_previousFrameTranslation = SampleRootMotionTranslation( m_sampleTimeMs );
+	m_thisFrameTranslation	   = m_previousFrameTranslation;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// the instance is owned by the controller and lives as long as it does, binding copies nothing
+void MovementState::BindRootMotionInstance( AnimNameId animStateId )
+{
+	m_rootMotionInstance = g_theAnimationController ? g_theAnimationController->GetStateInstance( animStateId ) : nullptr;
+	if ( m_rootMotionInstance )
+	{
+		// a warp left by an earlier entry into this state must not leak into this one, states set theirs after binding
+		m_rootMotionInstance->m_rootMotionWarp.Reset();
 	}
 	else
 	{
-		Transition* nextStateTransition = currentAnimationState->GetTransitionByName( movementStateName );
-		if ( nextStateTransition )
+		// no controller yet, fall back to a copy of the clip's curve
+		AnimationState* state = AnimationState::GetAnimationStateById( animStateId );
+		if ( state == nullptr )
 		{
-			std::string		   nextAnimationStateName = nextStateTransition->m_animationState;
+			DebuggerPrintf( "Error: no animation state to bind root motion to, for movement state %s\n", GetStateName() );
+			return;
+		}
+		m_rootMotionTranslationCurve = state->GetRootMotionTranslation();
+	}
 
-			AnimationState*	   nextAnimationState	  = AnimationState::GetAnimationStateByName( nextAnimationStateName );
-			AnimClip*		   animClip				  = nextAnimationState->m_clip;
-			AnimChannel const& rootJoint			  = animClip->m_animChannels[ 0 ];
-			Vec3AnimCurve	   rootJointTranslation	  = rootJoint.m_positionCurve;
+	m_sampleTimeMs			   = 0.f;
+	m_steppedTimeMs			   = 0.f;
+	m_isRootMotionStartSampled = false;
+	m_previousFrameTranslation = SampleRootMotionTranslation( m_sampleTimeMs );
+	m_thisFrameTranslation	   = m_previousFrameTranslation;
+}
 
-			m_rootMotionTranslationCurve			  = rootJointTranslation;
-		}
+
+//----------------------------------------------------------------------------------------------------------
+bool MovementState::HasRootMotion() const
+{
+	if ( m_rootMotionInstance )
+	{
+		return !m_rootMotionInstance->m_state->GetRootMotionTrack().IsEmpty();
 	}
 
+	return !m_rootMotionTranslationCurve.IsEmpty();
+}
 
-	m_sampleTimeMs			   = 0.f;
-	m_previousFrameTranslation = m_rootMotionTranslationCurve.Sample( m_sampleTimeMs, false );
-	// m_previousFrameTranslation.z = 0.f;
 
-	m_thisFrameTranslation = m_rootMotionTranslationCurve.Sample( m_sampleTimeMs, false );
-	// m_thisFrameTranslation.z = 0.f;
+//----------------------------------------------------------------------------------------------------------
+Vec3 MovementState::SampleRootMotionTranslation( float timeMs ) const
+{
+	if ( m_rootMotionInstance )
+	{
+		return m_rootMotionInstance->SampleRoot( timeMs ).m_translation;
+	}
+
+	return m_rootMotionTranslationCurve.Sample( timeMs, false );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+Vec3 MovementState::GetFirstRootMotionTranslation() const
+{
+	if ( m_rootMotionInstance )
+	{
+		return m_rootMotionInstance->GetFirstRootMotionTranslation();
+	}
+
+	return m_rootMotionTranslationCurve.GetKeyframeAtFirstIndex().m_value;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+Vec3 MovementState::GetLastRootMotionTranslation() const
+{
+	if ( m_rootMotionInstance )
+	{
+		return m_rootMotionInstance->GetLastRootMotionTranslation();
+	}
+
+	return m_rootMotionTranslationCurve.GetKeyframeAtLastIndex().m_value;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+float MovementState::GetRootMotionEndTimeMs() const
+{
+	if ( m_rootMotionInstance )
+	{
+		return m_rootMotionInstance->m_state->GetRootMotionTrack().GetEndTimeMs();
+	}
+
+	return m_rootMotionTranslationCurve.GetEndTimeMilliSeconds();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// debug drawing wants a whole curve, only here is a warped copy built
+Vec3AnimCurve MovementState::GetRootMotionCurveForDebug() const
+{
+	// the animation may still be waiting for a clip that was streamed out again
+	if ( m_rootMotionInstance == nullptr || !m_rootMotionInstance->m_state->m_isLoaded )
+	{
+		return m_rootMotionTranslationCurve;
+	}
+
+	Vec3AnimCurve warpedCurve = m_rootMotionInstance->GetSourceRootMotionCurve();
+	for ( unsigned int index = 0; index < warpedCurve.GetSize(); index++ )
+	{
+		Vec3& translation = warpedCurve.m_keyframes[ index ].m_value;
+		translation		  = m_rootMotionInstance->m_rootMotionWarp.Apply( translation );
+	}
+
+	return warpedCurve;
 }
 
 
 //----------------------------------------------------------------------------------------------------------
 void MovementState::UpdateRootMotionTranslation()
 {
-	// copy old
-	m_previousFrameTranslation = m_thisFrameTranslation;
+	// copy old, the first update samples the start through the warp the state has set up since binding
+	if ( m_isRootMotionStartSampled )
+	{
+		m_previousFrameTranslation = m_thisFrameTranslation;
+	}
+	else if ( HasRootMotion() )
+	{
+		Quaternion rotor		   = g_theThirdPersonController->GetCharacterOrientation();
+		m_previousFrameTranslation = rotor * SampleRootMotionTranslation( m_sampleTimeMs );
+		m_isRootMotionStartSampled = true;
+	}
 
-	if ( m_sampleTimeMs > m_rootMotionTranslationCurve.GetEndTimeMilliSeconds() )
+	bool isFixedStepping = g_theAnimationController->m_fixedTimestep.IsEnabled();
+	if ( isFixedStepping )
+	{
+		UpdateFixedStepSampleTime();
+	}
+
+	if ( m_sampleTimeMs > GetRootMotionEndTimeMs() )
 	{
 		// don't loop
 		return;
 	}
 
-	if ( m_rootMotionTranslationCurve.IsEmpty() )
+	if ( !HasRootMotion() )
 	{
 		return;
 	}
 
 	// sample new
-	Vec3 sampledTranslation			   = m_rootMotionTranslationCurve.Sample( m_sampleTimeMs, false );
+	Vec3 sampledTranslation			   = SampleRootMotionTranslation( m_sampleTimeMs );
 
 
 	m_debugSampledUnrotatedtranslation = sampledTranslation;
@@ -90,8 +248,11 @@ void MovementState::UpdateRootMotionTranslation()
 	m_thisFrameTranslation = sampledTranslation;
 
 	// update delta time
-	float deltaseconds	= g_theThirdPersonController->m_characterClock->GetDeltaSeconds();
-	m_sampleTimeMs	   += ( deltaseconds * 1000.f );
+	if ( !isFixedStepping )
+	{
+		float deltaseconds = g_theThirdPersonController->m_characterClock->GetDeltaSeconds();
+		m_sampleTimeMs	  += ( deltaseconds * 1000.f );
+	}
 
 	/*DebuggerPrintf( "//----------------------------------------------------------------------------------------------------------\n" );
 	DebuggerPrintf( "Prev Frame Translation: %.3f, %.3f, %.3f\n", m_previousFrameTranslation.x, m_previousFrameTranslation.y, m_previousFrameTranslation.z );
@@ -117,6 +278,25 @@ void MovementState::UpdateRootMotionTranslation()
 }
 
 
+//----------------------------------------------------------------------------------------------------------
+// this frame's steps are taken first, then the root is sampled where the shown pose is: between the last two steps
+// by the controller's interpolation fraction, so the character moves smoothly at any frame rate
+void MovementState::UpdateFixedStepSampleTime()
+{
+	AnimationController*	 controller	   = g_theAnimationController;
+	AnimFixedTimestep const& fixedTimestep = controller->m_fixedTimestep;
+	controller->AdvanceFixedTimestep();
+
+	float stepMs	 = fixedTimestep.GetStepSeconds() * 1000.f;
+	m_steppedTimeMs += fixedTimestep.GetSimulatedSecondsThisFrame() * 1000.f;
+	m_sampleTimeMs	 = m_steppedTimeMs - stepMs + fixedTimestep.GetInterpolationFraction() * stepMs;
+	if ( m_sampleTimeMs < 0.f )
+	{
+		m_sampleTimeMs = 0.f;
+	}
+}
+
+
 //----------------------------------------------------------------------------------------------------------
 Vec3 MovementState::GetRootMotionDeltaTranslation() const
 {
@@ -131,8 +311,8 @@ void MovementState::InitCameraPosition()
 	m_initialCameraPos = g_theThirdPersonController->GetCameraPosition();
 
 	// only consider x and z motion to update camera position
-	Vec3 translationAtFirstKeyframe = m_rootMotionTranslationCurve.GetKeyframeAtFirstIndex().m_value;
-	Vec3 translationAtLastKeyframe	= m_rootMotionTranslationCurve.GetKeyframeAtLastIndex().m_value;
+	Vec3 translationAtFirstKeyframe = GetFirstRootMotionTranslation();
+	Vec3 translationAtLastKeyframe	= GetLastRootMotionTranslation();
 	Vec3 totalTranslation			= translationAtLastKeyframe - translationAtFirstKeyframe;
 	totalTranslation.y				= 0.f;
 	totalTranslation				= g_theThirdPersonController->RotateTowardsCharacterOrientation( totalTranslation );
@@ -144,7 +324,7 @@ void MovementState::InitCameraPosition()
 void MovementState::LerpCameraPosition()
 {
 	float localTimeMs		  = g_theAnimationController->GetLocalTimeMsOfCurrentAnimation();
-	float parametricZeroToOne = localTimeMs / m_rootMotionTranslationCurve.GetEndTimeMilliSeconds();
+	float parametricZeroToOne = localTimeMs / GetRootMotionEndTimeMs();
 	Vec3  lerpedPosition	  = Lerp( m_initialCameraPos, m_finalCameraPos, parametricZeroToOne );
 	g_theThirdPersonController->SetCameraPosition( lerpedPosition );
 }
@@ -153,14 +333,7 @@ void MovementState::LerpCameraPosition()
 //----------------------------------------------------------------------------------------------------------
 IdleMovementState::IdleMovementState()
 {
-	AnimationState* state		 = AnimationState::GetAnimationStateByName( "idle" );
-	m_rootMotionTranslationCurve = state->GetRootMotionTranslation();
-	m_sampleTimeMs				 = 0.f;
-	if ( !m_rootMotionTranslationCurve.IsEmpty() )
-	{
-		m_previousFrameTranslation = m_rootMotionTranslationCurve.GetKeyframeAtIndex( 0 ).m_value;
-		m_thisFrameTranslation	   = m_previousFrameTranslation;
-	}
+	BindRootMotionInstance( ANIM_NAME_IDLE );
 }
 
 
@@ -180,20 +353,6 @@ MovementState* IdleMovementState::UpdateTransition()
 
 	if ( g_theInput->WasKeyJustPressed( 'C' ) )
 	{
-		// get the last forward translation of 'standToCrouch' root joint translation
-		AnimationState* standToCrouchState				  = AnimationState::GetAnimationStateByName( "standToCrouch" );
-		Vec3			lastTranslationOfPreviosAnimation = standToCrouchState->GetLastKeyframeRootMotionTranslation();
-		float			previosAnimationLastXTranslation  = lastTranslationOfPreviosAnimation.x;
-
-		// fix forward translation of 'crouch' to start at the end translation of 'standToCrouch'
-		AnimationState* crouchIdleState				= AnimationState::GetAnimationStateByName( "crouchedIdle" );
-		Vec3AnimCurve&	crouchedIdleRootMotionCurve = crouchIdleState->m_clip->GetRootJointTranslationCurveByRefernce();
-		for ( unsigned int index = 0; index < crouchedIdleRootMotionCurve.GetSize(); index++ )
-		{
-			Vec3& translation = crouchedIdleRootMotionCurve.m_keyframes[ index ].m_value;
-			translation.x	  = previosAnimationLastXTranslation;
-		}
-
 		return new CrouchMovementState();
 	}
 
@@ -204,14 +363,7 @@ MovementState* IdleMovementState::UpdateTransition()
 //----------------------------------------------------------------------------------------------------------
 WalkMovementState::WalkMovementState()
 {
-	AnimationState* state		 = AnimationState::GetAnimationStateByName( "walk" );
-	m_rootMotionTranslationCurve = state->GetRootMotionTranslation();
-	m_sampleTimeMs				 = 0.f;
-	if ( !m_rootMotionTranslationCurve.IsEmpty() )
-	{
-		m_previousFrameTranslation = m_rootMotionTranslationCurve.GetKeyframeAtIndex( 0 ).m_value;
-		m_thisFrameTranslation	   = m_previousFrameTranslation;
-	}
+	BindRootMotionInstance( ANIM_NAME_WALK );
 }
 
 
@@ -225,7 +377,7 @@ MovementState* WalkMovementState::UpdateTransition()
 	}
 
 	// ledge grab
-	bool inRangeOfLedgeGrab = g_theCharacter->IsHeadInRangeOfAnObstacle( FloatRange( 0.f, 0.6f ) );
+	bool inRangeOfLedgeGrab = g_theCharacter->FindLedgeToGrab();
 	// bool isActionButtonDown = g_theInput->WasKeyJustPressed( KEYCODE_SHIFT );
 	bool isActionButtonDown = true;
 	bool canLedgeGrab		= inRangeOfLedgeGrab && isActionButtonDown;
@@ -248,7 +400,7 @@ MovementState* WalkMovementState::UpdateTransition()
 
 	// edge slip
 	MovementState* edgeSlipState = CheckTransitionToEdgeSlip();
-	if ( edgeSlipState != nullptr )
+	if ( edgeSlipState != nullptr && IsRootMotionClipResident( ANIM_NAME_IDLE_DROP_TO_FREE_HANG ) )
 	{
 		// TODO: remove later, only for testing
 		return new IdleDropToFreeHang();
@@ -266,7 +418,8 @@ MovementState* WalkMovementState::CheckTransitionToEdgeSlip()
 
 	bool		   isNotOnGround = !g_theCharacter->IsCharacterOnTheGround();
 	bool		   isNearAnEdge	 = !g_theCharacter->IsGroundRaycastHittingSomething();
-	if ( isNotOnGround && isNearAnEdge )
+	// the drop hangs from the edge being walked off, without one there is no height to hang at
+	if ( isNotOnGround && isNearAnEdge && g_theCharacter->FindLedgeToDropFrom() )
 	{
 		edgeSlipState = new WalkingEdgeSlip();
 	}
@@ -278,14 +431,7 @@ MovementState* WalkMovementState::CheckTransitionToEdgeSlip()
 //----------------------------------------------------------------------------------------------------------
 RunMovementState::RunMovementState()
 {
-	AnimationState* state		 = AnimationState::GetAnimationStateByName( "run" );
-	m_rootMotionTranslationCurve = state->GetRootMotionTranslation();
-	m_sampleTimeMs				 = 0.f;
-	if ( !m_rootMotionTranslationCurve.IsEmpty() )
-	{
-		m_previousFrameTranslation = m_rootMotionTranslationCurve.GetKeyframeAtIndex( 0 ).m_value;
-		m_thisFrameTranslation	   = m_previousFrameTranslation;
-	}
+	BindRootMotionInstance( ANIM_NAME_RUN );
 }
 
 
@@ -313,11 +459,9 @@ MovementState* RunMovementState::UpdateTransition()
 	}*/
 
 	// if near an obstacle big enough to vault
-	Character* character	 = g_theCharacter;
-	bool	   isFootBlocked = character->IsFootInRangeOfAnObstacle( FloatRange( 2.f, 3.f ) );
-	bool	   isHeadBlocked = character->IsHeadBlockedByAnObstacle();
-	bool	   canVault		 = !isHeadBlocked && isFootBlocked;
-	if ( canVault )
+	Character* character = g_theCharacter;
+	bool	   canVault	 = character->FindLedgeToVault();
+	if ( canVault && IsRootMotionClipResident( ANIM_NAME_VAULT ) )
 	{
 		return new VaultMovementState();
 	}
@@ -326,7 +470,7 @@ MovementState* RunMovementState::UpdateTransition()
 	bool isGroundRaycastHittinSomething = character->IsGroundRaycastHittingSomething();
 	bool isOnGround						= character->IsCharacterOnTheGround();
 	bool isNearALedge					= !isOnGround && !isGroundRaycastHittinSomething;
-	if ( isNearALedge )
+	if ( isNearALedge && IsRootMotionClipResident( ANIM_NAME_RUN_STOP ) )
 	{
 		return new RunStop();
 	}
@@ -338,8 +482,7 @@ MovementState* RunMovementState::UpdateTransition()
 //----------------------------------------------------------------------------------------------------------
 RunStop::RunStop()
 {
-	AnimationState* runStopAnimationState = AnimationState::GetAnimationStateByName( "runStop" );
-	m_rootMotionTranslationCurve		  = runStopAnimationState->GetRootMotionTranslation();
+	BindRootMotionInstance( ANIM_NAME_RUN_STOP );
 
 	RemoveZRootMotion();
 	RemoveYRootMotion();
@@ -370,10 +513,9 @@ MovementState* RunStop::UpdateTransition()
 //----------------------------------------------------------------------------------------------------------
 void RunStop::RemoveZRootMotion()
 {
-	for ( unsigned int index = 0; index < m_rootMotionTranslationCurve.GetSize(); index++ )
+	if ( m_rootMotionInstance )
 	{
-		Vec3& value = m_rootMotionTranslationCurve.m_keyframes[ index ].m_value;
-		value.z		= 0.f;
+		m_rootMotionInstance->m_rootMotionWarp.FlattenAxis( 2, 0.f );
 	}
 }
 
@@ -381,10 +523,9 @@ void RunStop::RemoveZRootMotion()
 //----------------------------------------------------------------------------------------------------------
 void RunStop::RemoveYRootMotion()
 {
-	for ( unsigned int index = 0; index < m_rootMotionTranslationCurve.GetSize(); index++ )
+	if ( m_rootMotionInstance )
 	{
-		Vec3& value = m_rootMotionTranslationCurve.m_keyframes[ index ].m_value;
-		value.y		= 0.f;
+		m_rootMotionInstance->m_rootMotionWarp.FlattenAxis( 1, 0.f );
 	}
 }
 
@@ -392,18 +533,18 @@ void RunStop::RemoveYRootMotion()
 //----------------------------------------------------------------------------------------------------------
 void RunStop::NormalizeXRootMotion()
 {
+	if ( !m_rootMotionInstance )
+	{
+		return;
+	}
+
 	float minX;
 	float maxX;
-	m_rootMotionTranslationCurve.GetMaxAndMinXValuesFromCurve( minX, maxX );
+	m_rootMotionInstance->GetSourceRootMotionCurve().GetMaxAndMinXValuesFromCurve( minX, maxX );
 
 	// 1.1 subtract the lowest value from entire curve
 	// 1.2 divide all the points by the highest value
-	for ( unsigned int index = 0; index < m_rootMotionTranslationCurve.GetSize(); index++ )
-	{
-		float& x  = m_rootMotionTranslationCurve.m_keyframes[ index ].m_value.x;
-		x		 -= minX;
-		x		 /= maxX;
-	}
+	m_rootMotionInstance->m_rootMotionWarp.AlignAxis( 0, minX, minX + maxX, 0.f, 1.f );
 }
 
 
@@ -411,7 +552,7 @@ void RunStop::NormalizeXRootMotion()
 void RunStop::SampleCurveAndSetCharacterPosition()
 {
 	float sampleTimeMs		  = g_theAnimationController->GetLocalTimeMsOfCurrentAnimation();
-	Vec3  sampledTranslation  = m_rootMotionTranslationCurve.Sample( sampleTimeMs, false );
+	Vec3  sampledTranslation  = SampleRootMotionTranslation( sampleTimeMs );
 	sampledTranslation		  = g_theThirdPersonController->RotateTowardsCharacterOrientation( sampledTranslation );
 	Vec3 newCharacterPosition = m_initialCharacterPos + sampledTranslation;
 
@@ -425,7 +566,7 @@ void RunStop::SampleCurveAndSetCharacterPosition()
 void RunStop::SampleCurveAndSetCameraPosition()
 {
 	float sampleTimeMs		 = g_theAnimationController->GetLocalTimeMsOfCurrentAnimation();
-	Vec3  sampledTranslation = m_rootMotionTranslationCurve.Sample( sampleTimeMs, false );
+	Vec3  sampledTranslation = SampleRootMotionTranslation( sampleTimeMs );
 	sampledTranslation		 = g_theThirdPersonController->RotateTowardsCharacterOrientation( sampledTranslation );
 	Vec3 newCameraPosition	 = m_initialCameraPos + sampledTranslation;
 
@@ -444,8 +585,7 @@ JumpMovementState::JumpMovementState()
 //----------------------------------------------------------------------------------------------------------
 MovementState* JumpMovementState::UpdateTransition()
 {
-	AnimationState* currentAnimationState = g_theAnimationController->m_animationStack.top();
-	if ( currentAnimationState->IsAtEndOfState() )
+	if ( g_theAnimationController->IsCurrentAnimationAtEndOfState() )
 	{
 		if ( g_theInput->IsKeyDown( KEYCODE_SHIFT ) && g_theInput->IsKeyDown( 'W' ) )
 		{
@@ -468,8 +608,16 @@ MovementState* JumpMovementState::UpdateTransition()
 //----------------------------------------------------------------------------------------------------------
 CrouchMovementState::CrouchMovementState()
 {
-	// set the curve for debug viewing
-	m_rootMotionTranslationCurve = AnimationState::GetAnimationStateByName( "crouchedIdle" )->m_clip->GetRootJointTranslationCurve();
+	// bound for debug viewing
+	BindRootMotionInstance( ANIM_NAME_CROUCHED_IDLE );
+
+	// fix forward translation of 'crouch' to start at the end translation of 'standToCrouch'
+	if ( m_rootMotionInstance )
+	{
+		AnimationState* standToCrouchState				 = AnimationState::GetAnimationStateById( ANIM_NAME_STAND_TO_CROUCH );
+		float			previosAnimationLastXTranslation = standToCrouchState->GetLastKeyframeRootMotionTranslation().x;
+		m_rootMotionInstance->m_rootMotionWarp.FlattenAxis( 0, previosAnimationLastXTranslation );
+	}
 }
 
 //----------------------------------------------------------------------------------------------------------
@@ -478,20 +626,19 @@ MovementState* CrouchMovementState::UpdateTransition()
 {
 	if ( g_theInput->WasKeyJustPressed( 'C' ) )
 	{
-		// get the last forward translation of 'standToCrouch' root joint translation
-		AnimationState* crouchIdle						  = AnimationState::GetAnimationStateByName( "crouchedIdle" );
-		Vec3			lastTranslationOfPreviosAnimation = crouchIdle->GetLastKeyframeRootMotionTranslation();
-		float			previosAnimationLastXTranslation  = lastTranslationOfPreviosAnimation.x;
-
-		// fix forward translation of 'crouch' to start at the end translation of 'standToCrouch'
-		AnimationState* crouchToStandState			= AnimationState::GetAnimationStateByName( "crouchToStand" );
-		Vec3AnimCurve&	crouhToStandRootMotionCurve = crouchToStandState->m_clip->GetRootJointTranslationCurveByRefernce();
-		float			crouchToStandFirstX			= crouchToStandState->GetFirstKeyframeRootMotionTranslation().x;
-		float			crouchToStandLastX			= crouchToStandState->GetLastKeyframeRootMotionTranslation().x;
-		for ( unsigned int index = 0; index < crouhToStandRootMotionCurve.GetSize(); index++ )
+		// get the last forward translation of the warped 'crouch' root joint translation
+		float					previosAnimationLastXTranslation = GetLastRootMotionTranslation().x;
+
+		// fix forward translation of 'crouchToStand' to start there; no movement state binds it, so its warp is
+		// reset here instead
+		AnimationStateInstance* crouchToStandInstance = g_theAnimationController->GetStateInstance( ANIM_NAME_CROUCH_TO_STAND );
+		if ( crouchToStandInstance )
 		{
-			Vec3& translation = crouhToStandRootMotionCurve.m_keyframes[ index ].m_value;
-			translation.x	  = RangeMap( translation.x, crouchToStandFirstX, crouchToStandLastX, previosAnimationLastXTranslation, 0.f );
+			AnimationState* crouchToStandState	= crouchToStandInstance->m_state;
+			float			crouchToStandFirstX = crouchToStandState->GetFirstKeyframeRootMotionTranslation().x;
+			float			crouchToStandLastX	= crouchToStandState->GetLastKeyframeRootMotionTranslation().x;
+			crouchToStandInstance->m_rootMotionWarp.Reset();
+			crouchToStandInstance->m_rootMotionWarp.AlignAxis( 0, crouchToStandFirstX, crouchToStandLastX, previosAnimationLastXTranslation, 0.f );
 		}
 
 		return new IdleMovementState();
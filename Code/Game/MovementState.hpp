@@ -1,10 +1,15 @@
 #pragma once
 
+#include "Game/AnimNameTable.hpp"
+
 #include "Engine/Animation/AnimCurve.hpp"
 
 #include <string>
 
 class Character;
+class AnimationState;
+class AnimationStateInstance;
+struct AnimEventDispatch;
 
 
 //----------------------------------------------------------------------------------------------------------
@@ -14,22 +19,40 @@ public:
 	MovementState();
 	virtual ~MovementState() {}
 
-	virtual std::string	   GetStateName() const = 0;
+	virtual char const*	   GetStateName() const = 0;
 	virtual MovementState* UpdateTransition()	= 0;
+	AnimNameId			   GetStateId() const;
+	mutable AnimNameId	   m_stateId = INVALID_ANIM_NAME_ID;
 
 	Vec3AnimCurve		   m_rootMotionTranslationCurve;
 	bool				   m_applyRootMotionTranslation		  = false;
 
+	// when bound, root motion is read through the animation instance's warp instead of a private curve copy
+	AnimationStateInstance* m_rootMotionInstance = nullptr;
+	void				   BindRootMotionInstance( AnimNameId animStateId );
+	bool				   HasRootMotion() const;
+	Vec3				   SampleRootMotionTranslation( float timeMs ) const;
+	Vec3				   GetFirstRootMotionTranslation() const;
+	Vec3				   GetLastRootMotionTranslation() const;
+	float				   GetRootMotionEndTimeMs() const;
+	Vec3AnimCurve		   GetRootMotionCurveForDebug() const;
+
 	Vec3				   m_debugSampledUnrotatedtranslation = Vec3::ZERO;
 	Vec3				   m_previousFrameTranslation		  = Vec3::ZERO;
 	Vec3				   m_thisFrameTranslation			  = Vec3::ZERO;
 	float				   m_sampleTimeMs					  = 0.f;
+	float				   m_steppedTimeMs					  = 0.f; // whole animation steps since the bind, with fixed stepping
+	bool				   m_isRootMotionStartSampled		  = false; // the start is sampled on the first update, after the state set its warp
+	AnimationState*		   FindRootMotionAnimationState() const;
+	static bool			   IsRootMotionClipResident( AnimNameId animStateId );
 	void				   InitRootMotionTranslation();
 	virtual void		   UpdateRootMotionTranslation();
+	void				   UpdateFixedStepSampleTime();
 	Vec3				   GetRootMotionDeltaTranslation() const;
 
 	bool				   m_notifyStateChangeToAnimation = true;
 	virtual void		   NotifyEndOfAnimationState( bool triggerTransitionRequestToAnimation ) { ( void ) ( triggerTransitionRequestToAnimation ); }
+	virtual void		   OnAnimEvent( AnimEventDispatch const& animEvent ) { ( void ) ( animEvent ); }
 
 	Vec3				   m_initialCameraPos = Vec3::ZERO;
 	Vec3				   m_finalCameraPos	  = Vec3::ZERO;
@@ -45,7 +68,7 @@ public:
 	IdleMovementState();
 	virtual ~IdleMovementState() {}
 
-	virtual std::string	   GetStateName() const { return "idle"; }
+	virtual char const*	   GetStateName() const { return "idle"; }
 	virtual MovementState* UpdateTransition() override;
 };
 
@@ -57,7 +80,7 @@ public:
 	WalkMovementState();
 	virtual ~WalkMovementState() {}
 
-	virtual std::string	   GetStateName() const { return "walk"; }
+	virtual char const*	   GetStateName() const { return "walk"; }
 	virtual MovementState* UpdateTransition() override;
 
 	MovementState*		   CheckTransitionToEdgeSlip();
@@ -71,7 +94,7 @@ public:
 	RunMovementState();
 	virtual ~RunMovementState() {}
 
-	virtual std::string	   GetStateName() const { return "run"; }
+	virtual char const*	   GetStateName() const { return "run"; }
 	virtual MovementState* UpdateTransition() override;
 };
 
@@ -83,7 +106,7 @@ public:
 	RunStop();
 	virtual ~RunStop() {}
 
-	virtual std::string	   GetStateName() const { return "runStop"; }
+	virtual char const*	   GetStateName() const { return "runStop"; }
 	virtual MovementState* UpdateTransition() override;
 
 	void				   RemoveZRootMotion();
@@ -104,7 +127,7 @@ public:
 	JumpMovementState();
 	virtual ~JumpMovementState() {}
 
-	virtual std::string	   GetStateName() const { return "jump"; }
+	virtual char const*	   GetStateName() const { return "jump"; }
 	virtual MovementState* UpdateTransition() override;
 };
 
@@ -116,7 +139,7 @@ public:
 	CrouchMovementState();
 	virtual ~CrouchMovementState() {}
 
-	virtual std::string	   GetStateName() const { return "crouch"; }
+	virtual char const*	   GetStateName() const { return "crouch"; }
 	virtual MovementState* UpdateTransition() override;
 };
 
@@ -128,6 +151,6 @@ public:
 	CrouchWalkMovementState();
 	virtual ~CrouchWalkMovementState() {}
 
-	virtual std::string	   GetStateName() const { return "walk"; }
+	virtual char const*	   GetStateName() const { return "walk"; }
 	virtual MovementState* UpdateTransition() override;
 };
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "Game/ThirdPersonController.hpp"
 #include "Game/Character.hpp"
 #include "Game/AnimationState.hpp"
+#include "Game/AnimationStateInstance.hpp"
 #include "Game/AnimationController.hpp"
 #include "Game/GameCommon.hpp"
 
@@ -14,32 +15,24 @@
 //----------------------------------------------------------------------------------------------------------
 ClimbOver::ClimbOver()
 {
+	BindRootMotionInstance( ANIM_NAME_CLIMB_OVER );
+
 	// fix the z position of root joint animation, to start at current position of the character
-	AnimationState*		 state							= AnimationState::GetAnimationStateByName( "climbOver" );
-	AnimationState*		 hangState						= AnimationState::GetAnimationStateByName( "hang" );
-	Vec3AnimCurve const& hangRootMotionTranslationCurve = hangState->m_clip->GetRootJointTranslationCurve();
-	float				 lastHangingHeight				= hangRootMotionTranslationCurve.GetKeyframeAtLastIndex().m_value.z;
-	Vec3				 charCurrentPos					= g_theCharacter->m_physics.m_position;
-	Vec3AnimCurve&		 rootJointTranslationCurve		= state->m_clip->GetRootJointTranslationCurveByRefernce();
-	float				 climbOverCurveFirstZValue		= rootJointTranslationCurve.GetKeyframeAtFirstIndex().m_value.z;
-	float				 climbOverCurveLastZValue		= rootJointTranslationCurve.GetKeyframeAtLastIndex().m_value.z;
-	float				 climbDistance					= 2.0f;
-	float				 newStartHeightZ				= lastHangingHeight;
-	float				 newEndHeightZ					= lastHangingHeight + climbDistance;
-
-	for ( unsigned int index = 0; index < rootJointTranslationCurve.GetSize(); index++ )
+	if ( m_rootMotionInstance )
 	{
-		Vec3& rootTranslationValue = rootJointTranslationCurve.m_keyframes[ index ].m_value;
-		rootTranslationValue.y	   = 0.f;
-		float& zValue			   = rootTranslationValue.z;
-
-		zValue					   = GetFractionWithinRange( zValue, climbOverCurveFirstZValue, climbOverCurveLastZValue );
-		zValue					   = Lerp( newStartHeightZ, newEndHeightZ, zValue );
+		AnimationState*	 hangState				   = AnimationState::GetAnimationStateById( ANIM_NAME_HANG );
+		float			 lastHangingHeight		   = hangState->GetLastKeyframeRootMotionTranslation().z;
+		AnimationState*	 state					   = m_rootMotionInstance->m_state;
+		float			 climbOverCurveFirstZValue = state->GetFirstKeyframeRootMotionTranslation().z;
+		float			 climbOverCurveLastZValue  = state->GetLastKeyframeRootMotionTranslation().z;
+		float			 climbDistance			   = 2.0f;
+		float			 newStartHeightZ		   = lastHangingHeight;
+		float			 newEndHeightZ			   = lastHangingHeight + climbDistance;
+		RootMotionWarp&	 rootMotionWarp			   = m_rootMotionInstance->m_rootMotionWarp;
+		rootMotionWarp.FlattenAxis( 1, 0.f );
+		rootMotionWarp.AlignAxis( 2, climbOverCurveFirstZValue, climbOverCurveLastZValue, newStartHeightZ, newEndHeightZ );
 	}
 
-	// set the root motion curve for debug display
-	m_rootMotionTranslationCurve = state->GetRootMotionTranslation();
-
 	InitCameraPosition();
 }
 
@@ -62,9 +55,9 @@ void ClimbOver::NotifyEndOfAnimationState( bool triggerTransitionRequestToAnimat
 	m_notifyStateChangeToAnimation = triggerTransitionRequestToAnimation;
 
 	// fix the z height here
-	Vec3			finalRootBonePosOfCurrentState	= m_rootMotionTranslationCurve.GetKeyframeAtLastIndex().m_value;
-	Vec3			startRootBonePosOfCurrentState	= m_rootMotionTranslationCurve.GetKeyframeAtFirstIndex().m_value;
-	AnimationState* crouchIdleState					= AnimationState::GetAnimationStateByName( "crouchToStand" );
+	Vec3			finalRootBonePosOfCurrentState	= GetLastRootMotionTranslation();
+	Vec3			startRootBonePosOfCurrentState	= GetFirstRootMotionTranslation();
+	AnimationState* crouchIdleState					= AnimationState::GetAnimationStateById( ANIM_NAME_CROUCH_TO_STAND );
 	Vec3			startRootBonePosOfNextState		= crouchIdleState->GetFirstKeyframeRootMotionTranslation();
 
 	Vec3			characterPosTranslation			= Vec3::ZERO;
@@ -83,21 +76,19 @@ void ClimbOver::NotifyEndOfAnimationState( bool triggerTransitionRequestToAnimat
 //----------------------------------------------------------------------------------------------------------
 ClimbOverCrouchToStandingIdle::ClimbOverCrouchToStandingIdle()
 {
+	BindRootMotionInstance( ANIM_NAME_CROUCH_TO_STAND );
+
 	// fix forward translation of 'crouch' to start at the end translation of 'standToCrouch'
-	AnimationState* crouchToStandState			= AnimationState::GetAnimationStateByName( "crouchToStand" );
-	Vec3AnimCurve&	crouhToStandRootMotionCurve = crouchToStandState->m_clip->GetRootJointTranslationCurveByRefernce();
-	float			crouchToStandFirstX			= crouchToStandState->GetFirstKeyframeRootMotionTranslation().x;
-	float			crouchToStandLastX			= crouchToStandState->GetLastKeyframeRootMotionTranslation().x;
-	for ( unsigned int index = 0; index < crouhToStandRootMotionCurve.GetSize(); index++ )
+	if ( m_rootMotionInstance )
 	{
-		Vec3& translation = crouhToStandRootMotionCurve.m_keyframes[ index ].m_value;
-		translation.x	  = RangeMap( translation.x, crouchToStandFirstX, crouchToStandLastX, 0.f, 0.5f );
+		AnimationState* crouchToStandState	= m_rootMotionInstance->m_state;
+		float			crouchToStandFirstX = crouchToStandState->GetFirstKeyframeRootMotionTranslation().x;
+		float			crouchToStandLastX	= crouchToStandState->GetLastKeyframeRootMotionTranslation().x;
+		m_rootMotionInstance->m_rootMotionWarp.AlignAxis( 0, crouchToStandFirstX, crouchToStandLastX, 0.f, 0.5f );
 	}
 
 	// InitCameraTranslationLerpParameters();
 
-	m_rootMotionTranslationCurve = crouchToStandState->GetRootMotionTranslation();
-
 	InitCameraPosition();
 }
 
@@ -118,8 +109,7 @@ MovementState* ClimbOverCrouchToStandingIdle::UpdateTransition()
 void ClimbOverCrouchToStandingIdle::NotifyEndOfAnimationState( bool triggerTransitionRequestToAnimation )
 {
 	// fix the x forward position of the character's position
-	AnimationState* crouchToStandIdleState		   = AnimationState::GetAnimationStateByName( "crouchToStand" );
-	Vec3			previousAnimationLastKeyframe  = crouchToStandIdleState->GetLastKeyframeRootMotionTranslation();
+	Vec3			previousAnimationLastKeyframe  = GetLastRootMotionTranslation();
 	float			xDiff						   = previousAnimationLastKeyframe.x;
 	Vec3			characterForward			   = g_theCharacter->m_physics.m_orientation.GetVector_XFwd();
 	Vec3			characterTranslation		   = xDiff * characterForward;
@@ -130,14 +120,29 @@ void ClimbOverCrouchToStandingIdle::NotifyEndOfAnimationState( bool triggerTrans
 }
 
 
+//----------------------------------------------------------------------------------------------------------
+// fix idleToActionIdle according to idle; the edge slip lines itself up with the same warp
+static RootMotionWarp GetIdleToActionIdleWarp()
+{
+	AnimationState* idleToActionIdleState	   = AnimationState::GetAnimationStateById( ANIM_NAME_IDLE_TO_ACTION_IDLE );
+	AnimationState* actionIdleAnimationState   = AnimationState::GetAnimationStateById( ANIM_NAME_IDLE );
+	Vec3			actionIdleFirstkeyFramePos = actionIdleAnimationState->GetFirstKeyframeRootMotionTranslation();
+	float			idleToActionIdleLastZ	   = idleToActionIdleState->GetLastKeyframeRootMotionTranslation().z;
+
+	RootMotionWarp	idleToActionIdleWarp;
+	idleToActionIdleWarp.FlattenAxis( 1, 0.f );
+	idleToActionIdleWarp.AlignAxisEnd( 2, idleToActionIdleLastZ, actionIdleFirstkeyFramePos.z );
+
+	return idleToActionIdleWarp;
+}
+
+
 //----------------------------------------------------------------------------------------------------------
 WalkingEdgeSlip::WalkingEdgeSlip()
 {
+	BindRootMotionInstance( ANIM_NAME_WALKING_EDGE_SLIP );
 	FixRootMotionCurve();
 
-	AnimationState* currentAnimationState = AnimationState::GetAnimationStateByName( "walkingEdgeSlip" );
-	m_rootMotionTranslationCurve		  = currentAnimationState->GetRootMotionTranslation();
-
 	InitCameraPosition();
 }
 
@@ -160,25 +165,33 @@ MovementState* WalkingEdgeSlip::UpdateTransition()
 //----------------------------------------------------------------------------------------------------------
 void WalkingEdgeSlip::FixRootMotionCurve()
 {
-	// 1. fix idleToActionIdle according to idle
-	AnimationState* actionIdleAnimationState	   = AnimationState::GetAnimationStateByName( "idle" );
-	Vec3			actionIdleFirstkeyFramePos	   = actionIdleAnimationState->GetFirstKeyframeRootMotionTranslation();
-	AnimationState* idleToActionIdleAnimationState = AnimationState::GetAnimationStateByName( "idleToActionIdle" );
-	idleToActionIdleAnimationState->RemoveRootMotionTranslationOfYPos();
-	idleToActionIdleAnimationState->EndRootMotionZPosAtFollowingZValue( actionIdleFirstkeyFramePos.z );
+	// the clips are shared, so both fixes are warps on this character's instances
+	if ( m_rootMotionInstance == nullptr )
+	{
+		return;
+	}
+
+	// 1. fix idleToActionIdle according to idle, set ahead since the animation may get there before its movement state
+	RootMotionWarp			idleToActionIdleWarp	 = GetIdleToActionIdleWarp();
+	AnimationStateInstance* idleToActionIdleInstance = g_theAnimationController->GetStateInstance( ANIM_NAME_IDLE_TO_ACTION_IDLE );
+	if ( idleToActionIdleInstance )
+	{
+		idleToActionIdleInstance->m_rootMotionWarp = idleToActionIdleWarp;
+	}
 
 	// 2. fix walkingEdleSlip according to idleToActionIdle
-	Vec3			idleToActionIdleFirstkeyFramePos = idleToActionIdleAnimationState->GetFirstKeyframeRootMotionTranslation();
-	AnimationState* edgeSlipAnimationState			 = AnimationState::GetAnimationStateByName( "walkingEdgeSlip" );
-	edgeSlipAnimationState->RemoveRootMotionTranslationOfYPos();
-	edgeSlipAnimationState->EndRootMotionZPosAtFollowingZValue( idleToActionIdleFirstkeyFramePos.z );
+	AnimationState* idleToActionIdleState			 = AnimationState::GetAnimationStateById( ANIM_NAME_IDLE_TO_ACTION_IDLE );
+	Vec3			idleToActionIdleFirstkeyFramePos = idleToActionIdleWarp.Apply( idleToActionIdleState->GetFirstKeyframeRootMotionTranslation() );
+	float			edgeSlipLastZ					 = m_rootMotionInstance->m_state->GetLastKeyframeRootMotionTranslation().z;
+	m_rootMotionInstance->m_rootMotionWarp.FlattenAxis( 1, 0.f );
+	m_rootMotionInstance->m_rootMotionWarp.AlignAxisEnd( 2, edgeSlipLastZ, idleToActionIdleFirstkeyFramePos.z );
 }
 
 
 //----------------------------------------------------------------------------------------------------------
 void WalkingEdgeSlip::FixCharacterPosition()
 {
-	AnimationState* oldAnimationState			= AnimationState::GetAnimationStateByName( "walkingEdgeSlip" );
+	AnimationState* oldAnimationState			= AnimationState::GetAnimationStateById( ANIM_NAME_WALKING_EDGE_SLIP );
 	Vec3			rootMotionTranslationDelta	= oldAnimationState->GetLastAndFirstKeyframeRootMotionTranslationDelta();
 	Vec3			rootMotionXTranslation		= Vec3( rootMotionTranslationDelta.x, 0.f, 0.f );
 	Quaternion		characterOrientation		= g_theThirdPersonController->GetCharacterOrientation();
@@ -190,8 +203,11 @@ void WalkingEdgeSlip::FixCharacterPosition()
 //----------------------------------------------------------------------------------------------------------
 IdleToActionIdleTransition::IdleToActionIdleTransition()
 {
-	AnimationState* currentAnimationState = AnimationState::GetAnimationStateByName( "idleToActionIdle" );
-	m_rootMotionTranslationCurve		  = currentAnimationState->GetRootMotionTranslation();
+	BindRootMotionInstance( ANIM_NAME_IDLE_TO_ACTION_IDLE );
+	if ( m_rootMotionInstance )
+	{
+		m_rootMotionInstance->m_rootMotionWarp = GetIdleToActionIdleWarp();
+	}
 
 	InitCameraPosition();
 }
@@ -218,9 +234,9 @@ MovementState* IdleToActionIdleTransition::UpdateTransition()
 void IdleToActionIdleTransition::FixCharacterPosition()
 {
 	// 1. get end of Idle to action idle
-	Vec3 endOfPreviosAnim = AnimationState::GetAnimationStateByName( "idleToActionIdle" )->GetLastKeyframeRootMotionTranslation();
+	Vec3 endOfPreviosAnim = GetLastRootMotionTranslation();
 	// 2. get beginning of action idle
-	Vec3 startOfNextAnim = AnimationState::GetAnimationStateByName( "idle" )->GetFirstKeyframeRootMotionTranslation();
+	Vec3 startOfNextAnim = AnimationState::GetAnimationStateById( ANIM_NAME_IDLE )->GetFirstKeyframeRootMotionTranslation();
 	// 3. subtract the m_position by the difference
 	Vec3 diff = startOfNextAnim - endOfPreviosAnim;
 	// diff.y							= 0.f;
@@ -236,12 +252,12 @@ IdleDropToFreeHang::IdleDropToFreeHang()
 {
 	//m_applyRootMotionTranslation = true;
 	//g_theCharacter->m_physics.m_position.z = 0.f;
+	BindRootMotionInstance( GetStateId() );
+
 	RemoveYRootMotionTranslationFromAnimation();
 	NormalizeXRootMotionTranslation();
 	ShiftZRootMotionTranslationToCurrentPositionInAnimation();
 
-	m_rootMotionTranslationCurve = AnimationState::GetAnimationStateByName( GetStateName() )->GetRootMotionTranslation();
-
 	m_characterInitialPosition	 = g_theThirdPersonController->GetCharacterPosition();
 }
 
@@ -280,7 +296,7 @@ void IdleDropToFreeHang::NotifyEndOfAnimationState( bool triggerTransitionReques
 	//g_theCharacter->m_physics.m_position.z += thisAnimationZValue;
 
 	//// shift by next animation's first keyframe
-	//AnimationState* nextAnimationState	   = AnimationState::GetAnimationStateByName( "freeHangToBracedHang" );
+	//AnimationState* nextAnimationState	   = AnimationState::GetAnimationStateById( ANIM_NAME_FREE_HANG_TO_BRACED_HANG );
 	//float			nextAnimationZValue	   = nextAnimationState->GetFirstKeyframeRootMotionTranslation().z;
 	//g_theCharacter->m_physics.m_position.z -= nextAnimationZValue;
 	float obstacleHeight				   = g_theCharacter->m_latestObstacleHeight;
@@ -293,13 +309,9 @@ void IdleDropToFreeHang::NotifyEndOfAnimationState( bool triggerTransitionReques
 //----------------------------------------------------------------------------------------------------------
 void IdleDropToFreeHang::RemoveYRootMotionTranslationFromAnimation()
 {
-	AnimationState* idleDropToFreeHangState		   = AnimationState::GetAnimationStateByName( GetStateName() );
-	Vec3AnimCurve&	animationRootMotionTranslation = idleDropToFreeHangState->m_clip->GetRootJointTranslationCurveByRefernce();
-	for ( unsigned int index = 0; index < animationRootMotionTranslation.GetSize(); index++ )
+	if ( m_rootMotionInstance )
 	{
-		Vec3& translation = animationRootMotionTranslation.m_keyframes[ index ].m_value;
-		translation.y	  = 0.f;
-		//translation.x	  = 0.f;
+		m_rootMotionInstance->m_rootMotionWarp.FlattenAxis( 1, 0.f );
 	}
 }
 
@@ -307,39 +319,34 @@ void IdleDropToFreeHang::RemoveYRootMotionTranslationFromAnimation()
 //----------------------------------------------------------------------------------------------------------
 void IdleDropToFreeHang::NormalizeXRootMotionTranslation()
 {
-	AnimationState* idleDropToFreeHangState		   = AnimationState::GetAnimationStateByName( GetStateName() );
-	Vec3AnimCurve&	animationRootMotionTranslation = idleDropToFreeHangState->m_clip->GetRootJointTranslationCurveByRefernce();
-	float			xMin;
-	float			xMax;
-	animationRootMotionTranslation.GetMaxAndMinXValuesFromCurve( xMin, xMax );
-	for ( unsigned int index = 0; index < animationRootMotionTranslation.GetSize(); index++ )
+	if ( !m_rootMotionInstance )
 	{
-		Vec3&  translation	 = animationRootMotionTranslation.m_keyframes[ index ].m_value;
-		float& xTranslation	 = translation.x;
-		xTranslation		-= xMin;
-		xTranslation		/= xMax;
+		return;
 	}
+
+	float xMin;
+	float xMax;
+	m_rootMotionInstance->GetSourceRootMotionCurve().GetMaxAndMinXValuesFromCurve( xMin, xMax );
+
+	// subtract the lowest value, then divide by the highest
+	m_rootMotionInstance->m_rootMotionWarp.AlignAxis( 0, xMin, xMin + xMax, 0.f, 1.f );
 }
 
 
 //----------------------------------------------------------------------------------------------------------
 void IdleDropToFreeHang::ShiftZRootMotionTranslationToCurrentPositionInAnimation()
 {
-	// current animation
-	Vec3AnimCurve const& currentRMTCurve	= g_theAnimationController->GetCurrentStateRootMotionTranslation();
-	float				 currentLocalTimeMs = g_theAnimationController->GetLocalTimeMsOfCurrentAnimation();
-	Vec3				 currentRootBonePos = currentRMTCurve.Sample( currentLocalTimeMs, false );
-
-	// next animation
-	AnimationState* idleDropToFreeHangState		   = AnimationState::GetAnimationStateByName( GetStateName() );
-	Vec3AnimCurve&	animationRootMotionTranslation = idleDropToFreeHangState->m_clip->GetRootJointTranslationCurveByRefernce();
-	Vec3			firstTranslation			   = animationRootMotionTranslation.GetKeyframeAtFirstIndex().m_value;
-	float			diffZ						   = firstTranslation.z - currentRootBonePos.z;
-	for ( unsigned int index = 0; index < animationRootMotionTranslation.GetSize(); index++ )
+	if ( !m_rootMotionInstance )
 	{
-		Vec3& translation  = animationRootMotionTranslation.m_keyframes[ index ].m_value;
-		translation.z	  -= diffZ;
+		return;
 	}
+
+	// current animation
+	Vec3  currentRootBonePos = g_theAnimationController->SampleCurrentStateRoot().m_translation;
+
+	// next animation, shifted so its first key is where the current one is
+	float firstZ			 = m_rootMotionInstance->m_state->GetFirstKeyframeRootMotionTranslation().z;
+	m_rootMotionInstance->m_rootMotionWarp.AlignAxisEnd( 2, firstZ, currentRootBonePos.z );
 }
 
 
@@ -347,7 +354,7 @@ void IdleDropToFreeHang::ShiftZRootMotionTranslationToCurrentPositionInAnimation
 void IdleDropToFreeHang::SampleXRootMotionAndSetCharacterPosition()
 {
 	float localTimeMs			= g_theAnimationController->GetLocalTimeMsOfCurrentAnimation();
-	Vec3  normalizedTranslation = m_rootMotionTranslationCurve.Sample( localTimeMs, false );
+	Vec3  normalizedTranslation = SampleRootMotionTranslation( localTimeMs );
 	normalizedTranslation.y		= 0.f;
 	normalizedTranslation.z		= 0.f;
 	normalizedTranslation		= g_theThirdPersonController->RotateTowardsCharacterOrientation( normalizedTranslation );
@@ -389,7 +396,7 @@ void IdleDropToFreeHang::ReverseCharacterAndCameraOrientation()
 //----------------------------------------------------------------------------------------------------------
 void IdleDropToFreeHang::SetCharacterFinalZPosition()
 {
-	AnimationState* currentState		  = AnimationState::GetAnimationStateByName( GetStateName() );
+	AnimationState* currentState		  = AnimationState::GetAnimationStateById( GetStateId() );
 	Vec3			translationDelta	  = currentState->GetLastAndFirstKeyframeRootMotionTranslationDelta();
 	translationDelta.x					  = 0.f;
 	translationDelta.y					  = 0.f;
@@ -404,12 +411,12 @@ FreeHangToBracedHang::FreeHangToBracedHang()
 	m_applyRootMotionTranslation = false;
 
 	//// fix the root motion curve to start where the previous one ends
-	//AnimationState*		 hangState							= AnimationState::GetAnimationStateByName( "hang" );
+	//AnimationState*		 hangState							= AnimationState::GetAnimationStateById( ANIM_NAME_HANG );
 	//Vec3AnimCurve const& hangRootMotionCurve				= hangState->m_clip->GetRootJointTranslationCurve();
 	//float				 hangAnimationZRootMotionStartvalue = hangRootMotionCurve.GetKeyframeAtFirstIndex().m_value.z;
 	//float				 initValue							= hangAnimationZRootMotionStartvalue;
 
-	//AnimationState*		 currentState						= AnimationState::GetAnimationStateByName( GetStateName() );
+	//AnimationState*		 currentState						= AnimationState::GetAnimationStateById( GetStateId() );
 	//Vec3AnimCurve&		 currentRootMotionCurve				= currentState->m_clip->GetRootJointTranslationCurveByRefernce();
 	//float				 scaleValue							= currentState->GetLastAndFirstKeyframeRootMotionTranslationDelta().z;
 	//float				 minZValue;
@@ -430,7 +437,7 @@ FreeHangToBracedHang::FreeHangToBracedHang()
 	//}
 
 
-	m_rootMotionTranslationCurve = AnimationState::GetAnimationStateByName( GetStateName() )->GetRootMotionTranslation();
+	BindRootMotionInstance( GetStateId() );
 }
 
 
@@ -440,8 +447,8 @@ MovementState* FreeHangToBracedHang::UpdateTransition()
 	if (m_nextMovementState != nullptr)
 	{
 		// get the difference between free_hang_to_braced_hang last root motion value & braced_hang first root motion value
-		Vec3			freeToBracedHanglastXValue	= m_rootMotionTranslationCurve.GetKeyframeAtLastIndex().m_value;
-		AnimationState* nextAnimationState			= AnimationState::GetAnimationStateByName( "hang" );
+		Vec3			freeToBracedHanglastXValue	= GetLastRootMotionTranslation();
+		AnimationState* nextAnimationState			= AnimationState::GetAnimationStateById( ANIM_NAME_HANG );
 		Vec3			bracedHangFirstXValue		= nextAnimationState->GetFirstKeyframeRootMotionTranslation();
 		Vec3			diff						= bracedHangFirstXValue - freeToBracedHanglastXValue;
 
@@ -8,7 +8,7 @@ public:
 	ClimbOver();
 	virtual ~ClimbOver() {}
 
-	virtual std::string	   GetStateName() const override { return "climbOver"; }
+	virtual char const*	   GetStateName() const override { return "climbOver"; }
 	virtual MovementState* UpdateTransition() override;
 	virtual void		   NotifyEndOfAnimationState( bool triggerTransitionRequestToAnimation ) override;
 
@@ -23,7 +23,7 @@ public:
 	ClimbOverCrouchToStandingIdle();
 	virtual ~ClimbOverCrouchToStandingIdle() override {}
 
-	virtual std::string	   GetStateName() const override { return "crouchToStand"; }
+	virtual char const*	   GetStateName() const override { return "crouchToStand"; }
 	virtual MovementState* UpdateTransition() override;
 	virtual void		   NotifyEndOfAnimationState( bool triggerTransitionRequestToAnimation ) override;
 
@@ -38,7 +38,7 @@ public:
 	WalkingEdgeSlip();
 	virtual ~WalkingEdgeSlip() override {}
 
-	virtual std::string	   GetStateName() const override { return "walkingEdgeSlip"; }
+	virtual char const*	   GetStateName() const override { return "walkingEdgeSlip"; }
 	virtual MovementState* UpdateTransition() override;
 
 	MovementState*		   m_nextState = nullptr;
@@ -55,7 +55,7 @@ public:
 	IdleToActionIdleTransition();
 	virtual ~IdleToActionIdleTransition() override {}
 
-	virtual std::string	   GetStateName() const override { return "idleToActionIdle"; }
+	virtual char const*	   GetStateName() const override { return "idleToActionIdle"; }
 	virtual MovementState* UpdateTransition() override;
 
 	MovementState*		   m_nextState = nullptr;
@@ -71,7 +71,7 @@ public:
 	IdleDropToFreeHang();
 	virtual ~IdleDropToFreeHang() override {}
 
-	virtual std::string	   GetStateName() const override { return "idleDropToFreeHang"; }
+	virtual char const*	   GetStateName() const override { return "idleDropToFreeHang"; }
 	virtual MovementState* UpdateTransition() override;
 	virtual void		   NotifyEndOfAnimationState( bool triggerTransitionRequestToAnimation ) override;
 
@@ -94,7 +94,7 @@ public:
 	FreeHangToBracedHang();
 	virtual ~FreeHangToBracedHang() override {}
 
-	virtual std::string	   GetStateName() const override { return "freeHangToBracedHang"; }
+	virtual char const*	   GetStateName() const override { return "freeHangToBracedHang"; }
 	virtual MovementState* UpdateTransition() override;
 	virtual void		   NotifyEndOfAnimationState( bool triggerTransitionRequestToAnimation ) override;
 
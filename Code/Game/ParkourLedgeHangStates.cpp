@@ -1,6 +1,7 @@
 #include "Game/ParkourClimbStates.hpp"
 #include "Game/AnimationController.hpp"
 #include "Game/AnimationState.hpp"
+#include "Game/AnimationStateInstance.hpp"
 #include "Game/ThirdPersonController.hpp"
 #include "Game/ParkourLedgeHangStates.hpp"
 #include "Game/Character.hpp"
@@ -23,28 +24,22 @@ IdleToLedgeGrabState::IdleToLedgeGrabState()
 
 	//InitRootMotionTranslation();
 
-	AnimationState* currentAnimationState = AnimationState::GetAnimationStateByName( "idleToLedgeGrab" );
-	Vec3AnimCurve&	rmtCurve			  = currentAnimationState->m_clip->GetRootJointTranslationCurveByRefernce();
-
-	float			firstZValue			  = rmtCurve.GetKeyframeAtFirstIndex().m_value.z;
-	float			lastZValue			  = rmtCurve.GetKeyframeAtLastIndex().m_value.z;
-	float			obstacleHeight		  = g_theCharacter->m_latestObstacleHeight;
-
-	for ( Vector3Keyframe& keyframe : rmtCurve.m_keyframes )
+	// lift the grab so its last key lands on the ledge, through the instance's warp rather than the shared clip
+	BindRootMotionInstance( ANIM_NAME_IDLE_TO_LEDGE_GRAB );
+	if ( m_rootMotionInstance )
 	{
-		float& zValue	   = keyframe.m_value.z;
-		float  normalizedZ = RangeMap( zValue, firstZValue, lastZValue, 0.f, 1.f );
-		// zValue			   = normalizedZ * ( lastZValue + ( 0.75f ) );
-
-		zValue = ( normalizedZ * ( obstacleHeight - firstZValue - 1.27f ) ) + firstZValue;
+		AnimRootMotionTrack const& rootMotionTrack = m_rootMotionInstance->m_state->GetRootMotionTrack();
+		float					   firstZValue	   = rootMotionTrack.GetFirstTranslation().z;
+		float					   lastZValue	   = rootMotionTrack.GetLastTranslation().z;
+		float					   obstacleHeight  = g_theCharacter->m_latestObstacleHeight;
+		m_rootMotionInstance->m_rootMotionWarp.AlignAxis( 2, firstZValue, lastZValue, firstZValue, obstacleHeight - 1.27f );
 	}
-	m_rootMotionTranslationCurve = rmtCurve;
 
 
 	// init camera lerp start value
 	m_cameraLerpStartValue = g_theThirdPersonController->GetCameraPosition();
 	m_cameraLerpEndValue   = m_cameraLerpStartValue;
-	m_cameraLerpEndValue.z = m_rootMotionTranslationCurve.GetKeyframeAtLastIndex().m_value.z + CAMERA_HEIGHT_OFFSET;
+	m_cameraLerpEndValue.z = GetLastRootMotionTranslation().z + CAMERA_HEIGHT_OFFSET;
 
 	
 }
@@ -55,7 +50,7 @@ MovementState* IdleToLedgeGrabState::UpdateTransition()
 {
 	if (m_nextState == nullptr)
 	{
-		float totalAnimationTime = m_rootMotionTranslationCurve.GetKeyframeAtLastIndex().m_timeMilliSeconds;
+		float totalAnimationTime = GetRootMotionEndTimeMs();
 		float currentAnimationTime = g_theAnimationController->GetLocalTimeMsOfCurrentAnimation();
 		float cameraLerpedZValue   = RangeMap( currentAnimationTime, 0.f, totalAnimationTime, m_cameraLerpStartValue.z, m_cameraLerpEndValue.z );
 		Vec3  newCameraPos		   = m_cameraLerpStartValue;
@@ -75,12 +70,10 @@ void IdleToLedgeGrabState::NotifyEndOfAnimationState( bool triggerTransitionRequ
 	// g_theCharacter->m_physics.m_position = m_characterFinalPos;
 
 	// fix the z height here
-	Vector3Keyframe const& currentStateLastKeyFrame	 = m_rootMotionTranslationCurve.GetKeyframeAtLastIndex();
-	float				   currentStateLastZValue	 = currentStateLastKeyFrame.m_value.z;
+	float				   currentStateLastZValue	 = GetLastRootMotionTranslation().z;
 
 	m_nextState										 = new HangingIdleState();
-	Vector3Keyframe const& nextStateFirstKeyFrame	 = m_nextState->m_rootMotionTranslationCurve.GetKeyframeAtFirstIndex();
-	float				   nextStateFirstZValue		 = nextStateFirstKeyFrame.m_value.z;
+	float				   nextStateFirstZValue		 = m_nextState->GetFirstRootMotionTranslation().z;
 
 	float				   zDifference				 = currentStateLastZValue - nextStateFirstZValue;
 	g_theCharacter->m_physics.m_position			+= Vec3( 0.f, 0.f, zDifference );
@@ -92,14 +85,7 @@ HangingIdleState::HangingIdleState()
 {
 	m_applyRootMotionTranslation = false;
 
-	AnimationState* state		 = AnimationState::GetAnimationStateByName( "hang" );
-	m_rootMotionTranslationCurve = state->GetRootMotionTranslation();
-	m_sampleTimeMs				 = 0.f;
-	if ( !m_rootMotionTranslationCurve.IsEmpty() )
-	{
-		m_previousFrameTranslation = m_rootMotionTranslationCurve.GetKeyframeAtIndex( 0 ).m_value;
-		m_thisFrameTranslation	   = m_previousFrameTranslation;
-	}
+	BindRootMotionInstance( ANIM_NAME_HANG );
 }
 
 
@@ -107,13 +93,18 @@ HangingIdleState::HangingIdleState()
 MovementState* HangingIdleState::UpdateTransition()
 {
 	if ( g_theInput->WasKeyJustPressed( 'R' ) )
+	{
+		m_isDropRequested = true;
+	}
+
+	if ( m_isDropRequested && IsRootMotionClipResident( ANIM_NAME_HANG_TO_IDLE ) )
 	{
 		return new HangingIdleToDropState();
 	}
 
 	if ( g_theInput->IsKeyDown( 'D' ) )
 	{
-		if ( g_theCharacter->IsRightShoulderRaycastHittinSomething() )
+		if ( g_theCharacter->IsLedgeContinuingToRight() && IsRootMotionClipResident( ANIM_NAME_SHIMMY_RIGHT ) )
 		{
 			return new ShimmyRight();
 		}
@@ -121,7 +112,7 @@ MovementState* HangingIdleState::UpdateTransition()
 
 	if ( g_theInput->IsKeyDown( 'A' ) )
 	{
-		if ( g_theCharacter->IsLeftShoulderRaycastHittinSomething() )
+		if ( g_theCharacter->IsLedgeContinuingToLeft() && IsRootMotionClipResident( ANIM_NAME_SHIMMY_LEFT ) )
 		{
 			return new ShimmyLeft();
 		}
@@ -145,24 +136,21 @@ HangingIdleToDropState::HangingIdleToDropState()
 	m_characterStartZPos		 = g_theCharacter->m_physics.m_position.z;
 	// g_theCharacter->m_physics.m_position.z = 0.f;
 
-	InitRootMotionTranslation();
-
 	// TODO remove hard-coded state name later
-	AnimationState*		   previousState				   = AnimationState::GetAnimationStateByName( "hang" );
-	AnimClip*			   previousStateClip			   = previousState->m_clip;
-	Vec3AnimCurve const&   previosStateRootMotionCurve	   = previousStateClip->GetRootJointTranslationCurve();
-	Vector3Keyframe const& previousStateLastKeyframe	   = previosStateRootMotionCurve.GetKeyframeAtLastIndex();
-	float				   previousStateLastKeyframeZValue = previousStateLastKeyframe.m_value.z;
-
-	/*AnimationState*		   nextState					= AnimationState::GetAnimationStateByName( "idle" );
-	AnimClip*			   nextStateClip				= nextState->m_clip;
+	// the hang's root track outlives its clip, so the hang may already be streamed out
+	AnimationState*		   previousState				   = AnimationState::GetAnimationStateById( ANIM_NAME_HANG );
+	float				   previousStateLastKeyframeZValue = previousState->GetRootMotionTrack().GetLastTranslation().z;
+
+	/*AnimationState*		   nextState					= AnimationState::GetAnimationStateById( ANIM_NAME_IDLE );
+	AnimClip*			   nextStateClip				= nextState->GetClip();
 	Vec3AnimCurve const&   nextStateRootMotionCurve		= nextStateClip->GetRootJointTranslationCurve();
 	Vector3Keyframe const& nextStateFirstKeyframe		= nextStateRootMotionCurve.GetKeyframeAtFirstIndex();
 	float				   nextStateFirstKeyframeZValue = nextStateFirstKeyframe.m_value.z;*/
 
-	AnimationState*				  currentAnimationState		  = AnimationState::GetAnimationStateByName( "hangToIdle" );
-	AnimClip*					  currentAnimClip			  = currentAnimationState->m_clip;
-	Vec3AnimCurve&				  currentRootJointTranslation = currentAnimClip->GetRootJointTranslationCurveByRefernce();
+	// the drop reshapes z with a bezier, which a warp can't express, so like the vault it keeps its own copy
+	AnimationState*				  currentAnimationState		  = AnimationState::GetAnimationStateById( ANIM_NAME_HANG_TO_IDLE );
+	m_rootMotionTranslationCurve							  = currentAnimationState->GetRootMotionTranslation();
+	Vec3AnimCurve&				  currentRootJointTranslation = m_rootMotionTranslationCurve;
 	std::vector<Vector3Keyframe>& currentKeyframes			  = currentRootJointTranslation.m_keyframes;
 
 	float						  linearSplitStartParametric  = 0.f;
@@ -204,11 +192,14 @@ HangingIdleToDropState::HangingIdleToDropState()
 			z				  = cubicValue;
 		}
 	}
-
-	m_rootMotionTranslationCurve = currentRootJointTranslation;
+	m_sampleTimeMs			   = 0.f;
+	m_steppedTimeMs			   = 0.f;
+	m_isRootMotionStartSampled = false;
+	m_previousFrameTranslation = SampleRootMotionTranslation( m_sampleTimeMs );
+	m_thisFrameTranslation	   = m_previousFrameTranslation;
 
 	m_cameraLerpStartValue		 = g_theThirdPersonController->GetCameraPosition();
-	float lastZPos				  = m_rootMotionTranslationCurve.GetKeyframeAtLastIndex().m_value.z;
+	float lastZPos				  = GetLastRootMotionTranslation().z;
 	m_cameraLerpEndValue		 = m_cameraLerpStartValue;
 	m_cameraLerpEndValue.z		  = 1.38f + 1.35f ;
 }
@@ -220,7 +211,7 @@ MovementState* HangingIdleToDropState::UpdateTransition()
 	//----------------------------------------------------------------------------------------------------------
 	float splitStartParametric = 0.35f;
 	float splitEndParametric   = 0.59f;
-	float parametricZeroToOne  = GetFractionWithinRange( m_sampleTimeMs, 0.f, m_rootMotionTranslationCurve.GetEndTimeMilliSeconds() );
+	float parametricZeroToOne  = GetFractionWithinRange( m_sampleTimeMs, 0.f, GetRootMotionEndTimeMs() );
 
 	if ( parametricZeroToOne >= splitStartParametric && parametricZeroToOne <= splitEndParametric )
 	{
@@ -240,7 +231,7 @@ MovementState* HangingIdleToDropState::UpdateTransition()
 
 
 	//----------------------------------------------------------------------------------------------------------
-	bool animationComplete = m_sampleTimeMs > m_rootMotionTranslationCurve.GetEndTimeMilliSeconds();
+	bool animationComplete = m_sampleTimeMs > GetRootMotionEndTimeMs();
 	if ( animationComplete )
 	{
 		return new IdleMovementState();
@@ -254,46 +245,27 @@ MovementState* HangingIdleToDropState::UpdateTransition()
 ShimmyRight::ShimmyRight()
 {
 	m_applyRootMotionTranslation = false;
-	InitRootMotionTranslation();
-
-	// fix the shimmy right z height
-	AnimationState* idleHangAnimationState		  = AnimationState::GetAnimationStateByName( "hang" );
-	Vec3AnimCurve	idleHangRootMotionTranslation = idleHangAnimationState->GetRootMotionTranslation();
-	Vec3			hangStartPos				  = idleHangRootMotionTranslation.GetKeyframeAtFirstIndex().m_value;
-	float			hangStartZ					  = hangStartPos.z;
+	BindRootMotionInstance( ANIM_NAME_SHIMMY_RIGHT );
 
-	AnimationState* shimmyRightAnimationState	  = AnimationState::GetAnimationStateByName( "shimmyRight" );
-	Vec3AnimCurve&	shimmyRightRootMotionCurve	  = shimmyRightAnimationState->m_clip->GetRootJointTranslationCurveByRefernce();
-	float			shimmyZMinValue;
-	float			shimmyZMaxvalue;
-	shimmyRightRootMotionCurve.GetMaxAndMinZValuesFromCurve( shimmyZMinValue, shimmyZMaxvalue );
+	// fix the shimmy z height
+	AnimationState* idleHangAnimationState = AnimationState::GetAnimationStateById( ANIM_NAME_HANG );
+	float			hangStartZ			   = idleHangAnimationState->GetFirstKeyframeRootMotionTranslation().z;
+	float			sidewaysMovementLength = 1.f;
 
-	for ( unsigned int index = 0; index < shimmyRightRootMotionCurve.GetSize(); index++ )
+	if ( m_rootMotionInstance )
 	{
-		Vec3&  shimmyPos = shimmyRightRootMotionCurve.m_keyframes[ index ].m_value;
-		float& zValue	 = shimmyPos.z;
-
-		// normalize, get in 0 to 1 range
-		zValue = GetFractionWithinRange( zValue, shimmyZMinValue, shimmyZMaxvalue );
-
-		// get in the range of idle hang z to idle hang z + 0.2f;
-		zValue = Interpolate( hangStartZ, hangStartZ + 0.2f, zValue );
-	}
-
-	// fix shimmy right y values
-	float sidewaysMovementLength = 1.f;
-	float maxYValue				 = shimmyRightRootMotionCurve.GetKeyframeAtLastIndex().m_value.y;
-	float scalingFraction		 = sidewaysMovementLength / fabsf( maxYValue );
-	for ( unsigned int index = 0; index < shimmyRightRootMotionCurve.GetSize(); index++ )
-	{
-		Vec3&  shimmyPos  = shimmyRightRootMotionCurve.m_keyframes[ index ].m_value;
-		float& yValue	  = shimmyPos.y;
-		yValue			 *= scalingFraction;
+		Vec3AnimCurve const& shimmyRootMotionCurve = m_rootMotionInstance->GetSourceRootMotionCurve();
+		float				 shimmyZMinValue;
+		float				 shimmyZMaxvalue;
+		shimmyRootMotionCurve.GetMaxAndMinZValuesFromCurve( shimmyZMinValue, shimmyZMaxvalue );
+
+		// z is remapped into the range of idle hang z to idle hang z + 0.2f, y is scaled so the shimmy ends one unit sideways
+		float			maxYValue	   = m_rootMotionInstance->m_state->GetLastKeyframeRootMotionTranslation().y;
+		RootMotionWarp& rootMotionWarp = m_rootMotionInstance->m_rootMotionWarp;
+		rootMotionWarp.AlignAxis( 2, shimmyZMinValue, shimmyZMaxvalue, hangStartZ, hangStartZ + 0.2f );
+		rootMotionWarp.ScaleAxis( 1, sidewaysMovementLength / fabsf( maxYValue ) );
 	}
 
-	// update the movement state root motion curve
-	m_rootMotionTranslationCurve = shimmyRightRootMotionCurve;
-
 	// set character & camera start and end y positions
 	m_characterStartPos				= g_theCharacter->m_physics.m_position;
 	m_characterEndPos				= g_theCharacter->m_physics.m_position + sidewaysMovementLength * ( g_theCharacter->m_physics.m_orientation * Vec3( 0.f, 1.f, 0.f ) );
@@ -305,10 +277,10 @@ ShimmyRight::ShimmyRight()
 MovementState* ShimmyRight::UpdateTransition()
 {
 	// while the root motion is updating, translate the player position as well
-	AnimationState* shimmyRightAnimationState = AnimationState::GetAnimationStateByName( "shimmyRight" );
-	float			rootBoneYValue			  = m_rootMotionTranslationCurve.Sample( shimmyRightAnimationState->m_localTimeMs, false ).y;
-	Vec3&			charPos					  = g_theCharacter->m_physics.m_position;
-	charPos									  = Lerp( m_characterStartPos, m_characterEndPos, rootBoneYValue );
+	AnimationStateInstance* shimmyRightAnimationState = g_theAnimationController->GetStateInstance( ANIM_NAME_SHIMMY_RIGHT );
+	float					rootBoneYValue			  = SampleRootMotionTranslation( shimmyRightAnimationState->m_localTimeMs ).y;
+	Vec3&					charPos					  = g_theCharacter->m_physics.m_position;
+	charPos											  = Lerp( m_characterStartPos, m_characterEndPos, rootBoneYValue );
 
 	// update camera position
 	if ( g_theThirdPersonController->m_controllerMode != ControllerMode::FreeRoam )
@@ -319,8 +291,7 @@ MovementState* ShimmyRight::UpdateTransition()
 
 
 	// return to hanging idle state, when this animation completes
-	AnimationState* currentAnimationState = g_theAnimationController->m_animationStack.top();
-	if ( currentAnimationState->IsAtEndOfState() )
+	if ( g_theAnimationController->IsCurrentAnimationAtEndOfState() )
 	{
 		// go back to idle hang state
 		return new HangingIdleState();
@@ -334,46 +305,27 @@ MovementState* ShimmyRight::UpdateTransition()
 ShimmyLeft::ShimmyLeft()
 {
 	m_applyRootMotionTranslation = false;
-	InitRootMotionTranslation();
-
-	// fix the shimmy right z height
-	AnimationState* idleHangAnimationState		  = AnimationState::GetAnimationStateByName( "hang" );
-	Vec3AnimCurve	idleHangRootMotionTranslation = idleHangAnimationState->GetRootMotionTranslation();
-	Vec3			hangStartPos				  = idleHangRootMotionTranslation.GetKeyframeAtFirstIndex().m_value;
-	float			hangStartZ					  = hangStartPos.z;
+	BindRootMotionInstance( ANIM_NAME_SHIMMY_LEFT );
 
-	AnimationState* shimmyRightAnimationState	  = AnimationState::GetAnimationStateByName( "shimmyLeft" );
-	Vec3AnimCurve&	shimmyRightRootMotionCurve	  = shimmyRightAnimationState->m_clip->GetRootJointTranslationCurveByRefernce();
-	float			shimmyZMinValue;
-	float			shimmyZMaxvalue;
-	shimmyRightRootMotionCurve.GetMaxAndMinZValuesFromCurve( shimmyZMinValue, shimmyZMaxvalue );
+	// fix the shimmy z height
+	AnimationState* idleHangAnimationState = AnimationState::GetAnimationStateById( ANIM_NAME_HANG );
+	float			hangStartZ			   = idleHangAnimationState->GetFirstKeyframeRootMotionTranslation().z;
+	float			sidewaysMovementLength = 1.f;
 
-	for ( unsigned int index = 0; index < shimmyRightRootMotionCurve.GetSize(); index++ )
+	if ( m_rootMotionInstance )
 	{
-		Vec3&  shimmyPos = shimmyRightRootMotionCurve.m_keyframes[ index ].m_value;
-		float& zValue	 = shimmyPos.z;
-
-		// normalize, get in 0 to 1 range
-		zValue = GetFractionWithinRange( zValue, shimmyZMinValue, shimmyZMaxvalue );
-
-		// get in the range of idle hang z to idle hang z + 0.2f;
-		zValue = Interpolate( hangStartZ, hangStartZ + 0.2f, zValue );
-	}
-
-	// fix shimmy right y values
-	float sidewaysMovementLength = 1.f;
-	float maxYValue				 = shimmyRightRootMotionCurve.GetKeyframeAtLastIndex().m_value.y;
-	float scalingFraction		 = sidewaysMovementLength / fabsf( maxYValue );
-	for ( unsigned int index = 0; index < shimmyRightRootMotionCurve.GetSize(); index++ )
-	{
-		Vec3&  shimmyPos  = shimmyRightRootMotionCurve.m_keyframes[ index ].m_value;
-		float& yValue	  = shimmyPos.y;
-		yValue			 *= scalingFraction;
+		Vec3AnimCurve const& shimmyRootMotionCurve = m_rootMotionInstance->GetSourceRootMotionCurve();
+		float				 shimmyZMinValue;
+		float				 shimmyZMaxvalue;
+		shimmyRootMotionCurve.GetMaxAndMinZValuesFromCurve( shimmyZMinValue, shimmyZMaxvalue );
+
+		// z is remapped into the range of idle hang z to idle hang z + 0.2f, y is scaled so the shimmy ends one unit sideways
+		float			maxYValue	   = m_rootMotionInstance->m_state->GetLastKeyframeRootMotionTranslation().y;
+		RootMotionWarp& rootMotionWarp = m_rootMotionInstance->m_rootMotionWarp;
+		rootMotionWarp.AlignAxis( 2, shimmyZMinValue, shimmyZMaxvalue, hangStartZ, hangStartZ + 0.2f );
+		rootMotionWarp.ScaleAxis( 1, sidewaysMovementLength / fabsf( maxYValue ) );
 	}
 
-	// update the movement state root motion curve
-	m_rootMotionTranslationCurve = shimmyRightRootMotionCurve;
-
 	// set character & camera start and end y positions
 	m_characterStartPos				= g_theCharacter->m_physics.m_position;
 	m_characterEndPos				= g_theCharacter->m_physics.m_position + sidewaysMovementLength * ( g_theCharacter->m_physics.m_orientation * Vec3( 0.f, 1.f, 0.f ) );
@@ -385,10 +337,10 @@ ShimmyLeft::ShimmyLeft()
 MovementState* ShimmyLeft::UpdateTransition()
 {
 	// while the root motion is updating, translate the player position as well
-	AnimationState* shimmyRightAnimationState = AnimationState::GetAnimationStateByName( "shimmyLeft" );
-	float			rootBoneYValue			  = m_rootMotionTranslationCurve.Sample( shimmyRightAnimationState->m_localTimeMs, false ).y;
-	Vec3&			charPos					  = g_theCharacter->m_physics.m_position;
-	charPos									  = Lerp( m_characterStartPos, m_characterEndPos, rootBoneYValue );
+	AnimationStateInstance* shimmyLeftAnimationState = g_theAnimationController->GetStateInstance( ANIM_NAME_SHIMMY_LEFT );
+	float					rootBoneYValue			 = SampleRootMotionTranslation( shimmyLeftAnimationState->m_localTimeMs ).y;
+	Vec3&					charPos					  = g_theCharacter->m_physics.m_position;
+	charPos											  = Lerp( m_characterStartPos, m_characterEndPos, rootBoneYValue );
 
 	// update camera position
 	if ( g_theThirdPersonController->m_controllerMode != ControllerMode::FreeRoam )
@@ -399,8 +351,7 @@ MovementState* ShimmyLeft::UpdateTransition()
 
 
 	// return to hanging idle state, when this animation completes
-	AnimationState* currentAnimationState = g_theAnimationController->m_animationStack.top();
-	if ( currentAnimationState->IsAtEndOfState() )
+	if ( g_theAnimationController->IsCurrentAnimationAtEndOfState() )
 	{
 		// go back to idle hang state
 		return new HangingIdleState();
@@ -9,7 +9,7 @@ public:
 	IdleToLedgeGrabState();
 	virtual ~IdleToLedgeGrabState() {}
 
-	virtual std::string	   GetStateName() const { return "hang"; }
+	virtual char const*	   GetStateName() const { return "hang"; }
 	virtual MovementState* UpdateTransition() override;
 
 	//----------------------------------------------------------------------------------------------------------
@@ -28,8 +28,10 @@ public:
 	HangingIdleState();
 	virtual ~HangingIdleState() {}
 
-	virtual std::string	   GetStateName() const { return "hang"; }
+	virtual char const*	   GetStateName() const { return "hang"; }
 	virtual MovementState* UpdateTransition() override;
+
+	bool				   m_isDropRequested = false; // held until the drop's clip is resident
 };
 
 
@@ -40,7 +42,7 @@ public:
 	HangingIdleToDropState();
 	virtual ~HangingIdleToDropState() {}
 
-	virtual std::string	   GetStateName() const { return "hangDrop"; }
+	virtual char const*	   GetStateName() const { return "hangDrop"; }
 	virtual MovementState* UpdateTransition() override;
 
 	//----------------------------------------------------------------------------------------------------------
@@ -57,7 +59,7 @@ public:
 	ShimmyRight();
 	virtual ~ShimmyRight() {}
 
-	virtual std::string	   GetStateName() const { return "shimmyRight"; }
+	virtual char const*	   GetStateName() const { return "shimmyRight"; }
 	virtual MovementState* UpdateTransition() override;
 
 	Vec3				   m_characterStartPos			   = Vec3::ZERO;
@@ -73,7 +75,7 @@ public:
 	ShimmyLeft();
 	virtual ~ShimmyLeft() {}
 
-	virtual std::string	   GetStateName() const { return "shimmyLeft"; }
+	virtual char const*	   GetStateName() const { return "shimmyLeft"; }
 	virtual MovementState* UpdateTransition() override;
 
 	Vec3				   m_characterStartPos			   = Vec3::ZERO;
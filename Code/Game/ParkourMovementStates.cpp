@@ -1,5 +1,6 @@
 #include "Game/AnimationController.hpp"
 #include "Game/AnimationState.hpp"
+#include "Game/AnimationStateInstance.hpp"
 #include "Game/ThirdPersonController.hpp"
 #include "Game/Character.hpp"
 #include "Game/ParkourMovementStates.hpp"
@@ -23,7 +24,17 @@ VaultMovementState::VaultMovementState()
 {
 	m_applyRootMotionTranslation = true;
 
-	InitRootMotionTranslation();
+	// the forward split reshapes the curve piecewise, which a warp can't express, so the vault keeps its own copy
+	AnimationState* vaultAnimationState = FindRootMotionAnimationState();
+	if ( vaultAnimationState )
+	{
+		m_rootMotionTranslationCurve = vaultAnimationState->GetRootMotionTranslation();
+	}
+	m_sampleTimeMs			   = 0.f;
+	m_steppedTimeMs			   = 0.f;
+	m_isRootMotionStartSampled = false;
+	m_previousFrameTranslation = SampleRootMotionTranslation( m_sampleTimeMs );
+	m_thisFrameTranslation	   = m_previousFrameTranslation;
 
 	FixRootMotionInXForwardDirection();
 	RemoveRootMotionInZUpDirection();
@@ -33,8 +44,7 @@ VaultMovementState::VaultMovementState()
 //----------------------------------------------------------------------------------------------------------
 MovementState* VaultMovementState::UpdateTransition()
 {
-	AnimationState* currentAnimationState = g_theAnimationController->m_animationStack.top();
-	if ( currentAnimationState->IsAtEndOfState() )
+	if ( g_theAnimationController->IsCurrentAnimationAtEndOfState() )
 	{
 		if ( g_theInput->IsKeyDown( KEYCODE_SHIFT ) && g_theInput->IsKeyDown( 'W' ) )
 		{
@@ -106,18 +116,19 @@ void VaultMovementState::RemoveRootMotionInZUpDirection()
 		z		 = 0.f;
 	}
 
-	// scale up root motion in z according to our measures.
-	Vec3AnimCurve& animRootMotionCurve = AnimationState::GetAnimationStateByName( "vault" )->m_clip->GetRootJointTranslationCurveByRefernce();
-	float		   minZ, maxZ;
-	animRootMotionCurve.GetMaxAndMinZValuesFromCurve( minZ, maxZ );
-	float normalizeFraction = maxZ - minZ;
-	float scalingFraction = 0.7f;
-	for ( unsigned int index = 0; index < animRootMotionCurve.GetSize(); index++ )
+	// scale up root motion in z according to our measures, as a warp on this character's vault instance, the clip is shared
+	AnimationStateInstance* vaultInstance = g_theAnimationController->GetStateInstance( ANIM_NAME_VAULT );
+	if ( vaultInstance == nullptr )
 	{
-		float& zvalue = animRootMotionCurve.m_keyframes[ index ].m_value.z;
-		zvalue		  /= normalizeFraction;
-		zvalue		  *= scalingFraction;
+		return;
 	}
+
+	float minZ, maxZ;
+	vaultInstance->GetSourceRootMotionCurve().GetMaxAndMinZValuesFromCurve( minZ, maxZ );
+	float normalizeFraction = maxZ - minZ;
+	float scalingFraction	= 0.7f;
+	vaultInstance->m_rootMotionWarp.Reset();
+	vaultInstance->m_rootMotionWarp.ScaleAxis( 2, scalingFraction / normalizeFraction );
 }
 
 
@@ -129,10 +140,10 @@ RunningSlide::RunningSlide()
 	InitRootMotionTranslation();
 
 	// remove root motion in z for m_position
-	for ( unsigned int index = 0; index < m_rootMotionTranslationCurve.GetSize(); index++ )
+	if ( m_rootMotionInstance )
 	{
-		float& z = m_rootMotionTranslationCurve.m_keyframes[ index ].m_value.z;
-		z		 = m_rootMotionTranslationCurve.m_keyframes[ 0 ].m_value.z;
+		float firstZ = m_rootMotionInstance->m_state->GetFirstKeyframeRootMotionTranslation().z;
+		m_rootMotionInstance->m_rootMotionWarp.FlattenAxis( 2, firstZ );
 	}
 
 	
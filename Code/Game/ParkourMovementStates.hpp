@@ -8,7 +8,7 @@ public:
 	VaultMovementState();
 	virtual ~VaultMovementState() {}
 
-	virtual std::string	   GetStateName() const { return "vault"; }
+	virtual char const*	   GetStateName() const { return "vault"; }
 	virtual MovementState* UpdateTransition() override;
 	virtual void		   UpdateRootMotionTranslation() override;
 
@@ -25,7 +25,7 @@ public:
 	RunningSlide();
 	virtual ~RunningSlide() {}
 
-	virtual std::string	   GetStateName() const { return "runningSlide"; }
+	virtual char const*	   GetStateName() const { return "runningSlide"; }
 	virtual MovementState* UpdateTransition() override;
 	virtual void		   UpdateRootMotionTranslation() override;
 };
\ No newline at end of file
@@ -0,0 +1,78 @@
+#include "Game/RootMotionWarp.hpp"
+
+
+//----------------------------------------------------------------------------------------------------------
+static float& GetAxis( Vec3& vector, int axis )
+{
+	if ( axis == 0 )
+	{
+		return vector.x;
+	}
+	if ( axis == 1 )
+	{
+		return vector.y;
+	}
+	return vector.z;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RootMotionWarp::Reset()
+{
+	m_scale	 = Vec3( 1.f, 1.f, 1.f );
+	m_offset = Vec3::ZERO;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool RootMotionWarp::IsIdentity() const
+{
+	return m_scale.x == 1.f && m_scale.y == 1.f && m_scale.z == 1.f && m_offset.x == 0.f && m_offset.y == 0.f && m_offset.z == 0.f;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+Vec3 RootMotionWarp::Apply( Vec3 const& sourceTranslation ) const
+{
+	Vec3 warpedTranslation;
+	warpedTranslation.x = sourceTranslation.x * m_scale.x + m_offset.x;
+	warpedTranslation.y = sourceTranslation.y * m_scale.y + m_offset.y;
+	warpedTranslation.z = sourceTranslation.z * m_scale.z + m_offset.z;
+
+	return warpedTranslation;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RootMotionWarp::AlignAxis( int axis, float sourceStart, float sourceEnd, float targetStart, float targetEnd )
+{
+	float sourceLength = sourceEnd - sourceStart;
+	float scale		   = ( sourceLength != 0.f ) ? ( targetEnd - targetStart ) / sourceLength : 0.f;
+
+	GetAxis( m_scale, axis )  = scale;
+	GetAxis( m_offset, axis ) = targetStart - sourceStart * scale;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RootMotionWarp::AlignAxisEnd( int axis, float sourceEnd, float targetEnd )
+{
+	GetAxis( m_scale, axis )  = 1.f;
+	GetAxis( m_offset, axis ) = targetEnd - sourceEnd;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RootMotionWarp::ScaleAxis( int axis, float scale )
+{
+	GetAxis( m_scale, axis )  = scale;
+	GetAxis( m_offset, axis ) = 0.f;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RootMotionWarp::FlattenAxis( int axis, float value )
+{
+	GetAxis( m_scale, axis )  = 0.f;
+	GetAxis( m_offset, axis ) = value;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "Engine/Math/Vec3.hpp"
+
+
+//----------------------------------------------------------------------------------------------------------
+// per axis affine remap of a clip's root translation, applied when it is sampled so the clip itself is never
+// written; each setter replaces the mapping of one axis, so calling it again on every state entry is harmless
+struct RootMotionWarp
+{
+	Vec3 m_scale  = Vec3( 1.f, 1.f, 1.f );
+	Vec3 m_offset = Vec3::ZERO;
+
+	void Reset();
+	bool IsIdentity() const;
+	Vec3 Apply( Vec3 const& sourceTranslation ) const;
+
+	// target alignment, source values sourceStart and sourceEnd land on targetStart and targetEnd
+	void AlignAxis( int axis, float sourceStart, float sourceEnd, float targetStart, float targetEnd );
+	// the axis keeps its shape and scale but ends at targetEnd
+	void AlignAxisEnd( int axis, float sourceEnd, float targetEnd );
+	void ScaleAxis( int axis, float scale );
+	void FlattenAxis( int axis, float value );
+};
@@ -1,3 +1,4 @@
+#include "Game/AnimationController.hpp"
 #include "Game/App.hpp"
 #include "Game/Game.hpp"
 #include "Game/MovementState.hpp"
@@ -234,9 +235,9 @@ void ThirdPersonController::UpdateMovementFollow( float deltaseconds )
 //----------------------------------------------------------------------------------------------------------
 void ThirdPersonController::UpdateCameraOrientationInFollowMode()
 {
-	if ( g_theCharacter->m_movementState->GetStateName() != "idle" &&
-		 g_theCharacter->m_movementState->GetStateName() != "walk" &&
-		 g_theCharacter->m_movementState->GetStateName() != "run" )
+	if ( g_theCharacter->m_movementState->GetStateId() != ANIM_NAME_IDLE &&
+		 g_theCharacter->m_movementState->GetStateId() != ANIM_NAME_WALK &&
+		 g_theCharacter->m_movementState->GetStateId() != ANIM_NAME_RUN )
 	{
 		return;
 	}
@@ -280,7 +281,7 @@ void ThirdPersonController::UpdateCharacterOreintationAndXYMovementInFollowMode(
 {
 	UNUSED( deltaseconds );
 
-	if (g_theCharacter->m_movementState->GetStateName() == "idleDropToFreeHang")
+	if (g_theCharacter->m_movementState->GetStateId() == ANIM_NAME_IDLE_DROP_TO_FREE_HANG)
 	{
 		return;
 	}
@@ -340,9 +341,9 @@ void ThirdPersonController::UpdateCharacterMovementXY()
 		return;
 	}
 
-	if ( g_theCharacter->m_movementState->GetStateName() != "walk" &&
-		 g_theCharacter->m_movementState->GetStateName() != "run" && 
-		g_theCharacter->m_movementState->GetStateName() != "idle" )
+	if ( g_theCharacter->m_movementState->GetStateId() != ANIM_NAME_WALK &&
+		 g_theCharacter->m_movementState->GetStateId() != ANIM_NAME_RUN && 
+		g_theCharacter->m_movementState->GetStateId() != ANIM_NAME_IDLE )
 	{
 		return;
 	}
@@ -415,6 +416,12 @@ void ThirdPersonController::UpdateCharacterMovementXY()
 
 	moveIntentions *= m_cumulativeSpeed;
 
+	// locomotion blend space, forward only for now so direction stays at zero
+	if ( g_theAnimationController )
+	{
+		g_theAnimationController->SetBlendSpaceParameters( Vec2( m_cumulativeSpeed, 0.f ) );
+	}
+
 	// fast movement
 	/*float movementSpeed = MOVEMENT_SPEED;
 	if ( g_theInput->IsKeyDown( KEYCODE_SHIFT ) )
@@ -449,6 +456,26 @@ Quaternion ThirdPersonController::GetCharacterOrientation() const
 }
 
 
+//----------------------------------------------------------------------------------------------------------
+float ThirdPersonController::GetCharacterSpeed() const
+{
+	return m_cumulativeSpeed;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// the speed UpdateCharacterMovementXY settles at for the keys held now
+float ThirdPersonController::GetDesiredCharacterSpeed() const
+{
+	if ( !g_theInput->IsKeyDown( 'W' ) )
+	{
+		return 0.f;
+	}
+
+	return g_theInput->IsKeyDown( KEYCODE_SHIFT ) ? 10.f : 2.f;
+}
+
+
 //----------------------------------------------------------------------------------------------------------
 void ThirdPersonController::SetCharacterPosition( Vec3 const& position )
 {
@@ -57,6 +57,8 @@ public:
 	Vec3	   RotateTowardsCharacterOrientation( Vec3 const& translation );
 	void	   OrientAndAppendTranslationToCharacterPostion( Vec3 translation );
 	void	   SetCharacterOrientation( Quaternion const& orientation );
+	float	   GetCharacterSpeed() const;
+	float	   GetDesiredCharacterSpeed() const;
 
 	// camera
 protected: